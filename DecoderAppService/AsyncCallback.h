@@ -0,0 +1,85 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include "pch.h"
+
+namespace FFmpegPack {
+	/**
+	 * IMFAsyncCallback forwarding to a method of its parent, for classes
+	 * with several callbacks or that are not callbacks themselves.
+	 *
+	 * A member of the parent: references are counted on the parent, so
+	 * pending work items keep it alive. Runs on the given work queue.
+	 */
+	template<class T>
+	class AsyncCallback :
+		public IMFAsyncCallback
+	{
+	public:
+		typedef HRESULT (T::*InvokeFn)(IMFAsyncResult *pAsyncResult);
+
+		AsyncCallback(T *pParent, InvokeFn pInvoke) :
+			_pParent(pParent),
+			_pInvoke(pInvoke),
+			_dwQueue(MFASYNC_CALLBACK_QUEUE_STANDARD)
+		{
+		}
+
+		void SetQueue(DWORD dwQueue)
+		{
+			_dwQueue = dwQueue;
+		}
+
+		///////////////////////////////////////////////////////////
+		//   IUnknown Interface
+		///////////////////////////////////////////////////////////
+		virtual STDMETHODIMP QueryInterface(__in REFIID riid, __out void **outInterface)
+		{
+			if (outInterface == NULL)
+				return E_POINTER;
+
+			if (riid == IID_IUnknown || riid == IID_IMFAsyncCallback)
+				*outInterface = static_cast<IMFAsyncCallback*>(this);
+			else
+			{
+				*outInterface = NULL;
+				return E_NOINTERFACE;
+			}
+
+			AddRef();
+
+			return S_OK;
+		}
+
+		virtual STDMETHODIMP_(ULONG) AddRef()
+		{
+			return _pParent->AddRef();
+		}
+
+		virtual STDMETHODIMP_(ULONG) Release()
+		{
+			return _pParent->Release();
+		}
+
+		///////////////////////////////////////////////////////////
+		//   IMFAsyncCallback Interface
+		///////////////////////////////////////////////////////////
+		virtual STDMETHODIMP GetParameters(__out DWORD *pdwFlags, __out DWORD *pdwQueue)
+		{
+			*pdwFlags = 0;
+			*pdwQueue = _dwQueue;
+			return S_OK;
+		}
+
+		virtual STDMETHODIMP Invoke(__in IMFAsyncResult *pAsyncResult)
+		{
+			return (_pParent->*_pInvoke)(pAsyncResult);
+		}
+
+	private:
+		T *_pParent;
+		InvokeFn _pInvoke;
+		DWORD _dwQueue;
+	};
+};
@@ -1,12 +1,20 @@
 //Copyright (c) Microsoft Corporation. All rights reserved.
 
-#include "pch.h"
 #include "AudioTransformHelper.h"
 
-#include "FFmpegTypes.h"
+#include <string.h>
 
 using namespace FFmpegPack;
 
+AudioTransformHelper::AudioTransformHelper() :
+	m_pCodecContext(nullptr),
+	m_pResampleContext(nullptr),
+	m_outputFormat(AV_SAMPLE_FMT_NONE),
+	m_channels(0),
+	m_bCopy(false)
+{
+}
+
 /** Destroy the helper and free all resources. */
 AudioTransformHelper::~AudioTransformHelper()
 {
@@ -14,19 +22,16 @@ AudioTransformHelper::~AudioTransformHelper()
 		swr_free(&m_pResampleContext);
 
 	m_pCodecContext = nullptr;
-
-	if (m_resampledData)
-		av_freep(&m_resampledData);
 }
 
 /** Initialize the helper and allocate all resources. */
-HRESULT AudioTransformHelper::Initialize(
-	_In_ AVCodecContext *pCodecContext, 
-	_In_ IMFMediaType *inputType, 
-	_In_ IMFMediaType *outputType
+int AudioTransformHelper::Initialize(
+	AVCodecContext *pCodecContext, 
+	const MediaFormat &outputFormat,
+	const DecodeOptions &options
 ) {
-	HRESULT hr = S_OK;
-	int64 inChannelLayout, outChannelLayout;
+	int result = 0;
+	int64_t inChannelLayout, outChannelLayout;
 
 	m_pCodecContext = pCodecContext;
 	
@@ -38,16 +43,24 @@ HRESULT AudioTransformHelper::Initialize(
 
 	outChannelLayout = av_get_default_channel_layout(m_pCodecContext->channels);
 
-	GUID outputMFType;
-	m_outputFormat = AV_SAMPLE_FMT_NONE;
-	if (SUCCEEDED(outputType->GetGUID(MF_MT_SUBTYPE, &outputMFType)))
-	{
-		ARRAYTRANSLATE(FFMPEG_MFTYPES_OUTPUT_AUDIO, FFMPEG_AVTYPES_OUTPUT_AUDIO, outputMFType, m_outputFormat);
-		if(m_outputFormat == AV_SAMPLE_FMT_NONE) return E_FAIL;
-	}
+	m_outputFormat = outputFormat.audio.sampleFormat;
+	if(m_outputFormat == AV_SAMPLE_FMT_NONE) return AVERROR(EINVAL);
+
+	if (m_pResampleContext)
+		swr_free(&m_pResampleContext);
+
+	m_channels = av_get_channel_layout_nb_channels(outChannelLayout);
+
+	// Packed S16 or FLT already in the output layout, copied as is. The
+	// output keeps the codec sample rate, there is nothing to resample.
+	m_bCopy = m_pCodecContext->sample_fmt == m_outputFormat
+		&& !av_sample_fmt_is_planar(m_outputFormat)
+		&& inChannelLayout == outChannelLayout;
+
+	if (m_bCopy)
+		return 0;
 
 	// Set up resampler to convert any PCM format to the selected output format.
-	// TODO: Skip conversion if already in desired output format.
 	m_pResampleContext = swr_alloc_set_opts(
 		NULL,
 		outChannelLayout,
@@ -61,68 +74,103 @@ HRESULT AudioTransformHelper::Initialize(
 	);
 
 	if (!m_pResampleContext)
-		hr = E_OUTOFMEMORY;
+		result = AVERROR(ENOMEM);
 
-	if (SUCCEEDED(hr) && swr_init(m_pResampleContext) < 0)
-		hr = E_FAIL;
+	if (result >= 0)
+		result = swr_init(m_pResampleContext);
 
-	if (SUCCEEDED(hr))
-	{
-		m_samples = 0;
-		m_channels = 0;
-		m_resampledData = nullptr;
-	}
+	return result;
+}
 
-	return hr;
+/**
+ * Relative cost of producing outputFormat from inputFormat: 0 when the
+ * samples can be used as is, 1 when only interleaving is needed, 2 for a
+ * real sample format conversion.
+ */
+int AudioTransformHelper::GetConversionCost(
+	AVSampleFormat inputFormat,
+	AVSampleFormat outputFormat
+) {
+	if (inputFormat == AV_SAMPLE_FMT_NONE)
+		return 2;
+
+	if (inputFormat == outputFormat)
+		return 0;
+
+	if (av_get_packed_sample_fmt(inputFormat) == outputFormat)
+		return 1;
+
+	return 2;
+}
+
+/** Upper bound of the resampled size, including samples buffered by the resampler. */
+int AudioTransformHelper::GetOutputSize(
+	const AVFrame *pFrame,
+	int pitch,
+	size_t *pSize
+) {
+	int result = (m_bCopy) ? pFrame->nb_samples : swr_get_out_samples(m_pResampleContext, pFrame->nb_samples);
+
+	if (result >= 0)
+		result = av_samples_get_buffer_size(NULL, m_channels, FFMAX(result, 1), m_outputFormat, 1);
+
+	if (result >= 0)
+		*pSize = result;
+
+	return result;
 }
 
 /** Write an uncompressed frame to a stream in float format. */
-HRESULT AudioTransformHelper::ProcessDecodedFrame(
-	_In_  AVFrame *pFrame,
-	_Out_ Platform::Array<BYTE>^& phBuffer
+int AudioTransformHelper::ProcessDecodedFrame(
+	const AVFrame *pFrame,
+	const FrameBuffer &dest,
+	size_t *pWritten
 ) {
-	// Resample uncompressed frame to AV_SAMPLE_FMT_FLTfloat format
+	// Resample uncompressed frame to AV_SAMPLE_FMT_FLTfloat format,
+	// interleaved straight into the destination buffer.
+	int sampleSize = m_channels * av_get_bytes_per_sample(m_outputFormat);
+	if (!dest.pData || sampleSize <= 0) return AVERROR(EINVAL);
 
-	// m_resampledDataSize ends up = channels * nb_samples * sample size
-	// Reuse m_resampledData buffer whenever size is the same
-	if (!m_resampledData
-		|| pFrame->channels != m_channels
-		|| pFrame->nb_samples != m_samples)
+	if (m_bCopy)
 	{
-		if(m_resampledData) av_freep(&m_resampledData);
-
-		m_resampledDataSize = av_samples_alloc(
-			&m_resampledData,
-			NULL,
-			pFrame->channels,
-			pFrame->nb_samples,
-			m_outputFormat,
-			0
-		);
-		m_channels = pFrame->channels;
-		m_samples = pFrame->nb_samples;
+		size_t size = (size_t)pFrame->nb_samples * sampleSize;
+
+		// The codec changed format mid-stream
+		if (pFrame->format != m_outputFormat || pFrame->channels != m_channels)
+			return AVERROR(EINVAL);
+
+		if (size > dest.size)
+			return AVERROR(EINVAL);
+
+		memcpy(dest.pData, pFrame->extended_data[0], size);
+		*pWritten = size;
+
+		return 0;
 	}
 
-	
+	uint8_t *pOutput = dest.pData;
+
 	int resampledSamplesCount = swr_convert(
 		m_pResampleContext,
-		&m_resampledData,
-		m_resampledDataSize,
-		(const BYTE **)pFrame->extended_data,
+		&pOutput,
+		(int)(dest.size / sampleSize),
+		(const uint8_t **)pFrame->extended_data,
 		pFrame->nb_samples
 	);
 
-	unsigned int samplesByteSize = (
-		resampledSamplesCount * pFrame->channels * av_get_bytes_per_sample(m_outputFormat)
-	);
+	if (resampledSamplesCount < 0)
+		return resampledSamplesCount;
 
-	// Avoid extra copy here by using array reference instead of array.
-	Platform::ArrayReference<BYTE> aBuffer(
-		m_resampledData, 
-		min(m_resampledDataSize, samplesByteSize)
-	);
-	
-	phBuffer = aBuffer;
+	*pWritten = (size_t)resampledSamplesCount * sampleSize;
 
-	return S_OK;
-}
\ No newline at end of file
+	return 0;
+}
+
+/** Drops the samples the resampler still buffers, if any. */
+int AudioTransformHelper::Flush()
+{
+	if (!m_pResampleContext || swr_get_delay(m_pResampleContext, 1) <= 0)
+		return 0;
+
+	return swr_init(m_pResampleContext);
+}
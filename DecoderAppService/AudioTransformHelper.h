@@ -10,39 +10,39 @@ extern "C"
 }
 
 namespace FFmpegPack {
-	ref class AudioTransformHelper :
-		FFmpegTransformHelper
+	class AudioTransformHelper :
+		public FFmpegTransformHelper
 	{
 
 	public:
+		AudioTransformHelper();
 		virtual ~AudioTransformHelper();
 
-	internal:
-		AudioTransformHelper() {};
-
 		///////////////////////////////////////////////////////////
 		//   FFmpegTransformHelper Methods
 		///////////////////////////////////////////////////////////
-		HRESULT Initialize(_In_ AVCodecContext *pCodecContext, _In_ IMFMediaType *inputType, _In_ IMFMediaType *outputType) override;
-		HRESULT ProcessDecodedFrame(_In_ AVFrame *pFrame, _Out_ Platform::Array<BYTE>^& phBuffer) override;
+		int Initialize(AVCodecContext *pCodecContext, const MediaFormat &outputFormat, const DecodeOptions &options) override;
+		int GetOutputSize(const AVFrame *pFrame, int pitch, size_t *pSize) override;
+		int ProcessDecodedFrame(const AVFrame *pFrame, const FrameBuffer &dest, size_t *pWritten) override;
+		int Flush(void) override;
+
+		static int GetConversionCost(AVSampleFormat inputFormat, AVSampleFormat outputFormat);
 
 	private:
 		/** The codec context passed down from the FFmpegContext. */
 		AVCodecContext *m_pCodecContext;
 
-		/** The output float raw audio resampling context. */
+		/** The output float raw audio resampling context, NULL when m_bCopy. */
 		SwrContext* m_pResampleContext;
 
 		/** The output uncompressed sample format. */
 		AVSampleFormat m_outputFormat;
 
-		/** Byte buffer of the output resampled data. */
-		BYTE *m_resampledData;
-		unsigned int m_resampledDataSize;
-
-		// Some stream info so we can reuse memory
+		/** Channel count of the output, interleaved. */
 		int m_channels;
-		int m_samples;
+
+		/** The decoded samples are already in the output format and layout. */
+		bool m_bCopy;
 	};
 };
 
@@ -0,0 +1,522 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include "DecodeEngine.h"
+#include "AudioTransformHelper.h"
+#include "VideoTransformHelper.h"
+
+using namespace FFmpegPack;
+
+/** Sample times are carried in 100-nanosecond units. */
+static const AVRational DECODE_ENGINE_TIME_BASE = { 1, 10000000 };
+
+DecodeEngine::DecodeEngine() :
+	m_pCodec(nullptr),
+	m_pCodecContext(nullptr),
+	m_pCodecParams(nullptr),
+	m_pTransformHelper(nullptr),
+	m_bOutputChanged(false),
+	m_pThreadClient(nullptr),
+	m_packetPts(AV_NOPTS_VALUE),
+	m_packetDuration(0)
+{
+	m_outputFormat = {};
+	m_outputFormat.mediaType = AVMEDIA_TYPE_UNKNOWN;
+	m_options = {};
+}
+
+DecodeEngine::~DecodeEngine()
+{
+	if (m_pCodecParams)
+		avcodec_parameters_free(&m_pCodecParams);
+
+	if (m_pCodecContext)
+		avcodec_free_context(&m_pCodecContext);
+
+	if (m_pTransformHelper)
+		delete m_pTransformHelper;
+
+	// After the codec context, whose slice jobs run on it
+	if (m_pThreadClient)
+		DecodeThreadPool::GetShared().Detach(m_pThreadClient);
+}
+
+/**
+ * Opens the decoder and the conversion stage.
+ *
+ * @param pCodecParams  the compressed stream description, copied.
+ * @param outputFormat  the uncompressed format to produce. Video frame
+ *                      size is corrected to what the decoder reports,
+ *                      see HasOutputChanged.
+ * @param options       the engine tuning.
+ */
+int DecodeEngine::Open(
+	const AVCodecParameters *pCodecParams,
+	const MediaFormat &outputFormat,
+	const DecodeOptions &options
+) {
+	int result = (pCodecParams) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+	{
+		m_outputFormat = outputFormat;
+		m_options = options;
+		m_pCodecParams = avcodec_parameters_alloc();
+		if (!m_pCodecParams) result = AVERROR(ENOMEM);
+	}
+
+	if (result >= 0)
+		result = avcodec_parameters_copy(m_pCodecParams, pCodecParams);
+
+	if (result >= 0)
+	{
+		m_pCodec = avcodec_find_decoder(m_pCodecParams->codec_id);
+		if (!m_pCodec) result = AVERROR_DECODER_NOT_FOUND;
+	}
+
+	// Without a client, libavcodec picks one thread per core
+	if (result >= 0 && m_options.threadCount == 0 && !m_pThreadClient)
+		m_pThreadClient = DecodeThreadPool::GetShared().Attach();
+
+	if (result >= 0)
+		result = _CreateCodecContext();
+
+	if (result >= 0 && m_outputFormat.mediaType == AVMEDIA_TYPE_VIDEO)
+		_VideoUpdateOutput();
+
+	if (result >= 0)
+		result = _CreateTransformHelper();
+
+	return result;
+}
+
+/** Returns true if the engine has been opened. */
+bool DecodeEngine::IsOpen() const
+{
+	return (m_pCodecParams && m_pCodec && m_pTransformHelper);
+}
+
+/**
+ * Finds the format a decoder produces natively, without decoding. Opens a
+ * throwaway decoder, some only know their format after the first frame
+ * and report AV_PIX_FMT_NONE / AV_SAMPLE_FMT_NONE.
+ */
+int DecodeEngine::ProbeNativeFormat(
+	const AVCodecParameters *pCodecParams,
+	MediaFormat *pNativeFormat
+) {
+	int result = (pCodecParams && pNativeFormat) ? 0 : AVERROR(EINVAL);
+	AVCodec *pCodec = nullptr;
+	AVCodecContext *pCodecContext = nullptr;
+
+	if (result >= 0)
+	{
+		pCodec = avcodec_find_decoder(pCodecParams->codec_id);
+		if (!pCodec) result = AVERROR_DECODER_NOT_FOUND;
+	}
+
+	if (result >= 0)
+	{
+		pCodecContext = avcodec_alloc_context3(pCodec);
+		if (!pCodecContext) result = AVERROR(ENOMEM);
+	}
+
+	if (result >= 0)
+		result = avcodec_parameters_to_context(pCodecContext, pCodecParams);
+
+	if (result >= 0)
+		result = avcodec_open2(pCodecContext, pCodec, NULL);
+
+	if (result >= 0)
+	{
+		*pNativeFormat = {};
+		pNativeFormat->mediaType = pCodecContext->codec_type;
+
+		VideoFormat &video = pNativeFormat->video;
+		video.width = pCodecContext->width;
+		video.height = pCodecContext->height;
+		video.pixelFormat = pCodecContext->pix_fmt;
+		if (video.pixelFormat == AV_PIX_FMT_NONE && pCodec->pix_fmts)
+			video.pixelFormat = pCodec->pix_fmts[0];
+
+		video.fullRange = (pCodecContext->color_range == AVCOL_RANGE_JPEG
+			|| video.pixelFormat == AV_PIX_FMT_YUVJ420P
+			|| video.pixelFormat == AV_PIX_FMT_YUVJ422P
+			|| video.pixelFormat == AV_PIX_FMT_YUVJ444P);
+
+		AudioFormat &audio = pNativeFormat->audio;
+		audio.sampleRate = pCodecContext->sample_rate;
+		audio.channels = pCodecContext->channels;
+		audio.channelLayout = pCodecContext->channel_layout;
+		audio.sampleFormat = pCodecContext->sample_fmt;
+		if (audio.sampleFormat == AV_SAMPLE_FMT_NONE && pCodec->sample_fmts)
+			audio.sampleFormat = pCodec->sample_fmts[0];
+	}
+
+	if (pCodecContext)
+		avcodec_free_context(&pCodecContext);
+
+	return result;
+}
+
+/**
+ * Relative cost of converting decoder output to an output format, lower
+ * is cheaper. 0 means frames are only copied.
+ */
+int DecodeEngine::GetConversionCost(
+	const MediaFormat &nativeFormat,
+	const MediaFormat &outputFormat
+) {
+	if (outputFormat.mediaType == AVMEDIA_TYPE_AUDIO)
+		return AudioTransformHelper::GetConversionCost(nativeFormat.audio.sampleFormat, outputFormat.audio.sampleFormat);
+
+	return VideoTransformHelper::GetConversionCost(nativeFormat.video.pixelFormat, outputFormat.video.pixelFormat);
+}
+
+/**
+ * Sends a compressed packet to the decoder.
+ *
+ * @param pPacket  the packet, or NULL to drain the frames the decoder still
+ *                 holds back. ReceiveFrame returns AVERROR_EOF once they
+ *                 have all been received, then only Flush or Reset
+ *                 accept input.
+ *
+ * @return 0 on success, AVERROR(EAGAIN) if frames must be received first,
+ *         another negative AVERROR code on failure.
+ */
+int DecodeEngine::SendPacket(const AVPacket *pPacket)
+{
+	int result = (m_pCodecContext) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+		result = avcodec_send_packet(m_pCodecContext, pPacket);
+
+	if (result >= 0 && pPacket)
+	{
+		m_packetPts = pPacket->pts;
+		m_packetDuration = pPacket->duration;
+	}
+
+	return result;
+}
+
+/**
+ * Receives the next decoded frame, still in the decoder format.
+ * The frame pts and pkt_duration are set to the presentation time and
+ * duration, in the time base of the input packets.
+ *
+ * @param pFrame  an allocated frame, unreferenced by the caller once done.
+ *
+ * @return 0 on success, AVERROR(EAGAIN) if the decoder needs more input,
+ *         another negative AVERROR code on failure.
+ */
+int DecodeEngine::ReceiveFrame(AVFrame *pFrame)
+{
+	int result = (pFrame) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+		result = avcodec_receive_frame(m_pCodecContext, pFrame);
+
+	if (result < 0)
+		return result;
+
+	// Try to get the best effort timestamp for the frame. Delayed frames
+	// (frame threads, reordering) carry the timing of their own packet,
+	// the last packet sent is only a fallback.
+	if (pFrame->best_effort_timestamp != AV_NOPTS_VALUE)
+		pFrame->pts = pFrame->best_effort_timestamp;
+	else if (pFrame->pts == AV_NOPTS_VALUE)
+		pFrame->pts = m_packetPts;
+
+	// Audio duration in samples, converted to 100-nanosecond units.
+	if (pFrame->pkt_duration <= 0 && pFrame->nb_samples && m_pCodecContext->sample_rate > 0)
+	{
+		pFrame->pkt_duration = av_rescale_q(
+			pFrame->nb_samples,
+			av_make_q(1, m_pCodecContext->sample_rate),
+			DECODE_ENGINE_TIME_BASE
+		);
+	}
+	else if (pFrame->pkt_duration <= 0)
+		pFrame->pkt_duration = m_packetDuration;
+
+	return result;
+}
+
+/**
+ * Computes the buffer size ConvertFrame needs for a frame.
+ *
+ * @param pitch  the destination row pitch, 0 for tightly packed rows.
+ */
+int DecodeEngine::GetOutputSize(const AVFrame *pFrame, int pitch, size_t *pSize)
+{
+	int result = (pFrame && pSize && m_pTransformHelper) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+		result = m_pTransformHelper->GetOutputSize(pFrame, pitch, pSize);
+
+	return result;
+}
+
+/**
+ * Converts a received frame to the output format, directly into dest.
+ * Frames must be converted in the order they were received.
+ *
+ * @param pWritten  set to the number of bytes written into dest.
+ */
+int DecodeEngine::ConvertFrame(const AVFrame *pFrame, const FrameBuffer &dest, size_t *pWritten)
+{
+	int result = (pFrame && pWritten && m_pTransformHelper) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+		result = m_pTransformHelper->ProcessDecodedFrame(pFrame, dest, pWritten);
+
+	return result;
+}
+
+/**
+ * Drops the frames and packets held by the decoder and the converter, for
+ * a seek or a new stream after a drain. The codec stays open, along with
+ * its setup (e.g. Vorbis and Theora headers) and the converter.
+ */
+int DecodeEngine::Flush()
+{
+	int result = (m_pCodecContext && m_pTransformHelper) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+	{
+		avcodec_flush_buffers(m_pCodecContext);
+		result = m_pTransformHelper->Flush();
+	}
+
+	m_packetPts = AV_NOPTS_VALUE;
+	m_packetDuration = 0;
+
+	return result;
+}
+
+/**
+ * Reopens the decoder and rebuilds the converter, ready for a new stream.
+ * Flush is enough unless the codec itself must start over.
+ */
+int DecodeEngine::Reset()
+{
+	int result = (m_pCodec) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+	{
+		avcodec_free_context(&m_pCodecContext);
+		result = _CreateCodecContext();
+	}
+
+	if (result >= 0)
+		result = _CreateTransformHelper();
+
+	m_packetPts = AV_NOPTS_VALUE;
+	m_packetDuration = 0;
+
+	return result;
+}
+
+/** The uncompressed format produced by ReceiveFrame. */
+const MediaFormat &DecodeEngine::GetOutputFormat() const
+{
+	return m_outputFormat;
+}
+
+/**
+ * Frames the decoder holds back before the first one is output, i.e. the
+ * packets to send before ReceiveFrame stops returning AVERROR(EAGAIN).
+ */
+int DecodeEngine::GetDelay() const
+{
+	if (!m_pCodecContext)
+		return 0;
+
+	int delay = m_pCodecContext->has_b_frames;
+	if (m_pCodecContext->active_thread_type & FF_THREAD_FRAME)
+		delay += m_pCodecContext->thread_count - 1;
+
+	return delay;
+}
+
+/**
+ * Switches to another video output format without reopening the decoder,
+ * e.g. a new frame size mid-stream. Converters already built for a format
+ * are reused, see VideoTransformHelper.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) for audio, which needs a new
+ *         engine, another negative AVERROR code on failure.
+ */
+int DecodeEngine::SetOutputFormat(const MediaFormat &outputFormat)
+{
+	int result = (m_pCodecContext && m_pTransformHelper) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0 && (outputFormat.mediaType != AVMEDIA_TYPE_VIDEO || m_outputFormat.mediaType != AVMEDIA_TYPE_VIDEO))
+		result = AVERROR(ENOSYS);
+
+	if (result >= 0)
+		result = m_pTransformHelper->Initialize(m_pCodecContext, outputFormat, m_options);
+
+	if (result >= 0)
+		m_outputFormat = outputFormat;
+
+	return result;
+}
+
+/**
+ * Changes the decoding shortcuts, from the next packet on. Applies to the
+ * frame threads too, they copy the settings with each packet.
+ */
+int DecodeEngine::SetSkip(const DecodeSkip &skip)
+{
+	m_options.skip = skip;
+
+	if (m_pCodecContext)
+	{
+		m_pCodecContext->skip_frame = skip.skipFrame;
+		m_pCodecContext->skip_loop_filter = skip.skipLoopFilter;
+		m_pCodecContext->skip_idct = skip.skipIdct;
+	}
+
+	return 0;
+}
+
+/**
+ * Shortcuts for a degradation level, from 0 (none) to DECODE_SKIP_LEVELS - 1.
+ * Each level skips more work than the previous one.
+ *
+ * @param bDropFrames  whole frames may be skipped, the picture stutters.
+ *                     Otherwise only filtering and transforms are skipped,
+ *                     the picture degrades.
+ */
+void DecodeEngine::GetSkipForLevel(int level, bool bDropFrames, DecodeSkip *pSkip)
+{
+	// Loop filter, IDCT, by level
+	static const AVDiscard degrade[DECODE_SKIP_LEVELS][2] = {
+		{ AVDISCARD_DEFAULT, AVDISCARD_DEFAULT },
+		{ AVDISCARD_NONREF,  AVDISCARD_DEFAULT },
+		{ AVDISCARD_BIDIR,   AVDISCARD_DEFAULT },
+		{ AVDISCARD_NONKEY,  AVDISCARD_DEFAULT },
+		{ AVDISCARD_ALL,     AVDISCARD_DEFAULT },
+		{ AVDISCARD_ALL,     AVDISCARD_NONREF  },
+	};
+
+	// Frames, loop filter, by level
+	static const AVDiscard drop[DECODE_SKIP_LEVELS][2] = {
+		{ AVDISCARD_DEFAULT,  AVDISCARD_DEFAULT },
+		{ AVDISCARD_NONREF,   AVDISCARD_DEFAULT },
+		{ AVDISCARD_NONREF,   AVDISCARD_ALL     },
+		{ AVDISCARD_BIDIR,    AVDISCARD_ALL     },
+		{ AVDISCARD_NONINTRA, AVDISCARD_ALL     },
+		{ AVDISCARD_NONKEY,   AVDISCARD_ALL     },
+	};
+
+	level = FFMAX(0, FFMIN(level, DECODE_SKIP_LEVELS - 1));
+	*pSkip = {};
+
+	if (bDropFrames)
+	{
+		pSkip->skipFrame = drop[level][0];
+		pSkip->skipLoopFilter = drop[level][1];
+	}
+	else
+	{
+		pSkip->skipLoopFilter = degrade[level][0];
+		pSkip->skipIdct = degrade[level][1];
+	}
+}
+
+/** Returns true once if the output format was changed by the decoder. */
+bool DecodeEngine::HasOutputChanged()
+{
+	bool result = m_bOutputChanged;
+	m_bOutputChanged = false;
+	return result;
+}
+
+/**
+ * Creates the FFmpeg codec context. Threading follows the codec
+ * capabilities: frame threads where supported (FLAC, Theora, Fraps, CFHD),
+ * slice threads otherwise (VP6, FIC), unless low latency is requested.
+ *
+ * With an automatic thread count, slice jobs run on the shared pool and
+ * frame threads are limited to a fair share of it, see DecodeThreadPool.
+ * Otherwise libavcodec starts its own threads.
+ */
+int DecodeEngine::_CreateCodecContext()
+{
+	int result = (m_pCodec) ? 0 : AVERROR(EINVAL);
+
+	if (result >= 0)
+	{
+		m_pCodecContext = avcodec_alloc_context3(m_pCodec);
+		if (!m_pCodecContext) result = AVERROR(ENOMEM);
+	}
+
+	if (result >= 0)
+		result = avcodec_parameters_to_context(m_pCodecContext, m_pCodecParams);
+
+	if (result >= 0)
+	{
+		bool bFrameThreads = !m_options.lowLatency && (m_pCodec->capabilities & AV_CODEC_CAP_FRAME_THREADS);
+
+		// 0 lets FFmpeg pick one thread per core
+		m_pCodecContext->thread_count = FFMAX(m_options.threadCount, 0);
+		m_pCodecContext->thread_type = FF_THREAD_SLICE;
+
+		if (m_options.lowLatency)
+			m_pCodecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+		else
+			m_pCodecContext->thread_type |= FF_THREAD_FRAME;
+
+		// No slice threads of its own, the pool runs the slices
+		if (m_pThreadClient)
+			m_pCodecContext->thread_count = (bFrameThreads) ? m_pThreadClient->GetThreadShare() : 1;
+
+		m_pCodecContext->skip_frame = m_options.skip.skipFrame;
+		m_pCodecContext->skip_loop_filter = m_options.skip.skipLoopFilter;
+		m_pCodecContext->skip_idct = m_options.skip.skipIdct;
+	}
+
+	// Other instances may open codecs at once: libavcodec serializes the
+	// init of codecs not marked thread safe under its own lock
+	if (result >= 0)
+		result = avcodec_open2(m_pCodecContext, m_pCodec, NULL);
+
+	if (result >= 0 && m_pThreadClient && !(m_pCodecContext->active_thread_type & FF_THREAD_FRAME))
+		m_pThreadClient->SetupCodec(m_pCodecContext);
+
+	if (result < 0 && m_pCodecContext)
+		avcodec_free_context(&m_pCodecContext);
+
+	return result;
+}
+
+/** Creates the conversion stage for the current codec context. */
+int DecodeEngine::_CreateTransformHelper()
+{
+	if (m_pTransformHelper)
+		delete m_pTransformHelper;
+
+	if (m_outputFormat.mediaType == AVMEDIA_TYPE_AUDIO)
+		m_pTransformHelper = new AudioTransformHelper();
+	else
+		m_pTransformHelper = new VideoTransformHelper();
+
+	m_pTransformHelper->SetThreadPool(m_pThreadClient);
+
+	return m_pTransformHelper->Initialize(m_pCodecContext, m_outputFormat, m_options);
+}
+
+/** Matches the output frame size to the one the decoder produces. */
+void DecodeEngine::_VideoUpdateOutput()
+{
+	VideoFormat &video = m_outputFormat.video;
+
+	if (m_pCodecContext->width != video.width || m_pCodecContext->height != video.height)
+	{
+		video.width = m_pCodecContext->width;
+		video.height = m_pCodecContext->height;
+		m_bOutputChanged = true;
+	}
+}
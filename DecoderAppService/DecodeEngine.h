@@ -0,0 +1,76 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include "DecodeThreadPool.h"
+#include "DecodeTypes.h"
+#include "FFmpegTransformHelper.h"
+
+namespace FFmpegPack {
+	/**
+	 * Platform-neutral decoder: compressed packets in, converted frames out.
+	 *
+	 * Owns the FFmpeg codec context and the format conversion stage. Frames
+	 * are received in the decoder format and only converted on demand, into
+	 * a buffer supplied by the caller, so each one is written once. Knows
+	 * nothing about Media Foundation, see FFmpegContext for the MF adapter
+	 * and DecoderBench for the command line driver.
+	 *
+	 * All methods return 0 on success or a negative AVERROR code.
+	 */
+	class DecodeEngine
+	{
+	public:
+		DecodeEngine();
+		~DecodeEngine();
+
+		int Open(const AVCodecParameters *pCodecParams, const MediaFormat &outputFormat, const DecodeOptions &options = DecodeOptions());
+		bool IsOpen(void) const;
+
+		static int ProbeNativeFormat(const AVCodecParameters *pCodecParams, MediaFormat *pNativeFormat);
+		static int GetConversionCost(const MediaFormat &nativeFormat, const MediaFormat &outputFormat);
+
+		int SendPacket(const AVPacket *pPacket);
+		int ReceiveFrame(AVFrame *pFrame);
+
+		int GetOutputSize(const AVFrame *pFrame, int pitch, size_t *pSize);
+		int ConvertFrame(const AVFrame *pFrame, const FrameBuffer &dest, size_t *pWritten);
+
+		int Flush(void);
+		int Reset(void);
+
+		int GetDelay(void) const;
+
+		int SetSkip(const DecodeSkip &skip);
+		static void GetSkipForLevel(int level, bool bDropFrames, DecodeSkip *pSkip);
+
+		const MediaFormat &GetOutputFormat(void) const;
+		int SetOutputFormat(const MediaFormat &outputFormat);
+		bool HasOutputChanged(void);
+
+	private:
+		// FFmpeg
+		AVCodec *m_pCodec;
+		AVCodecContext *m_pCodecContext;
+		AVCodecParameters *m_pCodecParams;
+
+		// Others
+		FFmpegTransformHelper *m_pTransformHelper;
+		MediaFormat m_outputFormat;
+		DecodeOptions m_options;
+		bool m_bOutputChanged;
+
+		/** Attached to the shared pool when the thread count is automatic. */
+		DecodeThreadPoolClient *m_pThreadClient;
+
+		/** Timing of the last packet, used when the decoder has none. */
+		int64_t m_packetPts;
+		int64_t m_packetDuration;
+
+		// Methods
+		int _CreateCodecContext(void);
+		int _CreateTransformHelper(void);
+
+		void _VideoUpdateOutput(void);
+	};
+};
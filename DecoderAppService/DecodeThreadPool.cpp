@@ -0,0 +1,509 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include "DecodeThreadPool.h"
+
+#include <algorithm>
+#include <system_error>
+
+extern "C"
+{
+#include <libavutil/cpu.h> // av_cpu_count
+#include <libavutil/error.h> // AVERROR
+}
+
+using namespace FFmpegPack;
+
+DecodeThreadPool::DecodeThreadPool() :
+	m_maxThreads(std::min(av_cpu_count(), DECODE_POOL_MAX_THREADS)),
+	m_nextQueue(0),
+	m_batches(0),
+	m_jobs(0),
+	m_workerJobs(0),
+	m_steals(0)
+{
+}
+
+/** Stops the workers. Clients must have been detached. */
+DecodeThreadPool::~DecodeThreadPool()
+{
+	SetMaxThreads(-1);
+}
+
+/**
+ * The pool of the process, created on first use. Never destroyed: joining
+ * threads while the module unloads would deadlock on Windows, the workers
+ * end with the process instead.
+ */
+DecodeThreadPool &DecodeThreadPool::GetShared()
+{
+	static DecodeThreadPool *s_pShared = new DecodeThreadPool();
+	return *s_pShared;
+}
+
+/**
+ * Caps the workers, shared by every client. Workers beyond the cap finish
+ * their job and exit, new ones start with the next client attached.
+ *
+ * @param maxThreads  the most workers, 0 for one per core. Stops all of
+ *                    them when negative, only for the destructor.
+ *
+ * @return 0 on success, a negative AVERROR code on failure.
+ */
+int DecodeThreadPool::SetMaxThreads(int maxThreads)
+{
+	std::lock_guard<std::mutex> resizeLock(m_resizeMutex);
+	std::vector<std::thread> stopped;
+	int result = 0;
+
+	if (maxThreads == 0)
+		maxThreads = av_cpu_count();
+
+	maxThreads = std::min(maxThreads, DECODE_POOL_MAX_THREADS);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_maxThreads = std::max(maxThreads, 0);
+
+		while ((int)m_threads.size() > m_maxThreads)
+		{
+			stopped.push_back(std::move(m_threads.back()));
+			m_threads.pop_back();
+		}
+
+		if (!m_clients.empty())
+			result = _StartWorkers();
+	}
+
+	// Workers check their index against the cap on wake up
+	m_workCond.notify_all();
+
+	for (std::thread &thread : stopped)
+		thread.join();
+
+	return result;
+}
+
+int DecodeThreadPool::GetMaxThreads()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_maxThreads;
+}
+
+/**
+ * Threads one client should use for work the pool cannot run, i.e. frame
+ * threads: the workers over the clients attached, at least 1.
+ */
+int DecodeThreadPool::GetThreadShare()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return std::max(1, m_maxThreads / std::max(1, (int)m_clients.size()));
+}
+
+/**
+ * Attaches a decoder instance, starting the workers with the first one.
+ *
+ * @return the client, to Detach once done, or NULL on failure.
+ */
+DecodeThreadPoolClient *DecodeThreadPool::Attach()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	DecodeThreadPoolClient *pClient = new (std::nothrow) DecodeThreadPoolClient(this);
+
+	if (pClient)
+		m_clients.push_back(pClient);
+
+	// Without workers, batches run on the thread executing them
+	if (pClient)
+		_StartWorkers();
+
+	return pClient;
+}
+
+/** Detaches and frees a client, none of its batches may be executing. */
+void DecodeThreadPool::Detach(DecodeThreadPoolClient *pClient)
+{
+	if (!pClient)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_clients.erase(std::remove(m_clients.begin(), m_clients.end(), pClient), m_clients.end());
+	}
+
+	delete pClient;
+}
+
+void DecodeThreadPool::GetStats(DecodeThreadPoolStats *pStats)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	pStats->batches = m_batches;
+	pStats->jobs = m_jobs;
+	pStats->workerJobs = m_workerJobs;
+	pStats->steals = m_steals;
+	pStats->threads = (int)m_threads.size();
+	pStats->clients = (int)m_clients.size();
+}
+
+/** Starts workers up to the cap. Caller holds m_mutex. */
+int DecodeThreadPool::_StartWorkers()
+{
+	try
+	{
+		while ((int)m_threads.size() < m_maxThreads)
+			m_threads.push_back(std::thread(&DecodeThreadPool::_WorkerMain, this, (int)m_threads.size()));
+	}
+	catch (const std::system_error &)
+	{
+		return AVERROR(EAGAIN);
+	}
+
+	return 0;
+}
+
+/** Runs a job taken from a task, without m_mutex. */
+static int RunJob(const DecodeThreadPoolJob &job)
+{
+	const DecodeThreadPoolBatch *pBatch = job.pBatch;
+
+	if (pBatch->pThreadJob)
+		return pBatch->pThreadJob(pBatch->pArg, job.job, job.thread);
+
+	return pBatch->pJob(pBatch->pArg, job.job);
+}
+
+/** Whether a job of the batch may start now, it needs a free thread number. */
+static bool HasFreeThread(const DecodeThreadPoolBatch *pBatch)
+{
+	if (!pBatch->threadCount)
+		return true;
+
+	uint64_t allThreads = (pBatch->threadCount < 64) ? (1ull << pBatch->threadCount) - 1 : ~0ull;
+	return pBatch->busyThreads != allThreads;
+}
+
+/** Runs jobs of any client until the worker falls beyond the cap. */
+void DecodeThreadPool::_WorkerMain(int index)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (index < m_maxThreads)
+	{
+		DecodeThreadPoolJob job;
+
+		if (!_TakeJob(m_queues[index], nullptr, &job) && !_StealJob(index, &job))
+		{
+			m_workCond.wait(lock);
+			continue;
+		}
+
+		m_workerJobs++;
+
+		lock.unlock();
+		int result = RunJob(job);
+		lock.lock();
+
+		_FinishJob(job, result);
+	}
+}
+
+/**
+ * Runs the jobs of a batch on the workers and the calling thread, and
+ * returns once they have all finished.
+ */
+int DecodeThreadPool::_Execute(
+	DecodeJobFn pJob,
+	DecodeThreadJobFn pThreadJob,
+	void *pArg,
+	int *pResults,
+	int jobCount,
+	int threadCount
+) {
+	DecodeThreadPoolBatch batch = { pJob, pThreadJob, pArg, pResults, jobCount, threadCount, 0, jobCount };
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_batches++;
+	m_jobs += std::max(jobCount, 0);
+
+	// Nothing to share, or a single thread number: one job after the other
+	if (jobCount <= 1 || threadCount == 1 || m_threads.empty())
+	{
+		lock.unlock();
+
+		for (int job = 0; job < jobCount; job++)
+		{
+			DecodeThreadPoolJob run = { &batch, job, 0 };
+			int result = RunJob(run);
+			if (pResults)
+				pResults[job] = result;
+		}
+
+		return 0;
+	}
+
+	// A range of jobs per worker, or one for all when they take thread numbers in order
+	int taskCount = (threadCount) ? 1 : std::min(jobCount, (int)m_threads.size());
+
+	for (int i = 0; i < taskCount; i++)
+	{
+		DecodeThreadPoolTask task = { &batch, jobCount * i / taskCount, jobCount * (i + 1) / taskCount };
+		m_queues[m_nextQueue++ % m_threads.size()].push_back(task);
+	}
+
+	m_workCond.notify_all();
+
+	// The caller only takes jobs of its own batch, it returns with them
+	while (batch.pendingJobs > 0)
+	{
+		DecodeThreadPoolJob job;
+		bool bTaken = false;
+
+		for (int index = 0; index < DECODE_POOL_MAX_THREADS && !bTaken; index++)
+			bTaken = _TakeJob(m_queues[index], &batch, &job);
+
+		if (!bTaken)
+		{
+			m_doneCond.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+		int result = RunJob(job);
+		lock.lock();
+
+		_FinishJob(job, result);
+	}
+
+	return 0;
+}
+
+/**
+ * Takes the next job of the first task of a queue able to start one, of
+ * pBatch only when set. Otherwise the task goes to the back of the queue,
+ * so the batches there take turns job by job. Caller holds m_mutex.
+ *
+ * @return false when no task of the queue could start a job.
+ */
+bool DecodeThreadPool::_TakeJob(std::deque<DecodeThreadPoolTask> &queue, DecodeThreadPoolBatch *pBatch, DecodeThreadPoolJob *pJob)
+{
+	for (auto it = queue.begin(); it != queue.end(); ++it)
+	{
+		DecodeThreadPoolBatch *pTaskBatch = it->pBatch;
+
+		if ((pBatch && pTaskBatch != pBatch) || !HasFreeThread(pTaskBatch))
+			continue;
+
+		pJob->pBatch = pTaskBatch;
+		pJob->job = it->nextJob++;
+		pJob->thread = 0;
+
+		if (pTaskBatch->threadCount)
+		{
+			while (pTaskBatch->busyThreads & (1ull << pJob->thread))
+				pJob->thread++;
+
+			pTaskBatch->busyThreads |= 1ull << pJob->thread;
+		}
+
+		DecodeThreadPoolTask task = *it;
+
+		if (pBatch && task.nextJob < task.endJob)
+			return true;
+
+		queue.erase(it);
+
+		if (task.nextJob < task.endJob)
+			queue.push_back(task);
+
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Moves a task from the queue of another worker to the queue of an idle
+ * one, and takes its next job. The other keeps the first half of a range,
+ * a batch with thread numbers moves whole. Caller holds m_mutex.
+ *
+ * @return false when no queue had a task able to start a job.
+ */
+bool DecodeThreadPool::_StealJob(int index, DecodeThreadPoolJob *pJob)
+{
+	for (int i = 1; i < DECODE_POOL_MAX_THREADS; i++)
+	{
+		std::deque<DecodeThreadPoolTask> &victim = m_queues[(index + i) % DECODE_POOL_MAX_THREADS];
+
+		for (auto it = victim.begin(); it != victim.end(); ++it)
+		{
+			if (!HasFreeThread(it->pBatch))
+				continue;
+
+			DecodeThreadPoolTask task = *it;
+			int jobsLeft = task.endJob - task.nextJob;
+
+			if (!task.pBatch->threadCount && jobsLeft > 1)
+			{
+				task.nextJob = task.endJob - jobsLeft / 2;
+				it->endJob = task.nextJob;
+			}
+			else
+			{
+				victim.erase(it);
+			}
+
+			m_steals++;
+			m_queues[index].push_back(task);
+
+			// The own queue had nothing to start, this is the only task of the batch there
+			return _TakeJob(m_queues[index], task.pBatch, pJob);
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Stores a job result and frees its thread number, then wakes the caller
+ * of the batch after the last job. Caller holds m_mutex.
+ */
+void DecodeThreadPool::_FinishJob(const DecodeThreadPoolJob &job, int result)
+{
+	DecodeThreadPoolBatch *pBatch = job.pBatch;
+	bool bThreadFreed = (pBatch->threadCount != 0);
+
+	if (pBatch->pResults)
+		pBatch->pResults[job.job] = result;
+
+	// The next job may start with this thread number
+	if (bThreadFreed)
+	{
+		pBatch->busyThreads &= ~(1ull << job.thread);
+		m_workCond.notify_all();
+	}
+
+	// The batch may be gone once its caller wakes
+	if (--pBatch->pendingJobs == 0 || bThreadFreed)
+		m_doneCond.notify_all();
+}
+
+
+///////////////////////////////////////////////////////////
+//   DecodeThreadPoolClient
+///////////////////////////////////////////////////////////
+
+DecodeThreadPoolClient::DecodeThreadPoolClient(DecodeThreadPool *pPool) :
+	m_pPool(pPool)
+{
+}
+
+/**
+ * Runs a batch of independent jobs on the pool, and returns once they have
+ * all finished. The calling thread runs jobs of the batch as well.
+ *
+ * @param pResults  set to the result of each job, may be NULL.
+ *
+ * @return 0, failures are reported by the jobs.
+ */
+int DecodeThreadPoolClient::Execute(DecodeJobFn pJob, void *pArg, int *pResults, int jobCount)
+{
+	return m_pPool->_Execute(pJob, nullptr, pArg, pResults, jobCount, 0);
+}
+
+/**
+ * Runs a batch of jobs with thread numbers on the pool, like
+ * AVCodecContext.execute2: the jobs start in order, at most threadCount
+ * at once, each with a thread number none of the running ones has.
+ *
+ * @param threadCount  the thread numbers, up to DECODE_POOL_MAX_BATCH_THREADS.
+ *
+ * @return 0, failures are reported by the jobs.
+ */
+int DecodeThreadPoolClient::Execute2(DecodeThreadJobFn pJob, void *pArg, int *pResults, int jobCount, int threadCount)
+{
+	threadCount = std::min(std::max(threadCount, 1), DECODE_POOL_MAX_BATCH_THREADS);
+	return m_pPool->_Execute(nullptr, pJob, pArg, pResults, jobCount, threadCount);
+}
+
+/** Threads this client should use for work the pool cannot run, see DecodeThreadPool::GetThreadShare. */
+int DecodeThreadPoolClient::GetThreadShare()
+{
+	return m_pPool->GetThreadShare();
+}
+
+/** Slice jobs of a codec, see ExecuteCodecJobs. */
+struct CodecJobs
+{
+	AVCodecContext *pCodecContext;
+	int (*func)(AVCodecContext *c2, void *arg2);
+	char *pArgs;
+	int argSize;
+};
+
+static int RunCodecJob(void *pArg, int job)
+{
+	CodecJobs *pJobs = (CodecJobs *)pArg;
+	return pJobs->func(pJobs->pCodecContext, pJobs->pArgs + (size_t)job * pJobs->argSize);
+}
+
+/** AVCodecContext.execute over the pool of the client in the context opaque. */
+static int ExecuteCodecJobs(
+	AVCodecContext *c,
+	int (*func)(AVCodecContext *c2, void *arg2),
+	void *arg,
+	int *ret,
+	int count,
+	int size
+) {
+	DecodeThreadPoolClient *pClient = (DecodeThreadPoolClient *)c->opaque;
+	CodecJobs jobs = { c, func, (char *)arg, size };
+
+	return pClient->Execute(RunCodecJob, &jobs, ret, count);
+}
+
+/** Slice jobs of a codec with thread numbers, see ExecuteCodecJobs2. */
+struct CodecThreadJobs
+{
+	AVCodecContext *pCodecContext;
+	int (*func)(AVCodecContext *c2, void *arg2, int jobnr, int threadnr);
+	void *pArg;
+};
+
+static int RunCodecThreadJob(void *pArg, int job, int thread)
+{
+	CodecThreadJobs *pJobs = (CodecThreadJobs *)pArg;
+	return pJobs->func(pJobs->pCodecContext, pJobs->pArg, job, thread);
+}
+
+/** AVCodecContext.execute2 over the pool of the client in the context opaque. */
+static int ExecuteCodecJobs2(
+	AVCodecContext *c,
+	int (*func)(AVCodecContext *c2, void *arg2, int jobnr, int threadnr),
+	void *arg2,
+	int *ret,
+	int count
+) {
+	DecodeThreadPoolClient *pClient = (DecodeThreadPoolClient *)c->opaque;
+	CodecThreadJobs jobs = { c, func, arg2 };
+
+	return pClient->Execute2(RunCodecThreadJob, &jobs, ret, count, c->thread_count);
+}
+
+/**
+ * Runs the slice jobs of an opened codec on the pool, instead of the
+ * libavcodec slice threads it was opened without.
+ *
+ * execute2 jobs may share state by thread number, sized on thread_count:
+ * as with libavcodec slice threads, they start in order and at most
+ * thread_count run at once. With the thread_count of 1 the pool opens
+ * codecs with, they run one after the other on the decoding thread.
+ *
+ * Uses the context opaque, the codec must not have frame threads, whose
+ * contexts copy it.
+ */
+void DecodeThreadPoolClient::SetupCodec(AVCodecContext *pCodecContext)
+{
+	pCodecContext->opaque = this;
+	pCodecContext->execute = ExecuteCodecJobs;
+	pCodecContext->execute2 = ExecuteCodecJobs2;
+}
@@ -0,0 +1,212 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h> // AVCodecContext
+}
+
+namespace FFmpegPack {
+	/** Most workers of a DecodeThreadPool, like MAX_AUTO_THREADS in libavcodec. */
+	const int DECODE_POOL_MAX_THREADS = 16;
+
+	/** Most thread numbers of a batch, see DecodeThreadPoolClient::Execute2. */
+	const int DECODE_POOL_MAX_BATCH_THREADS = 64;
+
+	/**
+	 * A job of a batch, see DecodeThreadPoolClient::Execute.
+	 *
+	 * @param pArg  the argument of the batch.
+	 * @param job   the job index, from 0 to the job count of the batch.
+	 *
+	 * @return the job result, stored in the results of the batch.
+	 */
+	typedef int (*DecodeJobFn)(void *pArg, int job);
+
+	/**
+	 * A job of a batch with thread numbers, see DecodeThreadPoolClient::Execute2.
+	 *
+	 * @param thread  the thread number, from 0 to the thread count of the
+	 *                batch. No two jobs running at once have the same.
+	 */
+	typedef int (*DecodeThreadJobFn)(void *pArg, int job, int thread);
+
+	/** Counters of a DecodeThreadPool, see DecodeThreadPool::GetStats. */
+	struct DecodeThreadPoolStats
+	{
+		/** Batches executed. */
+		uint64_t batches;
+
+		/** Jobs run, by the callers and the workers. */
+		uint64_t jobs;
+
+		/** Jobs run by the workers, the rest ran on the thread executing the batch. */
+		uint64_t workerJobs;
+
+		/** Tasks idle workers took from the queue of another. */
+		uint64_t steals;
+
+		/** Workers running. */
+		int threads;
+
+		/** Clients attached. */
+		int clients;
+	};
+
+	class DecodeThreadPoolClient;
+
+	/** Jobs of one Execute call, split into tasks on the worker queues. */
+	struct DecodeThreadPoolBatch
+	{
+		DecodeJobFn pJob;
+		DecodeThreadJobFn pThreadJob;
+		void *pArg;
+		int *pResults;
+		int jobCount;
+
+		/**
+		 * Thread numbers of the jobs, 0 without. Such a batch stays one
+		 * task, its jobs start in order and at most this many run at once.
+		 */
+		int threadCount;
+
+		/** Thread numbers of the running jobs, one bit each. */
+		uint64_t busyThreads;
+
+		/** Jobs not finished yet, Execute returns once none are left. */
+		int pendingJobs;
+	};
+
+	/** Jobs of a batch left to start, nextJob to endJob excluded. */
+	struct DecodeThreadPoolTask
+	{
+		DecodeThreadPoolBatch *pBatch;
+		int nextJob;
+		int endJob;
+	};
+
+	/** A job taken from a task, see DecodeThreadPool::_TakeJob. */
+	struct DecodeThreadPoolJob
+	{
+		DecodeThreadPoolBatch *pBatch;
+		int job;
+		int thread;
+	};
+
+	/**
+	 * Process-wide workers shared by every decoder instance, against
+	 * oversubscription: each FFmpegDecoderMFT used to start one libavcodec
+	 * thread per core, and several streams decoding at once ran many times
+	 * more threads than the machine has cores.
+	 *
+	 * Instances attach as clients and execute batches of jobs (codec
+	 * slices, bands of a frame conversion). A batch is split into ranges of
+	 * jobs, one task on the queue of each worker. Workers run their own
+	 * queue first, the batches there taking turns job by job so a busy
+	 * instance does not starve the others, then steal from the queues of
+	 * the others, half of a range at a time. The thread executing a batch
+	 * runs its jobs too rather than wait idle.
+	 *
+	 * Frame threads keep their own libavcodec threads, each one holds a copy
+	 * of the codec context. Their count is a fair share of the pool instead,
+	 * see GetThreadShare.
+	 */
+	class DecodeThreadPool
+	{
+	public:
+		DecodeThreadPool();
+		~DecodeThreadPool();
+
+		static DecodeThreadPool &GetShared(void);
+
+		int SetMaxThreads(int maxThreads);
+		int GetMaxThreads(void);
+		int GetThreadShare(void);
+
+		DecodeThreadPoolClient *Attach(void);
+		void Detach(DecodeThreadPoolClient *pClient);
+
+		void GetStats(DecodeThreadPoolStats *pStats);
+
+	private:
+		friend class DecodeThreadPoolClient;
+
+		/** Guards everything below, jobs run without it. */
+		std::mutex m_mutex;
+
+		/** Serializes SetMaxThreads, which joins workers without m_mutex. */
+		std::mutex m_resizeMutex;
+
+		/** Signaled when tasks are queued or a thread number frees up, or workers must stop. */
+		std::condition_variable m_workCond;
+
+		/** Signaled when a job finishes the last one of its batch, or frees a thread number. */
+		std::condition_variable m_doneCond;
+
+		std::vector<std::thread> m_threads;
+		int m_maxThreads;
+
+		/**
+		 * Tasks of each worker, by worker index. The queues of stopped
+		 * workers are left to the others to steal.
+		 */
+		std::deque<DecodeThreadPoolTask> m_queues[DECODE_POOL_MAX_THREADS];
+
+		/** Queue of the first task of the next batch, batches start on each worker in turn. */
+		size_t m_nextQueue;
+
+		/** Clients attached. */
+		std::vector<DecodeThreadPoolClient *> m_clients;
+
+		// Statistics
+		uint64_t m_batches;
+		uint64_t m_jobs;
+		uint64_t m_workerJobs;
+		uint64_t m_steals;
+
+		// Methods
+		int _StartWorkers(void);
+		void _WorkerMain(int index);
+		int _Execute(
+			DecodeJobFn pJob,
+			DecodeThreadJobFn pThreadJob,
+			void *pArg,
+			int *pResults,
+			int jobCount,
+			int threadCount
+		);
+
+		bool _TakeJob(std::deque<DecodeThreadPoolTask> &queue, DecodeThreadPoolBatch *pBatch, DecodeThreadPoolJob *pJob);
+		bool _StealJob(int index, DecodeThreadPoolJob *pJob);
+		void _FinishJob(const DecodeThreadPoolJob &job, int result);
+	};
+
+	/**
+	 * One decoder instance of a DecodeThreadPool, from Attach to Detach.
+	 * Several threads of the instance may execute batches at the same time.
+	 */
+	class DecodeThreadPoolClient
+	{
+	public:
+		int Execute(DecodeJobFn pJob, void *pArg, int *pResults, int jobCount);
+		int Execute2(DecodeThreadJobFn pJob, void *pArg, int *pResults, int jobCount, int threadCount);
+		int GetThreadShare(void);
+
+		void SetupCodec(AVCodecContext *pCodecContext);
+
+	private:
+		friend class DecodeThreadPool;
+
+		DecodeThreadPoolClient(DecodeThreadPool *pPool);
+
+		DecodeThreadPool *m_pPool;
+	};
+};
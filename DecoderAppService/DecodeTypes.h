@@ -0,0 +1,100 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavformat/avformat.h> // AVPacket, AVFrame, AVCodecParameters
+}
+
+// Platform-neutral types shared by the decode engine and its adapters.
+// Nothing in here may depend on Media Foundation or C++/CX, so the
+// decode path can be built and measured outside of an app container.
+namespace FFmpegPack {
+
+	/** Uncompressed video description. */
+	struct VideoFormat
+	{
+		int width;
+		int height;
+		AVPixelFormat pixelFormat;
+
+		/** Full (0-255) instead of studio (16-235) luma range. */
+		bool fullRange;
+	};
+
+	/** Uncompressed audio description. */
+	struct AudioFormat
+	{
+		int sampleRate;
+		int channels;
+		uint64_t channelLayout;
+		AVSampleFormat sampleFormat;
+	};
+
+	/** Output description of a decode engine, only one of audio/video is used. */
+	struct MediaFormat
+	{
+		AVMediaType mediaType;
+		VideoFormat video;
+		AudioFormat audio;
+	};
+
+	/** Levels of DecodeEngine::GetSkipForLevel, 0 decodes everything. */
+	const int DECODE_SKIP_LEVELS = 6;
+
+	/**
+	 * Decoding shortcuts under CPU pressure, see DecodeEngine::SetSkip.
+	 * Zero-initialized (AVDISCARD_DEFAULT) decodes everything. Decoders
+	 * ignore the ones they do not implement.
+	 */
+	struct DecodeSkip
+	{
+		/** Frames not decoded at all, e.g. AVDISCARD_NONREF. */
+		AVDiscard skipFrame;
+
+		/** Frames decoded without the loop (deblocking) filter. */
+		AVDiscard skipLoopFilter;
+
+		/** Frames decoded without the inverse transform. */
+		AVDiscard skipIdct;
+	};
+
+	/** Tuning of a decode engine, zero-initialized defaults suit playback. */
+	struct DecodeOptions
+	{
+		/** Always convert video with swscale, even when a repack would do. */
+		bool forceScaler;
+
+		/** Decoding threads, 0 for one per core and 1 to decode on the caller thread. */
+		int threadCount;
+
+		/**
+		 * Output each frame as soon as its packet is decoded: slice threads
+		 * only, frame threads hold back one frame per extra thread.
+		 */
+		bool lowLatency;
+
+		/** Decoding shortcuts, changed while decoding with DecodeEngine::SetSkip. */
+		DecodeSkip skip;
+	};
+
+	/**
+	 * Caller-owned destination of a converted frame, the converter writes
+	 * straight into it.
+	 *
+	 * Video planes are stored one after the other, each row starting every
+	 * pitch bytes: NV12 has its interleaved UV plane at pData + pitch * height.
+	 */
+	struct FrameBuffer
+	{
+		uint8_t *pData;
+		size_t size;
+
+		/** Bytes from one row to the next, 0 for tightly packed rows. Video only. */
+		int pitch;
+	};
+}
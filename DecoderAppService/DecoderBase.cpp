@@ -19,6 +19,17 @@ DecoderBase::DecoderBase()
 
 	_pContext = ref new FFmpegContext();
 	_bFormatChange = false;
+	_bNativeFullRange = false;
+	_eDropMode = MF_DROP_MODE_NONE;
+	_eQualityLevel = MF_QUALITY_NORMAL;
+	_DecodeOptions = {};
+	_cOutputQueueDepth = FFMPEG_OUTPUT_QUEUE_SIZE;
+
+	// Lets the pipeline set MF_LOW_LATENCY, and unlock asynchronous mode
+	MFCreateAttributes(&_spAttributes, 2);
+
+	if (_spAttributes)
+		_spAttributes->SetUINT32(MF_TRANSFORM_ASYNC, TRUE);
 
 	AddRef();
 }
@@ -201,7 +212,18 @@ STDMETHODIMP DecoderBase::DeleteInputStream(__in DWORD dwStreamID)
 STDMETHODIMP DecoderBase::GetAttributes(
 	__deref_out IMFAttributes ** ppAttributes
 ) {
-	return E_NOTIMPL;
+	HRESULT hr = (ppAttributes) ? S_OK : E_POINTER;
+
+	if (SUCCEEDED(hr) && !_spAttributes)
+		hr = E_OUTOFMEMORY;
+
+	if (SUCCEEDED(hr))
+	{
+		*ppAttributes = _spAttributes;
+		(*ppAttributes)->AddRef();
+	}
+
+	return hr;
 }
 
 STDMETHODIMP DecoderBase::GetInputAvailableType(
@@ -300,9 +322,14 @@ STDMETHODIMP DecoderBase::GetInputStatus(
 			hr = MF_E_TRANSFORM_TYPE_NOT_SET;
 
 		
-		// TODO: read input status from FFmpegContext
+		// Refused while the output queue is full, see FFMPEG_OUTPUT_QUEUE_SIZE
 		if (SUCCEEDED(hr))
-			*pdwFlags = MFT_INPUT_STATUS_ACCEPT_DATA;
+		{
+			bool bAccept = !_bFormatChange
+				&& (!_pContext->HasInitialized() || _pContext->CanAcceptInput());
+
+			*pdwFlags = (bAccept) ? MFT_INPUT_STATUS_ACCEPT_DATA : 0;
+		}
 	}
 
 	LeaveCriticalSection(&_pcsLock);
@@ -354,12 +381,7 @@ STDMETHODIMP DecoderBase::GetOutputAvailableType(
 		else if (!_spInputType)
 			hr = MF_E_TRANSFORM_TYPE_NOT_SET;
 
-		else if (m_guidMajorType == MFMediaType_Audio
-			&& dwTypeIndex >= ARRAYSIZE(FFMPEG_MFTYPES_OUTPUT_AUDIO))
-			hr = MF_E_NO_MORE_TYPES;
-
-		else if (m_guidMajorType == MFMediaType_Video
-			&& dwTypeIndex >= ARRAYSIZE(FFMPEG_MFTYPES_OUTPUT_VIDEO))
+		else if (dwTypeIndex >= _OutputSubtypes.GetCount())
 			hr = MF_E_NO_MORE_TYPES;
 	}
 
@@ -378,18 +400,16 @@ STDMETHODIMP DecoderBase::GetOutputAvailableType(
 	if (SUCCEEDED(hr))
 		hr = spType->SetGUID(MF_MT_MAJOR_TYPE, m_guidMajorType);
 
+	// Cheapest type for the decoder first, see _UpdateOutputSubtypes
+	if (SUCCEEDED(hr))
+		hr = spType->SetGUID(MF_MT_SUBTYPE, _OutputSubtypes[dwTypeIndex]);
+
 	if (SUCCEEDED(hr))
 	{
 		if (m_guidMajorType == MFMediaType_Audio)
-		{
-			hr = spType->SetGUID(MF_MT_SUBTYPE, FFMPEG_MFTYPES_OUTPUT_AUDIO[dwTypeIndex]);
-			if (SUCCEEDED(hr)) hr = _SetOutputTypeAudioProperties(spType);
-		}
+			hr = _SetOutputTypeAudioProperties(spType);
 		else
-		{
-			hr = spType->SetGUID(MF_MT_SUBTYPE, FFMPEG_MFTYPES_OUTPUT_VIDEO[dwTypeIndex]);
-			if (SUCCEEDED(hr)) hr = _SetOutputTypeVideoProperties(spType);
-		}
+			hr = _SetOutputTypeVideoProperties(spType);
 	}
 
 	if (SUCCEEDED(hr))
@@ -436,9 +456,9 @@ STDMETHODIMP DecoderBase::GetOutputStatus(__out DWORD * pdwFlags)
 		if (FAILED(IsOutputTypeSet(&vtbOutputSet)) || VARIANT_FALSE == vtbOutputSet)
 			hr = MF_E_TRANSFORM_TYPE_NOT_SET;
 
-		// TODO: get output status from FFmpegContext
-		//if (SUCCEEDED(hr))
-		//	*pdwFlags = (_dwOutputRequests) ? MFT_OUTPUT_STATUS_SAMPLE_READY : 0;
+		// Decoder delay: input may not produce output right away
+		if (SUCCEEDED(hr))
+			*pdwFlags = (_pContext->HasNextSample()) ? MFT_OUTPUT_STATUS_SAMPLE_READY : 0;
 	}
 
 	LeaveCriticalSection(&_pcsLock);
@@ -477,15 +497,18 @@ STDMETHODIMP DecoderBase::GetOutputStreamInfo(
 	{
 		// width and height
 		UINT32 width, height;
+		GUID subType;
 		if (SUCCEEDED(hr))
 			hr = MFGetAttributeSize(_spOutputType, MF_MT_FRAME_SIZE, &width, &height);
 
 		if (SUCCEEDED(hr))
-		{
-			// ONLY WORKS FOR 12BPP - could change if needed.
-			pStreamInfo->cbSize = (width * height * (FFMPEG_OUTPUT_BITS_PER_PIXEL / 8.0));
+			hr = _spOutputType->GetGUID(MF_MT_SUBTYPE, &subType);
+
+		if (SUCCEEDED(hr))
+			hr = MFCalculateImageSize(subType, width, height, (UINT32 *)&pStreamInfo->cbSize);
+
+		if (SUCCEEDED(hr))
 			pStreamInfo->dwFlags = MFT_OUTPUT_STREAM_WHOLE_SAMPLES;
-		}
 	}
 	else
 	{
@@ -497,9 +520,10 @@ STDMETHODIMP DecoderBase::GetOutputStreamInfo(
 			| MFT_OUTPUT_STREAM_PROVIDES_SAMPLES;
 	}
 
+	// Lets the converter use aligned SIMD stores on pipeline buffers
 	if (SUCCEEDED(hr))
 	{
-		pStreamInfo->cbAlignment = 0;
+		pStreamInfo->cbAlignment = FFMPEG_OUTPUT_ALIGNMENT;
 	}
 
 	LeaveCriticalSection(&_pcsLock);
@@ -636,6 +660,9 @@ STDMETHODIMP DecoderBase::SetInputType(
 		if (!_spInputType)
 			hr = E_UNEXPECTED;
 
+		if (SUCCEEDED(hr))
+			hr = _UpdateOutputSubtypes();
+
 		if (SUCCEEDED(hr))
 		{
 			// Rebuild context - handles input type changes
@@ -716,14 +743,203 @@ STDMETHODIMP DecoderBase::SetOutputType(
 	return hr;
 }
 
+///////////////////////////////////////////////////////////
+//   IMFQualityAdvise Interface
+///////////////////////////////////////////////////////////
+
+/**
+ * Sets how many frames the decoder may skip when the pipeline falls behind,
+ * see DecodeEngine::GetSkipForLevel. Takes effect from the next packet.
+ */
+STDMETHODIMP DecoderBase::SetDropMode(__in MF_QUALITY_DROP_MODE eDropMode)
+{
+	if (eDropMode < MF_DROP_MODE_NONE || eDropMode > MF_DROP_MODE_5)
+		return MF_E_NO_MORE_DROP_MODES;
+
+	EnterCriticalSection(&_pcsLock);
+
+	_eDropMode = eDropMode;
+	HRESULT hr = _UpdateDecodeSkip();
+
+	LeaveCriticalSection(&_pcsLock);
+
+	return hr;
+}
+
+/** Sets how much decoding quality may be traded for speed, without skipping frames. */
+STDMETHODIMP DecoderBase::SetQualityLevel(__in MF_QUALITY_LEVEL eQualityLevel)
+{
+	if (eQualityLevel < MF_QUALITY_NORMAL || eQualityLevel > MF_QUALITY_NORMAL_MINUS_5)
+		return MF_E_NO_MORE_QUALITY_LEVELS;
+
+	EnterCriticalSection(&_pcsLock);
+
+	_eQualityLevel = eQualityLevel;
+	HRESULT hr = _UpdateDecodeSkip();
+
+	LeaveCriticalSection(&_pcsLock);
+
+	return hr;
+}
+
+STDMETHODIMP DecoderBase::GetDropMode(__out MF_QUALITY_DROP_MODE *peDropMode)
+{
+	if (!peDropMode)
+		return E_POINTER;
+
+	EnterCriticalSection(&_pcsLock);
+	*peDropMode = _eDropMode;
+	LeaveCriticalSection(&_pcsLock);
+
+	return S_OK;
+}
+
+STDMETHODIMP DecoderBase::GetQualityLevel(__out MF_QUALITY_LEVEL *peQualityLevel)
+{
+	if (!peQualityLevel)
+		return E_POINTER;
+
+	EnterCriticalSection(&_pcsLock);
+	*peQualityLevel = _eQualityLevel;
+	LeaveCriticalSection(&_pcsLock);
+
+	return S_OK;
+}
+
+/**
+ * Drops the next hnsAmountToDrop of video output. The frames are still
+ * decoded, as later ones may depend on them, but neither converted nor
+ * delivered.
+ */
+STDMETHODIMP DecoderBase::DropTime(__in LONGLONG hnsAmountToDrop)
+{
+	EnterCriticalSection(&_pcsLock);
+
+	HRESULT hr = _CheckShutdown();
+
+	if (SUCCEEDED(hr) && m_guidMajorType != MFMediaType_Video)
+		hr = MF_E_DROPTIME_NOT_SUPPORTED;
+
+	if (SUCCEEDED(hr) && hnsAmountToDrop > 0)
+		_pContext->DropTime(hnsAmountToDrop);
+
+	LeaveCriticalSection(&_pcsLock);
+
+	return hr;
+}
+
+/**
+ * Catches up when the renderer reports that samples arrive late
+ * (MF_QUALITY_NOTIFY_SAMPLE_LAG): the lag is dropped, see DropTime.
+ * Drop mode and quality level are left to the quality manager.
+ */
+STDMETHODIMP DecoderBase::NotifyQualityEvent(__in IMFMediaEvent *pEvent, __out DWORD *pdwFlags)
+{
+	HRESULT hr = (pEvent && pdwFlags) ? S_OK : E_POINTER;
+	MediaEventType meType = MEUnknown;
+	GUID guidExtendedType = GUID_NULL;
+	PROPVARIANT value;
+
+	PropVariantInit(&value);
+
+	if (SUCCEEDED(hr))
+	{
+		*pdwFlags = 0;
+		hr = pEvent->GetType(&meType);
+	}
+
+	if (SUCCEEDED(hr) && meType == MEQualityNotify)
+		hr = pEvent->GetExtendedType(&guidExtendedType);
+
+	if (SUCCEEDED(hr) && guidExtendedType == MF_QUALITY_NOTIFY_SAMPLE_LAG)
+		hr = pEvent->GetValue(&value);
+
+	if (SUCCEEDED(hr) && value.vt == VT_I8 && value.hVal.QuadPart > 0)
+	{
+		hr = DropTime(value.hVal.QuadPart);
+
+		// Audio keeps up by itself
+		if (hr == MF_E_DROPTIME_NOT_SUPPORTED)
+			hr = S_OK;
+	}
+
+	PropVariantClear(&value);
+
+	return hr;
+}
+
+
 ///////////////////////////////////////////////////////////
 //   IMediaExtension Methods
 ///////////////////////////////////////////////////////////
 
+/**
+ * Reads an Int32 extension property.
+ *
+ * @return S_OK if set, S_FALSE if absent, E_INVALIDARG if not an Int32
+ *         of at least minimum.
+ */
+static HRESULT GetInt32Property(
+	Windows::Foundation::Collections::IPropertySet^ properties,
+	const wchar_t *key,
+	int minimum,
+	int *pValue
+) {
+	if (!properties->HasKey(ref new Platform::String(key)))
+		return S_FALSE;
+
+	auto value = dynamic_cast<Windows::Foundation::IPropertyValue^>(properties->Lookup(ref new Platform::String(key)));
+
+	if (!value || value->Type != Windows::Foundation::PropertyType::Int32 || value->GetInt32() < minimum)
+		return E_INVALIDARG;
+
+	*pValue = value->GetInt32();
+	return S_OK;
+}
+
+/**
+ * Reads the decoder settings passed when registering the extension:
+ *    "ThreadCount"       Int32, decoding threads. 0 (default) for the threads
+ *                        shared by all decoders, see DecodeThreadPool.
+ *    "OutputQueueDepth"  Int32, most decoded frames waiting for output,
+ *                        FFMPEG_OUTPUT_QUEUE_SIZE by default.
+ *    "PoolThreadCount"   Int32, most shared decoding threads in the process,
+ *                        for all decoders. 0 (default) for one per core.
+ */
 STDMETHODIMP DecoderBase::SetProperties(
 	__RPC__in_opt ABI::Windows::Foundation::Collections::IPropertySet * configuration
 ) {
-	return S_OK;
+	if (!configuration)
+		return S_OK;
+
+	auto properties = reinterpret_cast<Windows::Foundation::Collections::IPropertySet^>(configuration);
+	int threadCount = _DecodeOptions.threadCount;
+	int queueDepth = (int)_cOutputQueueDepth;
+	int poolThreads = 0;
+
+	HRESULT hr = GetInt32Property(properties, FFMPEG_PROPERTY_THREAD_COUNT, 0, &threadCount);
+
+	if (SUCCEEDED(hr))
+		hr = GetInt32Property(properties, FFMPEG_PROPERTY_QUEUE_DEPTH, 1, &queueDepth);
+
+	if (SUCCEEDED(hr))
+		hr = GetInt32Property(properties, FFMPEG_PROPERTY_POOL_THREADS, 0, &poolThreads);
+
+	// Process-wide, the last decoder registered with it wins
+	if (hr == S_OK && DecodeThreadPool::GetShared().SetMaxThreads(poolThreads) < 0)
+		hr = E_OUTOFMEMORY;
+
+	if (SUCCEEDED(hr))
+	{
+		EnterCriticalSection(&_pcsLock);
+		_DecodeOptions.threadCount = threadCount;
+		_cOutputQueueDepth = queueDepth;
+		LeaveCriticalSection(&_pcsLock);
+
+		hr = S_OK;
+	}
+
+	return hr;
 }
 
 ///////////////////////////////////////////////////////////
@@ -737,7 +953,7 @@ STDMETHODIMP DecoderBase::GetIids(
 
 	if(SUCCEEDED(hr))
 	{
-		*iidCount = 6;
+		*iidCount = 8;
 		*iids = (IID *) CoTaskMemAlloc(sizeof(IID) * (*iidCount));
 		if (iids == nullptr) hr = E_OUTOFMEMORY;
 	}
@@ -750,6 +966,8 @@ STDMETHODIMP DecoderBase::GetIids(
 		(*iids)[3] = IID_IMFShutdown;
 		(*iids)[4] = IID_IInspectable;
 		(*iids)[5] = __uuidof(ABI::Windows::Media::IMediaExtension);
+		(*iids)[6] = IID_IMFQualityAdvise;
+		(*iids)[7] = IID_IMFQualityAdvise2;
 	}
 
 	return hr;
@@ -891,25 +1109,175 @@ HRESULT DecoderBase::ValidateOutputType(IMFMediaType *pType)
 	if (SUCCEEDED(hr) && newMajorType != m_guidMajorType)
 		hr = MF_E_INVALIDMEDIATYPE;
 
+	// Only types the transform helpers can produce
+	if (SUCCEEDED(hr))
+	{
+		int foundSubType;
+		if (newMajorType == MFMediaType_Audio)
+			ARRAYFIND(FFMPEG_MFTYPES_OUTPUT_AUDIO, newSubType, &foundSubType);
+		else
+			ARRAYFIND(FFMPEG_MFTYPES_OUTPUT_VIDEO, newSubType, &foundSubType);
+
+		if (foundSubType < 0) hr = MF_E_INVALIDMEDIATYPE;
+	}
+
 	// TODO: further parameter/format validation?
 	
 	return hr;
 }
 
 /**
- * Sets the output properties to uncompressed float wave audio,
- * based on the settings of the compressed input audio.
+ * The decode engine settings: the extension properties, and low latency
+ * when the pipeline asks for it on the transform or the input type.
+ */
+HRESULT DecoderBase::_GetDecodeOptions(DecodeOptions *pOptions)
+{
+	HRESULT hr = (pOptions) ? S_OK : E_POINTER;
+
+	if (SUCCEEDED(hr))
+	{
+		*pOptions = _DecodeOptions;
+		_GetDecodeSkip(&pOptions->skip);
+
+		pOptions->lowLatency = (_spAttributes && MFGetAttributeUINT32(_spAttributes, MF_LOW_LATENCY, FALSE))
+			|| (_spInputType && MFGetAttributeUINT32(_spInputType, MF_LOW_LATENCY, FALSE));
+	}
+
+	return hr;
+}
+
+/**
+ * Decoding shortcuts for the current drop mode and quality level, each
+ * mapped onto a level of DecodeEngine::GetSkipForLevel. The stronger of
+ * the two applies.
+ */
+void DecoderBase::_GetDecodeSkip(DecodeSkip *pSkip)
+{
+	DecodeSkip drop, degrade;
+
+	DecodeEngine::GetSkipForLevel((int)_eDropMode, true, &drop);
+	DecodeEngine::GetSkipForLevel((int)_eQualityLevel, false, &degrade);
+
+	pSkip->skipFrame = FFMAX(drop.skipFrame, degrade.skipFrame);
+	pSkip->skipLoopFilter = FFMAX(drop.skipLoopFilter, degrade.skipLoopFilter);
+	pSkip->skipIdct = FFMAX(drop.skipIdct, degrade.skipIdct);
+}
+
+/** Applies the drop mode and quality level to the running decoder. Caller holds the lock. */
+HRESULT DecoderBase::_UpdateDecodeSkip()
+{
+	HRESULT hr = _CheckShutdown();
+	DecodeSkip skip;
+
+	_GetDecodeSkip(&skip);
+
+	if (SUCCEEDED(hr))
+		hr = _pContext->SetSkip(skip);
+
+	return hr;
+}
+
+/**
+ * Orders the output subtypes of the build, cheapest to produce from the
+ * native decoder output first. Ties keep the build configuration order,
+ * which is also the fallback when the decoder cannot be probed.
+ */
+HRESULT DecoderBase::_UpdateOutputSubtypes()
+{
+	HRESULT hr = (_spInputType) ? S_OK : MF_E_TRANSFORM_TYPE_NOT_SET;
+
+	AVCodecParameters *pCodecParams = nullptr;
+	CComPtr<IMFMediaType> spNoOutputType;
+	MediaFormat nativeFormat = {};
+	MediaFormat outputFormat = {};
+	CAtlArray<int> costs;
+
+	nativeFormat.video.pixelFormat = AV_PIX_FMT_NONE;
+	nativeFormat.audio.sampleFormat = AV_SAMPLE_FMT_NONE;
+	outputFormat.mediaType = (m_guidMajorType == MFMediaType_Audio) ? AVMEDIA_TYPE_AUDIO : AVMEDIA_TYPE_VIDEO;
+
+	_OutputSubtypes.RemoveAll();
+
+	if (SUCCEEDED(hr))
+	{
+		pCodecParams = avcodec_parameters_alloc();
+		if (!pCodecParams) hr = E_OUTOFMEMORY;
+	}
+
+	// No output type yet, the decoder picks its own format
+	if (SUCCEEDED(hr))
+		hr = MFCreateMediaType(&spNoOutputType);
+
+	if (SUCCEEDED(hr)
+		&& SUCCEEDED(FFmpegTypes::CodecParamsFromMediaType(pCodecParams, _spInputType, spNoOutputType)))
+	{
+		DecodeEngine::ProbeNativeFormat(pCodecParams, &nativeFormat);
+	}
+
+	if (pCodecParams)
+		avcodec_parameters_free(&pCodecParams);
+
+	_bNativeFullRange = nativeFormat.video.fullRange;
+
+	size_t count = (outputFormat.mediaType == AVMEDIA_TYPE_AUDIO)
+		? ARRAYSIZE(FFMPEG_MFTYPES_OUTPUT_AUDIO)
+		: ARRAYSIZE(FFMPEG_MFTYPES_OUTPUT_VIDEO);
+
+	// Stable insertion sort, there are only a few types
+	for (size_t i = 0; SUCCEEDED(hr) && i < count; i++)
+	{
+		GUID subType;
+		if (outputFormat.mediaType == AVMEDIA_TYPE_AUDIO)
+		{
+			subType = FFMPEG_MFTYPES_OUTPUT_AUDIO[i];
+			outputFormat.audio.sampleFormat = FFMPEG_AVTYPES_OUTPUT_AUDIO[i];
+		}
+		else
+		{
+			subType = FFMPEG_MFTYPES_OUTPUT_VIDEO[i];
+			outputFormat.video.pixelFormat = FFMPEG_AVTYPES_OUTPUT_VIDEO[i];
+		}
+
+		int cost = DecodeEngine::GetConversionCost(nativeFormat, outputFormat);
+
+		size_t position = costs.GetCount();
+		while (position > 0 && costs[position - 1] > cost)
+			position--;
+
+		costs.InsertAt(position, cost);
+		_OutputSubtypes.InsertAt(position, subType);
+	}
+
+	return hr;
+}
+
+/**
+ * Sets the output properties to uncompressed wave audio of the subtype
+ * already set, based on the settings of the compressed input audio.
  */
 HRESULT DecoderBase::_SetOutputTypeAudioProperties(IMFMediaType *pType)
 {
 	HRESULT hr = (pType) ? S_OK : E_POINTER;
-	UINT32 sampleRate, channelCount;
+	UINT32 sampleRate, channelCount, bytesPerSample = 0;
+	GUID subType;
 
 	// Get input parameters
 	
 	if (SUCCEEDED(hr))
 		hr = _spInputType->GetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, &sampleRate);
 
+	if (SUCCEEDED(hr))
+		hr = pType->GetGUID(MF_MT_SUBTYPE, &subType);
+
+	if (SUCCEEDED(hr))
+	{
+		AVSampleFormat sampleFormat = AV_SAMPLE_FMT_NONE;
+		ARRAYTRANSLATE(FFMPEG_MFTYPES_OUTPUT_AUDIO, FFMPEG_AVTYPES_OUTPUT_AUDIO, subType, sampleFormat);
+
+		bytesPerSample = av_get_bytes_per_sample(sampleFormat);
+		if (bytesPerSample == 0) hr = MF_E_INVALIDMEDIATYPE;
+	}
+
 	if (SUCCEEDED(hr))
 		hr = _spInputType->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &channelCount);
 
@@ -922,10 +1290,10 @@ HRESULT DecoderBase::_SetOutputTypeAudioProperties(IMFMediaType *pType)
 		hr = pType->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, channelCount);
 
 	if (SUCCEEDED(hr))
-		hr = pType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, sizeof(float) * 8);
+		hr = pType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, bytesPerSample * 8);
 
 	if (SUCCEEDED(hr))
-		hr = pType->SetUINT32(MF_MT_AUDIO_VALID_BITS_PER_SAMPLE, sizeof(float) * 8);
+		hr = pType->SetUINT32(MF_MT_AUDIO_VALID_BITS_PER_SAMPLE, bytesPerSample * 8);
 
 	if (SUCCEEDED(hr))
 	{
@@ -943,10 +1311,10 @@ HRESULT DecoderBase::_SetOutputTypeAudioProperties(IMFMediaType *pType)
 	
 
 	if (SUCCEEDED(hr))
-		hr = pType->SetUINT32(MF_MT_AUDIO_AVG_BYTES_PER_SECOND, sizeof(float) * channelCount * sampleRate);
+		hr = pType->SetUINT32(MF_MT_AUDIO_AVG_BYTES_PER_SECOND, bytesPerSample * channelCount * sampleRate);
 
 	if (SUCCEEDED(hr))
-		hr = pType->SetUINT32(MF_MT_AUDIO_BLOCK_ALIGNMENT, sizeof(float) * channelCount);
+		hr = pType->SetUINT32(MF_MT_AUDIO_BLOCK_ALIGNMENT, bytesPerSample * channelCount);
 
 	if (SUCCEEDED(hr))
 		hr = pType->SetUINT32(MF_MT_ALL_SAMPLES_INDEPENDENT, TRUE);
@@ -977,8 +1345,24 @@ HRESULT DecoderBase::_SetOutputTypeVideoProperties(IMFMediaType *pType)
 		hr = pType->SetUINT64(MF_MT_FRAME_RATE, frameRate);
 		
 	if (SUCCEEDED(MFGetAttributeSize(_spInputType, MF_MT_FRAME_SIZE, &frameWidth, &frameHeight)))
+	{
 		hr = MFSetAttributeSize(pType, MF_MT_FRAME_SIZE, frameWidth, frameHeight);
 
+		// Top-down, RGB types would be bottom-up otherwise
+		GUID subType;
+		LONG stride;
+		if (SUCCEEDED(hr)
+			&& SUCCEEDED(pType->GetGUID(MF_MT_SUBTYPE, &subType))
+			&& SUCCEEDED(MFGetStrideForBitmapInfoHeader(subType.Data1, frameWidth, &stride)))
+		{
+			hr = pType->SetUINT32(MF_MT_DEFAULT_STRIDE, (UINT32)abs(stride));
+		}
+	}
+
+	// Full range decoders (e.g. Fraps YUVJ420P) can then be repacked as is
+	if (SUCCEEDED(hr) && _bNativeFullRange)
+		hr = pType->SetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, MFNominalRange_0_255);
+
 	//if (SUCCEEDED(MFGetAttributeRatio(_spInputType, MF_MT_PIXEL_ASPECT_RATIO, &ratioNum, &ratioDenom)))
 	//	hr = MFSetAttributeRatio(_spInputType, MF_MT_PIXEL_ASPECT_RATIO, ratioNum, ratioDenom);
 	
@@ -20,6 +20,7 @@ namespace FFmpegPack {
 		public IMFTransform,
 		public IMFMediaEventGenerator,
 		public IMFShutdown,
+		public IMFQualityAdvise2,
 		public ABI::Windows::Media::IMediaExtension
 	{
 	public:
@@ -44,6 +45,9 @@ namespace FFmpegPack {
 			else if (riid == IID_IMFShutdown)
 				*outInterface = reinterpret_cast<IMFShutdown*>(this);
 
+			else if (riid == IID_IMFQualityAdvise || riid == IID_IMFQualityAdvise2)
+				*outInterface = static_cast<IMFQualityAdvise2*>(this);
+
 			else if (riid == IID_IInspectable
 				|| riid == __uuidof(ABI::Windows::Media::IMediaExtension))
 				*outInterface = reinterpret_cast<ABI::Windows::Media::IMediaExtension*>(this);
@@ -88,6 +92,16 @@ namespace FFmpegPack {
 		virtual STDMETHODIMP GetShutdownStatus(__out MFSHUTDOWN_STATUS * pStatus);
 		virtual STDMETHODIMP Shutdown();
 
+		///////////////////////////////////////////////////////////
+		//   IMFQualityAdvise2 Interface
+		///////////////////////////////////////////////////////////
+		virtual STDMETHODIMP SetDropMode(__in MF_QUALITY_DROP_MODE eDropMode);
+		virtual STDMETHODIMP SetQualityLevel(__in MF_QUALITY_LEVEL eQualityLevel);
+		virtual STDMETHODIMP GetDropMode(__out MF_QUALITY_DROP_MODE *peDropMode);
+		virtual STDMETHODIMP GetQualityLevel(__out MF_QUALITY_LEVEL *peQualityLevel);
+		virtual STDMETHODIMP DropTime(__in LONGLONG hnsAmountToDrop);
+		virtual STDMETHODIMP NotifyQualityEvent(__in IMFMediaEvent *pEvent, __out DWORD *pdwFlags);
+
 		///////////////////////////////////////////////////////////
 		//   IMFTransform Interface
 		///////////////////////////////////////////////////////////
@@ -156,6 +170,15 @@ namespace FFmpegPack {
 		/** Specific values to return on GetOutputAvailableType */
 		CComPtr<IMFMediaType> _spSuggestedOutputType;
 
+		/** Transform attributes, set by the pipeline. */
+		CComPtr<IMFAttributes> _spAttributes;
+
+		/** Decoder settings from SetProperties. */
+		DecodeOptions _DecodeOptions;
+
+		/** Most decoded frames waiting for ProcessOutput, from SetProperties. */
+		size_t _cOutputQueueDepth;
+
 		/** The current major type, either audio or video. */
 		GUID m_guidMajorType;
 
@@ -165,6 +188,18 @@ namespace FFmpegPack {
 		/** Signals format change that requires rebuilding of the FFmpeg Context. */
 		boolean _bFormatChange;
 
+		/** Output subtypes offered for the current input, cheapest first. */
+		CAtlArray<GUID> _OutputSubtypes;
+
+		/** The decoder produces full range video, offered types say so. */
+		bool _bNativeFullRange;
+
+		/** Frames the decoder may skip, set by the quality manager. */
+		MF_QUALITY_DROP_MODE _eDropMode;
+
+		/** Decoding quality traded for speed, set by the quality manager. */
+		MF_QUALITY_LEVEL _eQualityLevel;
+
 
 
 		///////////////////////////////////////////////////////////
@@ -207,6 +242,10 @@ namespace FFmpegPack {
 		HRESULT ValidateInputType(IMFMediaType *pType);
 		HRESULT ValidateOutputType(IMFMediaType *pType);
 
+		HRESULT _GetDecodeOptions(DecodeOptions *pOptions);
+		void _GetDecodeSkip(DecodeSkip *pSkip);
+		HRESULT _UpdateDecodeSkip(void);
+		HRESULT _UpdateOutputSubtypes(void);
 		HRESULT _SetOutputTypeAudioProperties(IMFMediaType * pType);
 		HRESULT _SetOutputTypeVideoProperties(IMFMediaType * pType);
 	};
@@ -5,110 +5,185 @@
 #include <mferror.h> // MF_E_*
 
 #include "FFmpegContext.h"
-#include "AudioTransformHelper.h"
-#include "VideoTransformHelper.h"
 
 using namespace FFmpegPack;
 
 FFmpegContext::FFmpegContext() :
-	m_Codec(nullptr),
-	m_CodecContext(nullptr),
-	m_bFormatChange(false)
+	m_pOutputType(nullptr),
+	m_pInputType(nullptr),
+	m_pEngine(nullptr),
+	m_pSamplePool(nullptr),
+	m_bFormatChange(false),
+	m_bDraining(false),
+	m_bDrained(false),
+	m_frameWidth(0),
+	m_frameHeight(0),
+	m_dropRequest(0),
+	m_dropUntil(AV_NOPTS_VALUE),
+	m_cFramesOutput(0),
+	m_cFramesDropped(0)
 {
-
-
+	InitializeCriticalSection(&m_csDecoder);
 }
 
 FFmpegContext::~FFmpegContext()
 {
-	if (m_pCodecParams)
-		avcodec_parameters_free(&m_pCodecParams);
+	FrameQueueStats stats;
+	m_OutputQueue.GetStats(&stats);
 
-	if (m_CodecContext)
-		avcodec_free_context(&m_CodecContext);
+	_RPT4(_CRT_WARN, "FrameQueue: %I64u frames, %.2f mean occupancy, %Iu high-water, %I64u full\n",
+		stats.pushes,
+		(stats.pushes) ? (double)stats.occupancySum / stats.pushes : 0.0,
+		stats.highWater,
+		stats.fullCount);
 
-	if (m_pFrame)
-	{
-		av_frame_unref(m_pFrame);
-		av_freep(m_pFrame);
-	}
+	_RPT2(_CRT_WARN, "FFmpegContext: %I64u frames output, %I64u late frames dropped\n",
+		m_cFramesOutput, m_cFramesDropped);
 
-	if (m_TransformHelper)
-		delete m_TransformHelper;
+	m_OutputQueue.Clear();
 
-	IMFSample *pSample = nullptr;
-	while (!m_OutputQueue.IsEmpty())
+	if (m_pEngine)
+		delete m_pEngine;
+
+	// Samples still downstream keep the pool alive until they come back
+	if (m_pSamplePool)
 	{
-		 pSample = m_OutputQueue.RemoveHead();
-		 pSample->Release();
+		m_pSamplePool->Shutdown();
+		m_pSamplePool->Release();
 	}
+
+	if (m_pInputType)
+		m_pInputType->Release();
+
+	if (m_pOutputType)
+		m_pOutputType->Release();
+
+	DeleteCriticalSection(&m_csDecoder);
 }
 
 /**
  * Allocate all resources for decoding based on the set input
  * and output types.
+ *
+ * @param options     the decoder threading and latency settings.
+ * @param queueDepth  the most decoded frames waiting for ProcessOutput.
  */
 HRESULT FFmpegContext::Initialize(
 	_In_    IMFMediaType *inputType, 
-	_Inout_ IMFMediaType *outputType
+	_Inout_ IMFMediaType *outputType,
+	const DecodeOptions &options,
+	size_t queueDepth
 ) {
 	HRESULT hr = (inputType && outputType) ? S_OK : E_POINTER;
 
-	m_pInputType = inputType;
-	m_pOutputType = outputType;
-	
-	// Find codec
-	GUID inputMajorType, inputSubType;
-
-	if (SUCCEEDED(hr))
-		hr = inputType->GetGUID(MF_MT_MAJOR_TYPE, &inputMajorType);
-
+	// Kept while in use, the MFT replaces its own on type changes
 	if (SUCCEEDED(hr))
-		hr = inputType->GetGUID(MF_MT_SUBTYPE, &inputSubType);
+	{
+		m_pInputType = inputType;
+		m_pInputType->AddRef();
 
-	if (FAILED(hr)) return hr;
+		m_pOutputType = outputType;
+		m_pOutputType->AddRef();
+	}
 
+	AVCodecParameters *pCodecParams = nullptr;
+	MediaFormat outputFormat;
 
 	if (SUCCEEDED(hr))
 	{
-		m_pCodecParams = avcodec_parameters_alloc();
-		if (!m_pCodecParams) hr = E_OUTOFMEMORY;
+		pCodecParams = avcodec_parameters_alloc();
+		if (!pCodecParams) hr = E_OUTOFMEMORY;
 	}
 
 	if (SUCCEEDED(hr))
-		hr = FFmpegTypes::CodecParamsFromMediaType(m_pCodecParams, inputType, outputType);
+		hr = FFmpegTypes::CodecParamsFromMediaType(pCodecParams, inputType, outputType);
 
-	if(SUCCEEDED(hr))
-	{
-		AVCodecID inputCodecID = m_pCodecParams->codec_id;
-		m_Codec = avcodec_find_decoder(inputCodecID);
+	if (SUCCEEDED(hr))
+		hr = FFmpegTypes::MediaFormatFromMediaType(&outputFormat, outputType);
 
-		if (!m_Codec) hr = E_OUTOFMEMORY;
+	if (SUCCEEDED(hr))
+	{
+		m_pEngine = new DecodeEngine();
+		if (!m_pEngine) hr = E_OUTOFMEMORY;
 	}
 
 	if (SUCCEEDED(hr))
-		hr = _CreateCodecContext();
+		hr = FFmpegTypes::HResultFromAVError(m_pEngine->Open(pCodecParams, outputFormat, options));
 
 	if (SUCCEEDED(hr))
+		hr = FFmpegTypes::HResultFromAVError(m_OutputQueue.Initialize(queueDepth));
+
+	if (SUCCEEDED(hr))
+		hr = SamplePool::CreateInstance(FFMPEG_OUTPUT_POOL_SIZE, &m_pSamplePool);
+
+	// The decoder may disagree with the negotiated frame size.
+	if (SUCCEEDED(hr) && m_pEngine->HasOutputChanged())
 	{
-		if (inputMajorType == MFMediaType_Video && _VideoUpdateOutput(outputType))
-			QueueFormatChange();
+		const VideoFormat &video = m_pEngine->GetOutputFormat().video;
+		hr = _SetOutputFrameSize(video.width, video.height);
+
+		// Calls in this block are NOT expected to fail.
+		_ASSERT(SUCCEEDED(hr));
+		QueueFormatChange();
 	}
 
 	if (SUCCEEDED(hr))
 	{
-		if (inputMajorType == MFMediaType_Audio)
-			m_TransformHelper = ref new AudioTransformHelper();
-		else
-			m_TransformHelper = ref new VideoTransformHelper();
-
-		hr = m_TransformHelper->Initialize(m_CodecContext, inputType, outputType);
+		m_frameWidth = m_pEngine->GetOutputFormat().video.width;
+		m_frameHeight = m_pEngine->GetOutputFormat().video.height;
 	}
 
+	if (pCodecParams)
+		avcodec_parameters_free(&pCodecParams);
+
+	return hr;
+}
+
+/**
+ * Switches to new types without reopening the decoder, when only the
+ * output changed: e.g. the frame size of an adaptive stream. Queued frames
+ * are converted into the new output type.
+ *
+ * @return S_OK on success, an error code if a new context is needed:
+ *		MF_E_INVALIDMEDIATYPE  if the input type changed.
+ */
+HRESULT FFmpegContext::Reconfigure(
+	_In_ IMFMediaType *inputType,
+	_In_ IMFMediaType *outputType
+) {
+	HRESULT hr = (inputType && outputType) ? S_OK : E_POINTER;
+	MediaFormat outputFormat;
+	DWORD flags = 0;
+
+	if (SUCCEEDED(hr))
+		hr = (HasInitialized()) ? S_OK : MF_E_TRANSFORM_TYPE_NOT_SET;
+
+	// A new stream needs a new decoder
+	if (SUCCEEDED(hr) && inputType->IsEqual(m_pInputType, &flags) != S_OK)
+		hr = MF_E_INVALIDMEDIATYPE;
+
+	if (SUCCEEDED(hr))
+		hr = FFmpegTypes::MediaFormatFromMediaType(&outputFormat, outputType);
+
+	// Only the converters change, see DecodeEngine::SetOutputFormat
+	if (SUCCEEDED(hr))
+		hr = FFmpegTypes::HResultFromAVError(m_pEngine->SetOutputFormat(outputFormat));
+
 	if (SUCCEEDED(hr))
 	{
-		m_pFrame = av_frame_alloc();
-		if (!m_pFrame) hr = E_OUTOFMEMORY;
+		inputType->AddRef();
+		m_pInputType->Release();
+		m_pInputType = inputType;
+
+		outputType->AddRef();
+		m_pOutputType->Release();
+		m_pOutputType = outputType;
+
+		m_frameWidth = outputFormat.video.width;
+		m_frameHeight = outputFormat.video.height;
+
+		// Sized by the next sample
+		m_pSamplePool->Resize(0);
 	}
 
 	return hr;
@@ -117,25 +192,54 @@ HRESULT FFmpegContext::Initialize(
 /** Returns true if this context has been initialized. */
 bool FFmpegContext::HasInitialized()
 {
-	return (m_pCodecParams && m_Codec && m_TransformHelper);
+	return (m_pEngine && m_pEngine->IsOpen() && m_pSamplePool);
 }
 
-/** Decodes a compressed frame and queues the raw output. */
+/**
+ * Decodes a compressed frame and queues all the raw output it produced.
+ * Producer side of the output queue, runs concurrently with GetNextSample.
+ *
+ * @return S_OK if frames are queued, S_FALSE if the decoder needs more
+ *         input first (threading or reordering delay), an error code on failure:
+ *		MF_E_NOTACCEPTING  if output must be processed before this packet.
+ */
 HRESULT FFmpegContext::Decode(_In_ AVPacket *pPacket) {
-	HRESULT hr = (pPacket) ? S_OK : E_POINTER;
+	if (!pPacket) return E_POINTER;
+
+	EnterCriticalSection(&m_csDecoder);
+	HRESULT hr = _Decode(pPacket);
+	LeaveCriticalSection(&m_csDecoder);
+
+	return hr;
+}
+
+HRESULT FFmpegContext::_Decode(_In_ AVPacket *pPacket) {
+	HRESULT hr = (m_pEngine) ? S_OK : MF_E_TRANSFORM_TYPE_NOT_SET;
 
 	// Format change must be fulfilled before new packets can be decoded.
-	if (m_bFormatChange)
+	if (m_bFormatChange || m_bDraining)
 		return MF_E_NOTACCEPTING;
 
+	// First packet of a new stream after a drain. Its frames have all
+	// been delivered, so the transform helpers are not in use.
+	if (m_bDrained)
+		hr = _ResetDecoder();
+
+	// Frames left in the decoder by a full queue come first
+	if (SUCCEEDED(hr))
+		hr = _ReceiveFrames();
+
+	if (SUCCEEDED(hr) && !CanAcceptInput())
+		hr = MF_E_NOTACCEPTING;
+
 	if (SUCCEEDED(hr))
 	{
-		int sendPacketResult = avcodec_send_packet(m_CodecContext, pPacket);
+		int sendPacketResult = m_pEngine->SendPacket(pPacket);
 		if (sendPacketResult == AVERROR(EAGAIN))
 		{
-			// The decoder should have been drained and always ready to access input
-			_ASSERT(FALSE);
-			hr = E_UNEXPECTED;
+			// Frames left in the decoder by a full queue, the pipeline
+			// sends this packet again after ProcessOutput.
+			hr = MF_E_NOTACCEPTING;
 		}
 		else if (sendPacketResult < 0)
 		{
@@ -144,124 +248,306 @@ HRESULT FFmpegContext::Decode(_In_ AVPacket *pPacket) {
 		}
 	}
 
+	// One packet may hold several frames (Vorbis) or release several
+	// delayed ones, take them all.
 	if (SUCCEEDED(hr))
+		hr = _ReceiveFrames();
+
+	if (SUCCEEDED(hr) && m_OutputQueue.IsEmpty())
+		hr = S_FALSE;
+
+	return hr;
+}
+
+/**
+ * Retrieves the next decoded sample, converting the frame straight into
+ * its first buffer. Consumer side of the output queue: only takes the
+ * decoder lock when the queue is empty.
+ * 
+ * @param ppSample  the sample allocated by the pipeline, or a pointer to
+ *                  NULL to allocate a new one.
+ * @param bReceive  take frames from the decoder when the queue is empty,
+ *                  false when a worker does it, see ReceivePending.
+ * @return S_OK on success, an error code on failure:
+ *		MF_E_TRANSFORM_NEED_MORE_INPUT  if no sample is available.
+ *		MF_E_TRANSFORM_STREAM_CHANGE    if the next frame has a new size, the
+ *		                                output type is adjusted for it.
+ */
+HRESULT FFmpegContext::GetNextSample(_Inout_ IMFSample **ppSample, bool bReceive)
+{
+	HRESULT hr = (ppSample) ? S_OK : E_POINTER;
+	AVFrame *pFrame = nullptr;
+
+	while (SUCCEEDED(hr))
 	{
-		// Try to get a frame from the decoder.
-		int decodeFrame = avcodec_receive_frame(m_CodecContext, m_pFrame);
+		pFrame = m_OutputQueue.Peek();
 
-		// The decoder is empty, send a packet to it.
-		if (decodeFrame == AVERROR(EAGAIN))
+		// Frames left in the decoder by a full queue or a drain
+		if (!pFrame && bReceive)
 		{
-			// The decoder doesn't have enough data to produce a frame,
-			// return S_FALSE to indicate a partial frame
-			return S_FALSE;
-		}
-		else if (decodeFrame < 0)
-		{
-			hr = E_FAIL;
+			EnterCriticalSection(&m_csDecoder);
+			hr = _ReceiveFrames();
+			LeaveCriticalSection(&m_csDecoder);
+
+			if (SUCCEEDED(hr))
+				pFrame = m_OutputQueue.Peek();
 		}
 
-		if (SUCCEEDED(hr) && m_pFrame->nb_samples)
-			m_pFrame->pkt_duration = FFmpegTypes::TimeToAVTime(m_pFrame->nb_samples, m_CodecContext->time_base);
+		if (SUCCEEDED(hr) && !pFrame)
+			hr = MF_E_TRANSFORM_NEED_MORE_INPUT;
 
-		Platform::Array<BYTE>^ hBuffer;
-		IMFSample *pSample = nullptr;
-		if (SUCCEEDED(hr)) {
-			hr = MFCreateSample(&pSample);
-			if (pSample == nullptr) hr = E_OUTOFMEMORY;
-		}
+		if (FAILED(hr) || !_IsLate(pFrame))
+			break;
 
-		if(SUCCEEDED(hr))
-			hr = m_TransformHelper->ProcessDecodedFrame(m_pFrame, hBuffer);
-		
-		if (SUCCEEDED(hr))
-		{
-			hr = FFmpegTypes::SampleFromArray(pSample, hBuffer);
-			delete hBuffer;
-		}
+		// Late, dropped before conversion, see DropTime
+		m_OutputQueue.Pop();
+		av_frame_free(&pFrame);
+		m_cFramesDropped++;
+	}
 
+	if (FAILED(hr)) return hr;
+
+	// New frame size mid-stream: the frame stays queued until the pipeline
+	// picked an output type for it, see Reconfigure.
+	if (m_pEngine->GetOutputFormat().mediaType == AVMEDIA_TYPE_VIDEO
+		&& ((UINT32)pFrame->width != m_frameWidth || (UINT32)pFrame->height != m_frameHeight))
+	{
+		hr = _SetOutputFrameSize(pFrame->width, pFrame->height);
 
 		if (SUCCEEDED(hr))
 		{
-			if (m_pFrame->pts != AV_NOPTS_VALUE)
-				hr = pSample->SetSampleTime(m_pFrame->pts);
-			else
-				hr = pSample->SetSampleTime(pPacket->pts);
-
-			if (SUCCEEDED(hr)) {
-				if(pPacket->duration > 0)
-					hr = pSample->SetSampleDuration(pPacket->duration);
-				else
-					hr = pSample->SetSampleDuration(m_pFrame->pkt_duration);
-			}
+			m_frameWidth = pFrame->width;
+			m_frameHeight = pFrame->height;
+			QueueFormatChange();
+			hr = MF_E_TRANSFORM_STREAM_CHANGE;
 		}
 
+		return hr;
+	}
+
+	m_OutputQueue.Pop();
+
+	CComPtr<IMFSample> spSample = *ppSample;
+	CComPtr<IMFMediaBuffer> spBuffer;
+
+	// We allocate our own samples, recycled once downstream is done
+	if (!spSample)
+	{
+		size_t size = 0;
+		hr = FFmpegTypes::HResultFromAVError(m_pEngine->GetOutputSize(pFrame, 0, &size));
+
 		if (SUCCEEDED(hr))
-			hr = QueueOutput(pSample);
+			hr = m_pSamplePool->GetSample((DWORD)size, &spSample);
 	}
 
+	// Pipeline allocates sample
+	if (SUCCEEDED(hr))
+		hr = spSample->GetBufferByIndex(0, &spBuffer);
+
+	if (SUCCEEDED(hr))
+		hr = _ConvertFrame(pFrame, spBuffer);
+
+	if (SUCCEEDED(hr))
+		hr = spSample->SetSampleTime(pFrame->pts);
+
+	if (SUCCEEDED(hr))
+		hr = spSample->SetSampleDuration(pFrame->pkt_duration);
+
+	if (SUCCEEDED(hr) && !*ppSample)
+		*ppSample = spSample.Detach();
+
+	if (SUCCEEDED(hr))
+		m_cFramesOutput++;
+
+	av_frame_free(&pFrame);
+
 	return hr;
 }
 
 /**
- * Retrieves the next decoded sample.
- * 
- * @param ppSample  a pointer to the next sample.
- * @return S_OK on success, an error code on failure:
- *		MF_E_TRANSFORM_NEED_MORE_INPUT  if no sample is available.
+ * Moves the frames the decoder has ready to the output queue, until it
+ * needs more input or the queue is full. Frames stay in the decoder
+ * format until the output buffer is known, see GetNextSample.
+ *
+ * Caller holds the decoder lock, so there is a single producer.
  */
-HRESULT FFmpegContext::GetNextSample(_Deref_out_ IMFSample **ppSample)
+HRESULT FFmpegContext::_ReceiveFrames()
 {
-	HRESULT hr = (ppSample) ? S_OK : E_POINTER;
-	
-	if (m_OutputQueue.IsEmpty())
-		hr = MF_E_TRANSFORM_NEED_MORE_INPUT;
+	HRESULT hr = S_OK;
 
-	if (SUCCEEDED(hr))
+	// No decoder before the first packet, so nothing queued: GetNextSample
+	// then asks for input.
+	if (!m_pEngine)
+		return hr;
+
+	// Everything was received, the decoder is reset with the next packet
+	if (m_bDrained)
+		return hr;
+
+	while (SUCCEEDED(hr) && !m_OutputQueue.IsFull())
 	{
-		IMFSample *pSample = m_OutputQueue.RemoveTail();
-		hr = pSample->QueryInterface<IMFSample>(ppSample);
-		pSample->Release();
-		if (*ppSample == NULL) hr = E_UNEXPECTED;
+		AVFrame *pFrame = av_frame_alloc();
+		if (!pFrame)
+		{
+			hr = E_OUTOFMEMORY;
+			break;
+		}
+
+		int result = m_pEngine->ReceiveFrame(pFrame);
+
+		if (result >= 0)
+		{
+			hr = QueueOutput(pFrame);
+			continue;
+		}
+
+		av_frame_free(&pFrame);
+
+		// All input is decoded, now the frames the decoder holds back
+		if (result == AVERROR(EAGAIN) && m_bDraining)
+		{
+			result = m_pEngine->SendPacket(NULL);
+			if (result >= 0)
+				continue;
+		}
+
+		// Needs more input
+		if (result == AVERROR(EAGAIN))
+			break;
+
+		// Drained. Frames may still be converted, the decoder is only
+		// reset for the next stream, see _Decode.
+		if (result == AVERROR_EOF && m_bDraining)
+		{
+			m_bDraining = false;
+			m_bDrained = true;
+			break;
+		}
+
+		hr = E_FAIL;
 	}
 
 	return hr;
 }
 
-/** Returns true if there is a uncompressed output frame queued */
+/**
+ * Returns true if a packet can be decoded now: no pending format change
+ * or drain, and room in the output queue.
+ */
+bool FFmpegContext::CanAcceptInput() {
+	return (!m_bFormatChange && !m_bDraining && !m_OutputQueue.IsFull());
+}
+
+/** Occupancy of the output queue, to tune its depth. */
+void FFmpegContext::GetQueueStats(FrameQueueStats *pStats) {
+	m_OutputQueue.GetStats(pStats);
+}
+
+/**
+ * Moves the frames left in the decoder by a full queue or a drain to the
+ * output queue, from a decode worker.
+ */
+HRESULT FFmpegContext::ReceivePending()
+{
+	EnterCriticalSection(&m_csDecoder);
+	HRESULT hr = _ReceiveFrames();
+	LeaveCriticalSection(&m_csDecoder);
+
+	return hr;
+}
+
+/** Returns true from Drain until the decoder has output its last frame. */
+bool FFmpegContext::IsDraining() {
+	return m_bDraining;
+}
+
+/**
+ * Changes the decoding shortcuts while decoding, e.g. from the quality
+ * manager of the pipeline. Initialize takes them from the options.
+ */
+HRESULT FFmpegContext::SetSkip(const DecodeSkip &skip)
+{
+	EnterCriticalSection(&m_csDecoder);
+
+	if (m_pEngine)
+		m_pEngine->SetSkip(skip);
+
+	LeaveCriticalSection(&m_csDecoder);
+
+	return S_OK;
+}
+
+/**
+ * Drops the video frames of the next hnsAmountToDrop, from the next one
+ * output: they are decoded, but never converted nor delivered. Any thread.
+ */
+void FFmpegContext::DropTime(LONGLONG hnsAmountToDrop)
+{
+	m_dropRequest.store(hnsAmountToDrop);
+}
+
+/** Returns true if the frame falls in the time to drop. Consumer side. */
+bool FFmpegContext::_IsLate(const AVFrame *pFrame)
+{
+	if (m_pEngine->GetOutputFormat().mediaType != AVMEDIA_TYPE_VIDEO)
+		return false;
+
+	if (pFrame->pts == AV_NOPTS_VALUE)
+		return false;
+
+	// Starts from the first frame after the request
+	LONGLONG amount = m_dropRequest.exchange(0);
+	if (amount > 0)
+		m_dropUntil = pFrame->pts + amount;
+
+	return (m_dropUntil != AV_NOPTS_VALUE && pFrame->pts < m_dropUntil);
+}
+
+/** Returns true if there is a uncompressed output frame queued, or still in a draining decoder */
 bool FFmpegContext::HasNextSample() {
-	return (!m_OutputQueue.IsEmpty());
+	return (!m_OutputQueue.IsEmpty() || m_bDraining);
+}
+
+/**
+ * Signals the end of the stream to the decoder, the frames it holds back
+ * are then returned by GetNextSample. Input is refused until they all are.
+ * The decoder only gets the NULL packet once the frames left in it by a
+ * full queue are out, see _ReceiveFrames.
+ */
+HRESULT FFmpegContext::Drain()
+{
+	HRESULT hr = (m_pEngine) ? S_OK : MF_E_TRANSFORM_TYPE_NOT_SET;
+
+	EnterCriticalSection(&m_csDecoder);
+
+	if (SUCCEEDED(hr))
+		m_bDraining = true;
+
+	LeaveCriticalSection(&m_csDecoder);
+
+	return hr;
 }
 
 /** Resets the context. */
 HRESULT FFmpegContext::FlushInput()
 {
-	HRESULT hr = S_OK;
+	EnterCriticalSection(&m_csDecoder);
+	HRESULT hr = _ResetDecoder();
+	LeaveCriticalSection(&m_csDecoder);
 
-	avcodec_free_context(&m_CodecContext);
-	hr = _CreateCodecContext();
+	return hr;
+}
 
-	GUID inputMajorType;
+/** Flushes the decoder, keeping it open. The caller holds the decoder lock. */
+HRESULT FFmpegContext::_ResetDecoder()
+{
+	HRESULT hr = (m_pEngine) ? S_OK : MF_E_TRANSFORM_TYPE_NOT_SET;
 
-	if (SUCCEEDED(hr))
-	{
-		if (m_pInputType == nullptr)
-			hr = MF_E_TRANSFORM_TYPE_NOT_SET;
-		else
-			hr = m_pInputType->GetGUID(MF_MT_MAJOR_TYPE, &inputMajorType);
-	}
+	m_bDraining = false;
+	m_bDrained = false;
 
 	if (SUCCEEDED(hr))
-	{
-		delete m_TransformHelper;
-
-		if (inputMajorType == MFMediaType_Audio)
-			m_TransformHelper = ref new AudioTransformHelper();
-		else
-			m_TransformHelper = ref new VideoTransformHelper();
-
-		hr = m_TransformHelper->Initialize(m_CodecContext, m_pInputType, m_pOutputType);
-	}
+		hr = FFmpegTypes::HResultFromAVError(m_pEngine->Flush());
 
 	return hr;
 }
@@ -274,53 +560,105 @@ HRESULT FFmpegContext::FlushInput()
 HRESULT FFmpegContext::Flush()
 {
 	HRESULT hr = S_OK;
-	IMFSample *pSample = nullptr;
-	while (!m_OutputQueue.IsEmpty())
-	{
-		pSample = m_OutputQueue.RemoveHead();
-		pSample->Release();
-	}
+
+	// Neither input nor output is processed while flushing
+	m_OutputQueue.Clear();
+
+	// Times to drop were before the seek
+	m_dropRequest.store(0);
+	m_dropUntil = AV_NOPTS_VALUE;
 
 	FlushInput();
 	return hr;
 }
 
-/** Queues sample frame. */
-HRESULT FFmpegContext::QueueOutput(IMFSample *pSample)
+/** Queues decoded frame, the caller checked the queue is not full. */
+HRESULT FFmpegContext::QueueOutput(AVFrame *pFrame)
 {
-	m_OutputQueue.AddHead(pSample);
+	if (!m_OutputQueue.Push(pFrame))
+	{
+		av_frame_free(&pFrame);
+		return E_UNEXPECTED;
+	}
+
 	return S_OK;
 }
 
-/** Creates the FFmpeg codec context. */
-HRESULT FFmpegContext::_CreateCodecContext()
+/**
+ * Converts a decoded frame into a media buffer, in place. Uses the pitch
+ * of 2D buffers so pipeline-allocated video buffers need no extra copy.
+ */
+HRESULT FFmpegContext::_ConvertFrame(_In_ AVFrame *pFrame, _In_ IMFMediaBuffer *pBuffer)
 {
-	HRESULT hr = (m_Codec)? S_OK : E_POINTER;
+	HRESULT hr = (pFrame && pBuffer) ? S_OK : E_POINTER;
 
-	if (SUCCEEDED(hr))
+	CComPtr<IMF2DBuffer2> sp2DBuffer;
+	FrameBuffer dest = {};
+	BYTE *pbBuffer = nullptr;
+	DWORD bufferLength = 0;
+	bool bLocked = false;
+
+	if (SUCCEEDED(hr) && SUCCEEDED(pBuffer->QueryInterface(IID_PPV_ARGS(&sp2DBuffer))))
+	{
+		BYTE *pbScanline0 = nullptr;
+		LONG pitch = 0;
+		hr = sp2DBuffer->Lock2DSize(MF2DBuffer_LockFlags_Write, &pbScanline0, &pitch, &pbBuffer, &bufferLength);
+		bLocked = SUCCEEDED(hr);
+
+		// FFmpeg never produces bottom-up images
+		if (SUCCEEDED(hr) && pitch <= 0)
+			hr = MF_E_UNSUPPORTED_FORMAT;
+
+		dest.pitch = pitch;
+	}
+	else if (SUCCEEDED(hr))
 	{
-		m_CodecContext = avcodec_alloc_context3(m_Codec);
-		if (!m_CodecContext) hr = E_OUTOFMEMORY;
+		hr = pBuffer->Lock(&pbBuffer, &bufferLength, NULL);
+		bLocked = SUCCEEDED(hr);
 	}
 
+	size_t written = 0;
 	if (SUCCEEDED(hr))
 	{
-		int codecParamsResult = avcodec_parameters_to_context(
-			m_CodecContext,
-			m_pCodecParams
-		);
-		if (codecParamsResult < 0) hr = E_FAIL;
+		dest.pData = pbBuffer;
+		dest.size = bufferLength;
+		hr = FFmpegTypes::HResultFromAVError(m_pEngine->ConvertFrame(pFrame, dest, &written));
+	}
+
+	// 2D buffers report their contiguous length, not the pitched one
+	if (SUCCEEDED(hr) && sp2DBuffer)
+	{
+		DWORD contiguousLength = 0;
+		hr = sp2DBuffer->GetContiguousLength(&contiguousLength);
+		written = contiguousLength;
+	}
+
+	if (bLocked)
+	{
+		if (sp2DBuffer)
+			sp2DBuffer->Unlock2D();
+		else
+			pBuffer->Unlock();
 	}
 
-	// TODO : this is not thread safe - use locks?
 	if (SUCCEEDED(hr))
+		hr = pBuffer->SetCurrentLength((DWORD)written);
+
+	return hr;
+}
+
+/** Sets the frame size of the output type, with the matching default stride. */
+HRESULT FFmpegContext::_SetOutputFrameSize(UINT32 width, UINT32 height)
+{
+	HRESULT hr = MFSetAttributeSize(m_pOutputType, MF_MT_FRAME_SIZE, width, height);
+
+	GUID subType;
+	LONG stride;
+	if (SUCCEEDED(hr)
+		&& SUCCEEDED(m_pOutputType->GetGUID(MF_MT_SUBTYPE, &subType))
+		&& SUCCEEDED(MFGetStrideForBitmapInfoHeader(subType.Data1, width, &stride)))
 	{
-		int codecOpenResult = avcodec_open2(m_CodecContext, m_Codec, NULL);
-		if(codecOpenResult < 0)
-		{
-			m_CodecContext = nullptr;
-			hr = E_FAIL;
-		}
+		hr = m_pOutputType->SetUINT32(MF_MT_DEFAULT_STRIDE, (UINT32)abs(stride));
 	}
 
 	return hr;
@@ -331,34 +669,14 @@ void FFmpegContext::QueueFormatChange(void)
 	m_bFormatChange = true;
 }
 
+/** Takes the pending format change, if any. */
 bool FFmpegContext::HasFormatChange(void)
 {
-	bool result = m_bFormatChange;
-	m_bFormatChange = false;
-	return result;
+	return m_bFormatChange.exchange(false);
 }
 
-bool FFmpegContext::_VideoUpdateOutput(_Inout_ IMFMediaType *outputType)
+/** Like HasFormatChange, without taking the change. */
+bool FFmpegContext::IsFormatChangeQueued(void)
 {
-	HRESULT hr = (outputType) ? S_OK : E_POINTER;
-	bool result = false;
-
-	// width and height
-	UINT32 width, height;
-	if (SUCCEEDED(hr))
-		hr = MFGetAttributeSize(outputType, MF_MT_FRAME_SIZE, &width, &height);
-
-	if (SUCCEEDED(hr))
-	{
-		if (m_CodecContext->width != width || m_CodecContext->height != height)
-		{
-			hr = MFSetAttributeSize(outputType, MF_MT_FRAME_SIZE, m_CodecContext->width, m_CodecContext->height);
-			result = true;
-		}
-	}
-
-	// Calls in this function are NOT expected to fail.
-	_ASSERT(SUCCEEDED(hr)); 
-
-	return result;
+	return m_bFormatChange;
 }
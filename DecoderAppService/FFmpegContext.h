@@ -9,14 +9,18 @@ extern "C"
 #include <libavformat/avformat.h> // AVPacket, AVFrame
 }
 
-#include "FFmpegTransformHelper.h"
+#include "DecodeEngine.h"
 #include "FFmpegTypes.h"
-
-// basically a wrapper for the actual FFmpeg
-// context as in:
-//    - IO Context
-//    - Format Context
-//    - Codec Context
+#include "FrameQueue.h"
+#include "SamplePool.h"
+
+// Media Foundation adapter over the platform-neutral DecodeEngine:
+//    - translates MF media types to FFmpeg codec parameters
+//    - queues decoded frames and converts them into MF samples on output
+//
+// Decode (input side) and GetNextSample (output side) may run on different
+// threads: frames pass through a lock-free queue, and only the decoder
+// itself is locked.
 namespace FFmpegPack {
 	ref class FFmpegContext sealed
 	{
@@ -26,18 +30,28 @@ namespace FFmpegPack {
 
 	internal:
 
-		HRESULT Initialize(_In_ IMFMediaType *inputType, _Inout_ IMFMediaType *outputType);
+		HRESULT Initialize(_In_ IMFMediaType *inputType, _Inout_ IMFMediaType *outputType, const DecodeOptions &options, size_t queueDepth);
+		HRESULT Reconfigure(_In_ IMFMediaType *inputType, _In_ IMFMediaType *outputType);
 		bool HasInitialized(void);
 
 		HRESULT Decode(_In_ AVPacket *pPacket);
 
-		HRESULT GetNextSample(_Deref_out_ IMFSample **ppSample);
+		HRESULT GetNextSample(_Inout_ IMFSample **ppSample, bool bReceive = true);
+		HRESULT ReceivePending(void);
 		bool HasNextSample(void);
+		bool IsDraining(void);
+		bool CanAcceptInput(void);
+		void GetQueueStats(_Out_ FrameQueueStats *pStats);
+
+		HRESULT SetSkip(const DecodeSkip &skip);
+		void DropTime(LONGLONG hnsAmountToDrop);
 
+		HRESULT Drain(void);
 		HRESULT FlushInput(void);
 		HRESULT Flush(void);
 
 		bool HasFormatChange(void);
+		bool IsFormatChangeQueued(void);
 
 	private:
 		// MFT
@@ -48,24 +62,53 @@ namespace FFmpegPack {
 		IMFMediaType* m_pInputType;
 
 		// FFmpeg
-		AVCodec* m_Codec;
-		AVCodecContext * m_CodecContext;
-		AVCodecParameters *m_pCodecParams;
-
-		AVFrame *m_pFrame;
-		
+		/** The platform-neutral decoder doing the actual work. */
+		DecodeEngine *m_pEngine;
 
 		// Others
-		CAtlList<IMFSample*> m_OutputQueue;
-		FFmpegTransformHelper^ m_TransformHelper;
-		bool m_bFormatChange;
+		/** Recycles the output samples allocated by this context. */
+		SamplePool *m_pSamplePool;
+
+		/** Decoded frames, still in the decoder format. */
+		FrameQueue m_OutputQueue;
+
+		/** Guards the decoder: sending, receiving and resetting. */
+		CRITICAL_SECTION m_csDecoder;
+
+		// State flags, read from the MFT threads and the decode worker without the decoder lock
+
+		/** The output type must change before the next frame, see HasFormatChange. */
+		std::atomic<bool> m_bFormatChange;
+
+		/** End of stream was sent, frames held back by the decoder are still coming. */
+		std::atomic<bool> m_bDraining;
+
+		/** The decoder output its last frame, it needs a reset before new input. */
+		std::atomic<bool> m_bDrained;
+
+		/** Video frame size of the output type, frames of another size need a new one. */
+		UINT32 m_frameWidth;
+		UINT32 m_frameHeight;
+
+		/** Time to drop from the next frame on, set from any thread, see DropTime. */
+		std::atomic<LONGLONG> m_dropRequest;
+
+		/** Video frames before this time are dropped unconverted. Consumer side. */
+		LONGLONG m_dropUntil;
+
+		// Statistics, consumer side
+		uint64_t m_cFramesOutput;
+		uint64_t m_cFramesDropped;
 
 		// Methods
-		HRESULT QueueOutput(_In_ IMFSample *pSample);
-		HRESULT _CreateCodecContext(void);
+		HRESULT QueueOutput(_In_ AVFrame *pFrame);
+		HRESULT _Decode(_In_ AVPacket *pPacket);
+		HRESULT _ReceiveFrames(void);
+		HRESULT _ResetDecoder(void);
+		HRESULT _ConvertFrame(_In_ AVFrame *pFrame, _In_ IMFMediaBuffer *pBuffer);
+		HRESULT _SetOutputFrameSize(UINT32 width, UINT32 height);
+		bool _IsLate(const AVFrame *pFrame);
 
 		void QueueFormatChange(void);
-
-		bool _VideoUpdateOutput(_Inout_ IMFMediaType *outputType);
 	};
 };
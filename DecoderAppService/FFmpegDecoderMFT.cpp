@@ -9,16 +9,43 @@ using namespace FFmpegPack;
 
 FFmpegDecoderMFT::FFmpegDecoderMFT() :
 	_bStreaming(false),
-	_bDraining(false)
+	_bDraining(false),
+	_bAsync(false),
+	_bDrainStarted(false),
+	_bWorkPosted(false),
+	_bFormatChangeSent(false),
+	_dwWorkQueue(0),
+	_cNeedInput(0),
+	_cHaveOutput(0),
+	_cInputQueued(0),
+	_cInputDecoded(0),
+	_DecodeCallback(this, &FFmpegDecoderMFT::_OnDecodeWork),
+	_bStopWork(false)
 {
-	
+	InitializeCriticalSection(&_csWorker);
+	InitializeCriticalSection(&_csOutput);
 	_pPacket = av_packet_alloc();
 }
 
 FFmpegDecoderMFT::~FFmpegDecoderMFT()
 {
+	// Pending work items hold references, none is left by now
+	Shutdown();
+
+	if (_dwWorkQueue)
+		MFUnlockWorkQueue(_dwWorkQueue);
+
 	if(_pPacket)
 		av_packet_free(&_pPacket);
+
+	// Packets that could not reference the sample memory
+	PacketBufferPoolStats stats;
+	_PacketPool.GetStats(&stats);
+	_RPT2(_CRT_WARN, "PacketBufferPool: %I64u copied packets, %I64u unpooled\n",
+		stats.gets, stats.unpooled);
+
+	DeleteCriticalSection(&_csOutput);
+	DeleteCriticalSection(&_csWorker);
 }
 
 HRESULT FFmpegDecoderMFT::CreateInstance(
@@ -53,9 +80,13 @@ HRESULT FFmpegDecoderMFT::CreateInstance(
  * @param pSample          the data of the sample, including time and duration.
  * @param dwFlags          input settings bitmask, MUST be 0.
  *
+ * In asynchronous mode the sample is only queued for the decode worker,
+ * and must answer a METransformNeedInput event.
+ *
  * @return S_OK on success, an error code on failure:
  *		MF_E_INVALIDSTREAMNUMBER  on wrong stream number
- *      MF_E_NOTACCEPTING         if currently draining
+ *      MF_E_NOTACCEPTING         if currently draining, or output must be
+ *                                processed before this sample
  */
 STDMETHODIMP FFmpegDecoderMFT::ProcessInput(
 	__in DWORD dwInputStreamID, 
@@ -76,7 +107,7 @@ STDMETHODIMP FFmpegDecoderMFT::ProcessInput(
 
 	if (SUCCEEDED(hr)) {
 		hr = pSample->GetBufferCount(&bufferCount);
-		if (SUCCEEDED(hr) && bufferCount == 0)
+		if (SUCCEEDED(hr) && bufferCount == 0 && !_bAsync)
 			return S_OK;
 	}
 	
@@ -87,20 +118,50 @@ STDMETHODIMP FFmpegDecoderMFT::ProcessInput(
 	
 	// Check if can take in input
 	if (SUCCEEDED(hr))
-		hr = (_bDraining || _bFormatChange) ? MF_E_NOTACCEPTING : S_OK;
+		hr = (_bDraining || (_bFormatChange && !_bAsync)) ? MF_E_NOTACCEPTING : S_OK;
+
+	if (SUCCEEDED(hr) && _bAsync)
+	{
+		if (_cNeedInput == 0)
+			hr = MF_E_NOTACCEPTING;
+
+		// Empty samples still answer a request
+		if (SUCCEEDED(hr) && bufferCount == 0)
+		{
+			_cNeedInput--;
+			hr = _RequestInput();
+		}
+
+		else if (SUCCEEDED(hr))
+		{
+			_cNeedInput--;
+
+			pSample->AddRef();
+			_PendingInput.AddTail(pSample);
+			_cInputQueued++;
+
+			hr = _PostDecodeWork();
+		}
+
+		LeaveCriticalSection(&_pcsLock);
+		return hr;
+	}
 
 	LeaveCriticalSection(&_pcsLock);
 
-	if (SUCCEEDED(hr))
+	if (SUCCEEDED(hr) && !_pContext->HasInitialized())
 	{
-		if(!_pContext->HasInitialized())
-			hr = _pContext->Initialize(_spInputType, _spOutputType);
+		DecodeOptions options;
+		hr = _GetDecodeOptions(&options);
+
+		if (SUCCEEDED(hr))
+			hr = _pContext->Initialize(_spInputType, _spOutputType, options, _cOutputQueueDepth);
 	}
 
 	if (SUCCEEDED(hr))
 	{
 		// Process input sample as AVPacket
-		hr = FFmpegTypes::PacketFromSample(_pPacket, pSample);
+		hr = FFmpegTypes::PacketFromSample(_pPacket, pSample, &_PacketPool);
 		
 		if (SUCCEEDED(hr))
 			hr = _pContext->Decode(_pPacket);
@@ -119,9 +180,24 @@ HRESULT FFmpegDecoderMFT::StartStream() {
 
 	hr = _pContext->Flush();
 
+	// Asynchronous once the pipeline unlocked it, see MF_TRANSFORM_ASYNC
+	if (SUCCEEDED(hr))
+		_bAsync = _spAttributes && MFGetAttributeUINT32(_spAttributes, MF_TRANSFORM_ASYNC_UNLOCK, FALSE);
+
+	if (SUCCEEDED(hr) && _bAsync && !_dwWorkQueue)
+	{
+		// A dedicated thread, decoding never blocks the pipeline threads
+		hr = MFAllocateWorkQueue(&_dwWorkQueue);
+		if (SUCCEEDED(hr))
+			_DecodeCallback.SetQueue(_dwWorkQueue);
+	}
+
 	if (SUCCEEDED(hr))
 		_bStreaming = true;
 
+	if (SUCCEEDED(hr) && _bAsync)
+		hr = _RequestInput();
+
 	return hr;
 }
 
@@ -130,6 +206,18 @@ STDMETHODIMP FFmpegDecoderMFT::ProcessMessage(
 	__in MFT_MESSAGE_TYPE eMessage, 
 	__in ULONG_PTR ulParam
 ){
+	// Those reset the context: the decode worker is stopped after its
+	// current packet, and output waits for the reset
+	bool bReset = (eMessage == MFT_MESSAGE_COMMAND_FLUSH
+		|| eMessage == MFT_MESSAGE_NOTIFY_START_OF_STREAM);
+
+	if (bReset)
+	{
+		_bStopWork = true;
+		EnterCriticalSection(&_csWorker);
+		EnterCriticalSection(&_csOutput);
+		_bStopWork = false;
+	}
 
 	EnterCriticalSection(&_pcsLock);
 
@@ -153,25 +241,65 @@ STDMETHODIMP FFmpegDecoderMFT::ProcessMessage(
 		}
 		break;
 
-		// Stop accepting input until all possible output is queued
+		// Stop accepting input until the frames held back by the decoder are output
 		case MFT_MESSAGE_COMMAND_DRAIN:
 		{
-			if(_pContext->HasInitialized())
+			// The worker drains once the queued input is decoded, then
+			// sends METransformDrainComplete
+			if (_bAsync)
 			{
-				hr = _pContext->FlushInput();
 				_bDraining = true;
+				hr = _PostDecodeWork();
+			}
+			else if(_pContext->HasInitialized())
+			{
+				hr = _pContext->Drain();
+				_bDraining = SUCCEEDED(hr);
 			}
 		}
 		break;
 
 		// Drop all current samples - must be ready for new ones right away
 		case MFT_MESSAGE_COMMAND_FLUSH:
+			// No more input until the next start of stream
+			if (_bAsync)
+				_bStreaming = false;
+
+			_ReleasePendingInput();
+			_cNeedInput = 0;
+			_bDraining = false;
+			_bDrainStarted = false;
+
 			if (_pContext->HasInitialized())
 			{
 				hr = _pContext->Flush();
 			}
+
+			// No output events for the dropped frames
+			_SkipOutputEvents();
+
+			// The input before the pending markers is dropped, they are answered now
+			if (_bAsync)
+			{
+				_cInputDecoded = _cInputQueued;
+
+				HRESULT hrMarkers = _SendMarkerEvents();
+				if (SUCCEEDED(hr))
+					hr = hrMarkers;
+			}
 			
 		break;
+
+		// Answered with METransformMarker once the input received so far
+		// is decoded, after the METransformHaveOutput of its frames
+		case MFT_MESSAGE_COMMAND_MARKER:
+			if (_bAsync)
+			{
+				PendingMarker marker = { _cInputQueued, ulParam };
+				_PendingMarkers.AddTail(marker);
+				hr = _PostDecodeWork();
+			}
+		break;
 		
 		default:
 			// We do not handle this type of message so pass it downstream
@@ -179,8 +307,21 @@ STDMETHODIMP FFmpegDecoderMFT::ProcessMessage(
 			break;
 	}
 
+	// Input and markers left by the stopped worker
+	if (bReset && SUCCEEDED(hr) && _bAsync
+		&& (!_PendingInput.IsEmpty() || !_PendingMarkers.IsEmpty()))
+	{
+		hr = _PostDecodeWork();
+	}
+
 	LeaveCriticalSection(&_pcsLock);
 
+	if (bReset)
+	{
+		LeaveCriticalSection(&_csOutput);
+		LeaveCriticalSection(&_csWorker);
+	}
+
 	return hr;
 }
 
@@ -212,62 +353,402 @@ STDMETHODIMP FFmpegDecoderMFT::ProcessOutput(
 			hr = MF_E_INVALIDSTREAMNUMBER;
 	}
 
-	if (SUCCEEDED(hr) && _pContext->HasFormatChange())
+	if (FAILED(hr))
+		return hr;
+
+	// The context is neither flushed nor replaced meanwhile
+	EnterCriticalSection(&_csOutput);
+
+	if (_pContext->HasFormatChange())
+		hr = _SuggestOutputType(&pOutputSamples[0]);
+
+	else
 	{
-		hr = MFCreateMediaType(&_spSuggestedOutputType);
-		
-		if (SUCCEEDED(hr))
+		// The frame is converted straight into the pipeline sample when
+		// there is one, otherwise the context allocates the sample. Runs
+		// outside of the MFT lock, frames come from a lock-free queue. The
+		// decode worker, if any, takes frames from the decoder itself.
+		hr = _pContext->GetNextSample(&(pOutputSamples[0].pSample), !_bAsync);
+
+		// The next frame has a new size
+		if (hr == MF_E_TRANSFORM_STREAM_CHANGE && _pContext->HasFormatChange())
+			hr = _SuggestOutputType(&pOutputSamples[0]);
+
+		EnterCriticalSection(&_pcsLock);
+
+		// That frame is still queued, reported again once the type is set
+		if (_bAsync && hr == MF_E_TRANSFORM_STREAM_CHANGE && _cHaveOutput > 0)
+			_cHaveOutput--;
+
+		// Room in the queue, the worker may continue
+		if (_bAsync)
+			_PostDecodeWork();
+
+		else if (_bDraining && !_pContext->HasNextSample())
+			_bDraining = false;
+
+		// The worker rebuilds its own context
+		if (!_bAsync && _bFormatChange && !_pContext->HasNextSample())
 		{
-			_spOutputType->CopyAllItems(_spSuggestedOutputType);
-			_spOutputType.Release();
-			pOutputSamples[0].dwStatus |= MFT_OUTPUT_DATA_BUFFER_FORMAT_CHANGE;
+			// Rebuild context - handles output type changes
+			// We don't want to drop samples in between type changes!
+			delete _pContext;
+			_pContext = ref new FFmpegContext();
+			_bFormatChange = false;
+		}
+
+		LeaveCriticalSection(&_pcsLock);
+	}
+
+	LeaveCriticalSection(&_csOutput);
+
+	return hr;
+}
 
-			return MF_E_TRANSFORM_STREAM_CHANGE;
+/**
+ * Reconfigures the current context for the new output type when the
+ * decoder can stay open, e.g. a new frame size mid-stream. Otherwise it is
+ * rebuilt once its frames are output. Resumes the decode worker, stalled
+ * until the new output type.
+ */
+STDMETHODIMP FFmpegDecoderMFT::SetOutputType(
+	__in DWORD dwOutputStreamID,
+	__in IMFMediaType *pType,
+	__in DWORD dwFlags
+){
+	// The worker must not decode, nor ProcessOutput convert, meanwhile
+	EnterCriticalSection(&_csWorker);
+	EnterCriticalSection(&_csOutput);
+
+	HRESULT hr = DecoderBase::SetOutputType(dwOutputStreamID, pType, dwFlags);
+
+	if (SUCCEEDED(hr) && pType && !(dwFlags & MFT_SET_TYPE_TEST_ONLY))
+	{
+		EnterCriticalSection(&_pcsLock);
+
+		if (_bFormatChange && _pContext->HasInitialized()
+			&& SUCCEEDED(_pContext->Reconfigure(_spInputType, _spOutputType)))
+		{
+			_bFormatChange = false;
 		}
+
+		if (_bAsync && _bStreaming)
+			hr = _PostDecodeWork();
+
+		LeaveCriticalSection(&_pcsLock);
 	}
 
+	LeaveCriticalSection(&_csOutput);
+	LeaveCriticalSection(&_csWorker);
+
+	return hr;
+}
+
+/**
+ * Clears the output type and suggests the one the context adjusted for
+ * the decoded frames.
+ *
+ * @return MF_E_TRANSFORM_STREAM_CHANGE on success, an error code on failure.
+ */
+HRESULT FFmpegDecoderMFT::_SuggestOutputType(__inout MFT_OUTPUT_DATA_BUFFER *pOutputSample)
+{
+	if (_spSuggestedOutputType)
+		_spSuggestedOutputType.Release();
+
+	HRESULT hr = MFCreateMediaType(&_spSuggestedOutputType);
+
 	if (SUCCEEDED(hr))
 	{
-		EnterCriticalSection(&_pcsLock);
+		_spOutputType->CopyAllItems(_spSuggestedOutputType);
+		_spOutputType.Release();
+		pOutputSample->dwStatus |= MFT_OUTPUT_DATA_BUFFER_FORMAT_CHANGE;
 
-		CComPtr<IMFSample> spSample;
+		hr = MF_E_TRANSFORM_STREAM_CHANGE;
+	}
 
-		// TODO : Dont need markers for FFmpeg, RIGHT?
-		if (SUCCEEDED(hr))
-			hr = _pContext->GetNextSample(&spSample);
+	return hr;
+}
+
+/** Shuts down once the decode worker is idle, queued input is dropped. */
+STDMETHODIMP FFmpegDecoderMFT::Shutdown()
+{
+	EnterCriticalSection(&_csWorker);
+
+	HRESULT hr = DecoderBase::Shutdown();
+
+	EnterCriticalSection(&_pcsLock);
+	_ReleasePendingInput();
+	LeaveCriticalSection(&_pcsLock);
+
+	LeaveCriticalSection(&_csWorker);
+
+	return hr;
+}
+
+
+///////////////////////////////////////////////////////////
+//   Asynchronous mode
+///////////////////////////////////////////////////////////
+
+/**
+ * Decode worker, runs on the dedicated work queue. Decodes the queued
+ * input until the output queue is full, then reports the new frames with
+ * METransformHaveOutput and asks for input with METransformNeedInput.
+ * ProcessOutput posts it again once frames are taken.
+ */
+HRESULT FFmpegDecoderMFT::_OnDecodeWork(__in IMFAsyncResult *pAsyncResult)
+{
+	EnterCriticalSection(&_csWorker);
+
+	// The context is replaced while no ProcessOutput uses it
+	EnterCriticalSection(&_csOutput);
+	EnterCriticalSection(&_pcsLock);
+
+	_bWorkPosted = false;
+	HRESULT hr = _CheckShutdown();
+
+	// Type changed, once the frames of the old type are output
+	if (SUCCEEDED(hr) && _bFormatChange && !_pContext->HasNextSample())
+	{
+		delete _pContext;
+		_pContext = ref new FFmpegContext();
+		_bFormatChange = false;
+		_bFormatChangeSent = false;
+		_cHaveOutput = 0;
+	}
+
+	// No output type between MF_E_TRANSFORM_STREAM_CHANGE and SetOutputType
+	bool bDecode = SUCCEEDED(hr) && _spOutputType && !_bFormatChange;
+
+	if (bDecode && !_pContext->HasInitialized() && !_PendingInput.IsEmpty())
+	{
+		DecodeOptions options;
+		hr = _GetDecodeOptions(&options);
 
 		if (SUCCEEDED(hr))
+			hr = _pContext->Initialize(_spInputType, _spOutputType, options, _cOutputQueueDepth);
+	}
+
+	LeaveCriticalSection(&_pcsLock);
+	LeaveCriticalSection(&_csOutput);
+
+	// Decoding runs outside of the MFT lock, input keeps coming meanwhile.
+	// A flush stops it after the current packet.
+	while (SUCCEEDED(hr) && bDecode && !_bStopWork && _pContext->HasInitialized())
+	{
+		// Frames left in the decoder by a full queue, or by a drain
+		hr = _pContext->ReceivePending();
+		if (FAILED(hr) || !_pContext->CanAcceptInput())
+			break;
+
+		IMFSample *pSample = nullptr;
+
+		EnterCriticalSection(&_pcsLock);
+
+		if (!_PendingInput.IsEmpty())
+			pSample = _PendingInput.RemoveHead();
+
+		// All input decoded, now the frames the decoder holds back
+		else if (_bDraining && !_bDrainStarted)
 		{
-			// We allocate our own samples
-			if (pOutputSamples[0].pSample == NULL)
-				hr = spSample.CopyTo(&(pOutputSamples[0].pSample));
+			hr = _pContext->Drain();
+			_bDrainStarted = SUCCEEDED(hr);
+		}
 
-			// Pipeline allocates sample
-			else
-			{
-				hr = FFmpegTypes::CopySample(spSample, pOutputSamples[0].pSample);
-				spSample->RemoveAllBuffers();
-			}
+		LeaveCriticalSection(&_pcsLock);
 
-			spSample.Release();
+		if (!pSample)
+		{
+			if (_bDrainStarted && _pContext->IsDraining())
+				continue;
+			break;
 		}
 
+		hr = FFmpegTypes::PacketFromSample(_pPacket, pSample, &_PacketPool);
 
-		if (_bDraining && !_pContext->HasNextSample())
-			_bDraining = false;
+		if (SUCCEEDED(hr))
+			hr = _pContext->Decode(_pPacket);
 
-		if (_bFormatChange && !_pContext->HasNextSample())
+		// Queue filled up meanwhile, retried after ProcessOutput
+		if (hr == MF_E_NOTACCEPTING)
 		{
-			// Rebuild context - handles output type changes
-			// We don't want to drop samples in between type changes!
-			delete _pContext;
-			_pContext = ref new FFmpegContext();
-			_bFormatChange = false;
+			EnterCriticalSection(&_pcsLock);
+			_PendingInput.AddHead(pSample);
+			LeaveCriticalSection(&_pcsLock);
+
+			hr = S_OK;
+			break;
 		}
 
+		pSample->Release();
+
+		EnterCriticalSection(&_pcsLock);
+		_cInputDecoded++;
 		LeaveCriticalSection(&_pcsLock);
+
+		// Partial frame, the decoder needs more input
+		if (hr == S_FALSE)
+			hr = S_OK;
+	}
+
+	// ProcessMessage resets the context and posts the worker again
+	if (_bStopWork)
+	{
+		LeaveCriticalSection(&_csWorker);
+		return S_OK;
+	}
+
+	EnterCriticalSection(&_pcsLock);
+
+	if (SUCCEEDED(hr))
+		hr = _SendOutputEvents();
+
+	// After the frames of the input received before them
+	if (SUCCEEDED(hr))
+		hr = _SendMarkerEvents();
+
+	// ProcessOutput reports the new type with MF_E_TRANSFORM_STREAM_CHANGE
+	if (SUCCEEDED(hr) && !_bFormatChangeSent && _pContext->IsFormatChangeQueued())
+	{
+		hr = QueueEvent(METransformHaveOutput, GUID_NULL, S_OK, NULL);
+		_bFormatChangeSent = SUCCEEDED(hr);
+	}
+
+	// Drain is complete once the last frame is reported
+	if (SUCCEEDED(hr) && _bDraining && _PendingInput.IsEmpty()
+		&& (_bDrainStarted || !_pContext->HasInitialized())
+		&& !_pContext->IsDraining())
+	{
+		_bDraining = false;
+		_bDrainStarted = false;
+		hr = _QueueInputEvent(METransformDrainComplete);
+	}
+
+	if (SUCCEEDED(hr))
+		hr = _RequestInput();
+
+	if (FAILED(hr) && hr != MF_E_SHUTDOWN)
+		QueueEvent(MEError, GUID_NULL, hr, NULL);
+
+	LeaveCriticalSection(&_pcsLock);
+	LeaveCriticalSection(&_csWorker);
+
+	return S_OK;
+}
+
+/** Runs the decode worker, unless already pending. Caller holds the MFT lock. */
+HRESULT FFmpegDecoderMFT::_PostDecodeWork()
+{
+	HRESULT hr = (_dwWorkQueue) ? S_OK : MF_E_INVALIDREQUEST;
+
+	if (SUCCEEDED(hr) && !_bWorkPosted)
+	{
+		hr = MFPutWorkItem2(_dwWorkQueue, 0, &_DecodeCallback, NULL);
+		_bWorkPosted = SUCCEEDED(hr);
+	}
+
+	return hr;
+}
+
+/**
+ * Asks for input up to FFMPEG_ASYNC_INPUT_REQUESTS samples ahead of the
+ * decoder, unless draining or the output queue is full. Caller holds the
+ * MFT lock.
+ */
+HRESULT FFmpegDecoderMFT::_RequestInput()
+{
+	HRESULT hr = S_OK;
+
+	bool bAccept = _bStreaming && !_bDraining
+		&& (!_pContext->HasInitialized() || _pContext->CanAcceptInput());
+
+	while (SUCCEEDED(hr) && bAccept
+		&& _cNeedInput + _PendingInput.GetCount() < FFMPEG_ASYNC_INPUT_REQUESTS)
+	{
+		hr = _QueueInputEvent(METransformNeedInput);
+		if (SUCCEEDED(hr)) _cNeedInput++;
 	}
 
 	return hr;
 }
 
+/** Reports every frame queued since the last call with METransformHaveOutput. */
+HRESULT FFmpegDecoderMFT::_SendOutputEvents()
+{
+	HRESULT hr = S_OK;
+	FrameQueueStats stats;
+
+	_pContext->GetQueueStats(&stats);
+
+	while (SUCCEEDED(hr) && _cHaveOutput < stats.pushes)
+	{
+		hr = QueueEvent(METransformHaveOutput, GUID_NULL, S_OK, NULL);
+		if (SUCCEEDED(hr)) _cHaveOutput++;
+	}
+
+	return hr;
+}
+
+/**
+ * Answers the markers whose input is all decoded with METransformMarker.
+ * Caller holds the MFT lock.
+ */
+HRESULT FFmpegDecoderMFT::_SendMarkerEvents()
+{
+	HRESULT hr = S_OK;
+
+	while (SUCCEEDED(hr) && !_PendingMarkers.IsEmpty()
+		&& _PendingMarkers.GetHead().cInput <= _cInputDecoded)
+	{
+		CComPtr<IMFMediaEvent> spEvent;
+
+		hr = MFCreateMediaEvent(METransformMarker, GUID_NULL, S_OK, NULL, &spEvent);
+
+		if (SUCCEEDED(hr))
+			hr = spEvent->SetUINT64(MF_EVENT_MFT_CONTEXT, _PendingMarkers.RemoveHead().ulParam);
+
+		if (SUCCEEDED(hr))
+			hr = _CheckShutdown();
+
+		if (SUCCEEDED(hr))
+			hr = _spEventQueue->QueueEvent(spEvent);
+	}
+
+	return hr;
+}
+
+/** Marks every frame queued so far as reported, they were dropped. */
+void FFmpegDecoderMFT::_SkipOutputEvents()
+{
+	FrameQueueStats stats;
+
+	_pContext->GetQueueStats(&stats);
+	_cHaveOutput = stats.pushes;
+}
+
+/** Queues an event of the input stream, e.g. METransformNeedInput. */
+HRESULT FFmpegDecoderMFT::_QueueInputEvent(MediaEventType meType)
+{
+	CComPtr<IMFMediaEvent> spEvent;
+
+	HRESULT hr = MFCreateMediaEvent(meType, GUID_NULL, S_OK, NULL, &spEvent);
+
+	if (SUCCEEDED(hr))
+		hr = spEvent->SetUINT32(MF_EVENT_MFT_INPUT_STREAM_ID, 0);
+
+	if (SUCCEEDED(hr))
+		hr = _CheckShutdown();
+
+	if (SUCCEEDED(hr))
+		hr = _spEventQueue->QueueEvent(spEvent);
+
+	return hr;
+}
+
+/** Drops the input queued for the decode worker. Caller holds the MFT lock. */
+void FFmpegDecoderMFT::_ReleasePendingInput()
+{
+	while (!_PendingInput.IsEmpty())
+		_PendingInput.RemoveHead()->Release();
+}
+
@@ -9,7 +9,10 @@ extern "C"
 #include <libavformat/avformat.h> // AVPacket
 }
 
+#include <atomic> // std::atomic
+
 #include "DecoderBase.h" // DecoderBase
+#include "AsyncCallback.h" // AsyncCallback
 
 
 
@@ -29,6 +32,12 @@ namespace FFmpegPack {
 		virtual STDMETHODIMP ProcessInput(__in DWORD dwInputStreamID, __in IMFSample * pSample, __in DWORD dwFlags);
 		virtual STDMETHODIMP ProcessMessage(__in MFT_MESSAGE_TYPE eMessage, __in ULONG_PTR ulParam);
 		virtual STDMETHODIMP ProcessOutput(__in DWORD dwFlags, __in DWORD cOutputBufferCount, __inout_ecount(cOutputBufferCount) MFT_OUTPUT_DATA_BUFFER * pOutputSamples, __out DWORD *pdwStatus);
+		virtual STDMETHODIMP SetOutputType(__in DWORD dwOutputStreamID, __in IMFMediaType * pType, __in DWORD dwFlags);
+
+		///////////////////////////////////////////////////////////
+		//   IMFShutdown Interface
+		///////////////////////////////////////////////////////////
+		virtual STDMETHODIMP Shutdown();
 
 	private:
 		FFmpegDecoderMFT();
@@ -49,10 +58,81 @@ namespace FFmpegPack {
 		/** Reused input media packet. */
 		AVPacket *_pPacket;
 
+		/** Buffers of the input packets that are copied. */
+		PacketBufferPool _PacketPool;
+
+		// Asynchronous mode
+
+		/** Whether the pipeline unlocked asynchronous processing, see MF_TRANSFORM_ASYNC_UNLOCK. */
+		bool _bAsync;
+
+		/** Whether the decoder of the worker was told to drain. */
+		bool _bDrainStarted;
+
+		/** Whether the decode worker is queued already. */
+		bool _bWorkPosted;
+
+		/** Whether METransformHaveOutput announced the pending format change. */
+		bool _bFormatChangeSent;
+
+		/** Dedicated work queue of the decode worker. */
+		DWORD _dwWorkQueue;
+
+		/** METransformNeedInput events not answered yet. */
+		size_t _cNeedInput;
+
+		/** Decoded frames reported with METransformHaveOutput. */
+		uint64_t _cHaveOutput;
+
+		/** Input samples waiting for the decode worker, referenced. */
+		CAtlList<IMFSample*> _PendingInput;
+
+		/** Input samples queued for the decode worker so far, and those it decoded. */
+		uint64_t _cInputQueued;
+		uint64_t _cInputDecoded;
+
+		/** A marker waiting for the input received before it, see MFT_MESSAGE_COMMAND_MARKER. */
+		struct PendingMarker
+		{
+			uint64_t cInput;
+			ULONG_PTR ulParam;
+		};
+
+		/** Markers not answered with METransformMarker yet, in order. */
+		CAtlList<PendingMarker> _PendingMarkers;
+
+		/** Calls _OnDecodeWork on the work queue. */
+		AsyncCallback<FFmpegDecoderMFT> _DecodeCallback;
+
+		/** Asks the decode worker to stop after its current packet, see ProcessMessage. */
+		std::atomic<bool> _bStopWork;
+
+		/** Held by the decode worker, taken before the output lock. */
+		CRITICAL_SECTION _csWorker;
+
+		/**
+		 * Held by ProcessOutput, and while the context is flushed or
+		 * replaced. Taken before the MFT lock.
+		 */
+		CRITICAL_SECTION _csOutput;
+
 
 		///////////////////////////////////////////////////////////
 		//   Private decoder methods
 		///////////////////////////////////////////////////////////
 		HRESULT FFmpegDecoderMFT::StartStream();
+		HRESULT _SuggestOutputType(__inout MFT_OUTPUT_DATA_BUFFER *pOutputSample);
+
+		///////////////////////////////////////////////////////////
+		//   Asynchronous mode methods
+		///////////////////////////////////////////////////////////
+		HRESULT _OnDecodeWork(__in IMFAsyncResult *pAsyncResult);
+		HRESULT _PostDecodeWork();
+		HRESULT _RequestInput();
+		HRESULT _SendOutputEvents();
+		void _SkipOutputEvents();
+		HRESULT _SendMarkerEvents();
+		HRESULT _QueueInputEvent(MediaEventType meType);
+		void _ReleasePendingInput();
 	};
 }
@@ -2,40 +2,70 @@
 
 #pragma once
 
-#include "pch.h"
+#include "DecodeTypes.h"
 
-extern "C"
-{
-#include <libavformat/avformat.h> // AVPacket, AVFrame, AVCodecContext
-}
+namespace FFmpegPack {
+	class DecodeThreadPoolClient;
 
-using namespace Windows::Storage::Streams;
+	/** Converts decoded frames into the output format. Platform-neutral. */
+	class FFmpegTransformHelper {
+
+	public:
+		virtual ~FFmpegTransformHelper() {};
 
-namespace FFmpegPack {
-	ref class FFmpegTransformHelper abstract {
-			
-	internal:
-		
 		/**
 		 * Allocates all necessary resources for processing packets and frames.
 		 * Anything that can fail should go here instead of constructor.
 		 *
-		 * @return S_OK on success, an error code on failure.
+		 * @param pCodecContext  the opened decoder context.
+		 * @param outputFormat   the uncompressed format to produce.
+		 * @param options        the engine tuning.
+		 *
+		 * @return 0 on success, a negative AVERROR code on failure.
+		 */
+		virtual int Initialize(AVCodecContext *pCodecContext, const MediaFormat &outputFormat, const DecodeOptions &options) = 0;
+
+		/**
+		 * Computes the destination size needed for a decoded frame.
+		 *
+		 * @param pFrame  (AVFrame)  the decoded frame produced by FFmpeg.
+		 * @param pitch   the destination row pitch, 0 for tightly packed rows.
+		 * @param pSize   set to the number of bytes needed.
+		 *
+		 * @return 0 on success, a negative AVERROR code on failure.
 		 */
-		virtual HRESULT Initialize(_In_ AVCodecContext *pCodecContext, _In_ IMFMediaType *inputType, _In_ IMFMediaType *outputType) = 0;
+		virtual int GetOutputSize(const AVFrame *pFrame, int pitch, size_t *pSize) = 0;
 
 		/**
-		 * Writes a frame into a data stream, optionally processing it first.
-		 * If nothing is written to stream here there will be NO output.
+		 * Converts a decoded frame into the output format, writing directly
+		 * into the destination buffer.
+		 * If nothing is written here there will be NO output.
 		 *
-		 * @param pFrame  (AVFrame)    the decoded frame produced by FFmpeg.
-		 * @param sStream (DataWriter) a writeable output stream.
+		 * @param pFrame    (AVFrame)  the decoded frame produced by FFmpeg.
+		 * @param dest      the destination, at least GetOutputSize bytes.
+		 * @param pWritten  set to the number of bytes written.
 		 *
-		 * @return S_OK on success, an error code on failure.
+		 * @return 0 on success, a negative AVERROR code on failure.
 		 */
-		virtual HRESULT ProcessDecodedFrame(_In_ AVFrame *pFrame, _Out_ Platform::Array<BYTE>^& phBuffer) = 0;
+		virtual int ProcessDecodedFrame(const AVFrame *pFrame, const FrameBuffer &dest, size_t *pWritten) = 0;
+
+		/**
+		 * Drops whatever is kept from one frame to the next, for a seek.
+		 * Converters and buffers stay allocated.
+		 *
+		 * @return 0 on success, a negative AVERROR code on failure.
+		 */
+		virtual int Flush(void) = 0;
+
+		/**
+		 * Shares the thread pool client of the engine, to spread conversions
+		 * over its workers. Helpers that do not split their work ignore it.
+		 *
+		 * @param pClient  the client, NULL to convert on the calling thread.
+		 */
+		virtual void SetThreadPool(DecodeThreadPoolClient *pClient) {};
 
 		/** Process packet before decoding - if needed. */
-		//virtual HRESULT ProcessEncodedPacket(AVPacket *pPacket) = 0;
+		//virtual int ProcessEncodedPacket(AVPacket *pPacket) = 0;
 	};
-}
\ No newline at end of file
+}
@@ -12,84 +12,178 @@ using namespace FFmpegPack;
 /**
  * Create a FFmpeg Packet from a MF sample.
  * Packet must already be initialized. Data must be freed by av_packet_free().
+ *
+ * A sample of a single buffer with room for the padding is referenced by
+ * the packet as is, and stays locked until the decoder drops the packet.
+ * Other samples are copied into a buffer of the pool.
  */
 HRESULT FFmpegTypes::PacketFromSample(
 	_Out_ AVPacket *pPacket,
-	_In_ IMFSample *pSample
+	_In_ IMFSample *pSample,
+	_In_ PacketBufferPool *pPool
 ) {
-	HRESULT hr = (pPacket && pSample)? S_OK: E_POINTER;
+	HRESULT hr = (pPacket && pSample && pPool)? S_OK: E_POINTER;
+	DWORD bufferCount = 0;
 
-	/* A intermediary media buffer with concat. buffers of the sample. */
-	IMFMediaBuffer *pMediaBuffer = nullptr;
+	if (SUCCEEDED(hr))
+	{
+		// The decoder holds its own reference if it still needs the data
+		av_packet_unref(pPacket);
+		hr = pSample->GetBufferCount(&bufferCount);
+	}
 
-	/* The raw bytes of the sample, along with its total bytes count
-	 and the currently used count. */
-	BYTE *pbBuffer = nullptr;
-	DWORD maxLength, curLength;
+	if (SUCCEEDED(hr) && bufferCount == 1)
+		hr = _WrapSampleBuffer(pPacket, pSample);
 
-	/* An internal buffer used by the AVPacket */
-	uint8_t * pFFBuffer = nullptr;
-	
+	// Several buffers, or not enough room for the padding
+	if (SUCCEEDED(hr) && !pPacket->buf)
+		hr = _CopySampleBuffers(pPacket, pSample, pPool);
+
+	// Copy time and duration
+	LONGLONG sampleDuration, sampleTime;
+	if (SUCCEEDED(hr))
+		hr = pSample->GetSampleDuration(&sampleDuration);
+
+	if (SUCCEEDED(hr))
+		hr = pSample->GetSampleTime(&sampleTime);
 
 	if (SUCCEEDED(hr))
 	{
-		hr = pSample->ConvertToContiguousBuffer(&pMediaBuffer);
-		if (!pMediaBuffer) return E_UNEXPECTED;
+		pPacket->duration = sampleDuration;
+		pPacket->pts = sampleTime;
 	}
 
-	if (SUCCEEDED(hr))
-		hr = pMediaBuffer->Lock(&pbBuffer, &maxLength, &curLength);
+	return hr;
+}
+
+/**
+ * References the only buffer of a sample from a packet, without copy.
+ * The buffer is locked until the packet data is freed.
+ *
+ * @return S_OK on success, S_FALSE if the buffer has no room for the
+ *         padding and the packet is left empty, an error code on failure.
+ */
+HRESULT FFmpegTypes::_WrapSampleBuffer(
+	_Out_ AVPacket *pPacket,
+	_In_ IMFSample *pSample
+) {
+	IMFMediaBuffer *pMediaBuffer = nullptr;
+	BYTE *pbBuffer = nullptr;
+	DWORD maxLength, curLength;
+
+	HRESULT hr = pSample->GetBufferByIndex(0, &pMediaBuffer);
 
 	if (SUCCEEDED(hr))
 	{
-		if (pPacket->data && pPacket->size == curLength)
+		hr = pMediaBuffer->Lock(&pbBuffer, &maxLength, &curLength);
+		if (FAILED(hr))
 		{
-			// Reuse packet buffer
-			pFFBuffer = pPacket->data;
+			pMediaBuffer->Release();
+			return hr;
 		}
-		else
-		{
-			// Free old packet and allocate new packet/buffer
-			if (pPacket->data) av_packet_unref(pPacket);
+	}
+
+	// Bitstream readers may read past the end of the data
+	if (SUCCEEDED(hr) && (maxLength < curLength
+		|| maxLength - curLength < AV_INPUT_BUFFER_PADDING_SIZE
+		|| curLength > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE))
+		hr = S_FALSE;
+
+	if (hr == S_OK)
+	{
+		RtlZeroMemory(pbBuffer + curLength, AV_INPUT_BUFFER_PADDING_SIZE);
 
-			pFFBuffer = (uint8_t *)av_malloc(curLength + AV_INPUT_BUFFER_PADDING_SIZE);
-			if (pFFBuffer == nullptr) hr = E_OUTOFMEMORY;
+		// Owns the lock and the reference from now on
+		pPacket->buf = av_buffer_create(pbBuffer, curLength + AV_INPUT_BUFFER_PADDING_SIZE,
+			_ReleaseMediaBuffer, pMediaBuffer, AV_BUFFER_FLAG_READONLY);
+
+		if (pPacket->buf)
+		{
+			pPacket->data = pbBuffer;
+			pPacket->size = curLength;
+			pMediaBuffer = nullptr;
 		}
+		else hr = E_OUTOFMEMORY;
 	}
 
-	// TODO memcpy could fail? How to test?
-	if (SUCCEEDED(hr))
-		RtlCopyMemory(pFFBuffer, pbBuffer, curLength);
-
-	if (SUCCEEDED(hr) && pFFBuffer != pPacket->data)
+	if (pMediaBuffer)
 	{
-		// Attempt to set buffer info for packet
-		if (av_packet_from_data(pPacket, pFFBuffer, curLength) != 0)
-			hr = E_UNEXPECTED;
+		pMediaBuffer->Unlock();
+		pMediaBuffer->Release();
 	}
 
+	return hr;
+}
 
-	// Copy time and duration
-	LONGLONG sampleDuration, sampleTime;
-	if (SUCCEEDED(hr))
-		hr = pSample->GetSampleDuration(&sampleDuration);
+/** Copies the buffers of a sample one after the other into a pooled buffer. */
+HRESULT FFmpegTypes::_CopySampleBuffers(
+	_Out_ AVPacket *pPacket,
+	_In_ IMFSample *pSample,
+	_In_ PacketBufferPool *pPool
+) {
+	DWORD totalLength = 0, bufferCount = 0, offset = 0;
+
+	HRESULT hr = pSample->GetTotalLength(&totalLength);
 
 	if (SUCCEEDED(hr))
-		hr = pSample->GetSampleTime(&sampleTime);
+		hr = pSample->GetBufferCount(&bufferCount);
 
 	if (SUCCEEDED(hr))
 	{
-		pPacket->duration = sampleDuration;
-		pPacket->pts = sampleTime;
+		pPacket->buf = pPool->Get(totalLength);
+		if (!pPacket->buf) hr = E_OUTOFMEMORY;
 	}
 
-	// Cleanup even on failure
-	hr = pMediaBuffer->Unlock();
-	pMediaBuffer->Release();
+	for (DWORD i = 0; SUCCEEDED(hr) && i < bufferCount; i++)
+	{
+		IMFMediaBuffer *pMediaBuffer = nullptr;
+		BYTE *pbBuffer = nullptr;
+		DWORD maxLength, curLength;
+
+		hr = pSample->GetBufferByIndex(i, &pMediaBuffer);
+
+		if (SUCCEEDED(hr))
+		{
+			hr = pMediaBuffer->Lock(&pbBuffer, &maxLength, &curLength);
+
+			// The total length was read before, the sample must not change
+			if (SUCCEEDED(hr) && curLength > totalLength - offset)
+				hr = E_UNEXPECTED;
+
+			if (SUCCEEDED(hr))
+			{
+				RtlCopyMemory(pPacket->buf->data + offset, pbBuffer, curLength);
+				offset += curLength;
+			}
+
+			if (pbBuffer)
+				pMediaBuffer->Unlock();
+			pMediaBuffer->Release();
+		}
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		pPacket->data = pPacket->buf->data;
+		pPacket->size = offset;
+
+		if (offset < totalLength)
+			RtlZeroMemory(pPacket->data + offset, AV_INPUT_BUFFER_PADDING_SIZE);
+	}
+	else av_packet_unref(pPacket);
 
 	return hr;
 }
 
+/** Unlocks and releases the media buffer referenced by a packet, see _WrapSampleBuffer. */
+void FFmpegTypes::_ReleaseMediaBuffer(void *opaque, uint8_t *data)
+{
+	IMFMediaBuffer *pMediaBuffer = (IMFMediaBuffer *)opaque;
+
+	pMediaBuffer->Unlock();
+	pMediaBuffer->Release();
+}
+
 /**
  * Create a MF sample from a buffer. Sample must already be initialized.
  */
@@ -265,6 +359,95 @@ LONGLONG FFmpegTypes::TimeToAVTime(
 	return LONGLONG(av_q2d(timeBase) * 10000000 * time);
 }
 
+/**
+ * Maps a FFmpeg error code onto the closest HRESULT.
+ * Non-negative values are success.
+ */
+HRESULT FFmpegTypes::HResultFromAVError(int error)
+{
+	if (error >= 0)
+		return S_OK;
+
+	switch (error)
+	{
+		case AVERROR(ENOMEM):
+			return E_OUTOFMEMORY;
+		case AVERROR(EINVAL):
+			return E_INVALIDARG;
+		case AVERROR(EAGAIN):
+			return MF_E_NOTACCEPTING;
+		case AVERROR_DECODER_NOT_FOUND:
+			return MF_E_INVALIDMEDIATYPE;
+		default:
+			return E_FAIL;
+	}
+}
+
+/**
+ * Creates the platform-neutral output description from a MF media type.
+ * ONLY supports audio and video.
+ */
+HRESULT FFmpegTypes::MediaFormatFromMediaType(
+	_Out_ MediaFormat *pFormat,
+	_In_  IMFMediaType *pMediaTypeOut
+) {
+	HRESULT hr = (pFormat && pMediaTypeOut) ? S_OK : E_POINTER;
+	GUID majorType, subType;
+
+	if (SUCCEEDED(hr))
+	{
+		*pFormat = {};
+		pFormat->video.pixelFormat = AV_PIX_FMT_NONE;
+		pFormat->audio.sampleFormat = AV_SAMPLE_FMT_NONE;
+
+		hr = pMediaTypeOut->GetGUID(MF_MT_MAJOR_TYPE, &majorType);
+	}
+
+	if (SUCCEEDED(hr))
+		hr = pMediaTypeOut->GetGUID(MF_MT_SUBTYPE, &subType);
+
+	if (SUCCEEDED(hr) && majorType == MFMediaType_Audio)
+	{
+		pFormat->mediaType = AVMEDIA_TYPE_AUDIO;
+		ARRAYTRANSLATE(FFMPEG_MFTYPES_OUTPUT_AUDIO, FFMPEG_AVTYPES_OUTPUT_AUDIO, subType, pFormat->audio.sampleFormat);
+		if (pFormat->audio.sampleFormat == AV_SAMPLE_FMT_NONE) hr = MF_E_INVALIDMEDIATYPE;
+
+		UINT32 sampleRate, channels, channelMask;
+		if (SUCCEEDED(pMediaTypeOut->GetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, &sampleRate)))
+			pFormat->audio.sampleRate = sampleRate;
+
+		if (SUCCEEDED(pMediaTypeOut->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &channels)))
+			pFormat->audio.channels = channels;
+
+		if (SUCCEEDED(pMediaTypeOut->GetUINT32(MF_MT_AUDIO_CHANNEL_MASK, &channelMask)))
+			pFormat->audio.channelLayout = channelMask;
+	}
+	else if (SUCCEEDED(hr) && majorType == MFMediaType_Video)
+	{
+		pFormat->mediaType = AVMEDIA_TYPE_VIDEO;
+		ARRAYTRANSLATE(FFMPEG_MFTYPES_OUTPUT_VIDEO, FFMPEG_AVTYPES_OUTPUT_VIDEO, subType, pFormat->video.pixelFormat);
+		if (pFormat->video.pixelFormat == AV_PIX_FMT_NONE) hr = MF_E_INVALIDMEDIATYPE;
+
+		// Optional, the engine reports the decoder frame size otherwise
+		UINT32 width, height;
+		if (SUCCEEDED(hr) && SUCCEEDED(MFGetAttributeSize(pMediaTypeOut, MF_MT_FRAME_SIZE, &width, &height)))
+		{
+			pFormat->video.width = width;
+			pFormat->video.height = height;
+		}
+
+		UINT32 nominalRange;
+		if (SUCCEEDED(hr) && SUCCEEDED(pMediaTypeOut->GetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, &nominalRange)))
+			pFormat->video.fullRange = (nominalRange == MFNominalRange_0_255);
+	}
+	else if (SUCCEEDED(hr))
+	{
+		hr = E_INVALIDARG;
+	}
+
+	return hr;
+}
+
 /**
  * Creates FFmpeg codec parameters from a MF media type.
  * ONLY supports audio and video.
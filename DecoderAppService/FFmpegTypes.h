@@ -11,6 +11,9 @@
 #include "FFmpegBuildCodecs.g.h" 
 ////////////////////////////////////////////////////
 
+#include "DecodeTypes.h" // MediaFormat
+#include "PacketBufferPool.h" // PacketBufferPool
+
 using namespace Windows::Storage::Streams;
 
 /**
@@ -60,11 +63,30 @@ namespace FFmpegPack {
 	const int FFMPEG_INPUT_BUFFER_SIZE = 32768;
 	const int FFMPEG_OUTPUT_BUFFER_SIZE = 32768;
 
+	/** Byte alignment requested for output buffers, see MFT_OUTPUT_STREAM_INFO. */
+	const int FFMPEG_OUTPUT_ALIGNMENT = 16;
+
 	/**
-	 * Bits per pixel of the output format. Only 12bpp supported right now.
-	 * (i.e NV12 specifically). Could extend this to support several different.
+	 * Default for the most decoded frames queued for output, see the
+	 * "OutputQueueDepth" property. Once reached, input is refused until
+	 * ProcessOutput catches up, frames stay in the decoder meanwhile.
 	 */
-	const float FFMPEG_OUTPUT_BITS_PER_PIXEL = 12;
+	const size_t FFMPEG_OUTPUT_QUEUE_SIZE = 8;
+
+	/** Most idle output samples kept for reuse, see SamplePool. */
+	const DWORD FFMPEG_OUTPUT_POOL_SIZE = 8;
+
+	/** Input samples requested ahead of the decoder in asynchronous mode, see METransformNeedInput. */
+	const size_t FFMPEG_ASYNC_INPUT_REQUESTS = 2;
+
+	/** Extension property with the number of decoding threads, see DecoderBase::SetProperties. */
+	const wchar_t FFMPEG_PROPERTY_THREAD_COUNT[] = L"ThreadCount";
+
+	/** Extension property with the output queue depth, see DecoderBase::SetProperties. */
+	const wchar_t FFMPEG_PROPERTY_QUEUE_DEPTH[] = L"OutputQueueDepth";
+
+	/** Extension property capping the shared decoding threads, see DecoderBase::SetProperties. */
+	const wchar_t FFMPEG_PROPERTY_POOL_THREADS[] = L"PoolThreadCount";
 
 
 	///////////////////////////////////////////////////////////
@@ -242,17 +264,23 @@ namespace FFmpegPack {
 	/** Conversion utilities between MF and FFmpeg. */
 	class FFmpegTypes {
 	public:
-		static HRESULT PacketFromSample(_Out_ AVPacket *pPacket, _In_ IMFSample *pSample);
+		static HRESULT PacketFromSample(_Out_ AVPacket *pPacket, _In_ IMFSample *pSample, _In_ PacketBufferPool *pPool);
 		static HRESULT SampleFromBuffer(_Out_ IMFSample *pSample, _In_ IBuffer^ hBuffer);
 		static HRESULT SampleFromArray(_Out_ IMFSample *pSample, _In_ Platform::Array<BYTE> ^hArray);
 
 		static HRESULT CodecParamsFromMediaType(_Out_ AVCodecParameters *pCodecParams, _In_ IMFMediaType *pMediaTypeIn, _In_ IMFMediaType *pMediaTypeOut);
+		static HRESULT MediaFormatFromMediaType(_Out_ MediaFormat *pFormat, _In_ IMFMediaType *pMediaTypeOut);
 		static HRESULT CopySample(_In_ CComPtr<IMFSample> spSourceSample, _Out_ CComPtr<IMFSample> spDestSample);
 	
 		static LONGLONG TimeToAVTime(LONGLONG time, AVRational timeBase);
+		static HRESULT HResultFromAVError(int error);
 
 	private:
 		static HRESULT FFmpegTypes::_AudioCodecParams(_Inout_ AVCodecParameters *pCodecParams, _In_ IMFMediaType *pMediaTypeIn, _In_ IMFMediaType *pMediaTypeOut);
 		static HRESULT FFmpegTypes::_VideoCodecParams(_Inout_ AVCodecParameters *pCodecParams, _In_ IMFMediaType *pMediaTypeIn, _In_ IMFMediaType *pMediaTypeOut);
+
+		static HRESULT _WrapSampleBuffer(_Out_ AVPacket *pPacket, _In_ IMFSample *pSample);
+		static HRESULT _CopySampleBuffers(_Out_ AVPacket *pPacket, _In_ IMFSample *pSample, _In_ PacketBufferPool *pPool);
+		static void _ReleaseMediaBuffer(void *opaque, uint8_t *data);
 	};
 };
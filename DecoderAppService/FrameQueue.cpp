@@ -0,0 +1,149 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include "FrameQueue.h"
+
+extern "C"
+{
+#include <libavutil/error.h> // AVERROR
+#include <libavutil/mem.h> // av_malloc_array
+}
+
+using namespace FFmpegPack;
+
+FrameQueue::FrameQueue() :
+	m_ppFrames(nullptr),
+	m_capacity(0),
+	m_head(0),
+	m_tail(0),
+	m_pushes(0),
+	m_fullCount(0),
+	m_occupancySum(0),
+	m_highWater(0)
+{
+}
+
+FrameQueue::~FrameQueue()
+{
+	Clear();
+	av_freep(&m_ppFrames);
+}
+
+/**
+ * Allocates the ring, empty.
+ *
+ * @param capacity  the most frames queued at the same time, at least 1.
+ *
+ * @return 0 on success, a negative AVERROR code on failure.
+ */
+int FrameQueue::Initialize(size_t capacity)
+{
+	if (capacity == 0)
+		return AVERROR(EINVAL);
+
+	Clear();
+	av_freep(&m_ppFrames);
+
+	m_ppFrames = (AVFrame **)av_malloc_array(capacity, sizeof(AVFrame *));
+	m_capacity = (m_ppFrames) ? capacity : 0;
+
+	return (m_ppFrames) ? 0 : AVERROR(ENOMEM);
+}
+
+/**
+ * Queues a frame, producer side. The queue owns the frame once queued.
+ *
+ * @return false if the queue is full, the frame stays with the caller.
+ */
+bool FrameQueue::Push(AVFrame *pFrame)
+{
+	size_t tail = m_tail.load(std::memory_order_relaxed);
+	size_t count = tail - m_head.load(std::memory_order_acquire);
+
+	if (count >= m_capacity)
+	{
+		m_fullCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_ppFrames[tail % m_capacity] = pFrame;
+	m_tail.store(tail + 1, std::memory_order_release);
+
+	count++;
+	m_pushes.fetch_add(1, std::memory_order_relaxed);
+	m_occupancySum.fetch_add(count, std::memory_order_relaxed);
+	if (count > m_highWater.load(std::memory_order_relaxed))
+		m_highWater.store(count, std::memory_order_relaxed);
+
+	return true;
+}
+
+/**
+ * Takes the oldest frame, consumer side. The caller owns the frame.
+ *
+ * @return the frame, or NULL if the queue is empty.
+ */
+AVFrame *FrameQueue::Pop()
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+
+	if (head == m_tail.load(std::memory_order_acquire))
+		return nullptr;
+
+	AVFrame *pFrame = m_ppFrames[head % m_capacity];
+	m_head.store(head + 1, std::memory_order_release);
+
+	return pFrame;
+}
+
+/**
+ * Looks at the oldest frame without taking it, consumer side. The queue
+ * still owns the frame.
+ *
+ * @return the frame, or NULL if the queue is empty.
+ */
+AVFrame *FrameQueue::Peek() const
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+
+	if (head == m_tail.load(std::memory_order_acquire))
+		return nullptr;
+
+	return m_ppFrames[head % m_capacity];
+}
+
+/** Frees every queued frame, consumer side. */
+void FrameQueue::Clear()
+{
+	AVFrame *pFrame = nullptr;
+	while ((pFrame = Pop()) != nullptr)
+		av_frame_free(&pFrame);
+}
+
+/** Frames currently queued. Only a snapshot when the other side is active. */
+size_t FrameQueue::GetCount() const
+{
+	return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+}
+
+size_t FrameQueue::GetCapacity() const
+{
+	return m_capacity;
+}
+
+bool FrameQueue::IsEmpty() const
+{
+	return GetCount() == 0;
+}
+
+bool FrameQueue::IsFull() const
+{
+	return GetCount() >= m_capacity;
+}
+
+void FrameQueue::GetStats(FrameQueueStats *pStats) const
+{
+	pStats->pushes = m_pushes.load(std::memory_order_relaxed);
+	pStats->fullCount = m_fullCount.load(std::memory_order_relaxed);
+	pStats->occupancySum = m_occupancySum.load(std::memory_order_relaxed);
+	pStats->highWater = m_highWater.load(std::memory_order_relaxed);
+}
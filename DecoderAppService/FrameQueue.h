@@ -0,0 +1,88 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavutil/frame.h> // AVFrame
+}
+
+namespace FFmpegPack {
+	/** Bytes kept between the producer and consumer indexes, against false sharing. */
+	const size_t FRAME_QUEUE_CACHE_LINE = 64;
+
+	/** Occupancy counters of a FrameQueue, see FrameQueue::GetStats. */
+	struct FrameQueueStats
+	{
+		/** Frames queued. */
+		uint64_t pushes;
+
+		/** Pushes refused because the queue was full. */
+		uint64_t fullCount;
+
+		/** Sum of the queue length after each push, over pushes for the mean. */
+		uint64_t occupancySum;
+
+		/** Most frames queued at the same time. */
+		size_t highWater;
+	};
+
+	/**
+	 * Bounded single-producer/single-consumer ring of decoded frames.
+	 *
+	 * The decoding side pushes and the delivering side pops without any
+	 * lock: each index is only written by its own side, and published with
+	 * release/acquire ordering so a popped frame is fully written. Calling
+	 * Push from two threads at once, or Pop from two threads at once, is
+	 * not supported. Clear and Peek count as popping.
+	 *
+	 * The depth trades latency for smoothing: a deeper queue absorbs decode
+	 * time spikes, but holds more frames between input and output.
+	 */
+	class FrameQueue
+	{
+	public:
+		FrameQueue();
+		~FrameQueue();
+
+		int Initialize(size_t capacity);
+
+		bool Push(AVFrame *pFrame);
+		AVFrame *Pop(void);
+		AVFrame *Peek(void) const;
+		void Clear(void);
+
+		size_t GetCount(void) const;
+		size_t GetCapacity(void) const;
+		bool IsEmpty(void) const;
+		bool IsFull(void) const;
+
+		void GetStats(FrameQueueStats *pStats) const;
+
+	private:
+		AVFrame **m_ppFrames;
+		size_t m_capacity;
+
+		// Each side's index on its own cache line, padded rather than
+		// aligned so the queue can be allocated with plain new.
+		char m_padding0[FRAME_QUEUE_CACHE_LINE];
+
+		/** Frames popped so far, written by the consumer only. */
+		std::atomic<size_t> m_head;
+		char m_padding1[FRAME_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+		/** Frames pushed so far, written by the producer only. */
+		std::atomic<size_t> m_tail;
+		char m_padding2[FRAME_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+		// Statistics, written by the producer only
+		std::atomic<uint64_t> m_pushes;
+		std::atomic<uint64_t> m_fullCount;
+		std::atomic<uint64_t> m_occupancySum;
+		std::atomic<size_t> m_highWater;
+	};
+};
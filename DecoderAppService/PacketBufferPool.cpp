@@ -0,0 +1,81 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include "PacketBufferPool.h"
+
+#include <limits.h>
+#include <string.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h> // AV_INPUT_BUFFER_PADDING_SIZE
+}
+
+using namespace FFmpegPack;
+
+PacketBufferPool::PacketBufferPool() :
+	m_pPools(),
+	m_gets(0),
+	m_unpooled(0)
+{
+}
+
+PacketBufferPool::~PacketBufferPool()
+{
+	// Buckets are freed once their buffers still held by a decoder are back
+	for (int i = 0; i < PACKET_POOL_MAX_BITS - PACKET_POOL_MIN_BITS + 1; i++)
+		av_buffer_pool_uninit(&m_pPools[i]);
+}
+
+/**
+ * Takes a buffer for a packet of the given size, from the smallest bucket
+ * that fits it along with AV_INPUT_BUFFER_PADDING_SIZE bytes of padding.
+ * The padding is zeroed, the rest is left as is.
+ *
+ * Not thread-safe, buffers may be released from any thread though.
+ *
+ * @param size  the payload size in bytes.
+ *
+ * @return the buffer, or NULL on allocation failure.
+ */
+AVBufferRef *PacketBufferPool::Get(size_t size)
+{
+	if (size > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE)
+		return nullptr;
+
+	size_t padded = size + AV_INPUT_BUFFER_PADDING_SIZE;
+	AVBufferRef *pBuffer = nullptr;
+
+	int bits = PACKET_POOL_MIN_BITS;
+	while (bits <= PACKET_POOL_MAX_BITS && ((size_t)1 << bits) < padded)
+		bits++;
+
+	if (bits > PACKET_POOL_MAX_BITS)
+	{
+		pBuffer = av_buffer_alloc((int)padded);
+		m_unpooled++;
+	}
+	else
+	{
+		AVBufferPool *&pPool = m_pPools[bits - PACKET_POOL_MIN_BITS];
+
+		if (!pPool)
+			pPool = av_buffer_pool_init(1 << bits, nullptr);
+
+		if (pPool)
+			pBuffer = av_buffer_pool_get(pPool);
+	}
+
+	if (pBuffer)
+	{
+		memset(pBuffer->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+		m_gets++;
+	}
+
+	return pBuffer;
+}
+
+void PacketBufferPool::GetStats(PacketBufferPoolStats *pStats) const
+{
+	pStats->gets = m_gets;
+	pStats->unpooled = m_unpooled;
+}
@@ -0,0 +1,54 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavutil/buffer.h> // AVBufferRef, AVBufferPool
+}
+
+namespace FFmpegPack {
+	/** Smallest pooled packet buffer, 4 KiB. */
+	const int PACKET_POOL_MIN_BITS = 12;
+
+	/** Largest pooled packet buffer, 16 MiB. Larger ones are allocated each time. */
+	const int PACKET_POOL_MAX_BITS = 24;
+
+	/** Reuse counters of a PacketBufferPool, see PacketBufferPool::GetStats. */
+	struct PacketBufferPoolStats
+	{
+		/** Buffers handed out. */
+		uint64_t gets;
+
+		/** Buffers too large for any bucket, allocated and freed each time. */
+		uint64_t unpooled;
+	};
+
+	/**
+	 * Padded buffers for compressed packets, pooled by power-of-two size.
+	 *
+	 * Packet sizes vary from one packet to the next, so a single pool of
+	 * one size would either waste memory or miss. Each bucket is its own
+	 * AVBufferPool, created on first use: buffers go back to their bucket
+	 * when the decoder drops its last reference, from any thread.
+	 */
+	class PacketBufferPool
+	{
+	public:
+		PacketBufferPool();
+		~PacketBufferPool();
+
+		AVBufferRef *Get(size_t size);
+
+		void GetStats(PacketBufferPoolStats *pStats) const;
+
+	private:
+		AVBufferPool *m_pPools[PACKET_POOL_MAX_BITS - PACKET_POOL_MIN_BITS + 1];
+
+		uint64_t m_gets;
+		uint64_t m_unpooled;
+	};
+};
@@ -0,0 +1,284 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include "pch.h"
+#include "SamplePool.h"
+
+using namespace FFmpegPack;
+
+SamplePool::SamplePool(DWORD dwMaxFree) :
+	_ulRefCount(1),
+	_dwMaxFree(dwMaxFree),
+	_cbBufferSize(0),
+	_ulOutstanding(0),
+	_bShutdown(false)
+{
+	memset(&_stats, 0, sizeof(_stats));
+	InitializeCriticalSectionEx(&_pcsLock, 0, 0);
+}
+
+SamplePool::~SamplePool()
+{
+	_ReleaseFreeSamples();
+	DeleteCriticalSection(&_pcsLock);
+}
+
+/**
+ * Creates an empty pool.
+ *
+ * @param dwMaxFree  the most idle samples kept for reuse.
+ * @param ppPool     the new pool, with a reference for the caller.
+ */
+HRESULT SamplePool::CreateInstance(
+	__in DWORD dwMaxFree,
+	__deref_out SamplePool **ppPool
+) {
+	HRESULT hr = (ppPool) ? S_OK : E_POINTER;
+
+	if (SUCCEEDED(hr))
+	{
+		*ppPool = new SamplePool(dwMaxFree);
+		if (*ppPool == nullptr) hr = E_OUTOFMEMORY;
+	}
+
+	return hr;
+}
+
+/**
+ * Hands out a sample with a single buffer of at least cbSize bytes.
+ * The sample returns to the pool when its last reference is released.
+ *
+ * @return S_OK on success, an error code on failure:
+ *		MF_E_SHUTDOWN  if the pool was shut down.
+ */
+HRESULT SamplePool::GetSample(
+	__in DWORD cbSize,
+	__deref_out IMFSample **ppSample
+) {
+	HRESULT hr = (ppSample) ? S_OK : E_POINTER;
+	if (FAILED(hr)) return hr;
+
+	EnterCriticalSection(&_pcsLock);
+
+	CComPtr<IMFSample> spSample;
+	CComPtr<IMFTrackedSample> spTracked;
+
+	if (_bShutdown)
+		hr = MF_E_SHUTDOWN;
+
+	// Resize: idle samples are too small from now on
+	if (SUCCEEDED(hr) && cbSize > _cbBufferSize)
+	{
+		_ReleaseFreeSamples();
+		_cbBufferSize = cbSize;
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		if (!_FreeSamples.IsEmpty())
+		{
+			// Takes over the pool reference
+			spSample.Attach(_FreeSamples.RemoveHead());
+			hr = spSample->DeleteAllItems();
+			_stats.hits++;
+		}
+		else
+		{
+			hr = _CreateSample(&spSample);
+			_stats.misses++;
+		}
+	}
+
+	// One shot, the callback has to be set every time the sample goes out
+	if (SUCCEEDED(hr))
+		hr = spSample->QueryInterface(IID_PPV_ARGS(&spTracked));
+
+	if (SUCCEEDED(hr))
+		hr = spTracked->SetAllocator(this, NULL);
+
+	if (SUCCEEDED(hr))
+	{
+		_ulOutstanding++;
+		if (_ulOutstanding > _stats.highWater)
+			_stats.highWater = _ulOutstanding;
+
+		*ppSample = spSample.Detach();
+	}
+
+	LeaveCriticalSection(&_pcsLock);
+
+	return hr;
+}
+
+/** Copies the current counters. */
+void SamplePool::GetStats(__out SamplePoolStats *pStats)
+{
+	if (!pStats) return;
+
+	EnterCriticalSection(&_pcsLock);
+	*pStats = _stats;
+	LeaveCriticalSection(&_pcsLock);
+}
+
+/**
+ * Sets the buffer size of the samples handed out from now on, e.g. after
+ * the output frame size changed mid-stream. Idle samples of another size
+ * are released, those still downstream are dropped as they come back.
+ */
+void SamplePool::Resize(__in DWORD cbSize)
+{
+	EnterCriticalSection(&_pcsLock);
+
+	if (cbSize != _cbBufferSize)
+	{
+		_ReleaseFreeSamples();
+		_cbBufferSize = cbSize;
+	}
+
+	LeaveCriticalSection(&_pcsLock);
+}
+
+/**
+ * Releases all idle samples. Samples still held downstream are freed
+ * when they come back, the pool itself lives until they all did.
+ */
+void SamplePool::Shutdown()
+{
+	EnterCriticalSection(&_pcsLock);
+
+	_bShutdown = true;
+	_ReleaseFreeSamples();
+
+	_RPT3(_CRT_WARN, "SamplePool: %lu hits, %lu misses, %lu high-water\n",
+		_stats.hits, _stats.misses, _stats.highWater);
+
+	LeaveCriticalSection(&_pcsLock);
+}
+
+
+///////////////////////////////////////////////////////////
+//   IUnknown Interface Methods
+///////////////////////////////////////////////////////////
+
+STDMETHODIMP SamplePool::QueryInterface(
+	__in REFIID riid,
+	__out void **outInterface
+) {
+	if (outInterface == NULL)
+		return E_POINTER;
+
+	if (riid == IID_IUnknown || riid == IID_IMFAsyncCallback)
+		*outInterface = static_cast<IMFAsyncCallback*>(this);
+	else
+	{
+		*outInterface = NULL;
+		return E_NOINTERFACE;
+	}
+
+	AddRef();
+
+	return S_OK;
+}
+
+STDMETHODIMP_(ULONG) SamplePool::AddRef()
+{
+	return InterlockedIncrement(&_ulRefCount);
+}
+
+STDMETHODIMP_(ULONG) SamplePool::Release()
+{
+	ULONG ulRefCount = InterlockedDecrement(&_ulRefCount);
+	if (ulRefCount == 0)
+		delete this;
+
+	return ulRefCount;
+}
+
+
+///////////////////////////////////////////////////////////
+//   IMFAsyncCallback Interface Methods
+///////////////////////////////////////////////////////////
+
+STDMETHODIMP SamplePool::GetParameters(
+	__out DWORD *pdwFlags,
+	__out DWORD *pdwQueue
+) {
+	// Optional, use the default behavior
+	return E_NOTIMPL;
+}
+
+/** Called by a tracked sample once downstream released it. */
+STDMETHODIMP SamplePool::Invoke(__in IMFAsyncResult *pAsyncResult)
+{
+	HRESULT hr = (pAsyncResult) ? S_OK : E_POINTER;
+
+	CComPtr<IUnknown> spObject;
+	CComPtr<IMFSample> spSample;
+	CComPtr<IMFMediaBuffer> spBuffer;
+	DWORD cbMaxLength = 0;
+
+	// Holds the sample again, it is freed when spSample goes out of scope
+	// unless the pool keeps it.
+	if (SUCCEEDED(hr))
+		hr = pAsyncResult->GetObject(&spObject);
+
+	if (SUCCEEDED(hr))
+		hr = spObject->QueryInterface(IID_PPV_ARGS(&spSample));
+
+	if (SUCCEEDED(hr))
+		hr = spSample->GetBufferByIndex(0, &spBuffer);
+
+	if (SUCCEEDED(hr))
+		hr = spBuffer->GetMaxLength(&cbMaxLength);
+
+	EnterCriticalSection(&_pcsLock);
+
+	_ulOutstanding--;
+
+	if (SUCCEEDED(hr)
+		&& !_bShutdown
+		&& cbMaxLength == _cbBufferSize
+		&& _FreeSamples.GetCount() < _dwMaxFree)
+	{
+		_FreeSamples.AddTail(spSample.Detach());
+	}
+
+	LeaveCriticalSection(&_pcsLock);
+
+	return hr;
+}
+
+
+///////////////////////////////////////////////////////////
+//   Private Methods
+///////////////////////////////////////////////////////////
+
+/** Allocates a sample with one aligned buffer of the current size. */
+HRESULT SamplePool::_CreateSample(__deref_out IMFSample **ppSample)
+{
+	CComPtr<IMFTrackedSample> spTracked;
+	CComPtr<IMFSample> spSample;
+	CComPtr<IMFMediaBuffer> spBuffer;
+
+	HRESULT hr = MFCreateTrackedSample(&spTracked);
+
+	if (SUCCEEDED(hr))
+		hr = spTracked->QueryInterface(IID_PPV_ARGS(&spSample));
+
+	if (SUCCEEDED(hr))
+		hr = MFCreateAlignedMemoryBuffer(_cbBufferSize, MF_16_BYTE_ALIGNMENT, &spBuffer);
+
+	if (SUCCEEDED(hr))
+		hr = spSample->AddBuffer(spBuffer);
+
+	if (SUCCEEDED(hr))
+		*ppSample = spSample.Detach();
+
+	return hr;
+}
+
+/** Frees all idle samples. Must be called with the lock held. */
+void SamplePool::_ReleaseFreeSamples()
+{
+	while (!_FreeSamples.IsEmpty())
+		_FreeSamples.RemoveHead()->Release();
+}
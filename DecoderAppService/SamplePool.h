@@ -0,0 +1,75 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+
+#include "pch.h"
+
+namespace FFmpegPack {
+	/** Counters of a SamplePool, see SamplePool::GetStats. */
+	struct SamplePoolStats
+	{
+		/** Requests served with a recycled sample. */
+		ULONG hits;
+
+		/** Requests that allocated a new sample. */
+		ULONG misses;
+
+		/** Most samples handed out at the same time. */
+		ULONG highWater;
+	};
+
+	/**
+	 * Bounded pool of output samples, each holding a single memory buffer.
+	 *
+	 * Samples are tracked (see IMFTrackedSample): once downstream releases
+	 * the last reference, the sample comes back through Invoke and is handed
+	 * out again instead of allocating a sample and a buffer for every frame.
+	 * All buffers have the size of the largest request so far, or the size
+	 * set with Resize when the output type changes. Buffers of another size
+	 * are dropped as they come back.
+	 */
+	class SamplePool :
+		public IMFAsyncCallback
+	{
+	public:
+		static HRESULT CreateInstance(__in DWORD dwMaxFree, __deref_out SamplePool **ppPool);
+
+		HRESULT GetSample(__in DWORD cbSize, __deref_out IMFSample **ppSample);
+		void GetStats(__out SamplePoolStats *pStats);
+		void Resize(__in DWORD cbSize);
+		void Shutdown(void);
+
+		///////////////////////////////////////////////////////////
+		//   IUnknown Interface
+		///////////////////////////////////////////////////////////
+		virtual STDMETHODIMP QueryInterface(__in REFIID riid, __out void **outInterface);
+		virtual STDMETHODIMP_(ULONG) AddRef();
+		virtual STDMETHODIMP_(ULONG) Release();
+
+		///////////////////////////////////////////////////////////
+		//   IMFAsyncCallback Interface
+		///////////////////////////////////////////////////////////
+		virtual STDMETHODIMP GetParameters(__out DWORD *pdwFlags, __out DWORD *pdwQueue);
+		virtual STDMETHODIMP Invoke(__in IMFAsyncResult *pAsyncResult);
+
+	private:
+		SamplePool(DWORD dwMaxFree);
+		~SamplePool();
+
+		ULONG _ulRefCount;
+		CRITICAL_SECTION _pcsLock;
+
+		/** Samples ready to be handed out, each holding a pool reference. */
+		CAtlList<IMFSample*> _FreeSamples;
+		DWORD _dwMaxFree;
+		DWORD _cbBufferSize;
+
+		/** Samples currently held downstream. */
+		ULONG _ulOutstanding;
+		SamplePoolStats _stats;
+		bool _bShutdown;
+
+		HRESULT _CreateSample(__deref_out IMFSample **ppSample);
+		void _ReleaseFreeSamples(void);
+	};
+};
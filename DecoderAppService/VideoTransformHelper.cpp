@@ -1,147 +1,531 @@
 //Copyright (c) Microsoft Corporation. All rights reserved.
 
-#include "pch.h"
 #include "VideoTransformHelper.h"
 
-#include "FFmpegTypes.h"
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VIDEO_INTERLEAVE_SSE2
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VIDEO_INTERLEAVE_NEON
+#endif
 
 using namespace FFmpegPack;
 
-VideoTransformHelper::VideoTransformHelper() {
-	
+VideoTransformHelper::VideoTransformHelper() :
+	m_pCodecContext(nullptr),
+	m_outputFormat(AV_PIX_FMT_NONE),
+	m_bFullRange(false),
+	m_bForceScaler(false),
+	m_converterCount(0),
+	m_pThreadClient(nullptr)
+{
 }
 
 VideoTransformHelper::~VideoTransformHelper() 
 {
-	if (m_VideoBufferData)
-		av_freep(m_VideoBufferData);
-
 	if (m_pCodecContext)
 		m_pCodecContext = nullptr;
 
-	if (m_pScaleContext)
-		sws_freeContext(m_pScaleContext);
+	_ClearConverters();
 }
 
-HRESULT VideoTransformHelper::Initialize(
-	_In_ AVCodecContext *pCodecContext, 
-	_In_ IMFMediaType *inputType, 
-	_In_ IMFMediaType *outputType
+int VideoTransformHelper::Initialize(
+	AVCodecContext *pCodecContext, 
+	const MediaFormat &outputFormat,
+	const DecodeOptions &options
 ) {
-	HRESULT hr = (pCodecContext)? S_OK: E_POINTER;
+	int result = (pCodecContext) ? 0 : AVERROR(EINVAL);
 
-	if (FAILED(hr)) return hr;
+	if (result < 0) return result;
 
 	m_pCodecContext = pCodecContext;
 
-	GUID outputMFType;
-	m_outputFormat = AV_PIX_FMT_NONE;
-	if (SUCCEEDED(outputType->GetGUID(MF_MT_SUBTYPE, &outputMFType)))
+	if (outputFormat.video.pixelFormat == AV_PIX_FMT_NONE) return AVERROR(EINVAL);
+
+	// Called again when the output type changes mid-stream: converters
+	// stay cached, unless they no longer pick the right conversion.
+	if (outputFormat.video.fullRange != m_bFullRange || options.forceScaler != m_bForceScaler)
+		_ClearConverters();
+
+	m_outputFormat = outputFormat.video.pixelFormat;
+	m_bFullRange = outputFormat.video.fullRange;
+	m_bForceScaler = options.forceScaler;
+
+	// The converter is created on the first frame, some decoders only
+	// know their pixel format once they have decoded something.
+	return result;
+}
+
+/**
+ * Interleaves two chroma planes into the UV plane of NV12.
+ *
+ * @param width   the chroma width, in samples.
+ * @param height  the chroma height, in rows.
+ */
+static void InterleaveChroma(
+	uint8_t *pDst, int dstPitch,
+	const uint8_t *pU, int uPitch,
+	const uint8_t *pV, int vPitch,
+	int width, int height
+) {
+	for (int y = 0; y < height; y++)
 	{
-		ARRAYTRANSLATE(FFMPEG_MFTYPES_OUTPUT_VIDEO, FFMPEG_AVTYPES_OUTPUT_VIDEO, outputMFType, m_outputFormat);
-		if(m_outputFormat == AV_SAMPLE_FMT_NONE) return E_FAIL;
+		int x = 0;
+
+#if defined(VIDEO_INTERLEAVE_SSE2)
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i u = _mm_loadu_si128((const __m128i *)(pU + x));
+			__m128i v = _mm_loadu_si128((const __m128i *)(pV + x));
+			_mm_storeu_si128((__m128i *)(pDst + 2 * x), _mm_unpacklo_epi8(u, v));
+			_mm_storeu_si128((__m128i *)(pDst + 2 * x + 16), _mm_unpackhi_epi8(u, v));
+		}
+#elif defined(VIDEO_INTERLEAVE_NEON)
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16x2_t uv;
+			uv.val[0] = vld1q_u8(pU + x);
+			uv.val[1] = vld1q_u8(pV + x);
+			vst2q_u8(pDst + 2 * x, uv);
+		}
+#endif
+
+		for (; x < width; x++)
+		{
+			pDst[2 * x] = pU[x];
+			pDst[2 * x + 1] = pV[x];
+		}
+
+		pDst += dstPitch;
+		pU += uPitch;
+		pV += vPitch;
 	}
+}
 
-	// Only NV12 supported right now, change ProcessDecodedFrame and remove
-	_ASSERT(m_outputFormat == AV_PIX_FMT_NV12);
+/** A copy or repack split into bands of rows, see ConvertBand. */
+struct VideoBands
+{
+	const AVFrame *pFrame;
+	VideoConversion conversion;
+	AVPixelFormat format;
+	uint8_t **planes;
+	const int *linesizes;
+
+	/** Rows per band, a multiple of the chroma subsampling. */
+	int rows;
+};
+
+/**
+ * Copies or repacks one band of rows, the planes of each band do not
+ * overlap. The last band takes the rows left.
+ */
+static int ConvertBand(void *pArg, int band)
+{
+	const VideoBands *pBands = (const VideoBands *)pArg;
+	const AVFrame *pFrame = pBands->pFrame;
+	uint8_t **planes = pBands->planes;
+	const int *linesizes = pBands->linesizes;
 
-	if (SUCCEEDED(hr))
-		hr = _CreateScaleContext();
+	int top = band * pBands->rows;
+	int bottom = FFMIN(top + pBands->rows, pFrame->height);
+
+	if (pBands->conversion == VIDEO_CONVERSION_COPY)
+	{
+		const AVPixFmtDescriptor *pDesc = av_pix_fmt_desc_get(pBands->format);
+		int planeCount = av_pix_fmt_count_planes(pBands->format);
+
+		for (int plane = 0; plane < planeCount; plane++)
+		{
+			int shift = (plane == 1 || plane == 2) ? pDesc->log2_chroma_h : 0;
+			int planeTop = top >> shift;
+			int planeBottom = AV_CEIL_RSHIFT(bottom, shift);
+
+			av_image_copy_plane(
+				planes[plane] + (ptrdiff_t)planeTop * linesizes[plane],
+				linesizes[plane],
+				pFrame->data[plane] + (ptrdiff_t)planeTop * pFrame->linesize[plane],
+				pFrame->linesize[plane],
+				av_image_get_linesize(pBands->format, pFrame->width, plane),
+				planeBottom - planeTop
+			);
+		}
+	}
+	else
+	{
+		av_image_copy_plane(
+			planes[0] + (ptrdiff_t)top * linesizes[0],
+			linesizes[0],
+			pFrame->data[0] + (ptrdiff_t)top * pFrame->linesize[0],
+			pFrame->linesize[0],
+			pFrame->width,
+			bottom - top
+		);
+
+		int chromaTop = top >> 1;
+		int chromaBottom = (bottom + 1) >> 1;
+
+		InterleaveChroma(
+			planes[1] + (ptrdiff_t)chromaTop * linesizes[1], linesizes[1],
+			pFrame->data[1] + (ptrdiff_t)chromaTop * pFrame->linesize[1], pFrame->linesize[1],
+			pFrame->data[2] + (ptrdiff_t)chromaTop * pFrame->linesize[2], pFrame->linesize[2],
+			(pFrame->width + 1) >> 1,
+			chromaBottom - chromaTop
+		);
+	}
+
+	return 0;
+}
+
+/**
+ * Maps the deprecated full range (JPEG) formats onto the studio range
+ * format with the same memory layout.
+ */
+AVPixelFormat VideoTransformHelper::_GetStudioRangeFormat(
+	AVPixelFormat format,
+	bool *pbFullRange
+) {
+	*pbFullRange = true;
+
+	switch (format)
+	{
+	case AV_PIX_FMT_YUVJ420P: return AV_PIX_FMT_YUV420P;
+	case AV_PIX_FMT_YUVJ422P: return AV_PIX_FMT_YUV422P;
+	case AV_PIX_FMT_YUVJ444P: return AV_PIX_FMT_YUV444P;
+	default: break;
+	}
 
-	return hr;
+	*pbFullRange = false;
+	return format;
 }
 
-HRESULT VideoTransformHelper::_CreateScaleContext(void)
+/**
+ * Relative cost of producing outputFormat from inputFormat, assuming the
+ * output luma range follows the input: 0 for a plane copy, 1 for a
+ * repack, 2 for a swscale conversion and 3 between RGB and YUV.
+ */
+int VideoTransformHelper::GetConversionCost(
+	AVPixelFormat inputFormat,
+	AVPixelFormat outputFormat
+) {
+	const AVPixFmtDescriptor *pInputDesc = av_pix_fmt_desc_get(inputFormat);
+	const AVPixFmtDescriptor *pOutputDesc = av_pix_fmt_desc_get(outputFormat);
+
+	if (!pInputDesc || !pOutputDesc)
+		return 2;
+
+	bool bFullRange;
+	AVPixelFormat layout = _GetStudioRangeFormat(inputFormat, &bFullRange);
+
+	if (inputFormat == outputFormat || layout == outputFormat)
+		return 0;
+
+	if (layout == AV_PIX_FMT_YUV420P && outputFormat == AV_PIX_FMT_NV12)
+		return 1;
+
+	if ((pInputDesc->flags & AV_PIX_FMT_FLAG_RGB) != (pOutputDesc->flags & AV_PIX_FMT_FLAG_RGB))
+		return 3;
+
+	return 2;
+}
+
+/** Returns true if the converter was made for frames like this one. */
+bool VideoTransformHelper::_IsConverterKey(
+	const VideoConverter &converter,
+	const AVFrame *pFrame
+) const {
+	return (converter.width == pFrame->width
+		&& converter.height == pFrame->height
+		&& converter.inputFormat == pFrame->format
+		&& converter.outputFormat == m_outputFormat);
+}
+
+/**
+ * Makes the converter for frames like this one current, from the cache or
+ * newly created. The least recently used one is dropped when full.
+ */
+int VideoTransformHelper::_SelectConverter(const AVFrame *pFrame)
 {
-	HRESULT hr = (m_pCodecContext && m_outputFormat)? S_OK: E_POINTER;
+	int index = 0;
+	while (index < m_converterCount && !_IsConverterKey(m_converters[index], pFrame))
+		index++;
+
+	VideoConverter converter;
+
+	if (index < m_converterCount)
+		converter = m_converters[index];
+	else
+	{
+		int result = _CreateConverter(pFrame, &converter);
+		if (result < 0)
+			return result;
+
+		if (m_converterCount == VIDEO_CONVERTER_CACHE_SIZE)
+		{
+			index = m_converterCount - 1;
+			sws_freeContext(m_converters[index].pScaleContext);
+		}
+		else
+			index = m_converterCount++;
+	}
+
+	// Most recently used first
+	for (; index > 0; index--)
+		m_converters[index] = m_converters[index - 1];
+	m_converters[0] = converter;
+
+	return 0;
+}
+
+/**
+ * Picks the cheapest way to get frames of this format into the output
+ * format. Repacks keep the exact sample values, so they are only used
+ * when the luma range of both sides matches.
+ */
+int VideoTransformHelper::_CreateConverter(
+	const AVFrame *pFrame,
+	VideoConverter *pConverter
+) {
+	int result = (m_outputFormat != AV_PIX_FMT_NONE) ? 0 : AVERROR(EINVAL);
+	AVPixelFormat inputFormat = (AVPixelFormat)pFrame->format;
+
+	*pConverter = {};
+	pConverter->width = pFrame->width;
+	pConverter->height = pFrame->height;
+	pConverter->inputFormat = inputFormat;
+	pConverter->outputFormat = m_outputFormat;
+	pConverter->conversion = VIDEO_CONVERSION_SCALE;
+
+	if (!m_bForceScaler)
+	{
+		bool bInputFullRange;
+		AVPixelFormat layout = _GetStudioRangeFormat(inputFormat, &bInputFullRange);
+
+		if (inputFormat == m_outputFormat)
+			pConverter->conversion = VIDEO_CONVERSION_COPY;
+
+		else if (bInputFullRange != m_bFullRange)
+			pConverter->conversion = VIDEO_CONVERSION_SCALE;
+
+		else if (layout == m_outputFormat)
+			pConverter->conversion = VIDEO_CONVERSION_COPY;
+
+		else if (layout == AV_PIX_FMT_YUV420P && m_outputFormat == AV_PIX_FMT_NV12)
+			pConverter->conversion = VIDEO_CONVERSION_INTERLEAVE;
+	}
 
 	// Setup software scaler to convert any decoder pixel format (e.g. YUV420P)
 	// to the selected output format.
-	m_pScaleContext = sws_getContext(
-		m_pCodecContext->width,
-		m_pCodecContext->height,
-		m_pCodecContext->pix_fmt,
-		m_pCodecContext->width,
-		m_pCodecContext->height,
-		m_outputFormat,
-		SWS_BICUBIC,
-		NULL,
-		NULL,
-		NULL
-	);
-
-	if (m_pScaleContext == nullptr)
-		hr = E_OUTOFMEMORY;
-
-
-	if (SUCCEEDED(hr))
+	if (result >= 0 && pConverter->conversion == VIDEO_CONVERSION_SCALE)
 	{
-		m_inputFormat = m_pCodecContext->pix_fmt;
-		int allocResult = av_image_alloc(
-			m_VideoBufferData,
-			m_VideoBufferLineSizes,
-			m_pCodecContext->width,
-			m_pCodecContext->height,
+		pConverter->pScaleContext = sws_getContext(
+			pFrame->width,
+			pFrame->height,
+			inputFormat,
+			pFrame->width,
+			pFrame->height,
 			m_outputFormat,
-			1
+			SWS_BICUBIC,
+			NULL,
+			NULL,
+			NULL
 		);
 
-		if (allocResult < 0)
-			hr = E_FAIL;
+		if (pConverter->pScaleContext == nullptr)
+			result = AVERROR(ENOMEM);
 	}
 
-	return hr;
+	return result;
 }
 
+void VideoTransformHelper::_ClearConverters()
+{
+	for (int i = 0; i < m_converterCount; i++)
+		sws_freeContext(m_converters[i].pScaleContext);
+
+	m_converterCount = 0;
+}
+
+/**
+ * Rows per band to split a copy or repack of this frame over the thread
+ * pool, or 0 to convert it whole: without a pool, for small frames and
+ * palettes. swscale conversions are never split, a scaler context cannot
+ * be shared between threads.
+ */
+int VideoTransformHelper::_GetBandRows(const AVFrame *pFrame, VideoConversion conversion)
+{
+	if (!m_pThreadClient || conversion == VIDEO_CONVERSION_SCALE)
+		return 0;
+
+	const AVPixFmtDescriptor *pDesc = av_pix_fmt_desc_get(m_outputFormat);
+	if (!pDesc || (pDesc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_PSEUDOPAL)))
+		return 0;
+
+	int bands = FFMIN(m_pThreadClient->GetThreadShare(), pFrame->height / VIDEO_BAND_MIN_ROWS);
+	if (bands <= 1)
+		return 0;
 
-HRESULT VideoTransformHelper::ProcessDecodedFrame(
-	_In_  AVFrame *pFrame,
-	_Out_ Platform::Array<BYTE>^& phBuffer
+	// Bands start on a chroma row
+	int align = (conversion == VIDEO_CONVERSION_INTERLEAVE) ? 2 : 1 << pDesc->log2_chroma_h;
+	int rows = (pFrame->height + bands - 1) / bands;
+
+	return FFALIGN(rows, align);
+}
+
+/**
+ * Computes the plane pointers of an output image starting at pData.
+ *
+ * @param pitch  the row pitch of the first plane, 0 for tightly packed
+ *               rows. Following planes use the Media Foundation layout:
+ *               the same pitch for NV12, half of it for I420 chroma.
+ *
+ * @return the image size in bytes, or a negative AVERROR code.
+ */
+int VideoTransformHelper::_FillPlanes(
+	int width,
+	int height,
+	int pitch,
+	uint8_t *pData,
+	uint8_t *planes[4],
+	int linesizes[4]
 ) {
-	HRESULT hr = S_OK;
+	int result = av_image_fill_linesizes(linesizes, m_outputFormat, width);
+
+	// Lay the planes out as if the image was pitch pixels wide
+	if (result >= 0 && pitch > 0)
+	{
+		// Bytes per pixel of the first plane, over two pixels for 4:2:2 packing
+		int pixelStep = av_image_get_linesize(m_outputFormat, 2, 0) / 2;
 
-	if (m_inputFormat != m_pCodecContext->pix_fmt) {
-		// Decoder found better format match, need to recreate context.
-		if (m_VideoBufferData)
-			av_freep(m_VideoBufferData);
+		if (pixelStep <= 0 || pitch < linesizes[0] || pitch % pixelStep)
+			return AVERROR(EINVAL);
 
-		if (m_pScaleContext)
-			sws_freeContext(m_pScaleContext);
+		result = av_image_fill_linesizes(linesizes, m_outputFormat, pitch / pixelStep);
 
-		hr = _CreateScaleContext();
-		if (FAILED(hr)) return hr;
+		if (result >= 0 && linesizes[0] != pitch)
+			result = AVERROR(EINVAL);
 	}
 
-	// Convert decoded video pixel format to NV12 using FFmpeg software scaler
-	int scaleResult = sws_scale(
-		m_pScaleContext,
-		(const BYTE **)(pFrame->data),
-		pFrame->linesize,
-		0,
-		m_pCodecContext->height,
-		m_VideoBufferData,
-		m_VideoBufferLineSizes
-	);
-
-	if (scaleResult < 0)
-		hr = E_FAIL;
-
-	if (SUCCEEDED(hr))
+	if (result >= 0)
+		result = av_image_fill_pointers(planes, m_outputFormat, height, pData, linesizes);
+
+	return result;
+}
+
+int VideoTransformHelper::GetOutputSize(
+	const AVFrame *pFrame,
+	int pitch,
+	size_t *pSize
+) {
+	uint8_t *planes[4];
+	int linesizes[4];
+
+	int result = _FillPlanes(pFrame->width, pFrame->height, pitch, NULL, planes, linesizes);
+
+	if (result >= 0)
+		*pSize = result;
+
+	return result;
+}
+
+int VideoTransformHelper::ProcessDecodedFrame(
+	const AVFrame *pFrame,
+	const FrameBuffer &dest,
+	size_t *pWritten
+) {
+	int result = (dest.pData) ? 0 : AVERROR(EINVAL);
+
+	// Decoder found better format match, or the frame size changed
+	if (result >= 0 && (m_converterCount == 0 || !_IsConverterKey(m_converters[0], pFrame)))
+		result = _SelectConverter(pFrame);
+
+	const VideoConverter &converter = m_converters[0];
+
+	uint8_t *planes[4];
+	int linesizes[4];
+	int size = 0;
+
+	if (result >= 0)
+		result = size = _FillPlanes(pFrame->width, pFrame->height, dest.pitch, dest.pData, planes, linesizes);
+
+	if (result >= 0 && (size_t)size > dest.size)
+		result = AVERROR(EINVAL);
+
+	int bandRows = (result >= 0) ? _GetBandRows(pFrame, converter.conversion) : 0;
+
+	// Large frames, copies and repacks in bands on the thread pool
+	if (result >= 0 && bandRows > 0)
+	{
+		VideoBands bands = { pFrame, converter.conversion, m_outputFormat, planes, linesizes, bandRows };
+		result = m_pThreadClient->Execute(ConvertBand, &bands, NULL, (pFrame->height + bandRows - 1) / bandRows);
+	}
+
+	// Same layout, only the pitch may differ
+	else if (result >= 0 && converter.conversion == VIDEO_CONVERSION_COPY)
+	{
+		av_image_copy(
+			planes,
+			linesizes,
+			(const uint8_t **)(pFrame->data),
+			pFrame->linesize,
+			m_outputFormat,
+			pFrame->width,
+			pFrame->height
+		);
+	}
+
+	// I420 to NV12 is a pure chroma interleave, no scaler needed
+	else if (result >= 0 && converter.conversion == VIDEO_CONVERSION_INTERLEAVE)
+	{
+		av_image_copy_plane(
+			planes[0],
+			linesizes[0],
+			pFrame->data[0],
+			pFrame->linesize[0],
+			pFrame->width,
+			pFrame->height
+		);
+
+		InterleaveChroma(
+			planes[1], linesizes[1],
+			pFrame->data[1], pFrame->linesize[1],
+			pFrame->data[2], pFrame->linesize[2],
+			(pFrame->width + 1) >> 1,
+			(pFrame->height + 1) >> 1
+		);
+	}
+
+	// Convert decoded video pixel format to NV12 using FFmpeg software scaler,
+	// writing straight into the destination planes.
+	else if (result >= 0)
 	{
-		int YSize = m_VideoBufferLineSizes[0] * m_pCodecContext->height;
-		int UVSize = m_VideoBufferLineSizes[1] * m_pCodecContext->height / 2;
-		auto outBuffer = ref new Platform::Array<BYTE>(YSize + UVSize);
-
-		RtlCopyMemory(outBuffer->Data, m_VideoBufferData[0], YSize);
-		RtlCopyMemory(outBuffer->Data + YSize, m_VideoBufferData[1], UVSize);
-		
-		phBuffer = outBuffer;
+		int scaleResult = sws_scale(
+			converter.pScaleContext,
+			(const uint8_t **)(pFrame->data),
+			pFrame->linesize,
+			0,
+			pFrame->height,
+			planes,
+			linesizes
+		);
+
+		if (scaleResult < 0)
+			result = scaleResult;
 	}
 
-	// Don't set a timestamp on S_FALSE
-	// Try to get the best effort timestamp for the frame.
-	if (hr == S_OK)
-		pFrame->pts = pFrame->best_effort_timestamp;
+	if (result >= 0)
+		*pWritten = size;
 
-	return S_OK;
+	return result;
+}
+
+/** Nothing is kept between frames, the converter is reused as is. */
+int VideoTransformHelper::Flush()
+{
+	return 0;
+}
+
+void VideoTransformHelper::SetThreadPool(DecodeThreadPoolClient *pClient)
+{
+	m_pThreadClient = pClient;
 }
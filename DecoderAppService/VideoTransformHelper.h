@@ -1,4 +1,5 @@
 #pragma once
+#include "DecodeThreadPool.h"
 #include "FFmpegTransformHelper.h"
 
 extern "C"
@@ -8,38 +9,88 @@ extern "C"
 }
 
 namespace FFmpegPack{
-	ref class VideoTransformHelper :
-		FFmpegTransformHelper
+	/** How decoded frames get into the output format. */
+	enum VideoConversion
+	{
+		/** General conversion with swscale. */
+		VIDEO_CONVERSION_SCALE,
+
+		/** Same format, planes are copied. */
+		VIDEO_CONVERSION_COPY,
+
+		/** Planar 4:2:0 to NV12, luma copied and chroma interleaved. */
+		VIDEO_CONVERSION_INTERLEAVE,
+	};
+
+	/** Converters kept for the frame formats seen last, see VideoTransformHelper. */
+	const int VIDEO_CONVERTER_CACHE_SIZE = 4;
+
+	/** Fewest rows of a band when copies and repacks are split over the thread pool. */
+	const int VIDEO_BAND_MIN_ROWS = 128;
+
+	/** A conversion from one frame format into the output format. */
+	struct VideoConverter
+	{
+		// Key
+		int width;
+		int height;
+		AVPixelFormat inputFormat;
+		AVPixelFormat outputFormat;
+
+		VideoConversion conversion;
+
+		/** Only for VIDEO_CONVERSION_SCALE. */
+		SwsContext *pScaleContext;
+	};
+
+	class VideoTransformHelper :
+		public FFmpegTransformHelper
 	{
 		
 	public:
-		virtual ~VideoTransformHelper();
-
-	internal:
 		VideoTransformHelper();
+		virtual ~VideoTransformHelper();
 
 		///////////////////////////////////////////////////////////
 		//   FFmpegTransformHelper Methods
 		///////////////////////////////////////////////////////////
-		HRESULT Initialize(_In_ AVCodecContext *pCodecContext, _In_ IMFMediaType *inputType, _In_ IMFMediaType *outputType) override;
-		HRESULT ProcessDecodedFrame(_In_ AVFrame *pFrame, _Out_ Platform::Array<BYTE>^& phBuffer) override;
+		int Initialize(AVCodecContext *pCodecContext, const MediaFormat &outputFormat, const DecodeOptions &options) override;
+		int GetOutputSize(const AVFrame *pFrame, int pitch, size_t *pSize) override;
+		int ProcessDecodedFrame(const AVFrame *pFrame, const FrameBuffer &dest, size_t *pWritten) override;
+		int Flush(void) override;
+		void SetThreadPool(DecodeThreadPoolClient *pClient) override;
+
+		static int GetConversionCost(AVPixelFormat inputFormat, AVPixelFormat outputFormat);
 	
 	private:
-		SwsContext* m_pScaleContext;
-
-		int m_VideoBufferLineSizes[4];
-		uint8_t* m_VideoBufferData[4];
-
 		AVCodecContext *m_pCodecContext;
 
 		/** The output uncompressed sample format. */
 		AVPixelFormat m_outputFormat;
+		bool m_bFullRange;
+
+		bool m_bForceScaler;
 
-		/** The input (from decoder) uncompressed sample format. */
-		AVPixelFormat m_inputFormat;
+		/**
+		 * Converters by (width, height, input format, output format), most
+		 * recently used first: the current one is m_converters[0]. Streams
+		 * switching back to a previous resolution find theirs here.
+		 */
+		VideoConverter m_converters[VIDEO_CONVERTER_CACHE_SIZE];
+		int m_converterCount;
+
+		/** Splits copies and repacks into bands of rows, NULL to keep them whole. */
+		DecodeThreadPoolClient *m_pThreadClient;
 
 
 		//// Methods
-		HRESULT _CreateScaleContext(void);
+		static AVPixelFormat _GetStudioRangeFormat(AVPixelFormat format, bool *pbFullRange);
+
+		bool _IsConverterKey(const VideoConverter &converter, const AVFrame *pFrame) const;
+		int _SelectConverter(const AVFrame *pFrame);
+		int _CreateConverter(const AVFrame *pFrame, VideoConverter *pConverter);
+		void _ClearConverters(void);
+		int _FillPlanes(int width, int height, int pitch, uint8_t *pData, uint8_t *planes[4], int linesizes[4]);
+		int _GetBandRows(const AVFrame *pFrame, VideoConversion conversion);
 	};
 };
@@ -0,0 +1,859 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Headless driver for the platform-neutral DecodeEngine.
+//
+// Demuxes a file with libavformat, feeds the packets of one stream to the
+// same decode and conversion path used by the MFT, and reports throughput,
+// per-frame latency and peak memory use.
+//
+// With -i, the file is read like FFmpegInteropMSS reads its streams, through
+// a PrefetchStream over a stand-in for a slow IStream. With -m, like it reads
+// local files, from a MappedFile.
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h> // open
+#include <sys/resource.h> // getrusage
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close
+
+#include "DecodeEngine.h"
+#include "MappedFile.h"
+#include "PrefetchStream.h"
+
+extern "C"
+{
+#include <libavutil/cpu.h> // av_force_cpu_flags
+}
+
+using namespace FFmpegPack;
+using namespace FFmpegInterop;
+
+typedef std::chrono::steady_clock BenchClock;
+
+/** Command line settings. */
+struct BenchOptions
+{
+	AVMediaType mediaType;
+	int repeat;
+	DecodeOptions decode;
+
+	/** Random seeks per run instead of a linear decode, 0 for none. */
+	int seeks;
+
+	/** Reopen the decoder on each seek instead of flushing it. */
+	bool resetOnSeek;
+
+	/** Decoders running at once over the same file, each on its own thread. */
+	int streams;
+
+	/** Milliseconds per read of the stand-in stream with -i, negative to open the file directly. */
+	int ioLatency;
+
+	/** Read 16 KiB on demand with -i, like FFmpegInteropMSS used to. */
+	bool ioFixed;
+
+	/** Read the file from a mapped view. */
+	bool ioMap;
+
+	/** Only demux every packet of the file, no decoding. */
+	bool demuxOnly;
+};
+
+/** Measurements of a single run over a file. */
+struct BenchResult
+{
+	int64_t frames;
+	int64_t bytes;
+	double seconds;
+	double convertSeconds;
+	std::vector<double> latencies;
+
+	/** Frames held back by the decoder, see DecodeEngine::GetDelay. */
+	int delay;
+
+	/** Seeks done, latencies are then from each seek to its first frame. */
+	int64_t seeks;
+
+	/** Reads of the stand-in stream with -i, see PrefetchStreamStats. */
+	PrefetchStreamStats io;
+
+	/** Reads of the mapped file with -m. */
+	MappedFileStats mapped;
+
+	/** Packets demuxed with -d, of every stream. */
+	int64_t packets;
+	int64_t packetBytes;
+};
+
+/** File read with a delay per call, standing in for an IStream over a slow device. */
+class ThrottledFile : public ByteStream
+{
+public:
+	ThrottledFile(FILE *pFile, int latency) : m_pFile(pFile), m_latency(latency) {}
+	virtual ~ThrottledFile() { fclose(m_pFile); }
+
+	virtual int Read(uint8_t *buf, int size) override
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(m_latency));
+
+		size_t count = fread(buf, 1, size, m_pFile);
+		return (count == 0 && ferror(m_pFile)) ? AVERROR(EIO) : (int)count;
+	}
+
+	virtual int64_t Seek(int64_t pos) override
+	{
+		return (fseeko(m_pFile, pos, SEEK_SET) == 0) ? pos : AVERROR(errno);
+	}
+
+	virtual int64_t GetSize() override
+	{
+		struct stat st;
+		return (fstat(fileno(m_pFile), &st) == 0) ? (int64_t)st.st_size : AVERROR(errno);
+	}
+
+private:
+	FILE *m_pFile;
+	int m_latency;
+};
+
+/** Demuxer of a run, and the stream it reads with -i or -m. */
+struct BenchInput
+{
+	AVFormatContext *pFormat;
+	AVIOContext *pIo;
+	PrefetchStream *pStream;
+	MappedFile *pMapped;
+};
+
+static void PrintUsage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-a | -v] [-s] [-t threads] [-p threads] [-j streams] [-l] [-q level] [-k seeks [-r]] [-i ms [-f] | -m] [-d] [-c] [-n repeat] file [file ...]\n"
+		"  -a         decode the best audio stream\n"
+		"  -v         decode the best video stream (default, falls back to audio)\n"
+		"  -s         always convert video with swscale, no repack fast path\n"
+		"  -t threads decoding threads of each decoder, 0 for the shared pool (default)\n"
+		"  -p threads shared pool threads, 0 for one per core (default)\n"
+		"  -j streams decode the file with this many decoders at once\n"
+		"  -l         low latency, no frame threading\n"
+		"  -q level   skip decoding work like under CPU pressure, 0 (none) to 5\n"
+		"  -k seeks   seek to random positions, timing each seek to its first frame\n"
+		"  -r         reopen the decoder on each seek instead of flushing it\n"
+		"  -i ms      read through the FFmpegInterop stream bridge, each read taking ms\n"
+		"  -f         read 16 KiB blocks on demand with -i, no adaptive prefetch\n"
+		"  -m         read the file from a mapped view, like FFmpegInteropMSS reads local files\n"
+		"  -d         only demux every packet, no decoding\n"
+		"  -c         plain C, none of the SIMD functions of FFmpeg\n"
+		"  -n repeat  decode every file this many times\n",
+		name);
+}
+
+/** Peak resident set size of this process, in KiB. */
+static long GetPeakRss()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+
+	return usage.ru_maxrss;
+}
+
+static double Percentile(const std::vector<double> &sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+
+	size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/** Picks the stream to decode and the matching output format. */
+static int OpenStream(AVFormatContext *pFormat, AVMediaType mediaType, MediaFormat *pOutput)
+{
+	int streamIndex = av_find_best_stream(pFormat, mediaType, -1, -1, NULL, 0);
+
+	if (streamIndex < 0 && mediaType == AVMEDIA_TYPE_VIDEO)
+	{
+		mediaType = AVMEDIA_TYPE_AUDIO;
+		streamIndex = av_find_best_stream(pFormat, mediaType, -1, -1, NULL, 0);
+	}
+
+	if (streamIndex < 0)
+		return streamIndex;
+
+	const AVCodecParameters *pParams = pFormat->streams[streamIndex]->codecpar;
+
+	// Same outputs the pack negotiates with the pipeline.
+	*pOutput = {};
+	pOutput->mediaType = mediaType;
+	pOutput->video.width = pParams->width;
+	pOutput->video.height = pParams->height;
+	pOutput->video.pixelFormat = AV_PIX_FMT_NV12;
+	pOutput->audio.sampleRate = pParams->sample_rate;
+	pOutput->audio.channels = pParams->channels;
+	pOutput->audio.channelLayout = pParams->channel_layout;
+	pOutput->audio.sampleFormat = AV_SAMPLE_FMT_FLT;
+
+	return streamIndex;
+}
+
+/** Opens a file, through a PrefetchStream or a MappedFile like FFmpegInteropMSS with -i or -m. */
+static int OpenInput(const char *path, const BenchOptions &options, BenchInput *pInput)
+{
+	*pInput = {};
+
+	if (options.ioMap)
+	{
+		// Same setup as FFmpegInteropMSS::OpenMappedFile
+		const int bufferSize = PREFETCH_MIN_BLOCK_SIZE;
+		int file = open(path, O_RDONLY);
+		if (file < 0)
+			return AVERROR(errno);
+
+		pInput->pMapped = new MappedFile();
+		int result = pInput->pMapped->Open(file, MAPPED_FILE_WINDOW_SIZE);
+		close(file);
+		if (result < 0)
+			return result;
+
+		uint8_t *pBuffer = (uint8_t *)av_malloc(bufferSize);
+		if (pBuffer)
+			pInput->pIo = avio_alloc_context(pBuffer, bufferSize, 0, pInput->pMapped, MappedFile::AvioRead, 0, MappedFile::AvioSeek);
+		if (!pInput->pIo)
+		{
+			av_free(pBuffer);
+			return AVERROR(ENOMEM);
+		}
+	}
+	else if (options.ioLatency >= 0)
+	{
+		// Same setup as FFmpegInteropMSS::CreateMediaStreamSource
+		const int bufferSize = PREFETCH_MIN_BLOCK_SIZE;
+		FILE *pFile = fopen(path, "rb");
+		if (!pFile)
+			return AVERROR(errno);
+
+		pInput->pStream = new PrefetchStream(
+			new ThrottledFile(pFile, options.ioLatency),
+			bufferSize,
+			(options.ioFixed) ? bufferSize : PREFETCH_MAX_BLOCK_SIZE);
+		pInput->pStream->Start(!options.ioFixed);
+
+		uint8_t *pBuffer = (uint8_t *)av_malloc(bufferSize);
+		if (pBuffer)
+			pInput->pIo = avio_alloc_context(pBuffer, bufferSize, 0, pInput->pStream, PrefetchStream::AvioRead, 0, PrefetchStream::AvioSeek);
+		if (!pInput->pIo)
+		{
+			av_free(pBuffer);
+			return AVERROR(ENOMEM);
+		}
+	}
+
+	if (pInput->pIo)
+	{
+		pInput->pFormat = avformat_alloc_context();
+		if (!pInput->pFormat)
+			return AVERROR(ENOMEM);
+
+		pInput->pFormat->pb = pInput->pIo;
+		pInput->pFormat->flags |= AVFMT_FLAG_CUSTOM_IO;
+	}
+
+	return avformat_open_input(&pInput->pFormat, path, NULL, NULL);
+}
+
+/** Closes what OpenInput opened, adding up the reads of the stream. */
+static void CloseInput(BenchInput *pInput, BenchResult *pResult)
+{
+	if (pInput->pFormat)
+		avformat_close_input(&pInput->pFormat);
+
+	if (pInput->pIo)
+	{
+		av_freep(&pInput->pIo->buffer);
+		avio_context_free(&pInput->pIo);
+	}
+
+	if (pInput->pStream)
+	{
+		PrefetchStreamStats stats;
+		pInput->pStream->GetStats(stats);
+
+		pResult->io.reads += stats.reads;
+		pResult->io.bytes += stats.bytes;
+		pResult->io.waits += stats.waits;
+		pResult->io.seeks += stats.seeks;
+		pResult->io.discards += stats.discards;
+		pResult->io.maxBlockSize = std::max(pResult->io.maxBlockSize, stats.maxBlockSize);
+
+		delete pInput->pStream;
+		pInput->pStream = nullptr;
+	}
+
+	if (pInput->pMapped)
+	{
+		MappedFileStats stats;
+		pInput->pMapped->GetStats(stats);
+
+		pResult->mapped.maps += stats.maps;
+		pResult->mapped.bytes += stats.bytes;
+
+		delete pInput->pMapped;
+		pInput->pMapped = nullptr;
+	}
+}
+
+/**
+ * Receives every frame the decoder has ready and converts it, like the
+ * pipeline does with each output sample.
+ */
+static int ReceiveFrames(
+	DecodeEngine &engine,
+	AVFrame *pFrame,
+	FrameBuffer *pBuffer,
+	BenchClock::time_point sent,
+	BenchResult *pResult
+) {
+	int result = 0;
+
+	while (result >= 0)
+	{
+		result = engine.ReceiveFrame(pFrame);
+		if (result < 0)
+			break;
+
+		// Stands in for the pipeline buffer, reused like MF would.
+		size_t size = 0, written = 0;
+		result = engine.GetOutputSize(pFrame, 0, &size);
+
+		if (result >= 0 && size > pBuffer->size)
+		{
+			av_freep(&pBuffer->pData);
+			pBuffer->pData = (uint8_t *)av_malloc(size);
+			pBuffer->size = (pBuffer->pData) ? size : 0;
+			if (!pBuffer->pData) result = AVERROR(ENOMEM);
+		}
+
+		BenchClock::time_point converting = BenchClock::now();
+
+		if (result >= 0)
+			result = engine.ConvertFrame(pFrame, *pBuffer, &written);
+
+		pResult->convertSeconds += std::chrono::duration<double>(BenchClock::now() - converting).count();
+
+		av_frame_unref(pFrame);
+		if (result < 0)
+			break;
+
+		BenchClock::time_point received = BenchClock::now();
+		pResult->latencies.push_back(std::chrono::duration<double, std::milli>(received - sent).count());
+		pResult->frames++;
+		pResult->bytes += written;
+		sent = received;
+	}
+
+	return result;
+}
+
+/** Decodes every packet of the chosen stream once. */
+static int RunFile(const char *path, const BenchOptions &options, BenchResult *pResult)
+{
+	BenchInput input;
+	AVPacket *pPacket = nullptr;
+	AVFrame *pFrame = nullptr;
+	FrameBuffer buffer = {};
+	DecodeEngine engine;
+	MediaFormat output;
+	int streamIndex = -1;
+
+	int result = OpenInput(path, options, &input);
+	AVFormatContext *pFormat = input.pFormat;
+
+	if (result >= 0)
+		result = avformat_find_stream_info(pFormat, NULL);
+
+	if (result >= 0)
+		result = streamIndex = OpenStream(pFormat, options.mediaType, &output);
+
+	if (result >= 0)
+		result = engine.Open(pFormat->streams[streamIndex]->codecpar, output, options.decode);
+
+	if (result >= 0)
+	{
+		pPacket = av_packet_alloc();
+		pFrame = av_frame_alloc();
+		if (!pPacket || !pFrame) result = AVERROR(ENOMEM);
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+
+	while (result >= 0)
+	{
+		int readResult = av_read_frame(pFormat, pPacket);
+		if (readResult == AVERROR_EOF)
+		{
+			// Frames held back by frame threads or reordering
+			result = engine.SendPacket(NULL);
+			if (result >= 0)
+				result = ReceiveFrames(engine, pFrame, &buffer, BenchClock::now(), pResult);
+
+			if (result == AVERROR_EOF)
+				result = 0;
+			break;
+		}
+
+		result = readResult;
+		if (result < 0)
+			break;
+
+		if (pPacket->stream_index != streamIndex)
+		{
+			av_packet_unref(pPacket);
+			continue;
+		}
+
+		// Latency covers sending the packet up to each frame it produced.
+		BenchClock::time_point sent = BenchClock::now();
+		result = engine.SendPacket(pPacket);
+		av_packet_unref(pPacket);
+
+		// Corrupt packets are skipped, like in the pipeline.
+		if (result == AVERROR_INVALIDDATA)
+			result = 0;
+
+		if (result >= 0)
+			result = ReceiveFrames(engine, pFrame, &buffer, sent, pResult);
+
+		pResult->delay = std::max(pResult->delay, engine.GetDelay());
+
+		if (result == AVERROR(EAGAIN) || result == AVERROR_INVALIDDATA)
+			result = 0;
+	}
+
+	pResult->seconds += std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	if (pPacket)
+		av_packet_free(&pPacket);
+
+	if (pFrame)
+		av_frame_free(&pFrame);
+
+	av_freep(&buffer.pData);
+
+	CloseInput(&input, pResult);
+
+	return result;
+}
+
+/** Reads every packet of the file, timing the input and demuxer alone. */
+static int DemuxFile(const char *path, const BenchOptions &options, BenchResult *pResult)
+{
+	BenchInput input;
+	AVPacket *pPacket = nullptr;
+
+	int result = OpenInput(path, options, &input);
+
+	if (result >= 0)
+	{
+		pPacket = av_packet_alloc();
+		if (!pPacket) result = AVERROR(ENOMEM);
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+
+	while (result >= 0)
+	{
+		result = av_read_frame(input.pFormat, pPacket);
+		if (result == AVERROR_EOF)
+		{
+			result = 0;
+			break;
+		}
+
+		if (result >= 0)
+		{
+			pResult->packets++;
+			pResult->packetBytes += pPacket->size;
+			av_packet_unref(pPacket);
+		}
+	}
+
+	pResult->seconds += std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	if (pPacket)
+		av_packet_free(&pPacket);
+
+	CloseInput(&input, pResult);
+
+	return result;
+}
+
+/**
+ * Decodes from the current position until the first frame of the stream
+ * is converted, then drops the rest of what the decoder holds.
+ */
+static int DecodeFirstFrame(
+	AVFormatContext *pFormat,
+	int streamIndex,
+	DecodeEngine &engine,
+	AVPacket *pPacket,
+	AVFrame *pFrame,
+	FrameBuffer *pBuffer,
+	BenchResult *pResult
+) {
+	int result = 0;
+
+	while (result >= 0)
+	{
+		result = engine.ReceiveFrame(pFrame);
+
+		if (result >= 0)
+		{
+			size_t size = 0, written = 0;
+			result = engine.GetOutputSize(pFrame, 0, &size);
+
+			if (result >= 0 && size > pBuffer->size)
+			{
+				av_freep(&pBuffer->pData);
+				pBuffer->pData = (uint8_t *)av_malloc(size);
+				pBuffer->size = (pBuffer->pData) ? size : 0;
+				if (!pBuffer->pData) result = AVERROR(ENOMEM);
+			}
+
+			if (result >= 0)
+				result = engine.ConvertFrame(pFrame, *pBuffer, &written);
+
+			av_frame_unref(pFrame);
+
+			if (result >= 0)
+			{
+				pResult->frames++;
+				pResult->bytes += written;
+			}
+			return result;
+		}
+
+		if (result != AVERROR(EAGAIN))
+			break;
+
+		// Seeked near the end, the decoder still holds the frame
+		result = av_read_frame(pFormat, pPacket);
+		if (result == AVERROR_EOF)
+		{
+			result = engine.SendPacket(NULL);
+			continue;
+		}
+
+		if (result >= 0 && pPacket->stream_index == streamIndex)
+			result = engine.SendPacket(pPacket);
+
+		av_packet_unref(pPacket);
+
+		if (result == AVERROR_INVALIDDATA)
+			result = 0;
+	}
+
+	return result;
+}
+
+/**
+ * Seeks to random positions of the chosen stream, like scrubbing through
+ * it, and measures each seek up to its first converted frame.
+ */
+static int ScrubFile(const char *path, const BenchOptions &options, BenchResult *pResult)
+{
+	BenchInput input;
+	AVPacket *pPacket = nullptr;
+	AVFrame *pFrame = nullptr;
+	FrameBuffer buffer = {};
+	DecodeEngine engine;
+	MediaFormat output;
+	int streamIndex = -1;
+	int64_t duration = 0;
+
+	int result = OpenInput(path, options, &input);
+	AVFormatContext *pFormat = input.pFormat;
+
+	if (result >= 0)
+		result = avformat_find_stream_info(pFormat, NULL);
+
+	if (result >= 0)
+		result = streamIndex = OpenStream(pFormat, options.mediaType, &output);
+
+	if (result >= 0)
+		result = engine.Open(pFormat->streams[streamIndex]->codecpar, output, options.decode);
+
+	if (result >= 0)
+	{
+		pPacket = av_packet_alloc();
+		pFrame = av_frame_alloc();
+		if (!pPacket || !pFrame) result = AVERROR(ENOMEM);
+	}
+
+	if (result >= 0)
+	{
+		AVStream *pStream = pFormat->streams[streamIndex];
+		duration = pStream->duration;
+
+		if (duration <= 0 && pFormat->duration > 0)
+			duration = av_rescale_q(pFormat->duration, AV_TIME_BASE_Q, pStream->time_base);
+
+		if (duration <= 0)
+			result = AVERROR(ENOSYS);
+	}
+
+	// Same positions on every run, for comparable results
+	unsigned int seed = 1;
+
+	for (int i = 0; result >= 0 && i < options.seeks; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		int64_t target = pFormat->streams[streamIndex]->start_time;
+		if (target == AV_NOPTS_VALUE)
+			target = 0;
+		target += (int64_t)((seed >> 8) / (double)(1 << 24) * duration);
+
+		BenchClock::time_point start = BenchClock::now();
+
+		result = av_seek_frame(pFormat, streamIndex, target, AVSEEK_FLAG_BACKWARD);
+
+		if (result >= 0)
+			result = (options.resetOnSeek) ? engine.Reset() : engine.Flush();
+
+		if (result >= 0)
+			result = DecodeFirstFrame(pFormat, streamIndex, engine, pPacket, pFrame, &buffer, pResult);
+
+		// Nothing left to decode after that position
+		if (result == AVERROR_EOF)
+			result = 0;
+
+		double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+		pResult->latencies.push_back(1000.0 * seconds);
+		pResult->seconds += seconds;
+		pResult->seeks++;
+	}
+
+	if (pPacket)
+		av_packet_free(&pPacket);
+
+	if (pFrame)
+		av_frame_free(&pFrame);
+
+	av_freep(&buffer.pData);
+
+	CloseInput(&input, pResult);
+
+	return result;
+}
+
+/**
+ * Decodes a file with several decoders at once, each on its own thread,
+ * like streams playing side by side. Time is the wall time of them all.
+ */
+static int RunStreams(const char *path, const BenchOptions &options, BenchResult *pResult)
+{
+	std::vector<BenchResult> results(options.streams);
+	std::vector<int> runResults(options.streams, 0);
+	std::vector<std::thread> threads;
+
+	BenchClock::time_point start = BenchClock::now();
+
+	for (int i = 0; i < options.streams; i++)
+	{
+		threads.push_back(std::thread([&, i]() {
+			if (options.demuxOnly)
+				runResults[i] = DemuxFile(path, options, &results[i]);
+			else if (options.seeks)
+				runResults[i] = ScrubFile(path, options, &results[i]);
+			else
+				runResults[i] = RunFile(path, options, &results[i]);
+		}));
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	pResult->seconds += std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	int result = 0;
+	for (int i = 0; i < options.streams; i++)
+	{
+		pResult->frames += results[i].frames;
+		pResult->bytes += results[i].bytes;
+		pResult->convertSeconds += results[i].convertSeconds;
+		pResult->latencies.insert(pResult->latencies.end(), results[i].latencies.begin(), results[i].latencies.end());
+		pResult->delay = std::max(pResult->delay, results[i].delay);
+		pResult->seeks += results[i].seeks;
+		pResult->io.reads += results[i].io.reads;
+		pResult->io.bytes += results[i].io.bytes;
+		pResult->io.waits += results[i].io.waits;
+		pResult->io.maxBlockSize = std::max(pResult->io.maxBlockSize, results[i].io.maxBlockSize);
+		pResult->mapped.maps += results[i].mapped.maps;
+		pResult->mapped.bytes += results[i].mapped.bytes;
+		pResult->packets += results[i].packets;
+		pResult->packetBytes += results[i].packetBytes;
+
+		if (runResults[i] < 0)
+			result = runResults[i];
+	}
+
+	return result;
+}
+
+static void PrintResult(const char *path, const BenchResult &result)
+{
+	std::vector<double> sorted(result.latencies);
+	std::sort(sorted.begin(), sorted.end());
+
+	double fps = (result.seconds > 0) ? result.frames / result.seconds : 0.0;
+	double convertMs = (result.frames > 0) ? 1000.0 * result.convertSeconds / result.frames : 0.0;
+
+	printf("%s\n", path);
+	if (result.packets)
+	{
+		double packetMiB = result.packetBytes / (1024.0 * 1024.0);
+		printf("  packets       %lld (%.1f MiB, %.1f MiB/s)\n",
+			(long long)result.packets,
+			packetMiB,
+			(result.seconds > 0) ? packetMiB / result.seconds : 0.0);
+	}
+	else
+		printf("  frames        %lld (%.1f MiB out)\n", (long long)result.frames, result.bytes / (1024.0 * 1024.0));
+	printf("  time          %.3f s\n", result.seconds);
+	printf("  frames/s      %.1f\n", fps);
+	printf("  convert ms    %.3f per frame\n", convertMs);
+	printf("  delay         %d frames\n", result.delay);
+	if (result.seeks)
+		printf("  seeks         %lld\n", (long long)result.seeks);
+	printf("  %s    p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+		(result.seeks) ? "seek ms   " : "latency ms",
+		Percentile(sorted, 0.50),
+		Percentile(sorted, 0.95),
+		Percentile(sorted, 0.99),
+		sorted.empty() ? 0.0 : sorted.back());
+	printf("  peak rss      %.1f MiB\n", GetPeakRss() / 1024.0);
+	if (result.io.reads)
+		printf("  io            %llu reads, %.1f MiB, %llu waits, blocks up to %d KiB\n",
+			(unsigned long long)result.io.reads,
+			result.io.bytes / (1024.0 * 1024.0),
+			(unsigned long long)result.io.waits,
+			result.io.maxBlockSize / 1024);
+	if (result.mapped.maps)
+		printf("  mapped        %llu views, %.1f MiB\n",
+			(unsigned long long)result.mapped.maps,
+			result.mapped.bytes / (1024.0 * 1024.0));
+
+	DecodeThreadPoolStats pool;
+	DecodeThreadPool::GetShared().GetStats(&pool);
+	if (pool.jobs)
+		printf("  pool          %d threads, %llu jobs, %.0f%% on workers, %llu steals\n",
+			pool.threads,
+			(unsigned long long)pool.jobs,
+			100.0 * pool.workerJobs / pool.jobs,
+			(unsigned long long)pool.steals);
+}
+
+int main(int argc, char **argv)
+{
+	BenchOptions options;
+	options.mediaType = AVMEDIA_TYPE_VIDEO;
+	options.repeat = 1;
+	options.decode = {};
+	options.seeks = 0;
+	options.resetOnSeek = false;
+	options.streams = 1;
+	options.ioLatency = -1;
+	options.ioFixed = false;
+	options.ioMap = false;
+	options.demuxOnly = false;
+
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if (!strcmp(argv[arg], "-a"))
+			options.mediaType = AVMEDIA_TYPE_AUDIO;
+		else if (!strcmp(argv[arg], "-v"))
+			options.mediaType = AVMEDIA_TYPE_VIDEO;
+		else if (!strcmp(argv[arg], "-s"))
+			options.decode.forceScaler = true;
+		else if (!strcmp(argv[arg], "-t") && arg + 1 < argc)
+			options.decode.threadCount = std::max(0, atoi(argv[++arg]));
+		else if (!strcmp(argv[arg], "-p") && arg + 1 < argc)
+			DecodeThreadPool::GetShared().SetMaxThreads(std::max(0, atoi(argv[++arg])));
+		else if (!strcmp(argv[arg], "-j") && arg + 1 < argc)
+			options.streams = std::max(1, atoi(argv[++arg]));
+		else if (!strcmp(argv[arg], "-l"))
+			options.decode.lowLatency = true;
+		else if (!strcmp(argv[arg], "-q") && arg + 1 < argc)
+			DecodeEngine::GetSkipForLevel(atoi(argv[++arg]), true, &options.decode.skip);
+		else if (!strcmp(argv[arg], "-k") && arg + 1 < argc)
+			options.seeks = std::max(0, atoi(argv[++arg]));
+		else if (!strcmp(argv[arg], "-r"))
+			options.resetOnSeek = true;
+		else if (!strcmp(argv[arg], "-i") && arg + 1 < argc)
+			options.ioLatency = std::max(0, atoi(argv[++arg]));
+		else if (!strcmp(argv[arg], "-f"))
+			options.ioFixed = true;
+		else if (!strcmp(argv[arg], "-m"))
+			options.ioMap = true;
+		else if (!strcmp(argv[arg], "-d"))
+			options.demuxOnly = true;
+		else if (!strcmp(argv[arg], "-c"))
+			av_force_cpu_flags(0);
+		else if (!strcmp(argv[arg], "-n") && arg + 1 < argc)
+			options.repeat = std::max(1, atoi(argv[++arg]));
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (arg >= argc)
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	av_log_set_level(AV_LOG_ERROR);
+
+	int failures = 0;
+	for (; arg < argc; arg++)
+	{
+		BenchResult result = {};
+		int runResult = 0;
+
+		for (int i = 0; i < options.repeat && runResult >= 0; i++)
+		{
+			if (options.streams > 1)
+				runResult = RunStreams(argv[arg], options, &result);
+			else if (options.demuxOnly)
+				runResult = DemuxFile(argv[arg], options, &result);
+			else if (options.seeks)
+				runResult = ScrubFile(argv[arg], options, &result);
+			else
+				runResult = RunFile(argv[arg], options, &result);
+		}
+
+		if (runResult < 0)
+		{
+			char error[AV_ERROR_MAX_STRING_SIZE];
+			av_strerror(runResult, error, sizeof(error));
+			fprintf(stderr, "%s: %s\n", argv[arg], error);
+			failures++;
+			continue;
+		}
+
+		PrintResult(argv[arg], result);
+	}
+
+	return failures ? 1 : 0;
+}
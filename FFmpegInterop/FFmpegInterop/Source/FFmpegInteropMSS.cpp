@@ -42,6 +42,29 @@ using namespace Windows::Media::MediaProperties;
 // Size of the buffer when reading a stream
 const int FILESTREAMBUFFERSZ = 16384;
 
+// ffmpegOptions keys handled here rather than passed to FFmpeg: the bytes,
+// and milliseconds, of packets demuxed ahead of the sample requests on a
+// thread of its own. Packets are read on request when the size is 0 (default).
+const wchar_t READAHEADSIZE_OPTION[] = L"ReadAheadSize";
+const wchar_t READAHEADDURATION_OPTION[] = L"ReadAheadDuration";
+
+// Same for the packets queued per stream: bytes, milliseconds (no limit
+// when 0), and "Block" or "DropNonKey" (default) once past them, see
+// PacketQueueOverflow.
+const wchar_t PACKETQUEUESIZE_OPTION[] = L"PacketQueueSize";
+const wchar_t PACKETQUEUEDURATION_OPTION[] = L"PacketQueueDuration";
+const wchar_t PACKETQUEUEOVERFLOW_OPTION[] = L"PacketQueueOverflow";
+
+// Same for the stream opened: the largest block read at once in bytes, the
+// reads growing up to it with the bitrate consumed, and 0 to read each
+// block on demand rather than the next one meanwhile.
+const wchar_t STREAMBUFFERMAXSIZE_OPTION[] = L"StreamBufferMaxSize";
+const wchar_t STREAMPREFETCH_OPTION[] = L"StreamPrefetch";
+
+// Same for a local file path given as URI: 0 to read it through the file
+// protocol of FFmpeg rather than from a mapped view.
+const wchar_t MEMORYMAP_OPTION[] = L"MemoryMap";
+
 // Mapping of FFMPEG codec types to Windows recognized subtype strings
 IMapView<int, String^>^ create_map()
 {
@@ -54,9 +77,20 @@ IMapView<int, String^>^ create_map()
 }
 IMapView<int, String^>^ AvCodecMap = create_map();
 
+// Stream read by FFmpeg, through a PrefetchStream
+class FileStream : public ByteStream
+{
+public:
+	FileStream(IStream* stream) : m_stream(stream) {}
+	virtual int Read(uint8_t* buf, int size) override;
+	virtual int64_t Seek(int64_t pos) override;
+	virtual int64_t GetSize() override;
+
+private:
+	IStream* m_stream;
+};
+
 // Static functions passed to FFmpeg
-static int FileStreamRead(void* ptr, uint8_t* buf, int bufSize);
-static int64_t FileStreamSeek(void* ptr, int64_t pos, int whence);
 static int lock_manager(void **mtx, enum AVLockOp op);
 
 // Flag for ffmpeg global setup
@@ -69,11 +103,22 @@ FFmpegInteropMSS::FFmpegInteropMSS()
 	, avFormatCtx(nullptr)
 	, avAudioCodecCtx(nullptr)
 	, avVideoCodecCtx(nullptr)
+	, videoThreadClient(nullptr)
 	, audioStreamIndex(AVERROR_STREAM_NOT_FOUND)
 	, videoStreamIndex(AVERROR_STREAM_NOT_FOUND)
 	, thumbnailStreamIndex(AVERROR_STREAM_NOT_FOUND)
 	, fileStreamData(nullptr)
 	, fileStreamBuffer(nullptr)
+	, fileStreamPrefetch(nullptr)
+	, mappedFile(nullptr)
+	, readAheadSize(0)
+	, readAheadDuration(0)
+	, packetQueueSize(PACKET_QUEUE_DEFAULT_MAX_BYTES)
+	, packetQueueDuration(0)
+	, packetQueueOverflow(PacketQueueOverflow::DropNonKey)
+	, streamBufferMaxSize(PREFETCH_MAX_BLOCK_SIZE)
+	, streamPrefetch(true)
+	, memoryMap(true)
 {
 	if (!isRegistered)
 	{
@@ -84,6 +129,13 @@ FFmpegInteropMSS::FFmpegInteropMSS()
 FFmpegInteropMSS::~FFmpegInteropMSS()
 {
 	mutexGuard.lock();
+
+	// The demux thread queues into the sample providers
+	if (m_pReader != nullptr)
+	{
+		m_pReader->StopReadAhead();
+	}
+
 	if (mss)
 	{
 		mss->Starting -= startingRequestedToken;
@@ -104,9 +156,14 @@ FFmpegInteropMSS::~FFmpegInteropMSS()
 
 	avcodec_close(avVideoCodecCtx);
 	avcodec_close(avAudioCodecCtx);
+	FFmpegPack::DecodeThreadPool::GetShared().Detach(videoThreadClient);
 	avformat_close_input(&avFormatCtx);
 	av_free(avIOCtx);
 	av_dict_free(&avDict);
+
+	// Stops reading ahead, before the stream is released
+	delete fileStreamPrefetch;
+	delete mappedFile;
 	
 	if (fileStreamData != nullptr)
 	{
@@ -183,6 +240,13 @@ HRESULT FFmpegInteropMSS::CreateMediaStreamSource(String^ uri, bool forceAudioDe
 		hr = ParseOptions(ffmpegOptions);
 	}
 
+	if (SUCCEEDED(hr) && memoryMap && SUCCEEDED(OpenMappedFile(uri)))
+	{
+		// The URI still names the file, for probing its format
+		avFormatCtx->pb = avIOCtx;
+		avFormatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+	}
+
 	if (SUCCEEDED(hr))
 	{
 		std::wstring uriW(uri->Begin());
@@ -227,6 +291,36 @@ HRESULT FFmpegInteropMSS::CreateMediaStreamSource(IRandomAccessStream^ stream, b
 		hr = CreateStreamOverRandomAccessStream(reinterpret_cast<IUnknown*>(stream), IID_PPV_ARGS(&fileStreamData));
 	}
 
+	if (SUCCEEDED(hr))
+	{
+		// Populate AVDictionary avDict based on PropertySet ffmpegOptions. List of options can be found in https://www.ffmpeg.org/ffmpeg-protocols.html
+		hr = ParseOptions(ffmpegOptions);
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		// Read the stream in blocks growing with the bitrate, the next one
+		// on a thread of its own while FFmpeg consumes the current one
+		FileStream* fileStream = new (std::nothrow) FileStream(fileStreamData);
+		if (fileStream != nullptr)
+		{
+			fileStreamPrefetch = new (std::nothrow) PrefetchStream(fileStream, FILESTREAMBUFFERSZ, streamBufferMaxSize);
+			if (fileStreamPrefetch == nullptr)
+			{
+				delete fileStream;
+			}
+		}
+
+		if (fileStreamPrefetch == nullptr)
+		{
+			hr = E_OUTOFMEMORY;
+		}
+		else if (fileStreamPrefetch->Start(streamPrefetch) < 0)
+		{
+			DebugMessage(L"Could not start the prefetch thread\n");
+		}
+	}
+
 	if (SUCCEEDED(hr))
 	{
 		// Setup FFmpeg custom IO to access file as stream. This is necessary when accessing any file outside of app installation directory and appdata folder.
@@ -240,7 +334,7 @@ HRESULT FFmpegInteropMSS::CreateMediaStreamSource(IRandomAccessStream^ stream, b
 
 	if (SUCCEEDED(hr))
 	{
-		avIOCtx = avio_alloc_context(fileStreamBuffer, FILESTREAMBUFFERSZ, 0, fileStreamData, FileStreamRead, 0, FileStreamSeek);
+		avIOCtx = avio_alloc_context(fileStreamBuffer, FILESTREAMBUFFERSZ, 0, fileStreamPrefetch, PrefetchStream::AvioRead, 0, PrefetchStream::AvioSeek);
 		if (avIOCtx == nullptr)
 		{
 			hr = E_OUTOFMEMORY;
@@ -256,12 +350,6 @@ HRESULT FFmpegInteropMSS::CreateMediaStreamSource(IRandomAccessStream^ stream, b
 		}
 	}
 
-	if (SUCCEEDED(hr))
-	{
-		// Populate AVDictionary avDict based on PropertySet ffmpegOptions. List of options can be found in https://www.ffmpeg.org/ffmpeg-protocols.html
-		hr = ParseOptions(ffmpegOptions);
-	}
-
 	if (SUCCEEDED(hr))
 	{
 		avFormatCtx->pb = avIOCtx;
@@ -456,11 +544,13 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 
 				if (SUCCEEDED(hr))
 				{
-					// enable multi threading
-					unsigned threads = std::thread::hardware_concurrency();
-					if (threads > 0)
+					// enable multi threading on the threads shared by all decoders:
+					// slices run on the pool, frame threads take a fair share of it
+					videoThreadClient = FFmpegPack::DecodeThreadPool::GetShared().Attach();
+					if (videoThreadClient)
 					{
-						avVideoCodecCtx->thread_count = threads;
+						bool frameThreads = (avVideoCodec->capabilities & AV_CODEC_CAP_FRAME_THREADS) != 0;
+						avVideoCodecCtx->thread_count = frameThreads ? videoThreadClient->GetThreadShare() : 1;
 						avVideoCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 					}
 
@@ -471,6 +561,11 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 					}
 					else
 					{
+						if (videoThreadClient && !(avVideoCodecCtx->active_thread_type & FF_THREAD_FRAME))
+						{
+							videoThreadClient->SetupCodec(avVideoCodecCtx);
+						}
+
 						// Detect video format and create video stream descriptor accordingly
 						hr = CreateVideoStreamDescriptor(forceVideoDecode);
 						if (SUCCEEDED(hr))
@@ -557,6 +652,25 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 		}
 	}
 
+	if (SUCCEEDED(hr))
+	{
+		if (audioSampleProvider != nullptr)
+		{
+			audioSampleProvider->SetPacketQueueLimits(packetQueueSize, packetQueueDuration, packetQueueOverflow);
+		}
+
+		if (videoSampleProvider != nullptr)
+		{
+			videoSampleProvider->SetPacketQueueLimits(packetQueueSize, packetQueueDuration, packetQueueOverflow);
+		}
+	}
+
+	if (SUCCEEDED(hr) && readAheadSize > 0)
+	{
+		// Serve sample requests from memory, the stream is read ahead of them
+		m_pReader->StartReadAhead(readAheadSize, readAheadDuration);
+	}
+
 	return hr;
 }
 
@@ -744,8 +858,52 @@ HRESULT FFmpegInteropMSS::ParseOptions(PropertySet^ ffmpegOptions)
 			std::string valueA(valueW.begin(), valueW.end());
 			const char* valueChar = valueA.c_str();
 
+			if (keyW == READAHEADSIZE_OPTION)
+			{
+				readAheadSize = _wtoi64(valueW.c_str());
+			}
+			else if (keyW == READAHEADDURATION_OPTION)
+			{
+				readAheadDuration = _wtoi64(valueW.c_str()) * 10000;
+			}
+			else if (keyW == PACKETQUEUESIZE_OPTION)
+			{
+				packetQueueSize = _wtoi64(valueW.c_str());
+			}
+			else if (keyW == PACKETQUEUEDURATION_OPTION)
+			{
+				packetQueueDuration = _wtoi64(valueW.c_str()) * 10000;
+			}
+			else if (keyW == PACKETQUEUEOVERFLOW_OPTION)
+			{
+				if (valueW == L"Block")
+				{
+					packetQueueOverflow = PacketQueueOverflow::Block;
+				}
+				else if (valueW == L"DropNonKey")
+				{
+					packetQueueOverflow = PacketQueueOverflow::DropNonKey;
+				}
+				else
+				{
+					hr = E_INVALIDARG;
+					break;
+				}
+			}
+			else if (keyW == STREAMBUFFERMAXSIZE_OPTION)
+			{
+				streamBufferMaxSize = _wtoi(valueW.c_str());
+			}
+			else if (keyW == STREAMPREFETCH_OPTION)
+			{
+				streamPrefetch = _wtoi(valueW.c_str()) != 0;
+			}
+			else if (keyW == MEMORYMAP_OPTION)
+			{
+				memoryMap = _wtoi(valueW.c_str()) != 0;
+			}
 			// Add key and value pair entry
-			if (av_dict_set(&avDict, keyChar, valueChar, 0) < 0)
+			else if (av_dict_set(&avDict, keyChar, valueChar, 0) < 0)
 			{
 				hr = E_INVALIDARG;
 				break;
@@ -758,6 +916,85 @@ HRESULT FFmpegInteropMSS::ParseOptions(PropertySet^ ffmpegOptions)
 	return hr;
 }
 
+// Set up avIOCtx over a mapped view of the file, if the URI is a local path.
+// Copies the demuxer reads straight from the page cache into the packets,
+// without read calls.
+HRESULT FFmpegInteropMSS::OpenMappedFile(String^ uri)
+{
+	HRESULT hr = S_OK;
+	std::wstring path(uri->Begin());
+
+	// Same prefix as the file protocol of FFmpeg, other protocols are not local
+	if (path.compare(0, 5, L"file:") == 0)
+	{
+		path.erase(0, 5);
+	}
+	else if (path.find(L"://") != std::wstring::npos)
+	{
+		hr = E_INVALIDARG;
+	}
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+	if (SUCCEEDED(hr))
+	{
+		// Only files the app has access to, like with the file protocol
+		file = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			hr = HRESULT_FROM_WIN32(GetLastError());
+		}
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		mappedFile = new (std::nothrow) MappedFile();
+		if (mappedFile == nullptr)
+		{
+			hr = E_OUTOFMEMORY;
+		}
+		else if (mappedFile->Open(file, MAPPED_FILE_WINDOW_SIZE) < 0)
+		{
+			hr = E_FAIL;
+		}
+	}
+
+	// The mapping keeps the file open
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file);
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		fileStreamBuffer = (unsigned char*)av_malloc(FILESTREAMBUFFERSZ);
+		if (fileStreamBuffer == nullptr)
+		{
+			hr = E_OUTOFMEMORY;
+		}
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		avIOCtx = avio_alloc_context(fileStreamBuffer, FILESTREAMBUFFERSZ, 0, mappedFile, MappedFile::AvioRead, 0, MappedFile::AvioSeek);
+		if (avIOCtx == nullptr)
+		{
+			hr = E_OUTOFMEMORY;
+		}
+	}
+
+	// Not in direct mode: demuxers seek and skip often, and direct mode
+	// drops and refills the buffer on each of them
+	if (FAILED(hr))
+	{
+		DebugMessage(L"Not memory mapping the file\n");
+		av_freep(&fileStreamBuffer);
+		delete mappedFile;
+		mappedFile = nullptr;
+	}
+
+	return hr;
+}
+
 void FFmpegInteropMSS::OnStarting(MediaStreamSource ^sender, MediaStreamSourceStartingEventArgs ^args)
 {
 	MediaStreamSourceStartingRequest^ request = args->Request;
@@ -773,7 +1010,8 @@ void FFmpegInteropMSS::OnStarting(MediaStreamSource ^sender, MediaStreamSourceSt
 			// Convert TimeSpan unit to AV_TIME_BASE
 			int64_t seekTarget = static_cast<int64_t>(request->StartPosition->Value.Duration / (av_q2d(avFormatCtx->streams[streamIndex]->time_base) * 10000000));
 
-			if (av_seek_frame(avFormatCtx, streamIndex, seekTarget, AVSEEK_FLAG_BACKWARD) < 0)
+			// The reader flushes the sample providers, along with the packets read ahead
+			if (m_pReader->Seek(streamIndex, seekTarget, AVSEEK_FLAG_BACKWARD) < 0)
 			{
 				DebugMessage(L" - ### Error while seeking\n");
 			}
@@ -781,26 +1019,16 @@ void FFmpegInteropMSS::OnStarting(MediaStreamSource ^sender, MediaStreamSourceSt
 			{
 				// Add deferral
 
-				// Flush the AudioSampleProvider
-				if (audioSampleProvider != nullptr)
+				// Flush the audio decoder
+				if (audioSampleProvider != nullptr && avAudioCodecCtx != nullptr)
 				{
-					audioSampleProvider->EnableStream();
-					audioSampleProvider->Flush();
-					if (avAudioCodecCtx != nullptr)
-					{
-						avcodec_flush_buffers(avAudioCodecCtx);
-					}
+					avcodec_flush_buffers(avAudioCodecCtx);
 				}
 
-				// Flush the VideoSampleProvider
-				if (videoSampleProvider != nullptr)
+				// Flush the video decoder
+				if (videoSampleProvider != nullptr && avVideoCodecCtx != nullptr)
 				{
-					videoSampleProvider->EnableStream();
-					videoSampleProvider->Flush();
-					if (avVideoCodecCtx != nullptr)
-					{
-						avcodec_flush_buffers(avVideoCodecCtx);
-					}
+					avcodec_flush_buffers(avVideoCodecCtx);
 				}
 			}
 		}
@@ -830,36 +1058,29 @@ void FFmpegInteropMSS::OnSampleRequested(Windows::Media::Core::MediaStreamSource
 	mutexGuard.unlock();
 }
 
-// Static function to read file stream and pass data to FFmpeg. Credit to Philipp Sch http://www.codeproject.com/Tips/489450/Creating-Custom-FFmpeg-IO-Context
-static int FileStreamRead(void* ptr, uint8_t* buf, int bufSize)
+// Read the file stream for FFmpeg. Credit to Philipp Sch http://www.codeproject.com/Tips/489450/Creating-Custom-FFmpeg-IO-Context
+int FileStream::Read(uint8_t* buf, int size)
 {
-	IStream* pStream = reinterpret_cast<IStream*>(ptr);
 	ULONG bytesRead = 0;
-	HRESULT hr = pStream->Read(buf, bufSize, &bytesRead);
+	HRESULT hr = m_stream->Read(buf, size, &bytesRead);
 
 	if (FAILED(hr))
 	{
 		return -1;
 	}
 
-	// If we succeed but don't have any bytes, assume end of file
-	if (bytesRead == 0)
-	{
-		return AVERROR_EOF;  // Let FFmpeg know that we have reached eof
-	}
-
+	// If we succeed but don't have any bytes, PrefetchStream assumes end of file
 	return bytesRead;
 }
 
-// Static function to seek in file stream. Credit to Philipp Sch http://www.codeproject.com/Tips/489450/Creating-Custom-FFmpeg-IO-Context
-static int64_t FileStreamSeek(void* ptr, int64_t pos, int whence)
+// Seek in the file stream. Credit to Philipp Sch http://www.codeproject.com/Tips/489450/Creating-Custom-FFmpeg-IO-Context
+int64_t FileStream::Seek(int64_t pos)
 {
-	IStream* pStream = reinterpret_cast<IStream*>(ptr);
 	LARGE_INTEGER in;
 	in.QuadPart = pos;
 	ULARGE_INTEGER out = { 0 };
 
-	if (FAILED(pStream->Seek(in, whence, &out)))
+	if (FAILED(m_stream->Seek(in, STREAM_SEEK_SET, &out)))
 	{
 		return -1;
 	}
@@ -867,6 +1088,19 @@ static int64_t FileStreamSeek(void* ptr, int64_t pos, int whence)
 	return out.QuadPart; // Return the new position:
 }
 
+// Size of the file stream, for AVSEEK_SIZE
+int64_t FileStream::GetSize()
+{
+	STATSTG stat;
+
+	if (FAILED(m_stream->Stat(&stat, STATFLAG_NONAME)))
+	{
+		return -1;
+	}
+
+	return stat.cbSize.QuadPart;
+}
+
 static int lock_manager(void **mtx, enum AVLockOp op)
 {
 	switch (op)
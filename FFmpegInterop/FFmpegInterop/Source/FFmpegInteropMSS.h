@@ -21,6 +21,9 @@
 #include <mutex>
 #include "FFmpegReader.h"
 #include "MediaSampleProvider.h"
+#include "PrefetchStream.h"
+#include "MappedFile.h"
+#include "DecodeThreadPool.h"
 #include "MediaThumbnailData.h"
 
 using namespace Platform;
@@ -100,6 +103,7 @@ namespace FFmpegInterop
 		HRESULT CreateVideoStreamDescriptor(bool forceVideoDecode);
 		HRESULT ConvertCodecName(const char* codecName, String^ *outputCodecName);
 		HRESULT ParseOptions(PropertySet^ ffmpegOptions);
+		HRESULT OpenMappedFile(String^ uri);
 		void OnStarting(MediaStreamSource ^sender, MediaStreamSourceStartingEventArgs ^args);
 		void OnSampleRequested(MediaStreamSource ^sender, MediaStreamSourceSampleRequestedEventArgs ^args);
 
@@ -115,6 +119,9 @@ namespace FFmpegInterop
 		AVCodecContext* avVideoCodecCtx;
 
 	private:
+		// Video decoding threads shared with the other decoders of the process
+		FFmpegPack::DecodeThreadPoolClient* videoThreadClient;
+
 		AudioStreamDescriptor^ audioStreamDescriptor;
 		VideoStreamDescriptor^ videoStreamDescriptor;
 		int audioStreamIndex;
@@ -133,6 +140,25 @@ namespace FFmpegInterop
 		TimeSpan mediaDuration;
 		IStream* fileStreamData;
 		unsigned char* fileStreamBuffer;
+		PrefetchStream* fileStreamPrefetch;
+		MappedFile* mappedFile;
 		FFmpegReader^ m_pReader;
+
+		// Demux read-ahead budget from the ffmpegOptions, no read-ahead when 0
+		int64 readAheadSize;
+		int64 readAheadDuration;
+
+		// Packet queue limits of each stream from the ffmpegOptions
+		int64 packetQueueSize;
+		int64 packetQueueDuration;
+		PacketQueueOverflow packetQueueOverflow;
+
+		// Largest reads of the stream, and whether to read ahead of the
+		// demuxer, from the ffmpegOptions
+		int streamBufferMaxSize;
+		bool streamPrefetch;
+
+		// Read local files from a mapped view, from the ffmpegOptions
+		bool memoryMap;
 	};
 }
@@ -18,6 +18,7 @@
 
 #include "pch.h"
 #include "FFmpegReader.h"
+#include <system_error>
 
 using namespace FFmpegInterop;
 
@@ -25,16 +26,58 @@ FFmpegReader::FFmpegReader(AVFormatContext* avFormatCtx)
 	: m_pAvFormatCtx(avFormatCtx)
 	, m_audioStreamIndex(AVERROR_STREAM_NOT_FOUND)
 	, m_videoStreamIndex(AVERROR_STREAM_NOT_FOUND)
+	, m_maxQueuedBytes(0)
+	, m_maxQueuedDuration(0)
+	, m_queuedBytes(0)
+	, m_queuedDuration(0)
+	, m_queuedPackets(0)
+	, m_waitingReaders(0)
+	, m_readResult(0)
+	, m_stopReadAhead(false)
 {
 }
 
 FFmpegReader::~FFmpegReader()
 {
+	StopReadAhead();
 }
 
 // Read the next packet from the stream and push it into the appropriate
-// sample provider
+// sample provider. With read-ahead, wait for the demux thread to push one
+// instead.
 int FFmpegReader::ReadPacket()
+{
+	if (!m_readAheadThread.joinable())
+	{
+		std::lock_guard<std::mutex> demuxLock(m_demuxMutex);
+		return ReadPacketNow();
+	}
+
+	std::unique_lock<std::mutex> lock(m_readAheadMutex);
+	uint64 queuedPackets = m_queuedPackets;
+
+	// The budget may be full of packets for the other stream, the demux
+	// thread reads past it while someone waits
+	m_waitingReaders++;
+	m_readAheadCond.notify_one();
+
+	while (m_queuedPackets == queuedPackets && m_readResult >= 0 && !m_stopReadAhead)
+	{
+		m_packetQueuedCond.wait(lock);
+	}
+
+	m_waitingReaders--;
+
+	if (m_queuedPackets != queuedPackets)
+	{
+		return 0;
+	}
+
+	return m_readResult < 0 ? m_readResult : AVERROR_EXIT;
+}
+
+// Demux one packet into its sample provider, under m_demuxMutex
+int FFmpegReader::ReadPacketNow()
 {
 	int ret;
 	AVPacket avPacket;
@@ -48,14 +91,20 @@ int FFmpegReader::ReadPacket()
 		return ret;
 	}
 
+	// Accounted before the packet is handed over
+	AVRational timeBase = m_pAvFormatCtx->streams[avPacket.stream_index]->time_base;
+	int64 size = avPacket.size;
+	int64 duration = av_rescale_q(avPacket.duration, timeBase, { 1, 10000000 });
+	bool queued = false;
+
 	// Push the packet to the appropriate
 	if (avPacket.stream_index == m_audioStreamIndex && m_audioSampleProvider != nullptr)
 	{
-		m_audioSampleProvider->QueuePacket(avPacket);
+		queued = m_audioSampleProvider->QueuePacket(avPacket);
 	}
 	else if (avPacket.stream_index == m_videoStreamIndex && m_videoSampleProvider != nullptr)
 	{
-		m_videoSampleProvider->QueuePacket(avPacket);
+		queued = m_videoSampleProvider->QueuePacket(avPacket);
 	}
 	else
 	{
@@ -63,6 +112,155 @@ int FFmpegReader::ReadPacket()
 		av_packet_unref(&avPacket);
 	}
 
+	if (queued)
+	{
+		std::lock_guard<std::mutex> lock(m_readAheadMutex);
+		m_queuedBytes += size;
+		m_queuedDuration += duration;
+		m_queuedPackets++;
+	}
+
+	m_packetQueuedCond.notify_all();
+
+	return ret;
+}
+
+// Start demuxing ahead of the sample requests on a thread of its own, until
+// maxBytes or maxDuration (100ns units, 0 for no limit) are queued
+void FFmpegReader::StartReadAhead(int64 maxBytes, int64 maxDuration)
+{
+	StopReadAhead();
+
+	m_maxQueuedBytes = maxBytes;
+	m_maxQueuedDuration = maxDuration;
+	m_stopReadAhead = false;
+
+	try
+	{
+		m_readAheadThread = std::thread([this]() { ReadAheadMain(); });
+	}
+	catch (const std::system_error&)
+	{
+		// Packets are read on request as before
+		DebugMessage(L"Could not start the read-ahead thread\n");
+	}
+}
+
+// Stop the demux thread, packets already queued stay in the sample providers
+void FFmpegReader::StopReadAhead()
+{
+	if (!m_readAheadThread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_readAheadMutex);
+		m_stopReadAhead = true;
+	}
+
+	m_readAheadCond.notify_all();
+	m_packetQueuedCond.notify_all();
+	m_readAheadThread.join();
+}
+
+void FFmpegReader::ReadAheadMain()
+{
+	std::unique_lock<std::mutex> lock(m_readAheadMutex);
+
+	while (!m_stopReadAhead)
+	{
+		// Wait for room in the budget, or for a seek after the end of the stream
+		if (m_readResult < 0 || (IsReadAheadFull() && m_waitingReaders == 0))
+		{
+			m_readAheadCond.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+
+		{
+			std::lock_guard<std::mutex> demuxLock(m_demuxMutex);
+			int ret = ReadPacketNow();
+
+			// Published before releasing the demuxer, so that a Seek in
+			// between cannot be overwritten by the result of the old position
+			lock.lock();
+
+			if (ret < 0)
+			{
+				DebugMessage(L"Read-ahead reaching EOF\n");
+				m_readResult = ret;
+				m_packetQueuedCond.notify_all();
+			}
+		}
+	}
+}
+
+// Caller holds m_readAheadMutex. Also full while the queue of a stream with
+// the Block overflow policy is, until that stream catches up.
+bool FFmpegReader::IsReadAheadFull()
+{
+	if (m_queuedBytes >= m_maxQueuedBytes || (m_maxQueuedDuration > 0 && m_queuedDuration >= m_maxQueuedDuration))
+	{
+		return true;
+	}
+
+	return (m_audioSampleProvider != nullptr && m_audioSampleProvider->IsPacketQueueBlocking())
+		|| (m_videoSampleProvider != nullptr && m_videoSampleProvider->IsPacketQueueBlocking());
+}
+
+// Called by the sample providers for each packet taken off their queue,
+// making room for the demux thread
+void FFmpegReader::ReleasePacket(const AVPacket& packet)
+{
+	AVRational timeBase = m_pAvFormatCtx->streams[packet.stream_index]->time_base;
+
+	ReleasePackets(packet.size, av_rescale_q(packet.duration, timeBase, { 1, 10000000 }));
+}
+
+// Same for packets dropped or flushed from a queue at once, duration in
+// 100ns units
+void FFmpegReader::ReleasePackets(int64 bytes, int64 duration)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_readAheadMutex);
+		m_queuedBytes -= bytes;
+		m_queuedDuration -= duration;
+	}
+
+	m_readAheadCond.notify_one();
+}
+
+// Seek the demuxer, and drop the packets queued from the old position.
+// The demux thread waits meanwhile, then resumes from the new position.
+int FFmpegReader::Seek(int streamIndex, int64_t timestamp, int flags)
+{
+	std::lock_guard<std::mutex> demuxLock(m_demuxMutex);
+
+	int ret = av_seek_frame(m_pAvFormatCtx, streamIndex, timestamp, flags);
+	if (ret >= 0)
+	{
+		if (m_audioSampleProvider != nullptr)
+		{
+			m_audioSampleProvider->EnableStream();
+			m_audioSampleProvider->Flush();
+		}
+
+		if (m_videoSampleProvider != nullptr)
+		{
+			m_videoSampleProvider->EnableStream();
+			m_videoSampleProvider->Flush();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_readAheadMutex);
+			m_readResult = 0;
+		}
+
+		m_readAheadCond.notify_one();
+	}
+
 	return ret;
 }
 
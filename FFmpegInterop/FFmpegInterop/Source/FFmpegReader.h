@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "MediaSampleProvider.h"
 
 namespace FFmpegInterop
@@ -33,12 +36,42 @@ namespace FFmpegInterop
 
 	internal:
 		FFmpegReader(AVFormatContext* avFormatCtx);
+		void StartReadAhead(int64 maxBytes, int64 maxDuration);
+		void StopReadAhead();
+		int Seek(int streamIndex, int64_t timestamp, int flags);
+		void ReleasePacket(const AVPacket& packet);
+		void ReleasePackets(int64 bytes, int64 duration);
 
 	private:
+		int ReadPacketNow();
+		void ReadAheadMain();
+		bool IsReadAheadFull();
+
 		AVFormatContext* m_pAvFormatCtx;
 		MediaSampleProvider^ m_audioSampleProvider;
 		int m_audioStreamIndex;
 		MediaSampleProvider^ m_videoSampleProvider;
 		int m_videoStreamIndex;
+
+		// Read-ahead: a demux thread queues packets into the sample providers
+		// ahead of their requests, up to a byte and time budget.
+		std::thread m_readAheadThread;
+
+		// Held while demuxing or seeking, the format context is not thread-safe
+		std::mutex m_demuxMutex;
+
+		// Guards the read-ahead state below
+		std::mutex m_readAheadMutex;
+		std::condition_variable m_readAheadCond;
+		std::condition_variable m_packetQueuedCond;
+
+		int64 m_maxQueuedBytes;
+		int64 m_maxQueuedDuration;
+		int64 m_queuedBytes;
+		int64 m_queuedDuration;
+		uint64 m_queuedPackets;
+		int m_waitingReaders;
+		int m_readResult;
+		bool m_stopReadAhead;
 	};
 }
@@ -26,6 +26,8 @@ H264AVCSampleProvider::H264AVCSampleProvider(
 	AVFormatContext* avFormatCtx,
 	AVCodecContext* avCodecCtx)
 	: MediaSampleProvider(reader, avFormatCtx, avCodecCtx)
+	, m_hasParameterSets(false)
+	, m_nalLengthSize(4)
 {
 }
 
@@ -33,142 +35,177 @@ H264AVCSampleProvider::~H264AVCSampleProvider()
 {
 }
 
+HRESULT H264AVCSampleProvider::AllocateResources()
+{
+	HRESULT hr = S_OK;
+	hr = MediaSampleProvider::AllocateResources();
+	if (SUCCEEDED(hr))
+	{
+		// Without them key frames fail, like the packets of a broken stream
+		m_hasParameterSets = SUCCEEDED(GetSPSAndPPSBuffer());
+		if (!m_hasParameterSets)
+		{
+			DebugMessage(L"Invalid avcC extradata\n");
+		}
+	}
+
+	return hr;
+}
+
 HRESULT H264AVCSampleProvider::WriteAVPacketToStream(DataWriter^ dataWriter, AVPacket* avPacket)
 {
 	HRESULT hr = S_OK;
 	// On a KeyFrame, write the SPS and PPS
-	if (avPacket->flags & AV_PKT_FLAG_KEY)
+	bool isKeyFrame = (avPacket->flags & AV_PKT_FLAG_KEY) != 0;
+	if (isKeyFrame && !m_hasParameterSets)
 	{
-		hr = GetSPSAndPPSBuffer(dataWriter);
+		hr = E_FAIL;
 	}
 
 	if (SUCCEEDED(hr))
 	{
 		// Convert the packet to NAL format
-		hr = WriteNALPacket(dataWriter, avPacket);
+		hr = WriteNALPacket(dataWriter, avPacket, isKeyFrame);
 	}
 
 	// We have a complete frame
 	return hr;
 }
 
-HRESULT H264AVCSampleProvider::GetSPSAndPPSBuffer(DataWriter^ dataWriter)
+// Build the Annex B SPS and PPS units from the avcC extradata, each of them
+// and not only the first ones, and the size of the NAL unit lengths
+HRESULT H264AVCSampleProvider::GetSPSAndPPSBuffer()
 {
 	HRESULT hr = S_OK;
-	int spsLength = 0;
-	int ppsLength = 0;
+	const uint8_t* data = m_pAvCodecCtx ? m_pAvCodecCtx->extradata : nullptr;
+	int size = m_pAvCodecCtx ? m_pAvCodecCtx->extradata_size : 0;
+	int index = 6;
 
-	if (!m_pAvCodecCtx)
-	{
-		return E_FAIL;
-	}
+	m_parameterSets.clear();
 
-	// Get the position of the SPS
-	if (m_pAvCodecCtx->extradata == nullptr && m_pAvCodecCtx->extradata_size < 8)
+	// Version, profile, compatibility, level, length size and SPS count
+	if (data == nullptr || size < 7)
 	{
 		// The data isn't present
-		hr = E_FAIL;
+		return E_FAIL;
 	}
-	if (SUCCEEDED(hr))
-	{
-		byte* spsPos = m_pAvCodecCtx->extradata + 8;
-		spsLength = spsPos[-1];
-
-		if (m_pAvCodecCtx->extradata_size < (8 + spsLength))
-		{
-			// We don't have a complete SPS
-			hr = E_FAIL;
-		}
-		else
-		{
-			auto vSPS = ref new Platform::Array<uint8_t>(spsPos, spsLength);
-
-			// Write the NAL unit for the SPS
-			dataWriter->WriteByte(0);
-			dataWriter->WriteByte(0);
-			dataWriter->WriteByte(0);
-			dataWriter->WriteByte(1);
 
-			// Write the SPS
-			dataWriter->WriteBytes(vSPS);
-		}
-	}
+	m_nalLengthSize = (data[4] & 3) + 1;
 
-	if (SUCCEEDED(hr))
+	// The SPS units, then a count of PPS units and the PPS units
+	for (int set = 0; set < 2 && SUCCEEDED(hr); set++)
 	{
-		if (m_pAvCodecCtx->extradata_size < (8 + spsLength + 3))
-		{
-			hr = E_FAIL;
-		}
+		int count = (set == 0) ? (data[5] & 0x1f) : data[index++];
 
-		if (SUCCEEDED(hr))
+		for (int i = 0; i < count; i++)
 		{
-			byte* ppsPos = m_pAvCodecCtx->extradata + 8 + spsLength + 3;
-			ppsLength = ppsPos[-1];
-
-			if (m_pAvCodecCtx->extradata_size < (8 + spsLength + 3 + ppsLength))
+			if (size < index + 2)
 			{
 				hr = E_FAIL;
+				break;
 			}
-			else
-			{
-				auto vPPS = ref new Platform::Array<uint8_t>(ppsPos, ppsLength);
 
-				// Write the NAL unit for the PPS
-				dataWriter->WriteByte(0);
-				dataWriter->WriteByte(0);
-				dataWriter->WriteByte(0);
-				dataWriter->WriteByte(1);
+			int length = (data[index] << 8) | data[index + 1];
+			index += 2;
 
-				// Write the PPS
-				dataWriter->WriteBytes(vPPS);
+			if (size < index + length)
+			{
+				// We don't have a complete parameter set
+				hr = E_FAIL;
+				break;
 			}
+
+			static const uint8_t startCode[] = { 0, 0, 0, 1 };
+			m_parameterSets.insert(m_parameterSets.end(), startCode, startCode + sizeof(startCode));
+			m_parameterSets.insert(m_parameterSets.end(), data + index, data + index + length);
+			index += length;
+		}
+
+		if (set == 0 && size < index + 1)
+		{
+			hr = E_FAIL;
 		}
 	}
 
 	return hr;
 }
 
-// Write out an H.264 packet converting stream offsets to start-codes
-HRESULT H264AVCSampleProvider::WriteNALPacket(DataWriter^ dataWriter, AVPacket* avPacket)
+// Write out an H.264 packet converting stream offsets to start-codes. The
+// size is worked out first, then the parameter sets and every NAL unit are
+// converted into one buffer, written at once.
+HRESULT H264AVCSampleProvider::WriteNALPacket(DataWriter^ dataWriter, AVPacket* avPacket, bool writeParameterSets)
 {
-	HRESULT hr = S_OK;
-	uint32 index = 0;
-	uint32 size = 0;
-	uint32 packetSize = (uint32)avPacket->size;
+	const uint8_t* data = avPacket->data;
+	size_t packetSize = (size_t)avPacket->size;
+	size_t outSize = writeParameterSets ? m_parameterSets.size() : 0;
+	size_t index = 0;
 
-	do
+	if (packetSize == 0)
+	{
+		return E_FAIL;
+	}
+
+	// Lengths only, to validate the packet and size the output
+	while (index < packetSize)
 	{
 		// Make sure we have enough data
-		if (packetSize < (index + 4))
+		if (packetSize - index < (size_t)m_nalLengthSize)
 		{
-			hr = E_FAIL;
-			break;
+			return E_FAIL;
 		}
 
-		// Grab the size of the blob
-		size = (avPacket->data[index] << 24) + (avPacket->data[index + 1] << 16) + (avPacket->data[index + 2] << 8) + avPacket->data[index + 3];
+		size_t size = 0;
+		for (int i = 0; i < m_nalLengthSize; i++)
+		{
+			size = (size << 8) | data[index + i];
+		}
+		index += m_nalLengthSize;
 
-		// Write the NAL unit to the stream
-		dataWriter->WriteByte(0);
-		dataWriter->WriteByte(0);
-		dataWriter->WriteByte(0);
-		dataWriter->WriteByte(1);
-		index += 4;
+		// Stop if index and size goes beyond packet size
+		if (packetSize - index < size)
+		{
+			return E_FAIL;
+		}
 
-		// Stop if index and size goes beyond packet size or overflow
-		if (packetSize < (index + size) || (UINT32_MAX - index) < size)
+		index += size;
+		outSize += 4 + size;
+	}
+
+	// Grown as needed, never shrunk
+	if (m_sampleData.size() < outSize)
+	{
+		m_sampleData.resize(outSize);
+	}
+
+	uint8_t* out = m_sampleData.data();
+	if (writeParameterSets && !m_parameterSets.empty())
+	{
+		memcpy(out, m_parameterSets.data(), m_parameterSets.size());
+		out += m_parameterSets.size();
+	}
+
+	for (index = 0; index < packetSize;)
+	{
+		size_t size = 0;
+		for (int i = 0; i < m_nalLengthSize; i++)
 		{
-			hr = E_FAIL;
-			break;
+			size = (size << 8) | data[index + i];
 		}
+		index += m_nalLengthSize;
+
+		// The start code replaces the length
+		out[0] = 0;
+		out[1] = 0;
+		out[2] = 0;
+		out[3] = 1;
+		memcpy(out + 4, data + index, size);
 
-		// Write the rest of the packet to the stream
-		auto vBuffer = ref new Platform::Array<uint8_t>(&(avPacket->data[index]), size);
-		dataWriter->WriteBytes(vBuffer);
+		out += 4 + size;
 		index += size;
-	} while (index < packetSize);
+	}
 
-	return hr;
-}
+	// No intermediate array, the writer copies straight from the buffer
+	dataWriter->WriteBytes(Platform::ArrayReference<uint8_t>(m_sampleData.data(), (unsigned int)outSize));
 
+	return S_OK;
+}
@@ -18,6 +18,7 @@
 
 #pragma once
 #include "MediaSampleProvider.h"
+#include <vector>
 
 namespace FFmpegInterop
 {
@@ -28,14 +29,25 @@ namespace FFmpegInterop
 		virtual ~H264AVCSampleProvider();
 
 	private:
-		HRESULT WriteNALPacket(DataWriter^ dataWriter, AVPacket* avPacket);
-		HRESULT GetSPSAndPPSBuffer(DataWriter^ dataWriter);
+		HRESULT WriteNALPacket(DataWriter^ dataWriter, AVPacket* avPacket, bool writeParameterSets);
+		HRESULT GetSPSAndPPSBuffer();
+
+		// Annex B SPS and PPS units, built once from the avcC extradata
+		std::vector<uint8_t> m_parameterSets;
+		bool m_hasParameterSets;
+
+		// Bytes of the length before each NAL unit, 1 to 4
+		int m_nalLengthSize;
+
+		// Converted sample, reused for every packet
+		std::vector<uint8_t> m_sampleData;
 
 	internal:
 		H264AVCSampleProvider(
 			FFmpegReader^ reader,
 			AVFormatContext* avFormatCtx,
 			AVCodecContext* avCodecCtx);
+		virtual HRESULT AllocateResources() override;
 		virtual HRESULT WriteAVPacketToStream(DataWriter^ writer, AVPacket* avPacket) override;
 	};
 }
@@ -0,0 +1,272 @@
+//*****************************************************************************
+//
+//	Copyright 2015 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "MappedFile.h"
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+extern "C"
+{
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+}
+
+using namespace FFmpegInterop;
+
+MappedFile::MappedFile()
+#ifdef _WIN32
+	: m_mapping(nullptr)
+#else
+	: m_file(-1)
+#endif
+	, m_size(0)
+	, m_pos(0)
+	, m_view(nullptr)
+	, m_viewPos(0)
+	, m_viewSize(0)
+	, m_windowSize(MAPPED_FILE_WINDOW_SIZE)
+	, m_granularity(1)
+	, m_maps(0)
+	, m_bytes(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapView();
+
+#ifdef _WIN32
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+	}
+#else
+	if (m_file >= 0)
+	{
+		close(m_file);
+	}
+#endif
+}
+
+// Map a file opened for reading. The file handle is not kept, the caller
+// may close it right after. windowSize bounds the address space used.
+int MappedFile::Open(MappedFileHandle file, int64_t windowSize)
+{
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	SYSTEM_INFO info;
+
+	if (!GetFileSizeEx(file, &size))
+	{
+		return AVERROR(EIO);
+	}
+
+	// An empty file cannot be mapped, nothing to read anyway
+	if (size.QuadPart > 0)
+	{
+		m_mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+		if (m_mapping == nullptr)
+		{
+			return AVERROR(EIO);
+		}
+	}
+
+	GetSystemInfo(&info);
+	m_size = size.QuadPart;
+	m_granularity = info.dwAllocationGranularity;
+#else
+	struct stat st;
+
+	if (fstat(file, &st) != 0)
+	{
+		return AVERROR(errno);
+	}
+
+	m_file = dup(file);
+	if (m_file < 0)
+	{
+		return AVERROR(errno);
+	}
+
+	m_size = st.st_size;
+	m_granularity = sysconf(_SC_PAGESIZE);
+#endif
+
+	m_windowSize = std::max(windowSize, m_granularity);
+	m_windowSize -= m_windowSize % m_granularity;
+
+	return 0;
+}
+
+int MappedFile::Read(uint8_t* buf, int size)
+{
+	if (m_pos >= m_size)
+	{
+		return AVERROR_EOF;
+	}
+
+	if (m_view == nullptr || m_pos < m_viewPos || m_pos >= m_viewPos + m_viewSize)
+	{
+		int ret = MapView(m_pos);
+		if (ret < 0)
+		{
+			return ret;
+		}
+	}
+
+	int count = (int)std::min((int64_t)size, m_viewPos + m_viewSize - m_pos);
+	int ret = CopyFromView(buf, m_view + (m_pos - m_viewPos), count);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	m_pos += count;
+	m_bytes += count;
+
+	return count;
+}
+
+int64_t MappedFile::Seek(int64_t offset, int whence)
+{
+	int64_t target;
+
+	if (whence & AVSEEK_SIZE)
+	{
+		return m_size;
+	}
+
+	switch (whence & ~AVSEEK_FORCE)
+	{
+	case SEEK_SET:
+		target = offset;
+		break;
+	case SEEK_CUR:
+		target = m_pos + offset;
+		break;
+	case SEEK_END:
+		target = m_size + offset;
+		break;
+	default:
+		return AVERROR(EINVAL);
+	}
+
+	if (target < 0)
+	{
+		return AVERROR(EINVAL);
+	}
+
+	// Mapped on the next read, if in the file at all
+	m_pos = target;
+	return target;
+}
+
+void MappedFile::GetStats(MappedFileStats& stats)
+{
+	stats.maps = m_maps;
+	stats.bytes = m_bytes;
+}
+
+int MappedFile::AvioRead(void* opaque, uint8_t* buf, int size)
+{
+	return reinterpret_cast<MappedFile*>(opaque)->Read(buf, size);
+}
+
+int64_t MappedFile::AvioSeek(void* opaque, int64_t offset, int whence)
+{
+	return reinterpret_cast<MappedFile*>(opaque)->Seek(offset, whence);
+}
+
+// Copy out of the view. On Windows, pages that cannot be read in, e.g. past
+// the end of a file truncated meanwhile or on lost network media, raise
+// EXCEPTION_IN_PAGE_ERROR; it is turned into an I/O error.
+int MappedFile::CopyFromView(uint8_t* buf, const uint8_t* src, int size)
+{
+#ifdef _WIN32
+	__try
+	{
+		memcpy(buf, src, size);
+	}
+	__except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return AVERROR(EIO);
+	}
+#else
+	memcpy(buf, src, size);
+#endif
+
+	return size;
+}
+
+// Move the view to the window holding pos, the whole file when it fits
+int MappedFile::MapView(int64_t pos)
+{
+	UnmapView();
+
+	int64_t viewPos = pos - pos % m_granularity;
+	int64_t viewSize = std::min(m_windowSize, m_size - viewPos);
+
+#ifdef _WIN32
+	const void* view = MapViewOfFileFromApp(m_mapping, FILE_MAP_READ, viewPos, (SIZE_T)viewSize);
+	if (view == nullptr)
+	{
+		return AVERROR(ENOMEM);
+	}
+#else
+	void* view = mmap(nullptr, (size_t)viewSize, PROT_READ, MAP_SHARED, m_file, viewPos);
+	if (view == MAP_FAILED)
+	{
+		return AVERROR(errno);
+	}
+
+	// Demuxers mostly read straight through
+	madvise(view, (size_t)viewSize, MADV_SEQUENTIAL);
+#endif
+
+	m_view = (const uint8_t*)view;
+	m_viewPos = viewPos;
+	m_viewSize = viewSize;
+	m_maps++;
+
+	return 0;
+}
+
+void MappedFile::UnmapView()
+{
+	if (m_view == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_view);
+#else
+	munmap((void*)m_view, (size_t)m_viewSize);
+#endif
+
+	m_view = nullptr;
+	m_viewSize = 0;
+}
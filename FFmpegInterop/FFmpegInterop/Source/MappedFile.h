@@ -0,0 +1,92 @@
+//*****************************************************************************
+//
+//	Copyright 2015 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// Platform-neutral, no C++/CX here: also built by DecoderBench on Linux.
+
+namespace FFmpegInterop
+{
+#ifdef _WIN32
+	typedef HANDLE MappedFileHandle;
+#else
+	typedef int MappedFileHandle;
+#endif
+
+	// Most of a file mapped at once, the view moves along larger files
+	const int64_t MAPPED_FILE_WINDOW_SIZE = (sizeof(void*) >= 8) ? 1024 * 1024 * 1024 : 64 * 1024 * 1024;
+
+	// Counters of a MappedFile
+	struct MappedFileStats
+	{
+		uint64_t maps;
+		uint64_t bytes;
+	};
+
+	// Custom AVIO source reading a local file from a mapped view, rather
+	// than through read calls and the buffers of a stream. Seeking only
+	// moves the position. An I/O error on the mapped pages, e.g. a truncated
+	// file or lost network media, fails the read on Windows.
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		int Open(MappedFileHandle file, int64_t windowSize);
+		int Read(uint8_t* buf, int size);
+		int64_t Seek(int64_t offset, int whence);
+		void GetStats(MappedFileStats& stats);
+
+		// Callbacks of avio_alloc_context, opaque is the MappedFile
+		static int AvioRead(void* opaque, uint8_t* buf, int size);
+		static int64_t AvioSeek(void* opaque, int64_t offset, int whence);
+
+	private:
+		int MapView(int64_t pos);
+		void UnmapView();
+		static int CopyFromView(uint8_t* buf, const uint8_t* src, int size);
+
+#ifdef _WIN32
+		HANDLE m_mapping;
+#else
+		int m_file;
+#endif
+		int64_t m_size;
+		int64_t m_pos;
+
+		// The view maps m_viewSize bytes from m_viewPos, a multiple of the
+		// allocation granularity
+		const uint8_t* m_view;
+		int64_t m_viewPos;
+		int64_t m_viewSize;
+		int64_t m_windowSize;
+		int64_t m_granularity;
+
+		// Statistics
+		uint64_t m_maps;
+		uint64_t m_bytes;
+	};
+}
@@ -50,6 +50,16 @@ HRESULT MediaSampleProvider::AllocateResources()
 MediaSampleProvider::~MediaSampleProvider()
 {
 	DebugMessage(L"~MediaSampleProvider\n");
+
+#if _DEBUG
+	PacketQueueStats stats;
+	m_packetQueue.GetStats(stats);
+
+	wchar_t message[160];
+	swprintf_s(message, L"Packet queue: %I64u packets, %I64u dropped, at most %Iu packets and %I64d bytes\n",
+		stats.pushed, stats.dropped, stats.highWater, stats.highWaterBytes);
+	DebugMessage(message);
+#endif
 }
 
 void MediaSampleProvider::SetCurrentStreamIndex(int streamIndex)
@@ -58,6 +68,9 @@ void MediaSampleProvider::SetCurrentStreamIndex(int streamIndex)
 	if (m_pAvFormatCtx->nb_streams > (unsigned int)streamIndex)
 	{
 		m_streamIndex = streamIndex;
+
+		std::lock_guard<std::mutex> lock(m_packetMutex);
+		m_packetQueue.SetTimeBase(m_pAvFormatCtx->streams[streamIndex]->time_base);
 	}
 	else
 	{
@@ -129,18 +142,35 @@ HRESULT MediaSampleProvider::DecodeAVPacket(DataWriter^ dataWriter, AVPacket *av
 	return S_OK;
 }
 
-void MediaSampleProvider::QueuePacket(AVPacket packet)
+// Returns false if the stream is disabled or the queue overflows, the
+// packet is then dropped
+bool MediaSampleProvider::QueuePacket(AVPacket packet)
 {
 	DebugMessage(L" - QueuePacket\n");
 
-	if (m_isEnabled)
+	bool queued = false;
+	int64_t droppedBytes = 0;
+	int64_t droppedDuration = 0;
 	{
-		m_packetQueue.push_back(packet);
+		std::lock_guard<std::mutex> lock(m_packetMutex);
+
+		if (m_isEnabled)
+		{
+			queued = m_packetQueue.Push(packet, droppedBytes, droppedDuration);
+		}
+		else
+		{
+			av_packet_unref(&packet);
+		}
 	}
-	else
+
+	// Older packets dropped to make room
+	if ((droppedBytes > 0 || droppedDuration > 0) && m_pReader != nullptr)
 	{
-		av_packet_unref(&packet);
+		m_pReader->ReleasePackets(droppedBytes, droppedDuration);
 	}
+
+	return queued;
 }
 
 AVPacket MediaSampleProvider::PopPacket()
@@ -152,13 +182,52 @@ AVPacket MediaSampleProvider::PopPacket()
 	avPacket.data = NULL;
 	avPacket.size = 0;
 
-	if (!m_packetQueue.empty())
+	bool popped = false;
+	bool discontinuous = false;
+	{
+		std::lock_guard<std::mutex> lock(m_packetMutex);
+		popped = m_packetQueue.Pop(avPacket, discontinuous);
+	}
+
+	if (discontinuous)
+	{
+		m_isDiscontinuous = true;
+	}
+
+	// Room for the read-ahead
+	if (popped && m_pReader != nullptr)
 	{
-		avPacket = m_packetQueue.front();
-		m_packetQueue.erase(m_packetQueue.begin());
+		m_pReader->ReleasePacket(avPacket);
 	}
 
 	return avPacket;
+}
+
+bool MediaSampleProvider::IsPacketQueueEmpty()
+{
+	std::lock_guard<std::mutex> lock(m_packetMutex);
+	return m_packetQueue.IsEmpty();
+}
+
+// True when the demux thread should wait for this stream to be consumed
+bool MediaSampleProvider::IsPacketQueueBlocking()
+{
+	std::lock_guard<std::mutex> lock(m_packetMutex);
+	return m_packetQueue.IsBlocking();
+}
+
+// Bytes and duration (100ns units, 0 for no limit) of packets queued for
+// this stream, and what to do past them
+void MediaSampleProvider::SetPacketQueueLimits(int64 maxBytes, int64 maxDuration, PacketQueueOverflow overflow)
+{
+	std::lock_guard<std::mutex> lock(m_packetMutex);
+	m_packetQueue.SetLimits(maxBytes, maxDuration, overflow);
+}
+
+void MediaSampleProvider::GetPacketQueueStats(PacketQueueStats& stats)
+{
+	std::lock_guard<std::mutex> lock(m_packetMutex);
+	m_packetQueue.GetStats(stats);
 }
 
 HRESULT FFmpegInterop::MediaSampleProvider::GetNextPacket(DataWriter ^ writer, LONGLONG & pts, LONGLONG & dur, bool allowSkip)
@@ -178,7 +247,7 @@ HRESULT FFmpegInterop::MediaSampleProvider::GetNextPacket(DataWriter ^ writer, L
 	while (SUCCEEDED(hr) && !frameComplete)
 	{
 		// Continue reading until there is an appropriate packet in the stream
-		while (m_packetQueue.empty())
+		while (IsPacketQueueEmpty())
 		{
 			if (m_pReader->ReadPacket() < 0)
 			{
@@ -188,7 +257,7 @@ HRESULT FFmpegInterop::MediaSampleProvider::GetNextPacket(DataWriter ^ writer, L
 			}
 		}
 
-		if (!m_packetQueue.empty())
+		if (!IsPacketQueueEmpty())
 		{
 			// Pick the packets from the queue one at a time
 			avPacket = PopPacket();
@@ -239,22 +308,36 @@ HRESULT FFmpegInterop::MediaSampleProvider::GetNextPacket(DataWriter ^ writer, L
 void MediaSampleProvider::Flush()
 {
 	DebugMessage(L"Flush\n");
-	while (!m_packetQueue.empty())
+
+	PacketQueueStats stats;
 	{
-		av_packet_unref(&PopPacket());
+		std::lock_guard<std::mutex> lock(m_packetMutex);
+		m_packetQueue.GetStats(stats);
+		m_packetQueue.Clear();
 	}
+
+	// Room for the read-ahead
+	if (stats.count > 0 && m_pReader != nullptr)
+	{
+		m_pReader->ReleasePackets(stats.bytes, stats.duration);
+	}
+
 	m_isDiscontinuous = true;
 }
 
 void MediaSampleProvider::DisableStream()
 {
 	DebugMessage(L"DisableStream\n");
+	{
+		std::lock_guard<std::mutex> lock(m_packetMutex);
+		m_isEnabled = false;
+	}
 	Flush();
-	m_isEnabled = false;
 }
 
 void MediaSampleProvider::EnableStream()
 {
 	DebugMessage(L"EnableStream\n");
+	std::lock_guard<std::mutex> lock(m_packetMutex);
 	m_isEnabled = true;
 }
\ No newline at end of file
@@ -17,7 +17,9 @@
 //*****************************************************************************
 
 #pragma once
+#include <mutex>
 #include <queue>
+#include "PacketQueue.h"
 
 extern "C"
 {
@@ -41,13 +43,19 @@ namespace FFmpegInterop
 		virtual void SetCurrentStreamIndex(int streamIndex);
 
 	internal:
-		void QueuePacket(AVPacket packet);
+		bool QueuePacket(AVPacket packet);
 		AVPacket PopPacket();
+		bool IsPacketQueueEmpty();
+		bool IsPacketQueueBlocking();
+		void SetPacketQueueLimits(int64 maxBytes, int64 maxDuration, PacketQueueOverflow overflow);
+		void GetPacketQueueStats(PacketQueueStats& stats);
 		void DisableStream();
 		void EnableStream();
 
 	private:
-		std::vector<AVPacket> m_packetQueue;
+		// Packets are queued by the demux thread with read-ahead, see FFmpegReader
+		std::mutex m_packetMutex;
+		PacketQueue m_packetQueue;
 		int64 m_startOffset;
 		int64 m_nextFramePts;
 		bool m_isEnabled;
@@ -0,0 +1,251 @@
+//*****************************************************************************
+//
+//	Copyright 2015 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "pch.h"
+#include "PacketQueue.h"
+#include <new>
+
+using namespace FFmpegInterop;
+
+// Entries of a new ring, doubled whenever it is full
+const size_t PACKET_QUEUE_MIN_CAPACITY = 16;
+
+PacketQueue::PacketQueue()
+	: m_entries(nullptr)
+	, m_capacity(0)
+	, m_head(0)
+	, m_count(0)
+	, m_timeBase({ 1, 10000000 })
+	, m_maxBytes(PACKET_QUEUE_DEFAULT_MAX_BYTES)
+	, m_maxDuration(0)
+	, m_overflow(PacketQueueOverflow::DropNonKey)
+	, m_bytes(0)
+	, m_duration(0)
+	, m_isDropping(false)
+	, m_isDiscontinuous(false)
+	, m_pushed(0)
+	, m_dropped(0)
+	, m_highWater(0)
+	, m_highWaterBytes(0)
+{
+}
+
+PacketQueue::~PacketQueue()
+{
+	Clear();
+	delete[] m_entries;
+}
+
+// Time base of the packets, for their duration
+void PacketQueue::SetTimeBase(AVRational timeBase)
+{
+	m_timeBase = timeBase;
+}
+
+// Bytes and duration (100ns units) of packets kept, 0 for no limit.
+// Packets already queued stay until popped.
+void PacketQueue::SetLimits(int64_t maxBytes, int64_t maxDuration, PacketQueueOverflow overflow)
+{
+	m_maxBytes = maxBytes;
+	m_maxDuration = maxDuration;
+	m_overflow = overflow;
+}
+
+// Queue a packet, the queue owns it from now on. Returns false if it was
+// dropped instead. droppedBytes and droppedDuration are set to the queued
+// packets dropped to make room for it.
+bool PacketQueue::Push(AVPacket& packet, int64_t& droppedBytes, int64_t& droppedDuration)
+{
+	droppedBytes = 0;
+	droppedDuration = 0;
+
+	if (m_overflow == PacketQueueOverflow::DropNonKey)
+	{
+		if (!(packet.flags & AV_PKT_FLAG_KEY))
+		{
+			// Packets up to the next key packet may reference a dropped one
+			if (m_isDropping || IsFull())
+			{
+				m_isDropping = true;
+				m_isDiscontinuous = true;
+				m_dropped++;
+				av_packet_unref(&packet);
+				return false;
+			}
+		}
+		else
+		{
+			m_isDropping = false;
+
+			// Drop from the oldest packet up to a key packet, the rest
+			// decodes from there
+			while (m_count > 0 && IsFull())
+			{
+				do
+				{
+					DropOldest(droppedBytes, droppedDuration);
+				} while (m_count > 0 && !(m_entries[m_head].packet.flags & AV_PKT_FLAG_KEY));
+			}
+		}
+	}
+
+	if (m_count == m_capacity && !Grow())
+	{
+		m_isDiscontinuous = true;
+		m_dropped++;
+		av_packet_unref(&packet);
+		return false;
+	}
+
+	Entry& entry = m_entries[(m_head + m_count) & (m_capacity - 1)];
+	entry.packet = packet;
+	entry.duration = av_rescale_q(packet.duration, m_timeBase, { 1, 10000000 });
+	entry.discontinuous = m_isDiscontinuous;
+	m_isDiscontinuous = false;
+
+	m_count++;
+	m_bytes += packet.size;
+	m_duration += entry.duration;
+
+	m_pushed++;
+	if (m_count > m_highWater)
+	{
+		m_highWater = m_count;
+	}
+	if (m_bytes > m_highWaterBytes)
+	{
+		m_highWaterBytes = m_bytes;
+	}
+
+	return true;
+}
+
+// Take the oldest packet, the caller owns it. discontinuous is set if
+// packets were dropped right before it.
+bool PacketQueue::Pop(AVPacket& packet, bool& discontinuous)
+{
+	if (m_count == 0)
+	{
+		return false;
+	}
+
+	Entry& entry = m_entries[m_head];
+	packet = entry.packet;
+	discontinuous = entry.discontinuous;
+
+	m_head = (m_head + 1) & (m_capacity - 1);
+	m_count--;
+	m_bytes -= packet.size;
+	m_duration -= entry.duration;
+
+	return true;
+}
+
+// Free every packet queued, the ring is kept for the next ones
+void PacketQueue::Clear()
+{
+	while (m_count > 0)
+	{
+		av_packet_unref(&m_entries[m_head].packet);
+		m_head = (m_head + 1) & (m_capacity - 1);
+		m_count--;
+	}
+
+	m_head = 0;
+	m_bytes = 0;
+	m_duration = 0;
+	m_isDropping = false;
+	m_isDiscontinuous = false;
+}
+
+bool PacketQueue::IsEmpty() const
+{
+	return m_count == 0;
+}
+
+// At or past one of the limits
+bool PacketQueue::IsFull() const
+{
+	return (m_maxBytes > 0 && m_bytes >= m_maxBytes) || (m_maxDuration > 0 && m_duration >= m_maxDuration);
+}
+
+// Full with the Block policy, the read-ahead thread should wait for room
+bool PacketQueue::IsBlocking() const
+{
+	return m_overflow == PacketQueueOverflow::Block && IsFull();
+}
+
+void PacketQueue::GetStats(PacketQueueStats& stats) const
+{
+	stats.pushed = m_pushed;
+	stats.dropped = m_dropped;
+	stats.count = m_count;
+	stats.bytes = m_bytes;
+	stats.duration = m_duration;
+	stats.highWater = m_highWater;
+	stats.highWaterBytes = m_highWaterBytes;
+}
+
+// Double the ring, or allocate the first one
+bool PacketQueue::Grow()
+{
+	size_t capacity = m_capacity > 0 ? m_capacity * 2 : PACKET_QUEUE_MIN_CAPACITY;
+	Entry* entries = new (std::nothrow) Entry[capacity];
+	if (entries == nullptr)
+	{
+		DebugMessage(L"Could not grow the packet queue\n");
+		return false;
+	}
+
+	for (size_t i = 0; i < m_count; i++)
+	{
+		entries[i] = m_entries[(m_head + i) & (m_capacity - 1)];
+	}
+
+	delete[] m_entries;
+	m_entries = entries;
+	m_capacity = capacity;
+	m_head = 0;
+
+	return true;
+}
+
+// Free the oldest packet, the next one follows a discontinuity
+void PacketQueue::DropOldest(int64_t& droppedBytes, int64_t& droppedDuration)
+{
+	Entry& entry = m_entries[m_head];
+	droppedBytes += entry.packet.size;
+	droppedDuration += entry.duration;
+
+	m_bytes -= entry.packet.size;
+	m_duration -= entry.duration;
+	av_packet_unref(&entry.packet);
+
+	m_head = (m_head + 1) & (m_capacity - 1);
+	m_count--;
+	m_dropped++;
+
+	if (m_count > 0)
+	{
+		m_entries[m_head].discontinuous = true;
+	}
+	else
+	{
+		m_isDiscontinuous = true;
+	}
+}
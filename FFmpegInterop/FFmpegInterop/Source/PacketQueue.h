@@ -0,0 +1,115 @@
+//*****************************************************************************
+//
+//	Copyright 2015 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace FFmpegInterop
+{
+	// Default bytes of packets queued per stream
+	const int64_t PACKET_QUEUE_DEFAULT_MAX_BYTES = 32 * 1024 * 1024;
+
+	// What a PacketQueue does with a packet pushed past its limits
+	enum class PacketQueueOverflow
+	{
+		// Queue it anyway, the read-ahead thread waits for room before
+		// demuxing more (see FFmpegReader). Reading on request never waits.
+		Block,
+
+		// Drop non-key packets until the next key packet, which makes room
+		// by dropping the oldest packets instead
+		DropNonKey
+	};
+
+	// Occupancy counters of a PacketQueue
+	struct PacketQueueStats
+	{
+		uint64_t pushed;
+		uint64_t dropped;
+		size_t count;
+		int64_t bytes;
+		int64_t duration;
+		size_t highWater;
+		int64_t highWaterBytes;
+	};
+
+	// Ring of the demuxed packets of one stream, waiting for their sample
+	// request. Bounded in bytes and in duration (100ns units), 0 for no
+	// limit. Not thread-safe, the sample provider locks around it.
+	class PacketQueue
+	{
+	public:
+		PacketQueue();
+		~PacketQueue();
+
+		void SetTimeBase(AVRational timeBase);
+		void SetLimits(int64_t maxBytes, int64_t maxDuration, PacketQueueOverflow overflow);
+
+		bool Push(AVPacket& packet, int64_t& droppedBytes, int64_t& droppedDuration);
+		bool Pop(AVPacket& packet, bool& discontinuous);
+		void Clear();
+
+		bool IsEmpty() const;
+		bool IsFull() const;
+		bool IsBlocking() const;
+		void GetStats(PacketQueueStats& stats) const;
+
+	private:
+		struct Entry
+		{
+			AVPacket packet;
+			int64_t duration;
+			bool discontinuous;
+		};
+
+		bool Grow();
+		void DropOldest(int64_t& droppedBytes, int64_t& droppedDuration);
+
+		// Power of two, m_head is the oldest of m_count entries
+		Entry* m_entries;
+		size_t m_capacity;
+		size_t m_head;
+		size_t m_count;
+
+		AVRational m_timeBase;
+		int64_t m_maxBytes;
+		int64_t m_maxDuration;
+		PacketQueueOverflow m_overflow;
+		int64_t m_bytes;
+		int64_t m_duration;
+
+		// Dropping non-key packets until the next key packet
+		bool m_isDropping;
+
+		// The next packet pushed follows dropped packets
+		bool m_isDiscontinuous;
+
+		// Statistics
+		uint64_t m_pushed;
+		uint64_t m_dropped;
+		size_t m_highWater;
+		int64_t m_highWaterBytes;
+	};
+}
@@ -0,0 +1,400 @@
+//*****************************************************************************
+//
+//	Copyright 2015 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "PrefetchStream.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <system_error>
+
+extern "C"
+{
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+using namespace FFmpegInterop;
+
+// Seconds of the stream, at the rate it is consumed, read per block
+const double PREFETCH_BLOCK_SECONDS = 0.25;
+
+PrefetchStream::PrefetchStream(ByteStream* stream, int minBlockSize, int maxBlockSize)
+	: m_stream(stream)
+	, m_current(0)
+	, m_offset(0)
+	, m_fillPos(0)
+	, m_fillIndex(0)
+	, m_isFilling(false)
+	, m_stop(false)
+	, m_minBlockSize(minBlockSize)
+	, m_maxBlockSize(std::max(minBlockSize, maxBlockSize))
+	, m_blockSize(minBlockSize)
+	, m_byteRate(0)
+	, m_blockStart(std::chrono::steady_clock::now())
+	, m_reads(0)
+	, m_bytes(0)
+	, m_waits(0)
+	, m_seeks(0)
+	, m_discards(0)
+	, m_largestBlockSize(0)
+{
+	// The consumer starts on an empty block at position 0
+	memset(m_blocks, 0, sizeof(m_blocks));
+	m_blocks[0].ready = true;
+}
+
+PrefetchStream::~PrefetchStream()
+{
+	if (m_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		// A read in progress finishes first
+		m_fillCond.notify_all();
+		m_thread.join();
+	}
+
+	av_freep(&m_blocks[0].data);
+	av_freep(&m_blocks[1].data);
+	delete m_stream;
+}
+
+// Start the thread reading ahead. Without it, or if it cannot start, blocks
+// are read on demand.
+int PrefetchStream::Start(bool prefetch)
+{
+	if (prefetch && !m_thread.joinable())
+	{
+		try
+		{
+			m_thread = std::thread([this]() { PrefetchMain(); });
+		}
+		catch (const std::system_error&)
+		{
+			return AVERROR(EAGAIN);
+		}
+	}
+
+	return 0;
+}
+
+int PrefetchStream::Read(uint8_t* buf, int size)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (;;)
+	{
+		Block& block = m_blocks[m_current];
+
+		if (m_offset < block.size)
+		{
+			int count = std::min(size, block.size - m_offset);
+			memcpy(buf, block.data + m_offset, count);
+			m_offset += count;
+			return count;
+		}
+
+		if (block.result < 0)
+		{
+			return block.result;
+		}
+
+		NextBlock(lock);
+	}
+}
+
+int64_t PrefetchStream::Seek(int64_t offset, int whence)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	Block& current = m_blocks[m_current];
+	int64_t target;
+
+	// The stream is only used by one thread at a time
+	if (whence & AVSEEK_SIZE)
+	{
+		WaitFill(lock);
+		return m_stream->GetSize();
+	}
+
+	switch (whence & ~AVSEEK_FORCE)
+	{
+	case SEEK_SET:
+		target = offset;
+		break;
+	case SEEK_CUR:
+		target = current.pos + m_offset + offset;
+		break;
+	case SEEK_END:
+	{
+		WaitFill(lock);
+		int64_t size = m_stream->GetSize();
+		if (size < 0)
+		{
+			return size;
+		}
+		target = size + offset;
+		break;
+	}
+	default:
+		return AVERROR(EINVAL);
+	}
+
+	if (target < 0)
+	{
+		return AVERROR(EINVAL);
+	}
+
+	m_seeks++;
+
+	if (target >= current.pos && target <= current.pos + current.size)
+	{
+		m_offset = (int)(target - current.pos);
+		return target;
+	}
+
+	// Maybe in the block being read ahead
+	WaitFill(lock);
+
+	int next = m_current ^ 1;
+	Block& nextBlock = m_blocks[next];
+
+	if (nextBlock.ready && target >= nextBlock.pos && target < nextBlock.pos + nextBlock.size)
+	{
+		current.ready = false;
+		current.size = 0;
+		m_current = next;
+		m_offset = (int)(target - nextBlock.pos);
+		m_blockStart = std::chrono::steady_clock::now();
+
+		if (m_thread.joinable() && nextBlock.result == 0)
+		{
+			StartFill(next ^ 1);
+		}
+
+		return target;
+	}
+
+	// Anywhere else, what was read is of no use
+	int64_t pos = m_stream->Seek(target);
+	if (pos < 0)
+	{
+		return pos;
+	}
+
+	m_discards++;
+
+	current.pos = pos;
+	current.size = 0;
+	current.result = 0;
+	current.ready = true;
+	nextBlock.size = 0;
+	nextBlock.ready = false;
+	m_offset = 0;
+	m_fillPos = pos;
+
+	// Probably a header or an index, read little until it plays on
+	m_blockSize = m_minBlockSize;
+	m_byteRate = 0;
+
+	return pos;
+}
+
+void PrefetchStream::GetStats(PrefetchStreamStats& stats)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	stats.reads = m_reads;
+	stats.bytes = m_bytes;
+	stats.waits = m_waits;
+	stats.seeks = m_seeks;
+	stats.discards = m_discards;
+	stats.blockSize = m_blockSize;
+	stats.maxBlockSize = m_largestBlockSize;
+}
+
+int PrefetchStream::AvioRead(void* opaque, uint8_t* buf, int size)
+{
+	return reinterpret_cast<PrefetchStream*>(opaque)->Read(buf, size);
+}
+
+int64_t PrefetchStream::AvioSeek(void* opaque, int64_t offset, int whence)
+{
+	return reinterpret_cast<PrefetchStream*>(opaque)->Seek(offset, whence);
+}
+
+// Read the block after m_fillPos into m_blocks[index], on the prefetch
+// thread if running. Caller holds m_mutex.
+void PrefetchStream::StartFill(int index)
+{
+	m_blocks[index].ready = false;
+	m_fillIndex = index;
+	m_isFilling = true;
+
+	if (m_thread.joinable())
+	{
+		m_fillCond.notify_one();
+	}
+}
+
+// Read a block, without m_mutex meanwhile
+void PrefetchStream::FillBlock(std::unique_lock<std::mutex>& lock, int index)
+{
+	Block& block = m_blocks[index];
+	int64_t pos = m_fillPos;
+	int size = m_blockSize;
+	int filled = 0;
+	int result = 0;
+	uint64_t reads = 0;
+
+	// Grown as needed, never shrunk
+	av_fast_malloc(&block.data, &block.capacity, size);
+
+	if (block.data == nullptr)
+	{
+		block.capacity = 0;
+		result = AVERROR(ENOMEM);
+	}
+	else
+	{
+		lock.unlock();
+
+		while (filled < size)
+		{
+			int ret = m_stream->Read(block.data + filled, size - filled);
+			reads++;
+
+			if (ret <= 0)
+			{
+				result = (ret < 0) ? ret : AVERROR_EOF;
+				break;
+			}
+
+			filled += ret;
+		}
+
+		lock.lock();
+	}
+
+	block.pos = pos;
+	block.size = filled;
+	block.result = result;
+	block.ready = true;
+
+	m_fillPos = pos + filled;
+	m_isFilling = false;
+	m_reads += reads;
+	m_bytes += filled;
+	m_largestBlockSize = std::max(m_largestBlockSize, size);
+
+	m_readyCond.notify_all();
+}
+
+// Move on to the block after the current one, waiting for it if needed.
+// Caller holds m_mutex.
+void PrefetchStream::NextBlock(std::unique_lock<std::mutex>& lock)
+{
+	int next = m_current ^ 1;
+
+	if (!m_blocks[next].ready)
+	{
+		if (!m_isFilling)
+		{
+			StartFill(next);
+		}
+
+		if (!m_thread.joinable())
+		{
+			FillBlock(lock, next);
+		}
+		else
+		{
+			m_waits++;
+
+			while (!m_blocks[next].ready)
+			{
+				m_readyCond.wait(lock);
+			}
+		}
+	}
+
+	AdaptBlockSize();
+
+	m_blocks[m_current].ready = false;
+	m_blocks[m_current].size = 0;
+	m_current = next;
+	m_offset = 0;
+	m_blockStart = std::chrono::steady_clock::now();
+
+	// Double buffering: read the following block while this one is consumed
+	if (m_thread.joinable() && m_blocks[next].result == 0)
+	{
+		StartFill(next ^ 1);
+	}
+}
+
+void PrefetchStream::WaitFill(std::unique_lock<std::mutex>& lock)
+{
+	while (m_isFilling)
+	{
+		m_readyCond.wait(lock);
+	}
+}
+
+// Size the next blocks on how fast the current one was consumed
+void PrefetchStream::AdaptBlockSize()
+{
+	Block& block = m_blocks[m_current];
+
+	if (block.size == 0)
+	{
+		return;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_blockStart).count();
+	double rate = (seconds > 0) ? block.size / seconds : (double)m_maxBlockSize / PREFETCH_BLOCK_SECONDS;
+
+	m_byteRate = (m_byteRate > 0) ? (3 * m_byteRate + rate) / 4 : rate;
+
+	int size = m_minBlockSize;
+	while (size < m_maxBlockSize && size < m_byteRate * PREFETCH_BLOCK_SECONDS)
+	{
+		size *= 2;
+	}
+
+	m_blockSize = std::min(size, m_maxBlockSize);
+}
+
+void PrefetchStream::PrefetchMain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stop)
+	{
+		if (!m_isFilling)
+		{
+			m_fillCond.wait(lock);
+			continue;
+		}
+
+		FillBlock(lock, m_fillIndex);
+	}
+}
@@ -0,0 +1,139 @@
+//*****************************************************************************
+//
+//	Copyright 2015 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+// Platform-neutral, no C++/CX here: also built by DecoderBench on Linux.
+
+namespace FFmpegInterop
+{
+	// Smallest and largest reads of a PrefetchStream by default
+	const int PREFETCH_MIN_BLOCK_SIZE = 16 * 1024;
+	const int PREFETCH_MAX_BLOCK_SIZE = 2 * 1024 * 1024;
+
+	// Blocking byte source read by a PrefetchStream, e.g. an IStream
+	class ByteStream
+	{
+	public:
+		virtual ~ByteStream() {}
+
+		// Up to size bytes, 0 at the end of the stream, or a negative AVERROR
+		virtual int Read(uint8_t* buf, int size) = 0;
+
+		// Move to an absolute position, returns it or a negative AVERROR
+		virtual int64_t Seek(int64_t pos) = 0;
+
+		// Size of the stream, or a negative AVERROR when unknown
+		virtual int64_t GetSize() = 0;
+	};
+
+	// Counters of a PrefetchStream
+	struct PrefetchStreamStats
+	{
+		uint64_t reads;
+		uint64_t bytes;
+		uint64_t waits;
+		uint64_t seeks;
+		uint64_t discards;
+		int blockSize;
+		int maxBlockSize;
+	};
+
+	// Custom AVIO source over a ByteStream, reading it in blocks sized on
+	// the bitrate the demuxer consumes. While one block is consumed, a
+	// thread of its own reads the next one. Seeks within the blocks read
+	// are served from memory, others discard them and start over from the
+	// smallest block, for the small reads of headers and indexes.
+	class PrefetchStream
+	{
+	public:
+		PrefetchStream(ByteStream* stream, int minBlockSize, int maxBlockSize);
+		~PrefetchStream();
+
+		int Start(bool prefetch);
+		int Read(uint8_t* buf, int size);
+		int64_t Seek(int64_t offset, int whence);
+		void GetStats(PrefetchStreamStats& stats);
+
+		// Callbacks of avio_alloc_context, opaque is the PrefetchStream
+		static int AvioRead(void* opaque, uint8_t* buf, int size);
+		static int64_t AvioSeek(void* opaque, int64_t offset, int whence);
+
+	private:
+		struct Block
+		{
+			uint8_t* data;
+			unsigned int capacity;
+			int size;
+			int64_t pos;
+
+			// 0, or AVERROR_EOF or the read error after the data
+			int result;
+			bool ready;
+		};
+
+		void StartFill(int index);
+		void FillBlock(std::unique_lock<std::mutex>& lock, int index);
+		void NextBlock(std::unique_lock<std::mutex>& lock);
+		void WaitFill(std::unique_lock<std::mutex>& lock);
+		void AdaptBlockSize();
+		void PrefetchMain();
+
+		ByteStream* m_stream;
+		std::thread m_thread;
+
+		// Guards everything below, the stream is read without it
+		std::mutex m_mutex;
+		std::condition_variable m_fillCond;
+		std::condition_variable m_readyCond;
+
+		// The consumer reads m_blocks[m_current] from m_offset, the other
+		// block is being filled or holds what follows
+		Block m_blocks[2];
+		int m_current;
+		int m_offset;
+
+		// Stream position after the last block filled
+		int64_t m_fillPos;
+		int m_fillIndex;
+		bool m_isFilling;
+		bool m_stop;
+
+		// Block size from the bytes consumed per second, since the last
+		// discarding seek
+		int m_minBlockSize;
+		int m_maxBlockSize;
+		int m_blockSize;
+		double m_byteRate;
+		std::chrono::steady_clock::time_point m_blockStart;
+
+		// Statistics
+		uint64_t m_reads;
+		uint64_t m_bytes;
+		uint64_t m_waits;
+		uint64_t m_seeks;
+		uint64_t m_discards;
+		int m_largestBlockSize;
+	};
+}
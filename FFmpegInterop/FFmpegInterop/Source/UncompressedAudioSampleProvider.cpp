@@ -19,8 +19,11 @@
 #include "pch.h"
 
 #include "UncompressedAudioSampleProvider.h"
+#include <robuffer.h>
+#include <wrl/client.h>
 
 using namespace FFmpegInterop;
+using Microsoft::WRL::ComPtr;
 
 // Minimum duration for uncompressed audio samples (200 ms)
 const LONGLONG MINAUDIOSAMPLEDURATION = 2000000;
@@ -31,6 +34,9 @@ UncompressedAudioSampleProvider::UncompressedAudioSampleProvider(
 	AVCodecContext* avCodecCtx)
 	: UncompressedSampleProvider(reader, avFormatCtx, avCodecCtx)
 	, m_pSwrCtx(nullptr)
+	, m_sampleBuffer(nullptr)
+	, m_pSampleData(nullptr)
+	, m_sampleBufferSize(0)
 {
 }
 
@@ -40,33 +46,59 @@ HRESULT UncompressedAudioSampleProvider::AllocateResources()
 	hr = UncompressedSampleProvider::AllocateResources();
 	if (SUCCEEDED(hr))
 	{
-		// Set default channel layout when the value is unknown (0)
 		int64 inChannelLayout = m_pAvCodecCtx->channel_layout ? m_pAvCodecCtx->channel_layout : av_get_default_channel_layout(m_pAvCodecCtx->channels);
 		int64 outChannelLayout = av_get_default_channel_layout(m_pAvCodecCtx->channels);
 
-		// Set up resampler to convert any PCM format (e.g. AV_SAMPLE_FMT_FLTP) to AV_SAMPLE_FMT_S16 PCM format that is expected by Media Element.
-		// Additional logic can be added to avoid resampling PCM data that is already in AV_SAMPLE_FMT_S16_PCM.
-		m_pSwrCtx = swr_alloc_set_opts(
-			NULL,
-			outChannelLayout,
-			AV_SAMPLE_FMT_S16,
-			m_pAvCodecCtx->sample_rate,
-			inChannelLayout,
-			m_pAvCodecCtx->sample_fmt,
-			m_pAvCodecCtx->sample_rate,
-			0,
-			NULL);
-
-		if (!m_pSwrCtx)
+		// Interleaved S16 is what Media Element expects, copied as is. An
+		// unknown format waits for the first decoded frame.
+		if (m_pAvCodecCtx->sample_fmt != AV_SAMPLE_FMT_NONE &&
+			(m_pAvCodecCtx->sample_fmt != AV_SAMPLE_FMT_S16 || inChannelLayout != outChannelLayout))
 		{
-			hr = E_OUTOFMEMORY;
+			hr = CreateResampler(m_pAvCodecCtx->sample_fmt);
 		}
 	}
 
+	if (SUCCEEDED(hr))
+	{
+		// A minimum duration sample, with a quarter more for the frame
+		// crossing it. Grows to the largest sample seen.
+		int64 bytesPerSecond = (int64)m_pAvCodecCtx->channels * m_pAvCodecCtx->sample_rate * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16);
+		m_sampleBufferSize = (unsigned int)(bytesPerSecond * MINAUDIOSAMPLEDURATION / 10000000 * 5 / 4);
+	}
+
+	return hr;
+}
+
+// Set up resampler to convert any PCM format (e.g. AV_SAMPLE_FMT_FLTP) to AV_SAMPLE_FMT_S16 PCM format that is expected by Media Element.
+HRESULT UncompressedAudioSampleProvider::CreateResampler(AVSampleFormat inSampleFormat)
+{
+	HRESULT hr = S_OK;
+
+	// Set default channel layout when the value is unknown (0)
+	int64 inChannelLayout = m_pAvCodecCtx->channel_layout ? m_pAvCodecCtx->channel_layout : av_get_default_channel_layout(m_pAvCodecCtx->channels);
+	int64 outChannelLayout = av_get_default_channel_layout(m_pAvCodecCtx->channels);
+
+	m_pSwrCtx = swr_alloc_set_opts(
+		NULL,
+		outChannelLayout,
+		AV_SAMPLE_FMT_S16,
+		m_pAvCodecCtx->sample_rate,
+		inChannelLayout,
+		inSampleFormat,
+		m_pAvCodecCtx->sample_rate,
+		0,
+		NULL);
+
+	if (!m_pSwrCtx)
+	{
+		hr = E_OUTOFMEMORY;
+	}
+
 	if (SUCCEEDED(hr))
 	{
 		if (swr_init(m_pSwrCtx) < 0)
 		{
+			swr_free(&m_pSwrCtx);
 			hr = E_FAIL;
 		}
 	}
@@ -74,13 +106,51 @@ HRESULT UncompressedAudioSampleProvider::AllocateResources()
 	return hr;
 }
 
-UncompressedAudioSampleProvider::~UncompressedAudioSampleProvider()
+// Make room for size more bytes in the sample buffer, starting one if needed.
+// Only a sample longer than any before needs a larger buffer and a copy.
+HRESULT UncompressedAudioSampleProvider::ReserveSampleBuffer(unsigned int size)
 {
-	if (m_pAvFrame)
+	HRESULT hr = S_OK;
+	unsigned int length = (m_sampleBuffer != nullptr) ? m_sampleBuffer->Length : 0;
+
+	if (m_sampleBuffer != nullptr && length + size <= m_sampleBuffer->Capacity)
 	{
-		av_frame_free(&m_pAvFrame);
+		return S_OK;
 	}
 
+	m_sampleBufferSize = max(m_sampleBufferSize, length + size);
+	if (m_sampleBuffer != nullptr)
+	{
+		m_sampleBufferSize = max(m_sampleBufferSize, m_sampleBuffer->Capacity * 2);
+	}
+
+	Buffer^ buffer = ref new Buffer(m_sampleBufferSize);
+	ComPtr<IBufferByteAccess> byteAccess;
+	uint8_t* pData = nullptr;
+
+	hr = reinterpret_cast<IInspectable*>(buffer)->QueryInterface(IID_PPV_ARGS(&byteAccess));
+	if (SUCCEEDED(hr))
+	{
+		hr = byteAccess->Buffer(&pData);
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		if (length > 0)
+		{
+			memcpy(pData, m_pSampleData, length);
+		}
+		buffer->Length = length;
+
+		m_sampleBuffer = buffer;
+		m_pSampleData = pData;
+	}
+
+	return hr;
+}
+
+UncompressedAudioSampleProvider::~UncompressedAudioSampleProvider()
+{
 	// Free 
 	swr_free(&m_pSwrCtx);
 }
@@ -92,19 +162,63 @@ HRESULT UncompressedAudioSampleProvider::WriteAVPacketToStream(DataWriter^ dataW
 	return S_OK;
 }
 
+// Write the frame as S16 PCM at the end of the sample buffer, the DataWriter
+// is not used
 HRESULT UncompressedAudioSampleProvider::ProcessDecodedFrame(DataWriter^ dataWriter)
 {
-	// Resample uncompressed frame to AV_SAMPLE_FMT_S16 PCM format that is expected by Media Element
-	uint8_t *resampledData = nullptr;
-	unsigned int aBufferSize = av_samples_alloc(&resampledData, NULL, m_pAvFrame->channels, m_pAvFrame->nb_samples, AV_SAMPLE_FMT_S16, 0);
-	int resampledDataSize = swr_convert(m_pSwrCtx, &resampledData, aBufferSize, (const uint8_t **)m_pAvFrame->extended_data, m_pAvFrame->nb_samples);
-	auto aBuffer = ref new Platform::Array<uint8_t>(resampledData, min(aBufferSize, (unsigned int)(resampledDataSize * m_pAvFrame->channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16))));
-	dataWriter->WriteBytes(aBuffer);
-	av_freep(&resampledData);
+	HRESULT hr = S_OK;
+	const int bytesPerFrame = m_pAvFrame->channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16);
+
+	// The decoder may only settle on its output format with the first frame
+	if (m_pSwrCtx == nullptr &&
+		(m_pAvFrame->format != AV_SAMPLE_FMT_S16 ||
+		(m_pAvFrame->channel_layout && m_pAvFrame->channel_layout != av_get_default_channel_layout(m_pAvFrame->channels))))
+	{
+		hr = CreateResampler((AVSampleFormat)m_pAvFrame->format);
+	}
+
+	int outSamples = m_pAvFrame->nb_samples;
+	if (SUCCEEDED(hr) && m_pSwrCtx != nullptr)
+	{
+		outSamples = swr_get_out_samples(m_pSwrCtx, m_pAvFrame->nb_samples);
+		if (outSamples < 0)
+		{
+			hr = E_FAIL;
+		}
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		hr = ReserveSampleBuffer(outSamples * bytesPerFrame);
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		uint8_t* pOut = m_pSampleData + m_sampleBuffer->Length;
+
+		if (m_pSwrCtx == nullptr)
+		{
+			memcpy(pOut, m_pAvFrame->data[0], outSamples * bytesPerFrame);
+		}
+		else
+		{
+			// Resample uncompressed frame to AV_SAMPLE_FMT_S16 PCM format that is expected by Media Element
+			outSamples = swr_convert(m_pSwrCtx, &pOut, outSamples, (const uint8_t **)m_pAvFrame->extended_data, m_pAvFrame->nb_samples);
+			if (outSamples < 0)
+			{
+				hr = E_FAIL;
+			}
+		}
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		m_sampleBuffer->Length = m_sampleBuffer->Length + outSamples * bytesPerFrame;
+	}
+
 	av_frame_unref(m_pAvFrame);
-	av_frame_free(&m_pAvFrame);
 
-	return S_OK;
+	return hr;
 }
 
 MediaStreamSample^ UncompressedAudioSampleProvider::GetNextSample()
@@ -116,7 +230,6 @@ MediaStreamSample^ UncompressedAudioSampleProvider::GetNextSample()
 	HRESULT hr = S_OK;
 
 	MediaStreamSample^ sample;
-	DataWriter^ dataWriter = ref new DataWriter();
 
 	LONGLONG finalPts = -1;
 	LONGLONG finalDur = 0;
@@ -128,7 +241,7 @@ MediaStreamSample^ UncompressedAudioSampleProvider::GetNextSample()
 		LONGLONG pts = 0;
 		LONGLONG dur = 0;
 
-		hr = GetNextPacket(dataWriter, pts, dur, isFirstPacket);
+		hr = GetNextPacket(nullptr, pts, dur, isFirstPacket);
 		if (isFirstPacket)
 		{
 			isDiscontinuous = m_isDiscontinuous;
@@ -148,7 +261,10 @@ MediaStreamSample^ UncompressedAudioSampleProvider::GetNextSample()
 
 	if (finalPts != -1)
 	{
-		sample = MediaStreamSample::CreateFromBuffer(dataWriter->DetachBuffer(), { finalPts });
+		// The sample owns the buffer from now on, the next one starts anew
+		sample = MediaStreamSample::CreateFromBuffer((m_sampleBuffer != nullptr) ? m_sampleBuffer : ref new Buffer(0), { finalPts });
+		m_sampleBuffer = nullptr;
+		m_pSampleData = nullptr;
 
 		// Recalculate duration after appending samples
 		// FFMPEG does not seem to always output correct duration for uncompressed
@@ -166,11 +282,13 @@ MediaStreamSample^ UncompressedAudioSampleProvider::GetNextSample()
 			m_isDiscontinuous = false;
 		}
 	}
-	else
-	{
+	else
+	{
 		// flush stream and disable any further processing
-		DebugMessage(L"Too many broken packets - disable stream\n");
-		DisableStream();
+		DebugMessage(L"Too many broken packets - disable stream\n");
+		m_sampleBuffer = nullptr;
+		m_pSampleData = nullptr;
+		DisableStream();
 	}
 
 	return sample;
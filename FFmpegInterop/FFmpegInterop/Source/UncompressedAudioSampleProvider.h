@@ -42,7 +42,17 @@ namespace FFmpegInterop
 		virtual HRESULT AllocateResources() override;
 
 	private:
+		HRESULT CreateResampler(AVSampleFormat inSampleFormat);
+		HRESULT ReserveSampleBuffer(unsigned int size);
+
+		// Null while the decoder outputs interleaved S16 already
 		SwrContext* m_pSwrCtx;
+
+		// Buffer of the sample being aggregated, PCM is written straight
+		// into it. A new one per sample, the pipeline keeps the last one.
+		Buffer^ m_sampleBuffer;
+		uint8_t* m_pSampleData;
+		unsigned int m_sampleBufferSize;
 	};
 }
 
@@ -24,9 +24,33 @@ using namespace FFmpegInterop;
 UncompressedSampleProvider::UncompressedSampleProvider(FFmpegReader^ reader, AVFormatContext* avFormatCtx, AVCodecContext* avCodecCtx)
 	: MediaSampleProvider(reader, avFormatCtx, avCodecCtx)
 	, m_pAvFrame(nullptr)
+	, m_pReceivedFrame(nullptr)
 {
 }
 
+UncompressedSampleProvider::~UncompressedSampleProvider()
+{
+	av_frame_free(&m_pAvFrame);
+	av_frame_free(&m_pReceivedFrame);
+}
+
+HRESULT UncompressedSampleProvider::AllocateResources()
+{
+	HRESULT hr = S_OK;
+	hr = MediaSampleProvider::AllocateResources();
+	if (SUCCEEDED(hr))
+	{
+		m_pAvFrame = av_frame_alloc();
+		m_pReceivedFrame = av_frame_alloc();
+		if (m_pAvFrame == nullptr || m_pReceivedFrame == nullptr)
+		{
+			hr = E_OUTOFMEMORY;
+		}
+	}
+
+	return hr;
+}
+
 HRESULT UncompressedSampleProvider::ProcessDecodedFrame(DataWriter^ dataWriter)
 {
 	return S_OK;
@@ -56,9 +80,9 @@ HRESULT UncompressedSampleProvider::GetFrameFromFFmpegDecoder(AVPacket* avPacket
 	}
 	if (SUCCEEDED(hr))
 	{
-		AVFrame *pFrame = av_frame_alloc();
-		// Try to get a frame from the decoder.
-		decodeFrame = avcodec_receive_frame(m_pAvCodecCtx, pFrame);
+		// Try to get a frame from the decoder. Received aside, as a failed
+		// receive clears the frame and m_pAvFrame must keep the last one.
+		decodeFrame = avcodec_receive_frame(m_pAvCodecCtx, m_pReceivedFrame);
 
 		// The decoder is empty, send a packet to it.
 		if (decodeFrame == AVERROR(EAGAIN))
@@ -66,19 +90,16 @@ HRESULT UncompressedSampleProvider::GetFrameFromFFmpegDecoder(AVPacket* avPacket
 			// The decoder doesn't have enough data to produce a frame,
 			// return S_FALSE to indicate a partial frame
 			hr = S_FALSE;
-			av_frame_unref(pFrame);
-			av_frame_free(&pFrame);
 		}
 		else if (decodeFrame < 0)
 		{
 			hr = E_FAIL;
-			av_frame_unref(pFrame);
-			av_frame_free(&pFrame);
 			DebugMessage(L"Failed to get a frame from the decoder\n");
 		}
 		else
 		{
-			m_pAvFrame = pFrame;
+			av_frame_unref(m_pAvFrame);
+			av_frame_move_ref(m_pAvFrame, m_pReceivedFrame);
 		}
 	}
 
@@ -28,6 +28,9 @@ namespace FFmpegInterop
 {
 	ref class UncompressedSampleProvider abstract : public MediaSampleProvider
 	{
+	public:
+		virtual ~UncompressedSampleProvider();
+
 	internal:
 		// Try to get a frame from FFmpeg, otherwise, feed a frame to start decoding
 		virtual HRESULT GetFrameFromFFmpegDecoder(AVPacket* avPacket);
@@ -37,9 +40,12 @@ namespace FFmpegInterop
 			FFmpegReader^ reader,
 			AVFormatContext* avFormatCtx,
 			AVCodecContext* avCodecCtx);
+		virtual HRESULT AllocateResources() override;
 
 	internal:
+		// Last frame decoded, both frames are reused for every frame
 		AVFrame* m_pAvFrame;
+		AVFrame* m_pReceivedFrame;
 	};
 }
 
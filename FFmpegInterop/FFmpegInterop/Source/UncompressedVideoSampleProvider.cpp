@@ -67,15 +67,6 @@ HRESULT UncompressedVideoSampleProvider::AllocateResources()
 		}
 	}
 
-	if (SUCCEEDED(hr))
-	{
-		m_pAvFrame = av_frame_alloc();
-		if (m_pAvFrame == nullptr)
-		{
-			hr = E_OUTOFMEMORY;
-		}
-	}
-
 	if (SUCCEEDED(hr))
 	{
 		if (av_image_alloc(m_rgVideoBufferData, m_rgVideoBufferLineSize, m_pAvCodecCtx->width, m_pAvCodecCtx->height, AV_PIX_FMT_NV12, 1) < 0)
@@ -89,11 +80,6 @@ HRESULT UncompressedVideoSampleProvider::AllocateResources()
 
 UncompressedVideoSampleProvider::~UncompressedVideoSampleProvider()
 {
-	if (m_pAvFrame)
-	{
-		av_frame_free(&m_pAvFrame);
-	}
-
 	if (m_rgVideoBufferData)
 	{
 		av_freep(m_rgVideoBufferData);
@@ -151,7 +137,6 @@ HRESULT UncompressedVideoSampleProvider::WriteAVPacketToStream(DataWriter^ dataW
 	dataWriter->WriteBytes(YBuffer);
 	dataWriter->WriteBytes(UVBuffer);
 	av_frame_unref(m_pAvFrame);
-	av_frame_free(&m_pAvFrame);
 
 	return S_OK;
 }
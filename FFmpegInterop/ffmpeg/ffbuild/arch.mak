@@ -14,4 +14,9 @@ OBJS-$(HAVE_ALTIVEC) += $(ALTIVEC-OBJS) $(ALTIVEC-OBJS-yes)
 OBJS-$(HAVE_VSX)     += $(VSX-OBJS) $(VSX-OBJS-yes)
 
 OBJS-$(HAVE_MMX)     += $(MMX-OBJS)     $(MMX-OBJS-yes)
+OBJS-$(HAVE_SSE)     += $(SSE-OBJS)     $(SSE-OBJS-yes)
+OBJS-$(HAVE_SSE2)    += $(SSE2-OBJS)    $(SSE2-OBJS-yes)
+OBJS-$(HAVE_SSE4)    += $(SSE4-OBJS)    $(SSE4-OBJS-yes)
+OBJS-$(HAVE_AVX)     += $(AVX-OBJS)     $(AVX-OBJS-yes)
+OBJS-$(HAVE_AVX2)    += $(AVX2-OBJS)    $(AVX2-OBJS-yes)
 OBJS-$(HAVE_X86ASM)  += $(X86ASM-OBJS)  $(X86ASM-OBJS-yes)
@@ -903,7 +903,7 @@ int av_cold ff_celt_pvq_init(CeltPVQ **pvq, int encode)
     s->pvq_search = ppp_pvq_search_c;
     s->quant_band = encode ? pvq_encode_band : pvq_decode_band;
 
-    if (ARCH_X86)
+    if (ARCH_X86 && CONFIG_OPUS_ENCODER)
         ff_opus_dsp_init_x86(s);
 
     *pvq = s;
@@ -94,6 +94,7 @@ av_cold void ff_vp6dsp_init(VP56DSPContext *s)
     s->edge_filter_ver = vp6_edge_filter_ver;
 
     s->vp6_filter_diag4 = ff_vp6_filter_diag4_c;
+    s->vp6_filter_hv4   = ff_vp6_filter_hv4_c;
 
     if (ARCH_ARM)
         ff_vp6dsp_init_arm(s);
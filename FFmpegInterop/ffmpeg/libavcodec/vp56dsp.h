@@ -30,10 +30,20 @@ typedef struct VP56DSPContext {
 
     void (*vp6_filter_diag4)(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
                              const int16_t *h_weights,const int16_t *v_weights);
+
+    /**
+     * 4-tap filter of an 8x8 block along one direction.
+     *
+     * @param delta distance between two taps: 1 across, stride down
+     */
+    void (*vp6_filter_hv4)(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                           ptrdiff_t delta, const int16_t *weights);
 } VP56DSPContext;
 
 void ff_vp6_filter_diag4_c(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
                            const int16_t *h_weights, const int16_t *v_weights);
+void ff_vp6_filter_hv4_c(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                         ptrdiff_t delta, const int16_t *weights);
 
 void ff_vp5dsp_init(VP56DSPContext *s);
 void ff_vp6dsp_init(VP56DSPContext *s);
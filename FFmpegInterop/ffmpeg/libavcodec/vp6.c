@@ -546,23 +546,6 @@ static int vp6_block_variance(uint8_t *src, ptrdiff_t stride)
     return (16*square_sum - sum*sum) >> 8;
 }
 
-static void vp6_filter_hv4(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
-                           int delta, const int16_t *weights)
-{
-    int x, y;
-
-    for (y=0; y<8; y++) {
-        for (x=0; x<8; x++) {
-            dst[x] = av_clip_uint8((  src[x-delta  ] * weights[0]
-                                 + src[x        ] * weights[1]
-                                 + src[x+delta  ] * weights[2]
-                                 + src[x+2*delta] * weights[3] + 64) >> 7);
-        }
-        src += stride;
-        dst += stride;
-    }
-}
-
 static void vp6_filter_diag2(VP56Context *s, uint8_t *dst, uint8_t *src,
                              ptrdiff_t stride, int h_weight, int v_weight)
 {
@@ -602,11 +585,11 @@ static void vp6_filter(VP56Context *s, uint8_t *dst, uint8_t *src,
 
     if (filter4) {
         if (!y8) {                      /* left or right combine */
-            vp6_filter_hv4(dst, src+offset1, stride, 1,
-                           vp6_block_copy_filter[select][x8]);
+            s->vp56dsp.vp6_filter_hv4(dst, src+offset1, stride, 1,
+                                      vp6_block_copy_filter[select][x8]);
         } else if (!x8) {               /* above or below combine */
-            vp6_filter_hv4(dst, src+offset1, stride, stride,
-                           vp6_block_copy_filter[select][y8]);
+            s->vp56dsp.vp6_filter_hv4(dst, src+offset1, stride, stride,
+                                      vp6_block_copy_filter[select][y8]);
         } else {
             s->vp56dsp.vp6_filter_diag4(dst, src+offset1+((mv.x^mv.y)>>31), stride,
                              vp6_block_copy_filter[select][x8],
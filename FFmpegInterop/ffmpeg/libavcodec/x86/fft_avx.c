@@ -0,0 +1,93 @@
+/*
+ * AVX version of the split-radix FFT pass, bit-exact with fft_template.c
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+#include <immintrin.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "fft.h"
+
+/* pass_sse() of fft_sse.c on four complex per register. The buffers only
+ * need the alignment of the SSE version. */
+
+#define SWAP_RE_IM(v) _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1))
+
+/* Each twiddle twice, in the order of w */
+static av_always_inline X86_TARGET("avx")
+__m256 dup_twiddles(__m128 w)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(w, w)),
+                                _mm_unpackhi_ps(w, w), 1);
+}
+
+static av_always_inline X86_TARGET("avx")
+void transform(FFTComplex *z, ptrdiff_t o1, __m256 wre, __m256 wim, int zero)
+{
+    const __m256 sign_im = _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f,
+                                          0.0f, -0.0f, 0.0f, -0.0f);
+    __m256 a0  = _mm256_loadu_ps(&z[0].re);
+    __m256 a1  = _mm256_loadu_ps(&z[o1].re);
+    __m256 a2  = _mm256_loadu_ps(&z[2 * o1].re);
+    __m256 a3  = _mm256_loadu_ps(&z[3 * o1].re);
+    __m256 t12 = _mm256_add_ps(_mm256_mul_ps(a2, wre),
+                               _mm256_xor_ps(_mm256_mul_ps(SWAP_RE_IM(a2), wim), sign_im));
+    __m256 t56 = _mm256_sub_ps(_mm256_mul_ps(a3, wre),
+                               _mm256_xor_ps(_mm256_mul_ps(SWAP_RE_IM(a3), wim), sign_im));
+    __m256 s, d;
+
+    if (zero) {
+        t12 = _mm256_blend_ps(t12, a2, 0x03);
+        t56 = _mm256_blend_ps(t56, a3, 0x03);
+    }
+
+    s = _mm256_add_ps(t56, t12);
+    d = _mm256_xor_ps(SWAP_RE_IM(_mm256_sub_ps(t12, t56)), sign_im);
+
+    _mm256_storeu_ps(&z[0].re,      _mm256_add_ps(a0, s));
+    _mm256_storeu_ps(&z[2 * o1].re, _mm256_sub_ps(a0, s));
+    _mm256_storeu_ps(&z[o1].re,     _mm256_add_ps(a1, d));
+    _mm256_storeu_ps(&z[3 * o1].re, _mm256_sub_ps(a1, d));
+}
+
+/* z[0...8n-1], w[1...2n-1], n >= 2 */
+static X86_TARGET("avx")
+void pass_avx(FFTComplex *z, const FFTSample *wre, unsigned int n)
+{
+    const ptrdiff_t o1 = 2 * n;
+    unsigned int k;
+
+    for (k = 0; k < o1; k += 4) {
+        /* wre[k...k+3] and wim[-k...-k-3], with wim = wre + o1 */
+        __m256 wr = dup_twiddles(_mm_loadu_ps(wre + k));
+        __m128 wi = _mm_loadu_ps(wre + o1 - k - 3);
+
+        wi = _mm_shuffle_ps(wi, wi, _MM_SHUFFLE(0, 1, 2, 3));
+        if (k)
+            transform(z + k, o1, wr, dup_twiddles(wi), 0);
+        else
+            transform(z,     o1, wr, dup_twiddles(wi), 1);
+    }
+}
+
+void ff_fft_calc_avx(FFTContext *s, FFTComplex *z)
+{
+    ff_fft_dispatch_sse(z, s->nbits, pass_avx);
+}
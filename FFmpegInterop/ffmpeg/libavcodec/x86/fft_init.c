@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "fft.h"
+
+av_cold void ff_fft_init_x86(FFTContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    /* The permutation stays FF_FFT_PERM_DEFAULT: every version gives the
+     * output of the C one, bit for bit. */
+    if (X86_SSE(cpu_flags)) {
+        s->fft_calc = ff_fft_calc_sse;
+        /* MDCTs of 32 points and more, n / 8 being a multiple of 4, while
+         * revtab is 16 bits wide */
+        if (s->nbits >= 3 && s->nbits <= 16) {
+            s->imdct_calc = ff_imdct_calc_sse;
+            s->imdct_half = ff_imdct_half_sse;
+        }
+    }
+    if (X86_AVX_FAST(cpu_flags) && s->nbits >= 5)
+        s->fft_calc = ff_fft_calc_avx;
+}
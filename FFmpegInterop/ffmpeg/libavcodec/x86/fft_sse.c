@@ -0,0 +1,265 @@
+/*
+ * SSE split-radix FFT and inverse MDCT, bit-exact with fft_template.c and
+ * mdct_template.c
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <xmmintrin.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/x86/cpu.h"
+#include "fft.h"
+
+/* Complex numbers stay interleaved, two per register. Each one gets the
+ * operations of the C macros in the same order: a - (-b) and -a + b are
+ * computed as a + b and b - a, which round the same. */
+
+#define SWAP_RE_IM(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))
+#define REVERSE(v)    _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+
+#define SIGN_IM  _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f)
+#define SIGN_HI  _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f)
+#define SIGN_ALL _mm_set1_ps(-0.0f)
+
+/**
+ * TRANSFORM() of fft_template.c on z[0..1], z[o1..], z[2*o1..] and
+ * z[3*o1..], a2 and a3 being the latter two. wre and wim hold the twiddles
+ * of each complex twice. With zero set, the first complex gets
+ * TRANSFORM_ZERO() instead.
+ */
+static av_always_inline X86_TARGET("sse")
+void transform(FFTComplex *z, ptrdiff_t o1, __m128 a2, __m128 a3,
+               __m128 wre, __m128 wim, int zero)
+{
+    __m128 a0 = _mm_load_ps(&z[0].re);
+    __m128 a1 = _mm_load_ps(&z[o1].re);
+    /* t1 = a2.re * wre + a2.im * wim, t2 = a2.im * wre - a2.re * wim */
+    __m128 t12 = _mm_add_ps(_mm_mul_ps(a2, wre),
+                            _mm_xor_ps(_mm_mul_ps(SWAP_RE_IM(a2), wim), SIGN_IM));
+    /* t5 = a3.re * wre - a3.im * wim, t6 = a3.im * wre + a3.re * wim */
+    __m128 t56 = _mm_sub_ps(_mm_mul_ps(a3, wre),
+                            _mm_xor_ps(_mm_mul_ps(SWAP_RE_IM(a3), wim), SIGN_IM));
+    __m128 s, d;
+
+    if (zero) {
+        t12 = _mm_shuffle_ps(a2, t12, _MM_SHUFFLE(3, 2, 1, 0));
+        t56 = _mm_shuffle_ps(a3, t56, _MM_SHUFFLE(3, 2, 1, 0));
+    }
+
+    /* BUTTERFLIES(): s = { t5 + t1, t2 + t6 }, d = { t4, t3 } */
+    s = _mm_add_ps(t56, t12);
+    d = _mm_xor_ps(SWAP_RE_IM(_mm_sub_ps(t12, t56)), SIGN_IM);
+
+    _mm_store_ps(&z[0].re,      _mm_add_ps(a0, s));
+    _mm_store_ps(&z[2 * o1].re, _mm_sub_ps(a0, s));
+    _mm_store_ps(&z[o1].re,     _mm_add_ps(a1, d));
+    _mm_store_ps(&z[3 * o1].re, _mm_sub_ps(a1, d));
+}
+
+/* z[0...8n-1], w[1...2n-1] */
+static X86_TARGET("sse")
+void pass_sse(FFTComplex *z, const FFTSample *wre, unsigned int n)
+{
+    const ptrdiff_t o1 = 2 * n;
+    unsigned int k;
+
+    for (k = 0; k < o1; k += 2) {
+        /* wre[k], wre[k + 1] and wim[-k], wim[-k - 1], with wim = wre + o1 */
+        __m128 wr = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(wre + k));
+        __m128 wi = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(wre + o1 - k - 1));
+        __m128 a2 = _mm_load_ps(&z[k + 2 * o1].re);
+        __m128 a3 = _mm_load_ps(&z[k + 3 * o1].re);
+
+        wr = _mm_unpacklo_ps(wr, wr);
+        wi = _mm_shuffle_ps(wi, wi, _MM_SHUFFLE(0, 0, 1, 1));
+        if (k)
+            transform(z + k, o1, a2, a3, wr, wi, 0);
+        else
+            transform(z,     o1, a2, a3, wr, wi, 1);
+    }
+}
+
+static av_always_inline X86_TARGET("sse")
+void fft4(FFTComplex *z)
+{
+    __m128 a  = _mm_load_ps(&z[0].re);
+    __m128 b  = _mm_load_ps(&z[2].re);
+    __m128 a1 = _mm_movehl_ps(a, a);
+    __m128 b1 = _mm_movehl_ps(b, b);
+    /* { t1, t2 }, { t3, t4 }, { t6, t5 } and { t7, t8 } */
+    __m128 as = _mm_add_ps(a, a1);
+    __m128 ad = _mm_sub_ps(a, a1);
+    __m128 bs = _mm_add_ps(b, b1);
+    __m128 bd = _mm_xor_ps(SWAP_RE_IM(_mm_sub_ps(b, b1)), SIGN_IM);
+
+    _mm_store_ps(&z[0].re, _mm_movelh_ps(_mm_add_ps(as, bs), _mm_add_ps(ad, bd)));
+    _mm_store_ps(&z[2].re, _mm_movelh_ps(_mm_sub_ps(as, bs), _mm_sub_ps(ad, bd)));
+}
+
+static av_always_inline X86_TARGET("sse")
+void fft8(FFTComplex *z)
+{
+    __m128 a2 = _mm_load_ps(&z[4].re);
+    __m128 a3 = _mm_load_ps(&z[6].re);
+    __m128 w  = _mm_set1_ps((float)M_SQRT1_2);
+
+    fft4(z);
+
+    /* { z[4] + z[5], z[4] - z[5] } and the same for z[6] and z[7] */
+    a2 = _mm_add_ps(_mm_movelh_ps(a2, a2), _mm_xor_ps(_mm_movehl_ps(a2, a2), SIGN_HI));
+    a3 = _mm_add_ps(_mm_movelh_ps(a3, a3), _mm_xor_ps(_mm_movehl_ps(a3, a3), SIGN_HI));
+    transform(z, 2, a2, a3, w, w, 1);
+}
+
+static av_always_inline X86_TARGET("sse")
+void fft16(FFTComplex *z)
+{
+    fft8(z);
+    fft4(z + 8);
+    fft4(z + 12);
+    pass_sse(z, ff_cos_16, 2);
+}
+
+X86_TARGET("sse")
+void ff_fft_dispatch_sse(FFTComplex *z, int nbits, ff_fft_pass_func pass)
+{
+    int n4;
+
+    switch (nbits) {
+    case 2: fft4(z);  return;
+    case 3: fft8(z);  return;
+    case 4: fft16(z); return;
+    }
+
+    n4 = 1 << (nbits - 2);
+    ff_fft_dispatch_sse(z,          nbits - 1, pass);
+    ff_fft_dispatch_sse(z + 2 * n4, nbits - 2, pass);
+    ff_fft_dispatch_sse(z + 3 * n4, nbits - 2, pass);
+    pass(z, ff_cos_tabs[nbits], n4 / 2);
+}
+
+void ff_fft_calc_sse(FFTContext *s, FFTComplex *z)
+{
+    ff_fft_dispatch_sse(z, s->nbits, pass_sse);
+}
+
+static av_always_inline X86_TARGET("sse")
+void store_revtab(FFTComplex *z, const uint16_t *revtab, __m128 re, __m128 im)
+{
+    __m128 lo = _mm_unpacklo_ps(re, im);
+    __m128 hi = _mm_unpackhi_ps(re, im);
+
+    _mm_storel_pi((__m64 *)&z[revtab[0]], lo);
+    _mm_storeh_pi((__m64 *)&z[revtab[1]], lo);
+    _mm_storel_pi((__m64 *)&z[revtab[2]], hi);
+    _mm_storeh_pi((__m64 *)&z[revtab[3]], hi);
+}
+
+/* Four complex of z into their real and imaginary parts */
+static av_always_inline X86_TARGET("sse")
+void load_complex4(const FFTComplex *z, __m128 *re, __m128 *im)
+{
+    __m128 lo = _mm_load_ps(&z[0].re);
+    __m128 hi = _mm_load_ps(&z[2].re);
+
+    *re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+static av_always_inline X86_TARGET("sse")
+void store_complex4(FFTComplex *z, __m128 re, __m128 im)
+{
+    _mm_store_ps(&z[0].re, _mm_unpacklo_ps(re, im));
+    _mm_store_ps(&z[2].re, _mm_unpackhi_ps(re, im));
+}
+
+/* Needs n / 8 to be a multiple of 4, n being the MDCT size. */
+X86_TARGET("sse")
+void ff_imdct_half_sse(FFTContext *s, FFTSample *output, const FFTSample *input)
+{
+    const uint16_t *revtab = s->revtab;
+    const FFTSample *tcos = s->tcos;
+    const FFTSample *tsin = s->tsin;
+    FFTComplex *z = (FFTComplex *)output;
+    int n  = 1 << s->mdct_bits;
+    int n2 = n >> 1;
+    int n4 = n >> 2;
+    int n8 = n >> 3;
+    int k;
+
+    /* pre rotation, input[2 * k] with input[n2 - 1 - 2 * k] */
+    for (k = 0; k < n4; k += 4) {
+        const FFTSample *in2 = input + n2 - 8 - 2 * k;
+        __m128 in1 = _mm_shuffle_ps(_mm_loadu_ps(input + 2 * k),
+                                    _mm_loadu_ps(input + 2 * k + 4),
+                                    _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 re  = _mm_shuffle_ps(_mm_loadu_ps(in2 + 4), _mm_loadu_ps(in2),
+                                    _MM_SHUFFLE(1, 3, 1, 3));
+        __m128 c   = _mm_loadu_ps(tcos + k);
+        __m128 sn  = _mm_loadu_ps(tsin + k);
+
+        store_revtab(z, revtab + k,
+                     _mm_sub_ps(_mm_mul_ps(re, c),  _mm_mul_ps(in1, sn)),
+                     _mm_add_ps(_mm_mul_ps(re, sn), _mm_mul_ps(in1, c)));
+    }
+
+    s->fft_calc(s, z);
+
+    /* post rotation + reordering, z[n8 - 1 - k] with z[n8 + k]; the first
+     * ones are handled in increasing order, so their partners are reversed */
+    for (k = 0; k < n8; k += 4) {
+        int a = n8 - 4 - k, b = n8 + k;
+        __m128 ra, ia, rb, ib, ca, sa, cb, sb, r0, i0, r1, i1;
+
+        load_complex4(z + a, &ra, &ia);
+        load_complex4(z + b, &rb, &ib);
+        ca = _mm_loadu_ps(tcos + a);
+        sa = _mm_loadu_ps(tsin + a);
+        cb = _mm_loadu_ps(tcos + b);
+        sb = _mm_loadu_ps(tsin + b);
+
+        r0 = _mm_sub_ps(_mm_mul_ps(ia, sa), _mm_mul_ps(ra, ca));
+        i1 = _mm_add_ps(_mm_mul_ps(ia, ca), _mm_mul_ps(ra, sa));
+        r1 = _mm_sub_ps(_mm_mul_ps(ib, sb), _mm_mul_ps(rb, cb));
+        i0 = _mm_add_ps(_mm_mul_ps(ib, cb), _mm_mul_ps(rb, sb));
+
+        store_complex4(z + a, r0, REVERSE(i0));
+        store_complex4(z + b, r1, REVERSE(i1));
+    }
+}
+
+X86_TARGET("sse")
+void ff_imdct_calc_sse(FFTContext *s, FFTSample *output, const FFTSample *input)
+{
+    int k;
+    int n  = 1 << s->mdct_bits;
+    int n2 = n >> 1;
+    int n4 = n >> 2;
+
+    s->imdct_half(s, output + n4, input);
+
+    for (k = 0; k < n4; k += 4) {
+        __m128 a = _mm_load_ps(output + n2 - 4 - k);
+        __m128 b = _mm_load_ps(output + n2 + k);
+        _mm_store_ps(output + k,         _mm_xor_ps(REVERSE(a), SIGN_ALL));
+        _mm_store_ps(output + n - 4 - k, REVERSE(b));
+    }
+}
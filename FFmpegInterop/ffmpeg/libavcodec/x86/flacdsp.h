@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_X86_FLACDSP_H
+#define AVCODEC_X86_FLACDSP_H
+
+#include <stdint.h>
+
+void ff_flac_decorrelate_indep_16_sse2(uint8_t **out, int32_t **in,
+                                       int channels, int len, int shift);
+void ff_flac_decorrelate_ls_16_sse2(uint8_t **out, int32_t **in,
+                                    int channels, int len, int shift);
+void ff_flac_decorrelate_rs_16_sse2(uint8_t **out, int32_t **in,
+                                    int channels, int len, int shift);
+void ff_flac_decorrelate_ms_16_sse2(uint8_t **out, int32_t **in,
+                                    int channels, int len, int shift);
+
+void ff_flac_decorrelate_indep_32_sse2(uint8_t **out, int32_t **in,
+                                       int channels, int len, int shift);
+void ff_flac_decorrelate_ls_32_sse2(uint8_t **out, int32_t **in,
+                                    int channels, int len, int shift);
+void ff_flac_decorrelate_rs_32_sse2(uint8_t **out, int32_t **in,
+                                    int channels, int len, int shift);
+void ff_flac_decorrelate_ms_32_sse2(uint8_t **out, int32_t **in,
+                                    int channels, int len, int shift);
+
+void ff_flac_lpc_16_sse4(int32_t *samples, const int coeffs[32], int order,
+                         int qlevel, int len);
+void ff_flac_lpc_32_sse4(int32_t *samples, const int coeffs[32], int order,
+                         int qlevel, int len);
+
+void ff_flac_lpc_16_avx2(int32_t *samples, const int coeffs[32], int order,
+                         int qlevel, int len);
+void ff_flac_lpc_32_avx2(int32_t *samples, const int coeffs[32], int order,
+                         int qlevel, int len);
+
+#endif /* AVCODEC_X86_FLACDSP_H */
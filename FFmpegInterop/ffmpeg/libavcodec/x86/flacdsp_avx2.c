@@ -0,0 +1,164 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/cpu.h"
+#include "flacdsp.h"
+#include "flacdsp_lpc.h"
+
+/* The window is read 8 samples at a time, while 4 samples are still
+ * predicted at a time as in the SSE4 versions, so its last 8 are the
+ * outputs of the 2 previous blocks. Only the first output of the previous
+ * block is used there and it is kept in a register; the others are zeroed
+ * in the tables or come from memory, long after they were stored.
+ * Orders up to 8 fit one vector of the SSE4 versions, which are faster
+ * there, so they are left to them. */
+
+X86_TARGET("avx2")
+void ff_flac_lpc_16_avx2(int32_t *decoded, const int coeffs[32], int order,
+                         int qlevel, int len)
+{
+    DECLARE_ALIGNED(32, int32_t, tab)[4][36];
+    DECLARE_ALIGNED(16, int32_t, v)[4];
+    int n   = (order + 7) >> 3;
+    int pad = 8 * n - order;
+    int c[7], x[3];
+    int i = 0, k;
+    __m128i part;
+
+    if (order <= 8) {
+        ff_flac_lpc_16_sse4(decoded, coeffs, order, qlevel, len);
+        return;
+    }
+
+    len -= order;
+
+    for (; i < FFMIN(pad, len); i++)
+        lpc16_c(decoded + i, coeffs, order, qlevel);
+    if (len - i < 4)
+        goto tail;
+
+    lpc_tabs(tab, c, coeffs, order, pad);
+    part = _mm_cvtsi32_si128(decoded[i + order - 4]);
+    x[0] = decoded[i + order - 3];
+    x[1] = decoded[i + order - 2];
+    x[2] = decoded[i + order - 1];
+
+    for (; i + 4 <= len; i += 4) {
+        const int32_t *win = decoded + i - pad;
+        int32_t *out = decoded + i + order;
+        __m256i a0, a1, a2, a3, w;
+        __m128i s;
+
+        w  = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                 _mm_loadu_si128((const __m128i *)(out - 8))), part, 1);
+        a0 = _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[0] + 8 * (n - 1))));
+        a1 = _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[1] + 8 * (n - 1))));
+        a2 = _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[2] + 8 * (n - 1))));
+        a3 = _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[3] + 8 * (n - 1))));
+        for (k = 0; k < n - 1; k++) {
+            w  = _mm256_loadu_si256((const __m256i *)(win + 8 * k));
+            a0 = _mm256_add_epi32(a0, _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[0] + 8 * k))));
+            a1 = _mm256_add_epi32(a1, _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[1] + 8 * k))));
+            a2 = _mm256_add_epi32(a2, _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[2] + 8 * k))));
+            a3 = _mm256_add_epi32(a3, _mm256_mullo_epi32(w, _mm256_load_si256((const __m256i *)(tab[3] + 8 * k))));
+        }
+        a0 = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+        s  = _mm_add_epi32(_mm256_castsi256_si128(a0), _mm256_extracti128_si256(a0, 1));
+        _mm_store_si128((__m128i *)v, s);
+        part = _mm_cvtsi32_si128(lpc16_block(out, v, c, x, qlevel));
+    }
+
+tail:
+    for (; i < len; i++)
+        lpc16_c(decoded + i, coeffs, order, qlevel);
+}
+
+#define MAC64(acc, w, wodd, tab)                                            \
+    _mm256_add_epi64(acc, _mm256_add_epi64(                                 \
+        _mm256_mul_epi32(w,    _mm256_load_si256((const __m256i *)(tab))),  \
+        _mm256_mul_epi32(wodd, _mm256_loadu_si256((const __m256i *)((tab) + 1)))))
+
+X86_TARGET("avx2")
+void ff_flac_lpc_32_avx2(int32_t *decoded, const int coeffs[32], int order,
+                         int qlevel, int len)
+{
+    DECLARE_ALIGNED(32, int32_t, tab)[4][36];
+    DECLARE_ALIGNED(16, int64_t, v)[4];
+    int n   = (order + 7) >> 3;
+    int pad = 8 * n - order;
+    int c[7], x[3];
+    int i = 0, k;
+    __m128i part;
+
+    if (order <= 8) {
+        ff_flac_lpc_32_sse4(decoded, coeffs, order, qlevel, len);
+        return;
+    }
+
+    len -= order;
+
+    for (; i < FFMIN(pad, len); i++)
+        lpc32_c(decoded + i, coeffs, order, qlevel);
+    if (len - i < 4)
+        goto tail;
+
+    lpc_tabs(tab, c, coeffs, order, pad);
+    part = _mm_cvtsi32_si128(decoded[i + order - 4]);
+    x[0] = decoded[i + order - 3];
+    x[1] = decoded[i + order - 2];
+    x[2] = decoded[i + order - 1];
+
+    for (; i + 4 <= len; i += 4) {
+        const int32_t *win = decoded + i - pad;
+        int32_t *out = decoded + i + order;
+        __m256i a0, a1, a2, a3, w, wodd;
+
+        w    = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                   _mm_loadu_si128((const __m128i *)(out - 8))), part, 1);
+        wodd = _mm256_srli_epi64(w, 32);
+        a0   = MAC64(_mm256_setzero_si256(), w, wodd, tab[0] + 8 * (n - 1));
+        a1   = MAC64(_mm256_setzero_si256(), w, wodd, tab[1] + 8 * (n - 1));
+        a2   = MAC64(_mm256_setzero_si256(), w, wodd, tab[2] + 8 * (n - 1));
+        a3   = MAC64(_mm256_setzero_si256(), w, wodd, tab[3] + 8 * (n - 1));
+        for (k = 0; k < n - 1; k++) {
+            w    = _mm256_loadu_si256((const __m256i *)(win + 8 * k));
+            wodd = _mm256_srli_epi64(w, 32);
+            a0   = MAC64(a0, w, wodd, tab[0] + 8 * k);
+            a1   = MAC64(a1, w, wodd, tab[1] + 8 * k);
+            a2   = MAC64(a2, w, wodd, tab[2] + 8 * k);
+            a3   = MAC64(a3, w, wodd, tab[3] + 8 * k);
+        }
+        a0 = _mm256_add_epi64(_mm256_unpacklo_epi64(a0, a1), _mm256_unpackhi_epi64(a0, a1));
+        a2 = _mm256_add_epi64(_mm256_unpacklo_epi64(a2, a3), _mm256_unpackhi_epi64(a2, a3));
+        _mm_store_si128((__m128i *)v,       _mm_add_epi64(_mm256_castsi256_si128(a0),
+                                                          _mm256_extracti128_si256(a0, 1)));
+        _mm_store_si128((__m128i *)(v + 2), _mm_add_epi64(_mm256_castsi256_si128(a2),
+                                                          _mm256_extracti128_si256(a2, 1)));
+        part = _mm_cvtsi32_si128(lpc32_block(out, v, c, x, qlevel));
+    }
+
+tail:
+    for (; i < len; i++)
+        lpc32_c(decoded + i, coeffs, order, qlevel);
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/flacdsp.h"
+#include "config.h"
+#include "flacdsp.h"
+
+av_cold void ff_flacdsp_init_x86(FLACDSPContext *c, enum AVSampleFormat fmt, int channels,
+                                 int bps)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!CONFIG_FLAC_DECODER)
+        return;
+
+    /* All of these are bit-exact with the C versions. Interleaving is
+     * limited by memory bandwidth, so SSE2 serves for it on every CPU;
+     * only the prediction gains from wider vectors. */
+    if (X86_SSE2(cpu_flags)) {
+        if (fmt == AV_SAMPLE_FMT_S16) {
+            if (!(channels & 1))
+                c->decorrelate[0] = ff_flac_decorrelate_indep_16_sse2;
+            c->decorrelate[1] = ff_flac_decorrelate_ls_16_sse2;
+            c->decorrelate[2] = ff_flac_decorrelate_rs_16_sse2;
+            c->decorrelate[3] = ff_flac_decorrelate_ms_16_sse2;
+        } else if (fmt == AV_SAMPLE_FMT_S32) {
+            if (!(channels & 1))
+                c->decorrelate[0] = ff_flac_decorrelate_indep_32_sse2;
+            c->decorrelate[1] = ff_flac_decorrelate_ls_32_sse2;
+            c->decorrelate[2] = ff_flac_decorrelate_rs_32_sse2;
+            c->decorrelate[3] = ff_flac_decorrelate_ms_32_sse2;
+        }
+    }
+    if (X86_SSE4(cpu_flags)) {
+        c->lpc16 = ff_flac_lpc_16_sse4;
+        c->lpc32 = ff_flac_lpc_32_sse4;
+    }
+    if (X86_AVX2(cpu_flags)) {
+        c->lpc16 = ff_flac_lpc_16_avx2;
+        c->lpc32 = ff_flac_lpc_32_avx2;
+    }
+}
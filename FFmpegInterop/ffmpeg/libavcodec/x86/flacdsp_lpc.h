@@ -0,0 +1,131 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_X86_FLACDSP_LPC_H
+#define AVCODEC_X86_FLACDSP_LPC_H
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+
+/*
+ * Each predicted sample feeds the prediction of the next ones, so the
+ * samples are predicted 4 at a time. The taps on samples older than the 3
+ * just before the block are summed in vectors, over a window of samples
+ * aligned to end at the block, with zero coefficients padding its start
+ * and covering the 3 newest samples. The taps on those 3 and on the block
+ * itself are added in scalar code, so that from one sample to the next
+ * there is only a multiply and an add, and the vector sums of a block do
+ * not wait for the end of the previous one.
+ *
+ * tab[t] holds the coefficients of sample t of the block against the
+ * window, c[k] the coefficient of the sample k before the predicted one.
+ */
+static av_always_inline
+void lpc_tabs(int32_t tab[4][36], int c[7], const int coeffs[32], int order,
+              int pad)
+{
+    int t, m;
+
+    for (t = 0; t < 4; t++) {
+        for (m = 0; m < 36; m++)
+            tab[t][m] = 0;
+        for (m = pad + t; m < order + pad - 3; m++)
+            tab[t][m] = coeffs[m - pad - t];
+    }
+    for (m = 1; m < 7; m++)
+        c[m] = m <= order ? coeffs[order - m] : 0;
+}
+
+/* Predicts the block at out from the vector sums v[]. x[] holds the 3
+ * samples before the block and is moved on to its last 3; the first one
+ * is returned. */
+static av_always_inline
+int lpc16_block(int32_t *out, const int32_t v[4], const int c[7], int x[3],
+                int qlevel)
+{
+    unsigned xm3 = x[0], xm2 = x[1], xm1 = x[2], s;
+    int x0, x1, x2, x3;
+
+    s  = v[0] + c[3] * xm3 + c[2] * xm2 + c[1] * xm1;
+    x0 = out[0] + (unsigned)((int)s >> qlevel);
+    s  = v[1] + c[4] * xm3 + c[3] * xm2 + c[2] * xm1 + c[1] * (unsigned)x0;
+    x1 = out[1] + (unsigned)((int)s >> qlevel);
+    s  = v[2] + c[5] * xm3 + c[4] * xm2 + c[3] * xm1 + c[2] * (unsigned)x0
+              + c[1] * (unsigned)x1;
+    x2 = out[2] + (unsigned)((int)s >> qlevel);
+    s  = v[3] + c[6] * xm3 + c[5] * xm2 + c[4] * xm1 + c[3] * (unsigned)x0
+              + c[2] * (unsigned)x1 + c[1] * (unsigned)x2;
+    x3 = out[3] + (unsigned)((int)s >> qlevel);
+
+    out[0] = x0;
+    out[1] = x[0] = x1;
+    out[2] = x[1] = x2;
+    out[3] = x[2] = x3;
+    return x0;
+}
+
+static av_always_inline
+int lpc32_block(int32_t *out, const int64_t v[4], const int c[7], int x[3],
+                int qlevel)
+{
+    int64_t xm3 = x[0], xm2 = x[1], xm1 = x[2], s;
+    int x0, x1, x2, x3;
+
+    s  = v[0] + c[3] * xm3 + c[2] * xm2 + c[1] * xm1;
+    x0 = out[0] + (unsigned)(s >> qlevel);
+    s  = v[1] + c[4] * xm3 + c[3] * xm2 + c[2] * xm1 + c[1] * (int64_t)x0;
+    x1 = out[1] + (unsigned)(s >> qlevel);
+    s  = v[2] + c[5] * xm3 + c[4] * xm2 + c[3] * xm1 + c[2] * (int64_t)x0
+              + c[1] * (int64_t)x1;
+    x2 = out[2] + (unsigned)(s >> qlevel);
+    s  = v[3] + c[6] * xm3 + c[5] * xm2 + c[4] * xm1 + c[3] * (int64_t)x0
+              + c[2] * (int64_t)x1 + c[1] * (int64_t)x2;
+    x3 = out[3] + (unsigned)(s >> qlevel);
+
+    out[0] = x0;
+    out[1] = x[0] = x1;
+    out[2] = x[1] = x2;
+    out[3] = x[2] = x3;
+    return x0;
+}
+
+/* One sample of the C versions, for the edges of the block. */
+static av_always_inline
+void lpc16_c(int32_t *decoded, const int coeffs[32], int order, int qlevel)
+{
+    unsigned sum = 0;
+    int j;
+
+    for (j = 0; j < order; j++)
+        sum += coeffs[j] * (unsigned)decoded[j];
+    decoded[j] += (unsigned)((int)sum >> qlevel);
+}
+
+static av_always_inline
+void lpc32_c(int32_t *decoded, const int coeffs[32], int order, int qlevel)
+{
+    int64_t sum = 0;
+    int j;
+
+    for (j = 0; j < order; j++)
+        sum += (int64_t)coeffs[j] * decoded[j];
+    decoded[j] += (unsigned)(sum >> qlevel);
+}
+
+#endif /* AVCODEC_X86_FLACDSP_LPC_H */
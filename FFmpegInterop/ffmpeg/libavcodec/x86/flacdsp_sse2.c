@@ -0,0 +1,276 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+#include "flacdsp.h"
+
+/* The channel modes, as indices of FLACDSPContext.decorrelate[]. */
+#define LS 1
+#define RS 2
+#define MS 3
+
+static av_always_inline
+void stereo_c(int a, int b, int *l, int *r, int mode)
+{
+    switch (mode) {
+    case LS: *l = a;     *r = a - b; break;
+    case RS: *l = a + b; *r = b;     break;
+    case MS: a -= b >> 1;
+             *l = a + b; *r = a;     break;
+    }
+}
+
+static av_always_inline X86_TARGET("sse2")
+void stereo(__m128i a, __m128i b, __m128i *l, __m128i *r, int mode)
+{
+    switch (mode) {
+    case LS: *l = a;                   *r = _mm_sub_epi32(a, b); break;
+    case RS: *l = _mm_add_epi32(a, b); *r = b;                   break;
+    case MS: a  = _mm_sub_epi32(a, _mm_srai_epi32(b, 1));
+             *l = _mm_add_epi32(a, b); *r = a;                   break;
+    }
+}
+
+/* The 16-bit output of the C version keeps the low bits of each sample,
+ * so truncate before the saturating pack. */
+static av_always_inline X86_TARGET("sse2")
+__m128i pack16(__m128i lo, __m128i hi)
+{
+    return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                           _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+static av_always_inline X86_TARGET("sse2")
+__m128i load_shift(const int32_t *src, __m128i shift)
+{
+    return _mm_sll_epi32(_mm_loadu_si128((const __m128i *)src), shift);
+}
+
+static av_always_inline X86_TARGET("sse2")
+void decorrelate_stereo_16(uint8_t **out, int32_t **in, int len, int shift,
+                           int mode)
+{
+    int16_t *dst = (int16_t *)out[0];
+    const int32_t *in0 = in[0], *in1 = in[1];
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    int i, l, r;
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        __m128i l0, r0, l1, r1;
+
+        stereo(_mm_loadu_si128((const __m128i *)(in0 + i)),
+               _mm_loadu_si128((const __m128i *)(in1 + i)), &l0, &r0, mode);
+        stereo(_mm_loadu_si128((const __m128i *)(in0 + i + 4)),
+               _mm_loadu_si128((const __m128i *)(in1 + i + 4)), &l1, &r1, mode);
+        l0 = pack16(_mm_sll_epi32(l0, sh), _mm_sll_epi32(l1, sh));
+        r0 = pack16(_mm_sll_epi32(r0, sh), _mm_sll_epi32(r1, sh));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i),     _mm_unpacklo_epi16(l0, r0));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 8), _mm_unpackhi_epi16(l0, r0));
+    }
+    for (; i < len; i++) {
+        stereo_c(in0[i], in1[i], &l, &r, mode);
+        dst[2 * i]     = (int)((unsigned)l << shift);
+        dst[2 * i + 1] = (int)((unsigned)r << shift);
+    }
+}
+
+static av_always_inline X86_TARGET("sse2")
+void decorrelate_stereo_32(uint8_t **out, int32_t **in, int len, int shift,
+                           int mode)
+{
+    int32_t *dst = (int32_t *)out[0];
+    const int32_t *in0 = in[0], *in1 = in[1];
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    int i, l, r;
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        __m128i l0, r0;
+
+        stereo(_mm_loadu_si128((const __m128i *)(in0 + i)),
+               _mm_loadu_si128((const __m128i *)(in1 + i)), &l0, &r0, mode);
+        l0 = _mm_sll_epi32(l0, sh);
+        r0 = _mm_sll_epi32(r0, sh);
+        _mm_storeu_si128((__m128i *)(dst + 2 * i),     _mm_unpacklo_epi32(l0, r0));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 4), _mm_unpackhi_epi32(l0, r0));
+    }
+    for (; i < len; i++) {
+        stereo_c(in0[i], in1[i], &l, &r, mode);
+        dst[2 * i]     = (int)((unsigned)l << shift);
+        dst[2 * i + 1] = (int)((unsigned)r << shift);
+    }
+}
+
+#define DECORRELATE_STEREO(mode, name)                                      \
+X86_TARGET("sse2")                                                          \
+void ff_flac_decorrelate_ ## name ## _16_sse2(uint8_t **out, int32_t **in,  \
+                                              int channels, int len,        \
+                                              int shift)                    \
+{                                                                           \
+    decorrelate_stereo_16(out, in, len, shift, mode);                       \
+}                                                                           \
+                                                                            \
+X86_TARGET("sse2")                                                          \
+void ff_flac_decorrelate_ ## name ## _32_sse2(uint8_t **out, int32_t **in,  \
+                                              int channels, int len,        \
+                                              int shift)                    \
+{                                                                           \
+    decorrelate_stereo_32(out, in, len, shift, mode);                       \
+}
+
+DECORRELATE_STEREO(LS, ls)
+DECORRELATE_STEREO(RS, rs)
+DECORRELATE_STEREO(MS, ms)
+
+/* Independent channels are interleaved 4 at a time with a transpose,
+ * then a last pair if the count is not a multiple of 4. Only even channel
+ * counts are handled. */
+static av_always_inline X86_TARGET("sse2")
+void decorrelate_indep_16(uint8_t **out, int32_t **in, int channels,
+                          int len, int shift)
+{
+    int16_t *dst = (int16_t *)out[0];
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    int i, c, k;
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        int16_t *row = dst + i * channels;
+        __m128i x0, x1, x2, x3, t0, t1, t2, t3;
+
+        for (c = 0; c + 4 <= channels; c += 4) {
+            x0 = pack16(load_shift(in[c]     + i, sh), load_shift(in[c]     + i + 4, sh));
+            x1 = pack16(load_shift(in[c + 1] + i, sh), load_shift(in[c + 1] + i + 4, sh));
+            x2 = pack16(load_shift(in[c + 2] + i, sh), load_shift(in[c + 2] + i + 4, sh));
+            x3 = pack16(load_shift(in[c + 3] + i, sh), load_shift(in[c + 3] + i + 4, sh));
+            t0 = _mm_unpacklo_epi16(x0, x1);
+            t1 = _mm_unpacklo_epi16(x2, x3);
+            t2 = _mm_unpackhi_epi16(x0, x1);
+            t3 = _mm_unpackhi_epi16(x2, x3);
+            x0 = _mm_unpacklo_epi32(t0, t1);
+            x1 = _mm_unpackhi_epi32(t0, t1);
+            x2 = _mm_unpacklo_epi32(t2, t3);
+            x3 = _mm_unpackhi_epi32(t2, t3);
+            if (channels == 4) {
+                _mm_storeu_si128((__m128i *)row,        x0);
+                _mm_storeu_si128((__m128i *)(row + 8),  x1);
+                _mm_storeu_si128((__m128i *)(row + 16), x2);
+                _mm_storeu_si128((__m128i *)(row + 24), x3);
+            } else {
+                _mm_storel_epi64((__m128i *)(row + c),                x0);
+                _mm_storel_epi64((__m128i *)(row + c + channels),     _mm_srli_si128(x0, 8));
+                _mm_storel_epi64((__m128i *)(row + c + 2 * channels), x1);
+                _mm_storel_epi64((__m128i *)(row + c + 3 * channels), _mm_srli_si128(x1, 8));
+                _mm_storel_epi64((__m128i *)(row + c + 4 * channels), x2);
+                _mm_storel_epi64((__m128i *)(row + c + 5 * channels), _mm_srli_si128(x2, 8));
+                _mm_storel_epi64((__m128i *)(row + c + 6 * channels), x3);
+                _mm_storel_epi64((__m128i *)(row + c + 7 * channels), _mm_srli_si128(x3, 8));
+            }
+        }
+        if (c < channels) {
+            x0 = pack16(load_shift(in[c]     + i, sh), load_shift(in[c]     + i + 4, sh));
+            x1 = pack16(load_shift(in[c + 1] + i, sh), load_shift(in[c + 1] + i + 4, sh));
+            t0 = _mm_unpacklo_epi16(x0, x1);
+            t1 = _mm_unpackhi_epi16(x0, x1);
+            if (channels == 2) {
+                _mm_storeu_si128((__m128i *)row,       t0);
+                _mm_storeu_si128((__m128i *)(row + 8), t1);
+            } else {
+                for (k = 0; k < 4; k++) {
+                    AV_WN32(row + c + k * channels,       _mm_cvtsi128_si32(t0));
+                    AV_WN32(row + c + (k + 4) * channels, _mm_cvtsi128_si32(t1));
+                    t0 = _mm_srli_si128(t0, 4);
+                    t1 = _mm_srli_si128(t1, 4);
+                }
+            }
+        }
+    }
+    for (; i < len; i++)
+        for (c = 0; c < channels; c++)
+            dst[i * channels + c] = (int)((unsigned)in[c][i] << shift);
+}
+
+static av_always_inline X86_TARGET("sse2")
+void decorrelate_indep_32(uint8_t **out, int32_t **in, int channels,
+                          int len, int shift)
+{
+    int32_t *dst = (int32_t *)out[0];
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    int i, c;
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        int32_t *row = dst + i * channels;
+        __m128i x0, x1, x2, x3, t0, t1, t2, t3;
+
+        for (c = 0; c + 4 <= channels; c += 4) {
+            x0 = load_shift(in[c]     + i, sh);
+            x1 = load_shift(in[c + 1] + i, sh);
+            x2 = load_shift(in[c + 2] + i, sh);
+            x3 = load_shift(in[c + 3] + i, sh);
+            t0 = _mm_unpacklo_epi32(x0, x1);
+            t1 = _mm_unpacklo_epi32(x2, x3);
+            t2 = _mm_unpackhi_epi32(x0, x1);
+            t3 = _mm_unpackhi_epi32(x2, x3);
+            _mm_storeu_si128((__m128i *)(row + c),                _mm_unpacklo_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(row + c + channels),     _mm_unpackhi_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(row + c + 2 * channels), _mm_unpacklo_epi64(t2, t3));
+            _mm_storeu_si128((__m128i *)(row + c + 3 * channels), _mm_unpackhi_epi64(t2, t3));
+        }
+        if (c < channels) {
+            x0 = load_shift(in[c]     + i, sh);
+            x1 = load_shift(in[c + 1] + i, sh);
+            t0 = _mm_unpacklo_epi32(x0, x1);
+            t1 = _mm_unpackhi_epi32(x0, x1);
+            if (channels == 2) {
+                _mm_storeu_si128((__m128i *)row,       t0);
+                _mm_storeu_si128((__m128i *)(row + 4), t1);
+            } else {
+                _mm_storel_epi64((__m128i *)(row + c),                t0);
+                _mm_storel_epi64((__m128i *)(row + c + channels),     _mm_srli_si128(t0, 8));
+                _mm_storel_epi64((__m128i *)(row + c + 2 * channels), t1);
+                _mm_storel_epi64((__m128i *)(row + c + 3 * channels), _mm_srli_si128(t1, 8));
+            }
+        }
+    }
+    for (; i < len; i++)
+        for (c = 0; c < channels; c++)
+            dst[i * channels + c] = (int)((unsigned)in[c][i] << shift);
+}
+
+X86_TARGET("sse2")
+void ff_flac_decorrelate_indep_16_sse2(uint8_t **out, int32_t **in,
+                                       int channels, int len, int shift)
+{
+    if (channels == 2)
+        decorrelate_indep_16(out, in, 2, len, shift);
+    else
+        decorrelate_indep_16(out, in, channels, len, shift);
+}
+
+X86_TARGET("sse2")
+void ff_flac_decorrelate_indep_32_sse2(uint8_t **out, int32_t **in,
+                                       int channels, int len, int shift)
+{
+    if (channels == 2)
+        decorrelate_indep_32(out, in, 2, len, shift);
+    else
+        decorrelate_indep_32(out, in, channels, len, shift);
+}
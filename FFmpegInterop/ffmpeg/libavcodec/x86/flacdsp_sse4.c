@@ -0,0 +1,142 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <smmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/cpu.h"
+#include "flacdsp.h"
+#include "flacdsp_lpc.h"
+
+X86_TARGET("sse4.1")
+void ff_flac_lpc_16_sse4(int32_t *decoded, const int coeffs[32], int order,
+                         int qlevel, int len)
+{
+    DECLARE_ALIGNED(16, int32_t, tab)[4][36];
+    int n   = (order + 3) >> 2;
+    int pad = 4 * n - order;
+    DECLARE_ALIGNED(16, int32_t, v)[4];
+    int c[7], x[3];
+    int i = 0, k;
+    __m128i part;
+
+    len -= order;
+
+    for (; i < FFMIN(pad, len); i++)
+        lpc16_c(decoded + i, coeffs, order, qlevel);
+    if (len - i < 4)
+        goto tail;
+
+    lpc_tabs(tab, c, coeffs, order, pad);
+    part = _mm_cvtsi32_si128(decoded[i + order - 4]);
+    x[0] = decoded[i + order - 3];
+    x[1] = decoded[i + order - 2];
+    x[2] = decoded[i + order - 1];
+
+    for (; i + 4 <= len; i += 4) {
+        const int32_t *win = decoded + i - pad;
+        int32_t *out = decoded + i + order;
+        __m128i a0, a1, a2, a3, w;
+
+        w  = part;
+        a0 = _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[0] + 4 * (n - 1))));
+        a1 = _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[1] + 4 * (n - 1))));
+        a2 = _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[2] + 4 * (n - 1))));
+        a3 = _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[3] + 4 * (n - 1))));
+        for (k = 0; k < n - 1; k++) {
+            w  = _mm_loadu_si128((const __m128i *)(win + 4 * k));
+            a0 = _mm_add_epi32(a0, _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[0] + 4 * k))));
+            a1 = _mm_add_epi32(a1, _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[1] + 4 * k))));
+            a2 = _mm_add_epi32(a2, _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[2] + 4 * k))));
+            a3 = _mm_add_epi32(a3, _mm_mullo_epi32(w, _mm_load_si128((const __m128i *)(tab[3] + 4 * k))));
+        }
+        _mm_store_si128((__m128i *)v, _mm_hadd_epi32(_mm_hadd_epi32(a0, a1),
+                                                     _mm_hadd_epi32(a2, a3)));
+        part = _mm_cvtsi32_si128(lpc16_block(out, v, c, x, qlevel));
+    }
+
+tail:
+    for (; i < len; i++)
+        lpc16_c(decoded + i, coeffs, order, qlevel);
+}
+
+/* The 64-bit products come from the even lanes, then the odd ones moved
+ * down, as _mm_mul_epi32() only reads the former. */
+#define MAC64(acc, w, wodd, tab)                                            \
+    _mm_add_epi64(acc, _mm_add_epi64(                                       \
+        _mm_mul_epi32(w,    _mm_load_si128((const __m128i *)(tab))),        \
+        _mm_mul_epi32(wodd, _mm_loadu_si128((const __m128i *)((tab) + 1)))))
+
+X86_TARGET("sse4.1")
+void ff_flac_lpc_32_sse4(int32_t *decoded, const int coeffs[32], int order,
+                         int qlevel, int len)
+{
+    DECLARE_ALIGNED(16, int32_t, tab)[4][36];
+    DECLARE_ALIGNED(16, int64_t, v)[4];
+    int n   = (order + 3) >> 2;
+    int pad = 4 * n - order;
+    int c[7], x[3];
+    int i = 0, k;
+    __m128i part;
+
+    len -= order;
+
+    for (; i < FFMIN(pad, len); i++)
+        lpc32_c(decoded + i, coeffs, order, qlevel);
+    if (len - i < 4)
+        goto tail;
+
+    lpc_tabs(tab, c, coeffs, order, pad);
+    part = _mm_cvtsi32_si128(decoded[i + order - 4]);
+    x[0] = decoded[i + order - 3];
+    x[1] = decoded[i + order - 2];
+    x[2] = decoded[i + order - 1];
+
+    for (; i + 4 <= len; i += 4) {
+        const int32_t *win = decoded + i - pad;
+        int32_t *out = decoded + i + order;
+        __m128i a0, a1, a2, a3, w, wodd;
+
+        w    = part;
+        wodd = _mm_srli_epi64(w, 32);
+        a0   = MAC64(_mm_setzero_si128(), w, wodd, tab[0] + 4 * (n - 1));
+        a1   = MAC64(_mm_setzero_si128(), w, wodd, tab[1] + 4 * (n - 1));
+        a2   = MAC64(_mm_setzero_si128(), w, wodd, tab[2] + 4 * (n - 1));
+        a3   = MAC64(_mm_setzero_si128(), w, wodd, tab[3] + 4 * (n - 1));
+        for (k = 0; k < n - 1; k++) {
+            w    = _mm_loadu_si128((const __m128i *)(win + 4 * k));
+            wodd = _mm_srli_epi64(w, 32);
+            a0   = MAC64(a0, w, wodd, tab[0] + 4 * k);
+            a1   = MAC64(a1, w, wodd, tab[1] + 4 * k);
+            a2   = MAC64(a2, w, wodd, tab[2] + 4 * k);
+            a3   = MAC64(a3, w, wodd, tab[3] + 4 * k);
+        }
+        _mm_store_si128((__m128i *)v,       _mm_add_epi64(_mm_unpacklo_epi64(a0, a1),
+                                                          _mm_unpackhi_epi64(a0, a1)));
+        _mm_store_si128((__m128i *)(v + 2), _mm_add_epi64(_mm_unpacklo_epi64(a2, a3),
+                                                          _mm_unpackhi_epi64(a2, a3)));
+        part = _mm_cvtsi32_si128(lpc32_block(out, v, c, x, qlevel));
+    }
+
+tail:
+    for (; i < len; i++)
+        lpc32_c(decoded + i, coeffs, order, qlevel);
+}
@@ -0,0 +1,136 @@
+/*
+ * SSE2 versions of the H.263 loop filters, bit-exact with the C ones
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/h263dsp.h"
+#include "h263dsp.h"
+
+/* x / (1 << shift), rounded toward 0 like the C division */
+static av_always_inline X86_TARGET("sse2")
+__m128i div_pow2(__m128i x, int shift)
+{
+    __m128i round = _mm_srli_epi16(_mm_srai_epi16(x, 15), 16 - shift);
+
+    return _mm_srai_epi16(_mm_add_epi16(x, round), shift);
+}
+
+/* p0 to p3 are the 8 pixels across the edge on 16 bits, which is between
+ * p1 and p2 */
+static av_always_inline X86_TARGET("sse2")
+void loop_filter(__m128i *p0, __m128i *p1, __m128i *p2, __m128i *p3,
+                 int qscale)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i strength2 = _mm_set1_epi16(2 * ff_h263_loop_filter_strength[qscale]);
+    __m128i d03 = _mm_sub_epi16(*p0, *p3);
+    __m128i d, s, ad, d1, ad1, d2;
+
+    d  = _mm_add_epi16(d03, _mm_slli_epi16(_mm_sub_epi16(*p2, *p1), 2));
+    d  = div_pow2(d, 3);
+
+    /* d up to strength, folding back to 0 at 2 * strength */
+    s  = _mm_srai_epi16(d, 15);
+    ad = _mm_sub_epi16(_mm_xor_si128(d, s), s);
+    ad1 = _mm_max_epi16(_mm_min_epi16(ad, _mm_sub_epi16(strength2, ad)), zero);
+    d1 = _mm_sub_epi16(_mm_xor_si128(ad1, s), s);
+
+    *p1 = _mm_add_epi16(*p1, d1);
+    *p2 = _mm_sub_epi16(*p2, d1);
+
+    ad1 = _mm_srli_epi16(ad1, 1);
+    d2  = div_pow2(d03, 2);
+    d2  = _mm_max_epi16(_mm_min_epi16(d2, ad1), _mm_sub_epi16(zero, ad1));
+
+    *p0 = _mm_sub_epi16(*p0, d2);
+    *p3 = _mm_add_epi16(*p3, d2);
+}
+
+X86_TARGET("sse2")
+void ff_h263_v_loop_filter_sse2(uint8_t *src, int stride, int qscale)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src - 2 * stride)), zero);
+    __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src - stride)), zero);
+    __m128i p2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), zero);
+    __m128i p3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + stride)), zero);
+    __m128i p01, p23;
+
+    loop_filter(&p0, &p1, &p2, &p3, qscale);
+
+    p01 = _mm_packus_epi16(p0, p1);
+    p23 = _mm_packus_epi16(p2, p3);
+    _mm_storel_epi64((__m128i *)(src - 2 * stride), p01);
+    _mm_storel_epi64((__m128i *)(src - stride), _mm_unpackhi_epi64(p01, p01));
+    _mm_storel_epi64((__m128i *)src, p23);
+    _mm_storel_epi64((__m128i *)(src + stride), _mm_unpackhi_epi64(p23, p23));
+}
+
+/* The 4 pixels around the edge on 4 rows, one row per 32 bits */
+static av_always_inline X86_TARGET("sse2")
+__m128i load_rows(const uint8_t *src, int stride)
+{
+    __m128i r0 = _mm_cvtsi32_si128(AV_RN32(src - 2));
+    __m128i r1 = _mm_cvtsi32_si128(AV_RN32(src + stride - 2));
+    __m128i r2 = _mm_cvtsi32_si128(AV_RN32(src + 2 * stride - 2));
+    __m128i r3 = _mm_cvtsi32_si128(AV_RN32(src + 3 * stride - 2));
+
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(r0, r1),
+                              _mm_unpacklo_epi8(r2, r3));
+}
+
+static av_always_inline X86_TARGET("sse2")
+void store_rows(uint8_t *dst, int stride, __m128i v)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        AV_WN32(dst + i * stride - 2, _mm_cvtsi128_si32(v));
+        v = _mm_srli_si128(v, 4);
+    }
+}
+
+X86_TARGET("sse2")
+void ff_h263_h_loop_filter_sse2(uint8_t *src, int stride, int qscale)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = load_rows(src, stride);
+    __m128i b = load_rows(src + 4 * stride, stride);
+    __m128i t0 = _mm_unpacklo_epi32(a, b);
+    __m128i t1 = _mm_unpackhi_epi32(a, b);
+    __m128i p0 = _mm_unpacklo_epi8(t0, zero);
+    __m128i p1 = _mm_unpackhi_epi8(t0, zero);
+    __m128i p2 = _mm_unpacklo_epi8(t1, zero);
+    __m128i p3 = _mm_unpackhi_epi8(t1, zero);
+
+    loop_filter(&p0, &p1, &p2, &p3, qscale);
+
+    /* Back to 4 bytes per row */
+    t0 = _mm_packus_epi16(p0, p1);
+    t1 = _mm_packus_epi16(p2, p3);
+    t0 = _mm_unpacklo_epi8(t0, _mm_unpackhi_epi64(t0, t0));
+    t1 = _mm_unpacklo_epi8(t1, _mm_unpackhi_epi64(t1, t1));
+    store_rows(src, stride, _mm_unpacklo_epi16(t0, t1));
+    store_rows(src + 4 * stride, stride, _mm_unpackhi_epi16(t0, t1));
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_X86_HPELDSP_H
+#define AVCODEC_X86_HPELDSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HPEL_FUNCS(op, size)                                                  \
+void ff_ ## op ## _pixels ## size ## _sse2(uint8_t *block,                    \
+                                           const uint8_t *pixels,             \
+                                           ptrdiff_t line_size, int h);       \
+void ff_ ## op ## _pixels ## size ## _x2_sse2(uint8_t *block,                 \
+                                              const uint8_t *pixels,          \
+                                              ptrdiff_t line_size, int h);    \
+void ff_ ## op ## _pixels ## size ## _y2_sse2(uint8_t *block,                 \
+                                              const uint8_t *pixels,          \
+                                              ptrdiff_t line_size, int h);    \
+void ff_ ## op ## _pixels ## size ## _xy2_sse2(uint8_t *block,                \
+                                               const uint8_t *pixels,         \
+                                               ptrdiff_t line_size, int h);
+
+HPEL_FUNCS(put,         16)
+HPEL_FUNCS(put,          8)
+HPEL_FUNCS(avg,         16)
+HPEL_FUNCS(avg,          8)
+HPEL_FUNCS(put_no_rnd,  16)
+HPEL_FUNCS(put_no_rnd,   8)
+HPEL_FUNCS(avg_no_rnd,  16)
+
+#undef HPEL_FUNCS
+
+#endif /* AVCODEC_X86_HPELDSP_H */
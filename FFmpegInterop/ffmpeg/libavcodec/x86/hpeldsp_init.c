@@ -0,0 +1,50 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/hpeldsp.h"
+#include "hpeldsp.h"
+
+#define SET_HPEL_FUNCS(pfx, idx, size)                                              \
+    do {                                                                            \
+        c->pfx ## _pixels_tab idx [0] = ff_ ## pfx ## _pixels ## size ## _sse2;     \
+        c->pfx ## _pixels_tab idx [1] = ff_ ## pfx ## _pixels ## size ## _x2_sse2;  \
+        c->pfx ## _pixels_tab idx [2] = ff_ ## pfx ## _pixels ## size ## _y2_sse2;  \
+        c->pfx ## _pixels_tab idx [3] = ff_ ## pfx ## _pixels ## size ## _xy2_sse2; \
+    } while (0)
+
+av_cold void ff_hpeldsp_init_x86(HpelDSPContext *c, int flags)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    /* All of them are bit-exact, AV_CODEC_FLAG_BITEXACT changes nothing.
+     * The 4 and 2 pixels wide functions are left to C. */
+    if (X86_SSE2(cpu_flags)) {
+        SET_HPEL_FUNCS(put,        [0], 16);
+        SET_HPEL_FUNCS(put,        [1],  8);
+        SET_HPEL_FUNCS(avg,        [0], 16);
+        SET_HPEL_FUNCS(avg,        [1],  8);
+        SET_HPEL_FUNCS(put_no_rnd, [0], 16);
+        SET_HPEL_FUNCS(put_no_rnd, [1],  8);
+        SET_HPEL_FUNCS(avg_no_rnd,    , 16);
+    }
+}
@@ -0,0 +1,167 @@
+/*
+ * SSE2 versions of the 16 and 8 pixels wide HpelDSPContext functions,
+ * bit-exact with the C ones
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "hpeldsp.h"
+
+enum { PUT, AVG };
+
+static av_always_inline X86_TARGET("sse2")
+__m128i load(const uint8_t *src, int w)
+{
+    return w == 16 ? _mm_loadu_si128((const __m128i *)src)
+                   : _mm_loadl_epi64((const __m128i *)src);
+}
+
+/* The avg functions round the result up into block, whatever the rounding
+ * of the interpolation */
+static av_always_inline X86_TARGET("sse2")
+void store(uint8_t *dst, __m128i v, int w, int op)
+{
+    if (op == AVG)
+        v = _mm_avg_epu8(v, load(dst, w));
+    if (w == 16)
+        _mm_storeu_si128((__m128i *)dst, v);
+    else
+        _mm_storel_epi64((__m128i *)dst, v);
+}
+
+/* (a + b) >> 1 */
+static av_always_inline X86_TARGET("sse2")
+__m128i avg_no_rnd(__m128i a, __m128i b)
+{
+    __m128i odd = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1));
+
+    return _mm_sub_epi8(_mm_avg_epu8(a, b), odd);
+}
+
+static av_always_inline X86_TARGET("sse2")
+void copy_pixels(uint8_t *block, const uint8_t *pixels, ptrdiff_t line_size,
+                 int h, int w, int op)
+{
+    int i;
+
+    for (i = 0; i < h; i++) {
+        store(block, load(pixels, w), w, op);
+        pixels += line_size;
+        block  += line_size;
+    }
+}
+
+/* delta is 1 for x2, line_size for y2 */
+static av_always_inline X86_TARGET("sse2")
+void pixels_l2(uint8_t *block, const uint8_t *pixels, ptrdiff_t line_size,
+               ptrdiff_t delta, int h, int w, int op, int rnd)
+{
+    int i;
+
+    for (i = 0; i < h; i++) {
+        __m128i a = load(pixels, w);
+        __m128i b = load(pixels + delta, w);
+
+        store(block, rnd ? _mm_avg_epu8(a, b) : avg_no_rnd(a, b), w, op);
+        pixels += line_size;
+        block  += line_size;
+    }
+}
+
+/* Sums of horizontal pairs on 16 bits, for the 8 pixels at src */
+static av_always_inline X86_TARGET("sse2")
+void pair_sums(const uint8_t *src, __m128i *lo, __m128i *hi, int w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = load(src, w);
+    __m128i b = load(src + 1, w);
+
+    *lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    *hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+}
+
+/* (a + b + c + d + 2) >> 2, or + 1 without rounding */
+static av_always_inline X86_TARGET("sse2")
+void pixels_xy2(uint8_t *block, const uint8_t *pixels, ptrdiff_t line_size,
+                int h, int w, int op, int rnd)
+{
+    const __m128i bias = _mm_set1_epi16(rnd ? 2 : 1);
+    __m128i lo0, hi0, lo1, hi1;
+    int i;
+
+    pair_sums(pixels, &lo0, &hi0, w);
+    lo0 = _mm_add_epi16(lo0, bias);
+    hi0 = _mm_add_epi16(hi0, bias);
+    for (i = 0; i < h; i++) {
+        __m128i lo, hi;
+
+        pixels += line_size;
+        pair_sums(pixels, &lo1, &hi1, w);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo0, lo1), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi0, hi1), 2);
+        store(block, _mm_packus_epi16(lo, hi), w, op);
+        lo0 = _mm_add_epi16(lo1, bias);
+        hi0 = _mm_add_epi16(hi1, bias);
+        block += line_size;
+    }
+}
+
+#define HPEL_FUNCS(name, size, op, rnd)                                       \
+X86_TARGET("sse2")                                                            \
+void ff_ ## name ## _pixels ## size ## _sse2(uint8_t *block,                  \
+                                             const uint8_t *p,                \
+                                             ptrdiff_t line_size, int h)      \
+{                                                                             \
+    copy_pixels(block, p, line_size, h, size, op);                            \
+}                                                                             \
+                                                                              \
+X86_TARGET("sse2")                                                            \
+void ff_ ## name ## _pixels ## size ## _x2_sse2(uint8_t *block,               \
+                                                const uint8_t *p,             \
+                                                ptrdiff_t line_size, int h)   \
+{                                                                             \
+    pixels_l2(block, p, line_size, 1, h, size, op, rnd);                      \
+}                                                                             \
+                                                                              \
+X86_TARGET("sse2")                                                            \
+void ff_ ## name ## _pixels ## size ## _y2_sse2(uint8_t *block,               \
+                                                const uint8_t *p,             \
+                                                ptrdiff_t line_size, int h)   \
+{                                                                             \
+    pixels_l2(block, p, line_size, line_size, h, size, op, rnd);              \
+}                                                                             \
+                                                                              \
+X86_TARGET("sse2")                                                            \
+void ff_ ## name ## _pixels ## size ## _xy2_sse2(uint8_t *block,              \
+                                                 const uint8_t *p,            \
+                                                 ptrdiff_t line_size, int h)  \
+{                                                                             \
+    pixels_xy2(block, p, line_size, h, size, op, rnd);                        \
+}
+
+HPEL_FUNCS(put,        16, PUT, 1)
+HPEL_FUNCS(put,         8, PUT, 1)
+HPEL_FUNCS(avg,        16, AVG, 1)
+HPEL_FUNCS(avg,         8, AVG, 1)
+HPEL_FUNCS(put_no_rnd, 16, PUT, 0)
+HPEL_FUNCS(put_no_rnd,  8, PUT, 0)
+HPEL_FUNCS(avg_no_rnd, 16, AVG, 0)
@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/idctdsp.h"
+#include "idctdsp.h"
+#include "simple_idct.h"
+
+av_cold int ff_init_scantable_permutation_x86(uint8_t *idct_permutation,
+                                              enum idct_permutation_type perm_type)
+{
+    /* The IDCTs here take the coefficients in the order of the C ones */
+    return 0;
+}
+
+av_cold void ff_idctdsp_init_x86(IDCTDSPContext *c, AVCodecContext *avctx,
+                                 unsigned high_bit_depth)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (X86_SSE2(cpu_flags)) {
+        c->put_pixels_clamped        = ff_put_pixels_clamped_sse2;
+        c->put_signed_pixels_clamped = ff_put_signed_pixels_clamped_sse2;
+        c->add_pixels_clamped        = ff_add_pixels_clamped_sse2;
+
+        /* Bit-exact with the simple IDCT, so it stands in for it wherever
+         * the C one is picked */
+        if (!high_bit_depth && avctx->lowres == 0 &&
+            (avctx->idct_algo == FF_IDCT_AUTO ||
+             avctx->idct_algo == FF_IDCT_SIMPLEAUTO ||
+             avctx->idct_algo == FF_IDCT_SIMPLE ||
+             avctx->idct_algo == FF_IDCT_SIMPLEMMX)) {
+            c->idct_put  = ff_simple_idct_put_sse2;
+            c->idct_add  = ff_simple_idct_add_sse2;
+            c->idct      = ff_simple_idct_sse2;
+            c->perm_type = FF_IDCT_PERM_NONE;
+        }
+    }
+}
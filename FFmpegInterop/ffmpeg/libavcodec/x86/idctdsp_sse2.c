@@ -0,0 +1,87 @@
+/*
+ * SSE2 versions of the pixel functions of IDCTDSPContext
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "idctdsp.h"
+
+/* Two rows of the block at a time */
+static av_always_inline X86_TARGET("sse2")
+void store_rows(uint8_t *pixels, ptrdiff_t line_size, __m128i v)
+{
+    _mm_storel_epi64((__m128i *)pixels, v);
+    _mm_storel_epi64((__m128i *)(pixels + line_size), _mm_unpackhi_epi64(v, v));
+}
+
+X86_TARGET("sse2")
+void ff_put_pixels_clamped_sse2(const int16_t *block, uint8_t *pixels,
+                                ptrdiff_t line_size)
+{
+    int i;
+
+    for (i = 0; i < 8; i += 2) {
+        __m128i a = _mm_load_si128((const __m128i *)(block + 8 * i));
+        __m128i b = _mm_load_si128((const __m128i *)(block + 8 * i + 8));
+
+        store_rows(pixels, line_size, _mm_packus_epi16(a, b));
+        pixels += 2 * line_size;
+    }
+}
+
+X86_TARGET("sse2")
+void ff_put_signed_pixels_clamped_sse2(const int16_t *block,
+                                       uint8_t *pixels,
+                                       ptrdiff_t line_size)
+{
+    const __m128i bias = _mm_set1_epi8(-128);
+    int i;
+
+    for (i = 0; i < 8; i += 2) {
+        __m128i a = _mm_load_si128((const __m128i *)(block + 8 * i));
+        __m128i b = _mm_load_si128((const __m128i *)(block + 8 * i + 8));
+
+        store_rows(pixels, line_size,
+                   _mm_xor_si128(_mm_packs_epi16(a, b), bias));
+        pixels += 2 * line_size;
+    }
+}
+
+X86_TARGET("sse2")
+void ff_add_pixels_clamped_sse2(const int16_t *block, uint8_t *pixels,
+                                ptrdiff_t line_size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < 8; i += 2) {
+        __m128i a = _mm_load_si128((const __m128i *)(block + 8 * i));
+        __m128i b = _mm_load_si128((const __m128i *)(block + 8 * i + 8));
+        __m128i p = _mm_loadl_epi64((const __m128i *)pixels);
+        __m128i q = _mm_loadl_epi64((const __m128i *)(pixels + line_size));
+
+        a = _mm_adds_epi16(a, _mm_unpacklo_epi8(p, zero));
+        b = _mm_adds_epi16(b, _mm_unpacklo_epi8(q, zero));
+        store_rows(pixels, line_size, _mm_packus_epi16(a, b));
+        pixels += 2 * line_size;
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_X86_MDCT15_H
+#define AVCODEC_X86_MDCT15_H
+
+#include <stddef.h>
+
+#include "libavcodec/fft.h"
+
+/* Where ff_mdct15_init_x86() puts the twiddles of ff_fft15_sse(), after the
+ * 21 of the C version */
+#define FFT15_SSE_TWIDDLES 22
+
+void ff_fft15_sse(FFTComplex *out, FFTComplex *in, FFTComplex *exptab,
+                  ptrdiff_t stride);
+
+void ff_mdct15_postreindex_sse(FFTComplex *out, FFTComplex *in,
+                               FFTComplex *exp, int *lut, ptrdiff_t len8);
+
+#endif /* AVCODEC_X86_MDCT15_H */
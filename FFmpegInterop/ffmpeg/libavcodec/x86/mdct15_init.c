@@ -0,0 +1,55 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/mdct15.h"
+#include "mdct15.h"
+
+/* For each k < 5, the twiddles of the outputs k, k + 5 and k + 10 as
+ * ff_fft15_sse() loads them: those of the second fft5 for k and k + 5,
+ * of the third one for k and k + 5, then both for k + 10. */
+static av_cold void perm_twiddles(MDCT15Context *s)
+{
+    FFTComplex *tab = s->exptab + FFT15_SSE_TWIDDLES;
+    int k;
+
+    for (k = 0; k < 5; k++) {
+        tab[6 * k + 0] = s->exptab[k];
+        tab[6 * k + 1] = s->exptab[k + 5];
+        tab[6 * k + 2] = s->exptab[2 * k];
+        tab[6 * k + 3] = s->exptab[2 * k + 10];
+        tab[6 * k + 4] = s->exptab[k + 10];
+        tab[6 * k + 5] = s->exptab[2 * k + 5];
+    }
+}
+
+av_cold void ff_mdct15_init_x86(MDCT15Context *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    /* Both are bit-exact with the C versions. */
+    if (X86_SSE(cpu_flags)) {
+        perm_twiddles(s);
+        s->fft15       = ff_fft15_sse;
+        s->postreindex = ff_mdct15_postreindex_sse;
+    }
+}
@@ -0,0 +1,189 @@
+/*
+ * SSE versions of the MDCT15Context functions, bit-exact with the C ones
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+#include <xmmintrin.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "mdct15.h"
+
+#define SWAP_RE_IM(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))
+#define REVERSE(v)    _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+#define SPLAT(v, i)   _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+
+#define SIGN_RE _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f)
+
+/* The real parts of a with the imaginary ones of b */
+static av_always_inline X86_TARGET("sse")
+__m128 re_im(__m128 a, __m128 b)
+{
+    __m128 t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 2, 0));
+    return _mm_shuffle_ps(t, t, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+/* CMUL() of the complex in a by those in b: { ar, ai } * b is
+ * { ar * br - ai * bi, ar * bi + ai * br } */
+static av_always_inline X86_TARGET("sse")
+__m128 cmul(__m128 ar, __m128 ai, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(ar, b),
+                      _mm_xor_ps(_mm_mul_ps(ai, SWAP_RE_IM(b)), SIGN_RE));
+}
+
+/* fft5() of mdct15.c on x[0], x[3], x[6], x[9] and x[12], for the transforms
+ * in each half of the registers */
+static av_always_inline X86_TARGET("sse")
+void fft5(__m128 out[5], const __m128 x[5], const FFTComplex exptab[2])
+{
+    __m128 e0r = _mm_set1_ps(exptab[0].re), e1r = _mm_set1_ps(exptab[1].re);
+    __m128 e0i = _mm_set1_ps(exptab[0].im), e1i = _mm_set1_ps(exptab[1].im);
+    __m128 t0  = _mm_add_ps(x[1], x[4]);
+    __m128 t1  = SWAP_RE_IM(_mm_sub_ps(x[1], x[4]));
+    __m128 t2  = _mm_add_ps(x[2], x[3]);
+    __m128 t3  = SWAP_RE_IM(_mm_sub_ps(x[2], x[3]));
+    __m128 t4, t5, z0, z1, z2, z3;
+
+    out[0] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(x[0], x[1]), x[2]), x[3]), x[4]);
+
+    t4 = _mm_sub_ps(_mm_mul_ps(e0r, t2), _mm_mul_ps(e1r, t0));
+    t0 = _mm_sub_ps(_mm_mul_ps(e0r, t0), _mm_mul_ps(e1r, t2));
+    t5 = _mm_sub_ps(_mm_mul_ps(e0i, t3), _mm_mul_ps(e1i, t1));
+    t1 = _mm_add_ps(_mm_mul_ps(e0i, t1), _mm_mul_ps(e1i, t3));
+
+    z0 = _mm_sub_ps(t0, t1);
+    z1 = _mm_add_ps(t4, t5);
+    z2 = _mm_sub_ps(t4, t5);
+    z3 = _mm_add_ps(t0, t1);
+
+    out[1] = _mm_add_ps(x[0], re_im(z3, z0));
+    out[2] = _mm_add_ps(x[0], re_im(z2, z1));
+    out[3] = _mm_add_ps(x[0], re_im(z1, z2));
+    out[4] = _mm_add_ps(x[0], re_im(z0, z3));
+}
+
+/* The first two fft5 share registers, the third one has half of others. */
+X86_TARGET("sse")
+void ff_fft15_sse(FFTComplex *out, FFTComplex *in, FFTComplex *exptab,
+                  ptrdiff_t stride)
+{
+    const __m128 *tab = (const __m128 *)(exptab + FFT15_SSE_TWIDDLES);
+    __m128 x[5], y[5], a[5], b[5];
+    int k;
+
+    for (k = 0; k < 5; k++) {
+        x[k] = _mm_loadu_ps(&in[3 * k].re);
+        y[k] = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&in[3 * k + 2]);
+    }
+    fft5(a, x, exptab + 19);
+    fft5(b, y, exptab + 19);
+
+    for (k = 0; k < 5; k++) {
+        /* tmp1[k] twice, tmp2[k] twice, tmp3[k] twice, tmp2[k] and tmp3[k] */
+        __m128 t1  = _mm_movelh_ps(a[k], a[k]);
+        __m128 t2  = _mm_movehl_ps(a[k], a[k]);
+        __m128 t3  = _mm_movelh_ps(b[k], b[k]);
+        __m128 t23 = _mm_shuffle_ps(a[k], b[k], _MM_SHUFFLE(1, 0, 3, 2));
+        __m128 lo, hi;
+
+        /* out[k], out[k + 5] */
+        lo = _mm_add_ps(_mm_add_ps(t1, cmul(SPLAT(t2, 0), SPLAT(t2, 1), tab[3 * k])),
+                        cmul(SPLAT(t3, 0), SPLAT(t3, 1), tab[3 * k + 1]));
+        /* out[k + 10], as tmp1[k] + t[0] first and + t[1] then */
+        hi = cmul(_mm_shuffle_ps(t23, t23, _MM_SHUFFLE(2, 2, 0, 0)),
+                  _mm_shuffle_ps(t23, t23, _MM_SHUFFLE(3, 3, 1, 1)), tab[3 * k + 2]);
+        hi = _mm_add_ps(_mm_add_ps(t1, hi), _mm_movehl_ps(hi, hi));
+
+        _mm_storel_pi((__m64 *)&out[stride * k],        lo);
+        _mm_storeh_pi((__m64 *)&out[stride * (k + 5)],  lo);
+        _mm_storel_pi((__m64 *)&out[stride * (k + 10)], hi);
+    }
+}
+
+/* in[lut[i...i+3]] into their real and imaginary parts */
+static av_always_inline X86_TARGET("sse")
+void gather4(const FFTComplex *in, const int *lut, __m128 *re, __m128 *im)
+{
+    __m128 lo = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&in[lut[0]]);
+    __m128 hi = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&in[lut[2]]);
+
+    lo  = _mm_loadh_pi(lo, (const __m64 *)&in[lut[1]]);
+    hi  = _mm_loadh_pi(hi, (const __m64 *)&in[lut[3]]);
+    *re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+static av_always_inline X86_TARGET("sse")
+void load_complex4(const FFTComplex *z, __m128 *re, __m128 *im)
+{
+    __m128 lo = _mm_loadu_ps(&z[0].re);
+    __m128 hi = _mm_loadu_ps(&z[2].re);
+
+    *re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+static av_always_inline X86_TARGET("sse")
+void store_complex4(FFTComplex *z, __m128 re, __m128 im)
+{
+    _mm_storeu_ps(&z[0].re, _mm_unpacklo_ps(re, im));
+    _mm_storeu_ps(&z[2].re, _mm_unpackhi_ps(re, im));
+}
+
+/* Output i gets, with s = lut[i] and j = 2 * len8 - 1 - i,
+ * re = in[s].im * exp[i].im - in[s].re * exp[i].re and
+ * im = in[s'].im * exp[j].re + in[s'].re * exp[j].im, s' = lut[j],
+ * as the pairs of postrotate_c() write them. The len8 % 4 outputs at each
+ * end are done as in C. */
+X86_TARGET("sse")
+void ff_mdct15_postreindex_sse(FFTComplex *out, FFTComplex *in,
+                               FFTComplex *exp, int *lut, ptrdiff_t len8)
+{
+    ptrdiff_t i;
+
+    for (i = 0; i + 4 <= len8; i += 4) {
+        ptrdiff_t lo = len8 - 4 - i, hi = len8 + i;
+        __m128 rl, il, rh, ih, erl, eil, erh, eih;
+        __m128 al, bl, ah, bh;
+
+        gather4(in, lut + lo, &rl, &il);
+        gather4(in, lut + hi, &rh, &ih);
+        load_complex4(exp + lo, &erl, &eil);
+        load_complex4(exp + hi, &erh, &eih);
+
+        al = _mm_sub_ps(_mm_mul_ps(il, eil), _mm_mul_ps(rl, erl));
+        bl = _mm_add_ps(_mm_mul_ps(il, erl), _mm_mul_ps(rl, eil));
+        ah = _mm_sub_ps(_mm_mul_ps(ih, eih), _mm_mul_ps(rh, erh));
+        bh = _mm_add_ps(_mm_mul_ps(ih, erh), _mm_mul_ps(rh, eih));
+
+        store_complex4(out + lo, al, REVERSE(bh));
+        store_complex4(out + hi, ah, REVERSE(bl));
+    }
+
+    for (; i < len8; i++) {
+        const ptrdiff_t i0 = len8 + i, i1 = len8 - i - 1;
+        const int s0 = lut[i0], s1 = lut[i1];
+
+        out[i1].re = in[s1].im * exp[i1].im - in[s1].re * exp[i1].re;
+        out[i0].im = in[s1].im * exp[i1].re + in[s1].re * exp[i1].im;
+        out[i0].re = in[s0].im * exp[i0].im - in[s0].re * exp[i0].re;
+        out[i1].im = in[s0].im * exp[i0].re + in[s0].re * exp[i0].im;
+    }
+}
@@ -0,0 +1,214 @@
+/*
+ * SSE2 version of the 8-bit simple IDCT, bit-exact with the C one
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "simple_idct.h"
+
+#define W1  22725
+#define W2  21407
+#define W3  19266
+#define W4  16383
+#define W5  12873
+#define W6  8867
+#define W7  4520
+
+#define ROW_SHIFT 11
+#define COL_SHIFT 20
+#define DC_SHIFT 3
+
+/* c0 * v[2 * i] + c1 * v[2 * i + 1]. No weight is -32768 and the sum of
+ * two products fits in 32 bits, so the sums wrap around like those of the
+ * C version. */
+static av_always_inline X86_TARGET("sse2")
+__m128i madd(__m128i v, int c0, int c1)
+{
+    return _mm_madd_epi16(v, _mm_setr_epi16(c0, c1, c0, c1, c0, c1, c0, c1));
+}
+
+/* One 1-D transform of 4 lanes, from the coefficients interleaved in
+ * pairs. out[] is a + b and a - b, not shifted yet. */
+static av_always_inline X86_TARGET("sse2")
+void idct_4(__m128i x02, __m128i x46, __m128i x13, __m128i x57,
+            __m128i bias, __m128i *out)
+{
+    __m128i a0 = _mm_add_epi32(_mm_add_epi32(madd(x02, W4,  W2), madd(x46,  W4,  W6)), bias);
+    __m128i a1 = _mm_add_epi32(_mm_add_epi32(madd(x02, W4,  W6), madd(x46, -W4, -W2)), bias);
+    __m128i a2 = _mm_add_epi32(_mm_add_epi32(madd(x02, W4, -W6), madd(x46, -W4,  W2)), bias);
+    __m128i a3 = _mm_add_epi32(_mm_add_epi32(madd(x02, W4, -W2), madd(x46,  W4, -W6)), bias);
+    __m128i b0 = _mm_add_epi32(madd(x13, W1,  W3), madd(x57,  W5,  W7));
+    __m128i b1 = _mm_add_epi32(madd(x13, W3, -W7), madd(x57, -W1, -W5));
+    __m128i b2 = _mm_add_epi32(madd(x13, W5, -W1), madd(x57,  W7,  W3));
+    __m128i b3 = _mm_add_epi32(madd(x13, W7, -W5), madd(x57,  W3, -W1));
+
+    out[0] = _mm_add_epi32(a0, b0);
+    out[1] = _mm_add_epi32(a1, b1);
+    out[2] = _mm_add_epi32(a2, b2);
+    out[3] = _mm_add_epi32(a3, b3);
+    out[4] = _mm_sub_epi32(a3, b3);
+    out[5] = _mm_sub_epi32(a2, b2);
+    out[6] = _mm_sub_epi32(a1, b1);
+    out[7] = _mm_sub_epi32(a0, b0);
+}
+
+/* 1-D transform of the 8 lanes of x[], lo[] and hi[] get lanes 0-3 and
+ * 4-7 of the results */
+static av_always_inline X86_TARGET("sse2")
+void idct_8(const __m128i *x, __m128i bias, __m128i *lo, __m128i *hi)
+{
+    idct_4(_mm_unpacklo_epi16(x[0], x[2]), _mm_unpacklo_epi16(x[4], x[6]),
+           _mm_unpacklo_epi16(x[1], x[3]), _mm_unpacklo_epi16(x[5], x[7]),
+           bias, lo);
+    idct_4(_mm_unpackhi_epi16(x[0], x[2]), _mm_unpackhi_epi16(x[4], x[6]),
+           _mm_unpackhi_epi16(x[1], x[3]), _mm_unpackhi_epi16(x[5], x[7]),
+           bias, hi);
+}
+
+/* Like the int16_t stores of the C version, without saturation */
+static av_always_inline X86_TARGET("sse2")
+__m128i narrow(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+static av_always_inline X86_TARGET("sse2")
+void transpose8x8(__m128i *r)
+{
+    __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+    __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+    __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+    __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+    __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+    __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+    __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+    __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+
+    r[0] = _mm_unpacklo_epi64(u0, u4);
+    r[1] = _mm_unpackhi_epi64(u0, u4);
+    r[2] = _mm_unpacklo_epi64(u1, u5);
+    r[3] = _mm_unpackhi_epi64(u1, u5);
+    r[4] = _mm_unpacklo_epi64(u2, u6);
+    r[5] = _mm_unpackhi_epi64(u2, u6);
+    r[6] = _mm_unpacklo_epi64(u3, u7);
+    r[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+/* Both passes, the rows of the result in r[]. Unlike the C version, block
+ * is left as it was. */
+static av_always_inline X86_TARGET("sse2")
+void idct(__m128i *r, const int16_t *block)
+{
+    __m128i lo[8], hi[8];
+    __m128i nz, dc;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        r[i] = _mm_load_si128((const __m128i *)(block + 8 * i));
+
+    /* Lane i of r[k] is coefficient k of row i */
+    transpose8x8(r);
+
+    /* The C version shortcuts the rows with only a DC, with a result that
+     * is not always that of the transform */
+    nz = _mm_or_si128(_mm_or_si128(r[1], r[2]), _mm_or_si128(r[3], r[4]));
+    nz = _mm_or_si128(nz, _mm_or_si128(_mm_or_si128(r[5], r[6]), r[7]));
+    nz = _mm_cmpeq_epi16(nz, _mm_setzero_si128());
+    dc = _mm_and_si128(nz, _mm_slli_epi16(r[0], DC_SHIFT));
+
+    idct_8(r, _mm_set1_epi32(1 << (ROW_SHIFT - 1)), lo, hi);
+    for (i = 0; i < 8; i++) {
+        r[i] = narrow(_mm_srai_epi32(lo[i], ROW_SHIFT),
+                      _mm_srai_epi32(hi[i], ROW_SHIFT));
+        r[i] = _mm_or_si128(_mm_andnot_si128(nz, r[i]), dc);
+    }
+
+    /* Back to rows in r[], each column in a lane */
+    transpose8x8(r);
+
+    /* W4 * (col[0] + ((1 << (COL_SHIFT - 1)) / W4)) of the C version */
+    idct_8(r, _mm_set1_epi32(W4 * ((1 << (COL_SHIFT - 1)) / W4)), lo, hi);
+    for (i = 0; i < 8; i++)
+        r[i] = _mm_packs_epi32(_mm_srai_epi32(lo[i], COL_SHIFT),
+                               _mm_srai_epi32(hi[i], COL_SHIFT));
+}
+
+X86_TARGET("sse2")
+void ff_simple_idct_sse2(int16_t *block)
+{
+    __m128i r[8];
+    int i;
+
+    idct(r, block);
+    for (i = 0; i < 8; i++)
+        _mm_store_si128((__m128i *)(block + 8 * i), r[i]);
+}
+
+X86_TARGET("sse2")
+void ff_simple_idct_put_sse2(uint8_t *dest, ptrdiff_t line_size,
+                             int16_t *block)
+{
+    __m128i r[8];
+    int i;
+
+    idct(r, block);
+    for (i = 0; i < 8; i += 2) {
+        __m128i v = _mm_packus_epi16(r[i], r[i + 1]);
+
+        _mm_storel_epi64((__m128i *)dest, v);
+        _mm_storel_epi64((__m128i *)(dest + line_size), _mm_unpackhi_epi64(v, v));
+        dest += 2 * line_size;
+    }
+}
+
+X86_TARGET("sse2")
+void ff_simple_idct_add_sse2(uint8_t *dest, ptrdiff_t line_size,
+                             int16_t *block)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r[8];
+    int i;
+
+    idct(r, block);
+    for (i = 0; i < 8; i += 2) {
+        __m128i p = _mm_loadl_epi64((const __m128i *)dest);
+        __m128i q = _mm_loadl_epi64((const __m128i *)(dest + line_size));
+        __m128i v;
+
+        p = _mm_add_epi16(r[i],     _mm_unpacklo_epi8(p, zero));
+        q = _mm_add_epi16(r[i + 1], _mm_unpacklo_epi8(q, zero));
+        v = _mm_packus_epi16(p, q);
+        _mm_storel_epi64((__m128i *)dest, v);
+        _mm_storel_epi64((__m128i *)(dest + line_size), _mm_unpackhi_epi64(v, v));
+        dest += 2 * line_size;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * SSE version of vorbis_inverse_coupling, bit-exact with the C one
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <xmmintrin.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "vorbisdsp.h"
+
+/* Negating ang where mag <= 0 folds the four cases of the C version into
+ * two: if ang > 0 the new (mag, ang) is (mag, mag - ang), otherwise it is
+ * (mag + ang, mag). A NaN mag counts as mag <= 0, as in C. */
+X86_TARGET("sse")
+void ff_vorbis_inverse_coupling_sse(float *mag, float *ang,
+                                    intptr_t blocksize)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    intptr_t i;
+
+    for (i = 0; i < blocksize; i += 4) {
+        __m128 m   = _mm_load_ps(mag + i);
+        __m128 a   = _mm_load_ps(ang + i);
+        __m128 pos = _mm_cmpgt_ps(a, zero);
+        __m128 b   = _mm_xor_ps(a, _mm_and_ps(_mm_cmpngt_ps(m, zero), sign));
+        __m128 sub = _mm_sub_ps(m, b);
+        __m128 add = _mm_add_ps(m, b);
+
+        _mm_store_ps(mag + i, _mm_or_ps(_mm_and_ps(pos, m),
+                                        _mm_andnot_ps(pos, add)));
+        _mm_store_ps(ang + i, _mm_or_ps(_mm_and_ps(pos, sub),
+                                        _mm_andnot_ps(pos, m)));
+    }
+}
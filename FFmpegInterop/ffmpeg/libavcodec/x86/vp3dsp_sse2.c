@@ -0,0 +1,323 @@
+/*
+ * SSE2 versions of the VP3DSPContext functions, bit-exact with the C ones
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+#include "vp3dsp.h"
+
+#define xC1S7 64277
+#define xC2S6 60547
+#define xC3S5 54491
+#define xC4S4 46341
+#define xC5S3 36410
+#define xC6S2 25080
+#define xC7S1 12785
+
+/* M() of the C version on 32-bit lanes. The low 32 bits of the product
+ * are built from 16-bit multiplies, so the wraparound of the C code on
+ * large sums is reproduced as well. */
+static av_always_inline X86_TARGET("sse2")
+__m128i mul(__m128i a, int c)
+{
+    __m128i k  = _mm_set1_epi16((int16_t)c);
+    __m128i lo = _mm_mullo_epi16(a, k);
+    __m128i hi = _mm_mulhi_epu16(a, k);
+
+    return _mm_srai_epi32(_mm_add_epi32(lo, _mm_slli_epi32(hi, 16)), 16);
+}
+
+/* One 1-D transform of 4 lanes, x[] in and out in coefficient order.
+ * bias is added to E and F. */
+static av_always_inline X86_TARGET("sse2")
+void idct_1d(__m128i *x, __m128i bias)
+{
+    __m128i A, B, C, D, Ad, Bd, Cd, Dd, E, F, G, H;
+    __m128i Ed, Gd, Add, Bdd, Fd, Hd;
+
+    A = _mm_add_epi32(mul(x[1], xC1S7), mul(x[7], xC7S1));
+    B = _mm_sub_epi32(mul(x[1], xC7S1), mul(x[7], xC1S7));
+    C = _mm_add_epi32(mul(x[3], xC3S5), mul(x[5], xC5S3));
+    D = _mm_sub_epi32(mul(x[5], xC3S5), mul(x[3], xC5S3));
+
+    Ad = mul(_mm_sub_epi32(A, C), xC4S4);
+    Bd = mul(_mm_sub_epi32(B, D), xC4S4);
+
+    Cd = _mm_add_epi32(A, C);
+    Dd = _mm_add_epi32(B, D);
+
+    E = _mm_add_epi32(mul(_mm_add_epi32(x[0], x[4]), xC4S4), bias);
+    F = _mm_add_epi32(mul(_mm_sub_epi32(x[0], x[4]), xC4S4), bias);
+
+    G = _mm_add_epi32(mul(x[2], xC2S6), mul(x[6], xC6S2));
+    H = _mm_sub_epi32(mul(x[2], xC6S2), mul(x[6], xC2S6));
+
+    Ed = _mm_sub_epi32(E, G);
+    Gd = _mm_add_epi32(E, G);
+
+    Add = _mm_add_epi32(F, Ad);
+    Bdd = _mm_sub_epi32(Bd, H);
+
+    Fd = _mm_sub_epi32(F, Ad);
+    Hd = _mm_add_epi32(Bd, H);
+
+    x[0] = _mm_add_epi32(Gd, Cd);
+    x[7] = _mm_sub_epi32(Gd, Cd);
+
+    x[1] = _mm_add_epi32(Add, Hd);
+    x[2] = _mm_sub_epi32(Add, Hd);
+
+    x[3] = _mm_add_epi32(Ed, Dd);
+    x[4] = _mm_sub_epi32(Ed, Dd);
+
+    x[5] = _mm_add_epi32(Fd, Bdd);
+    x[6] = _mm_sub_epi32(Fd, Bdd);
+}
+
+static av_always_inline X86_TARGET("sse2")
+__m128i widen_lo(__m128i v)
+{
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+static av_always_inline X86_TARGET("sse2")
+__m128i widen_hi(__m128i v)
+{
+    return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+
+/* Like the int16_t stores of the C version, without saturation */
+static av_always_inline X86_TARGET("sse2")
+__m128i narrow(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+static av_always_inline X86_TARGET("sse2")
+void transpose8x8(__m128i *r)
+{
+    __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+    __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+    __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+    __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+    __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+    __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+    __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+    __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+
+    r[0] = _mm_unpacklo_epi64(u0, u4);
+    r[1] = _mm_unpackhi_epi64(u0, u4);
+    r[2] = _mm_unpacklo_epi64(u1, u5);
+    r[3] = _mm_unpackhi_epi64(u1, u5);
+    r[4] = _mm_unpacklo_epi64(u2, u6);
+    r[5] = _mm_unpackhi_epi64(u2, u6);
+    r[6] = _mm_unpacklo_epi64(u3, u7);
+    r[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+/* The C version skips the all-zero rows and columns, the transform gives
+ * the same result on them so every one is transformed here. */
+static av_always_inline X86_TARGET("sse2")
+void idct(uint8_t *dst, ptrdiff_t stride, int16_t *block, int type)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r[8], lo[8], hi[8];
+    __m128i bias;
+    int i;
+
+    /* Rows of the block are columns of the picture: the first pass runs
+     * down them, 8 at a time */
+    for (i = 0; i < 8; i++) {
+        r[i]  = _mm_load_si128((const __m128i *)(block + 8 * i));
+        lo[i] = widen_lo(r[i]);
+        hi[i] = widen_hi(r[i]);
+    }
+
+    idct_1d(lo, zero);
+    idct_1d(hi, zero);
+
+    for (i = 0; i < 8; i++)
+        r[i] = narrow(lo[i], hi[i]);
+
+    /* The second one across them, each lane now one column of the block */
+    transpose8x8(r);
+
+    for (i = 0; i < 8; i++) {
+        lo[i] = widen_lo(r[i]);
+        hi[i] = widen_hi(r[i]);
+    }
+
+    bias = _mm_set1_epi32(type == 1 ? 8 + 16 * 128 : 8);
+    idct_1d(lo, bias);
+    idct_1d(hi, bias);
+
+    for (i = 0; i < 8; i++) {
+        __m128i v = _mm_packs_epi32(_mm_srai_epi32(lo[i], 4),
+                                    _mm_srai_epi32(hi[i], 4));
+
+        if (type == 2) {
+            __m128i d = _mm_loadl_epi64((const __m128i *)(dst + i * stride));
+            v = _mm_adds_epi16(v, _mm_unpacklo_epi8(d, zero));
+        }
+        _mm_storel_epi64((__m128i *)(dst + i * stride), _mm_packus_epi16(v, v));
+    }
+
+    for (i = 0; i < 8; i++)
+        _mm_store_si128((__m128i *)(block + 8 * i), zero);
+}
+
+X86_TARGET("sse2")
+void ff_vp3_idct_put_sse2(uint8_t *dest, ptrdiff_t stride, int16_t *block)
+{
+    idct(dest, stride, block, 1);
+}
+
+X86_TARGET("sse2")
+void ff_vp3_idct_add_sse2(uint8_t *dest, ptrdiff_t stride, int16_t *block)
+{
+    idct(dest, stride, block, 2);
+}
+
+X86_TARGET("sse2")
+void ff_vp3_idct_dc_add_sse2(uint8_t *dest, ptrdiff_t stride, int16_t *block)
+{
+    int i, dc = (block[0] + 15) >> 5;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i add = _mm_packus_epi16(_mm_set1_epi16(dc), zero);
+    __m128i sub = _mm_packus_epi16(_mm_set1_epi16(-dc), zero);
+
+    for (i = 0; i < 8; i++) {
+        __m128i d = _mm_loadl_epi64((const __m128i *)dest);
+        d = _mm_subs_epu8(_mm_adds_epu8(d, add), sub);
+        _mm_storel_epi64((__m128i *)dest, d);
+        dest += stride;
+    }
+    block[0] = 0;
+}
+
+/* bounding_values[] as built by the decoder: x for |x| below the filter
+ * limit L, then back down to 0 at 2 * L. Its entry 129 holds 2 * L in each
+ * byte, the function is computed from that rather than looked up. */
+static av_always_inline X86_TARGET("sse2")
+void loop_filter(__m128i *p1, __m128i *p2, __m128i p0, __m128i p3,
+                 const int *bounding_values)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i limit = _mm_set1_epi16(bounding_values[129] & 0xff);
+    __m128i d = _mm_sub_epi16(*p2, *p1);
+    __m128i x, sign, f;
+
+    x = _mm_add_epi16(_mm_sub_epi16(p0, p3), _mm_add_epi16(d, _mm_add_epi16(d, d)));
+    x = _mm_srai_epi16(_mm_add_epi16(x, _mm_set1_epi16(4)), 3);
+
+    sign = _mm_srai_epi16(x, 15);
+    x = _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+    f = _mm_max_epi16(_mm_min_epi16(x, _mm_sub_epi16(limit, x)), zero);
+    f = _mm_sub_epi16(_mm_xor_si128(f, sign), sign);
+
+    *p1 = _mm_add_epi16(*p1, f);
+    *p2 = _mm_sub_epi16(*p2, f);
+}
+
+X86_TARGET("sse2")
+void ff_vp3_v_loop_filter_sse2(uint8_t *src, ptrdiff_t stride,
+                               int *bounding_values)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src - 2 * stride)), zero);
+    __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src - stride)), zero);
+    __m128i p2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), zero);
+    __m128i p3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + stride)), zero);
+
+    loop_filter(&p1, &p2, p0, p3, bounding_values);
+
+    p1 = _mm_packus_epi16(p1, p2);
+    _mm_storel_epi64((__m128i *)(src - stride), p1);
+    _mm_storel_epi64((__m128i *)src, _mm_unpackhi_epi64(p1, p1));
+}
+
+X86_TARGET("sse2")
+void ff_vp3_h_loop_filter_sse2(uint8_t *src, ptrdiff_t stride,
+                               int *bounding_values)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r[8], p0, p1, p2, p3, t0, t1;
+    int i;
+
+    /* 4 pixels across the edge on 8 rows, transposed to 4 columns */
+    for (i = 0; i < 8; i++)
+        r[i] = _mm_cvtsi32_si128(AV_RN32(src + i * stride - 2));
+
+    r[0] = _mm_unpacklo_epi16(_mm_unpacklo_epi8(r[0], r[1]),
+                              _mm_unpacklo_epi8(r[2], r[3]));
+    r[4] = _mm_unpacklo_epi16(_mm_unpacklo_epi8(r[4], r[5]),
+                              _mm_unpacklo_epi8(r[6], r[7]));
+    t0 = _mm_unpacklo_epi32(r[0], r[4]);
+    t1 = _mm_unpackhi_epi32(r[0], r[4]);
+
+    p0 = _mm_unpacklo_epi8(t0, zero);
+    p1 = _mm_unpackhi_epi8(t0, zero);
+    p2 = _mm_unpacklo_epi8(t1, zero);
+    p3 = _mm_unpackhi_epi8(t1, zero);
+
+    loop_filter(&p1, &p2, p0, p3, bounding_values);
+
+    /* Back to 2 pixels per row */
+    p1 = _mm_packus_epi16(p1, p2);
+    p1 = _mm_unpacklo_epi8(p1, _mm_unpackhi_epi64(p1, p1));
+
+    for (i = 0; i < 8; i += 2) {
+        uint32_t v = _mm_cvtsi128_si32(p1);
+        AV_WN16(src +  i      * stride - 1, v);
+        AV_WN16(src + (i + 1) * stride - 1, v >> 16);
+        p1 = _mm_srli_si128(p1, 4);
+    }
+}
+
+X86_TARGET("sse2")
+void ff_put_vp_no_rnd_pixels8_l2_sse2(uint8_t *dst, const uint8_t *a,
+                                      const uint8_t *b, ptrdiff_t stride,
+                                      int h)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    int i;
+
+    /* (a + b) >> 1 is the rounded average less the rounding bit */
+    for (i = 0; i < h; i++) {
+        __m128i va = _mm_loadl_epi64((const __m128i *)(a + i * stride));
+        __m128i vb = _mm_loadl_epi64((const __m128i *)(b + i * stride));
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(va, vb),
+                                   _mm_and_si128(_mm_xor_si128(va, vb), one));
+        _mm_storel_epi64((__m128i *)(dst + i * stride), avg);
+    }
+}
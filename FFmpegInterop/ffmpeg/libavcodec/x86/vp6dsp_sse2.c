@@ -0,0 +1,227 @@
+/*
+ * SSE2 versions of the VP6 functions of VP56DSPContext, bit-exact with the
+ * C ones
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+#include "vp6dsp.h"
+
+/* vp6_adjust() of the C version: v, except between t and 2 * t where it
+ * folds back to 0. The unsigned comparison is kept as is, 16 bits are
+ * enough for its operands. */
+static av_always_inline X86_TARGET("sse2")
+__m128i adjust(__m128i v, __m128i t)
+{
+    const __m128i bias = _mm_set1_epi16(-0x8000);
+    const __m128i one  = _mm_set1_epi16(1);
+    __m128i s = _mm_srai_epi16(v, 15);
+    __m128i a = _mm_sub_epi16(_mm_xor_si128(v, s), s);
+    __m128i x = _mm_sub_epi16(_mm_sub_epi16(a, t), one);
+    __m128i y = _mm_sub_epi16(t, one);
+    __m128i fold = _mm_cmplt_epi16(_mm_xor_si128(x, bias), _mm_xor_si128(y, bias));
+    __m128i f = _mm_sub_epi16(_mm_add_epi16(t, t), a);
+
+    f = _mm_sub_epi16(_mm_xor_si128(f, s), s);
+    return _mm_or_si128(_mm_and_si128(fold, f), _mm_andnot_si128(fold, v));
+}
+
+/* p0 to p3 are the pixels across the edge, which is between p1 and p2 */
+static av_always_inline X86_TARGET("sse2")
+void edge_filter(__m128i *p1, __m128i *p2, __m128i p0, __m128i p3, __m128i t)
+{
+    __m128i d = _mm_sub_epi16(*p2, *p1);
+    __m128i v;
+
+    v = _mm_add_epi16(_mm_sub_epi16(p0, p3), _mm_add_epi16(d, _mm_add_epi16(d, d)));
+    v = _mm_srai_epi16(_mm_add_epi16(v, _mm_set1_epi16(4)), 3);
+    v = adjust(v, t);
+
+    *p1 = _mm_add_epi16(*p1, v);
+    *p2 = _mm_sub_epi16(*p2, v);
+}
+
+/* 12 pixels of a row, without reading past them */
+static av_always_inline X86_TARGET("sse2")
+__m128i load12(const uint8_t *src)
+{
+    return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)src),
+                              _mm_cvtsi32_si128(AV_RN32(src + 8)));
+}
+
+static av_always_inline X86_TARGET("sse2")
+void store12(uint8_t *dst, __m128i v)
+{
+    _mm_storel_epi64((__m128i *)dst, v);
+    AV_WN32(dst + 8, _mm_cvtsi128_si32(_mm_srli_si128(v, 8)));
+}
+
+X86_TARGET("sse2")
+void ff_vp6_edge_filter_ver_sse2(uint8_t *yuv, ptrdiff_t stride, int t)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vt = _mm_set1_epi16(t);
+    __m128i r0 = load12(yuv - 2 * stride);
+    __m128i r1 = load12(yuv - stride);
+    __m128i r2 = load12(yuv);
+    __m128i r3 = load12(yuv + stride);
+    __m128i p0 = _mm_unpacklo_epi8(r0, zero), q0 = _mm_unpackhi_epi8(r0, zero);
+    __m128i p1 = _mm_unpacklo_epi8(r1, zero), q1 = _mm_unpackhi_epi8(r1, zero);
+    __m128i p2 = _mm_unpacklo_epi8(r2, zero), q2 = _mm_unpackhi_epi8(r2, zero);
+    __m128i p3 = _mm_unpacklo_epi8(r3, zero), q3 = _mm_unpackhi_epi8(r3, zero);
+
+    edge_filter(&p1, &p2, p0, p3, vt);
+    edge_filter(&q1, &q2, q0, q3, vt);
+
+    store12(yuv - stride, _mm_packus_epi16(p1, q1));
+    store12(yuv,          _mm_packus_epi16(p2, q2));
+}
+
+/* 4 pixels around the edge on 4 rows, one row per 32 bits */
+static av_always_inline X86_TARGET("sse2")
+__m128i load_rows(const uint8_t *src, ptrdiff_t stride)
+{
+    __m128i r0 = _mm_cvtsi32_si128(AV_RN32(src - 2));
+    __m128i r1 = _mm_cvtsi32_si128(AV_RN32(src + stride - 2));
+    __m128i r2 = _mm_cvtsi32_si128(AV_RN32(src + 2 * stride - 2));
+    __m128i r3 = _mm_cvtsi32_si128(AV_RN32(src + 3 * stride - 2));
+
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(r0, r1),
+                              _mm_unpacklo_epi8(r2, r3));
+}
+
+/* The 2 pixels next to the edge of 8 rows, or 4 in the low half */
+static av_always_inline X86_TARGET("sse2")
+void store_rows(uint8_t *dst, ptrdiff_t stride, __m128i p1, __m128i p2, int h)
+{
+    __m128i v = _mm_packus_epi16(p1, p2);
+    int i;
+
+    v = _mm_unpacklo_epi8(v, _mm_unpackhi_epi64(v, v));
+    for (i = 0; i < h; i += 2) {
+        uint32_t w = _mm_cvtsi128_si32(v);
+        AV_WN16(dst +  i      * stride - 1, w);
+        AV_WN16(dst + (i + 1) * stride - 1, w >> 16);
+        v = _mm_srli_si128(v, 4);
+    }
+}
+
+X86_TARGET("sse2")
+void ff_vp6_edge_filter_hor_sse2(uint8_t *yuv, ptrdiff_t stride, int t)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vt = _mm_set1_epi16(t);
+    __m128i a = load_rows(yuv, stride);
+    __m128i b = load_rows(yuv + 4 * stride, stride);
+    __m128i c = load_rows(yuv + 8 * stride, stride);
+    __m128i t0, t1, t2, t3;
+    __m128i p0, p1, p2, p3, q0, q1, q2, q3;
+
+    /* Transposed to the 4 columns: rows 0-7 in p, rows 8-11 in q */
+    t0 = _mm_unpacklo_epi32(a, b);
+    t1 = _mm_unpackhi_epi32(a, b);
+    t2 = _mm_unpacklo_epi32(c, zero);
+    t3 = _mm_unpackhi_epi32(c, zero);
+
+    p0 = _mm_unpacklo_epi8(t0, zero);
+    p1 = _mm_unpackhi_epi8(t0, zero);
+    p2 = _mm_unpacklo_epi8(t1, zero);
+    p3 = _mm_unpackhi_epi8(t1, zero);
+    q0 = _mm_unpacklo_epi8(t2, zero);
+    q1 = _mm_unpackhi_epi8(t2, zero);
+    q2 = _mm_unpacklo_epi8(t3, zero);
+    q3 = _mm_unpackhi_epi8(t3, zero);
+
+    edge_filter(&p1, &p2, p0, p3, vt);
+    edge_filter(&q1, &q2, q0, q3, vt);
+
+    store_rows(yuv, stride, p1, p2, 8);
+    store_rows(yuv + 8 * stride, stride, q1, q2, 4);
+}
+
+/* 8 pixels of src[x - delta] * w[0] + ... + src[x + 2 * delta] * w[3],
+ * rounded and clipped. Pairs of taps go through pmaddwd, the sums of the
+ * sharpest filters do not fit in 16 bits. */
+static av_always_inline X86_TARGET("sse2")
+__m128i filter4(const uint8_t *src, ptrdiff_t delta, __m128i w01, __m128i w23)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rnd  = _mm_set1_epi32(64);
+    __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src - delta)), zero);
+    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), zero);
+    __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + delta)), zero);
+    __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + 2 * delta)), zero);
+    __m128i lo, hi;
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), w01),
+                       _mm_madd_epi16(_mm_unpacklo_epi16(c, d), w23));
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), w01),
+                       _mm_madd_epi16(_mm_unpackhi_epi16(c, d), w23));
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, rnd), 7);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, rnd), 7);
+
+    lo = _mm_packs_epi32(lo, hi);
+    return _mm_packus_epi16(lo, lo);
+}
+
+static av_always_inline X86_TARGET("sse2")
+__m128i weight_pair(const int16_t *weights)
+{
+    return _mm_set1_epi32((weights[1] << 16) | (uint16_t)weights[0]);
+}
+
+static av_always_inline X86_TARGET("sse2")
+void filter_block(uint8_t *dst, ptrdiff_t dst_stride, uint8_t *src,
+                  ptrdiff_t src_stride, ptrdiff_t delta,
+                  const int16_t *weights, int h)
+{
+    __m128i w01 = weight_pair(weights);
+    __m128i w23 = weight_pair(weights + 2);
+    int y;
+
+    for (y = 0; y < h; y++) {
+        _mm_storel_epi64((__m128i *)dst, filter4(src, delta, w01, w23));
+        src += src_stride;
+        dst += dst_stride;
+    }
+}
+
+X86_TARGET("sse2")
+void ff_vp6_filter_hv4_sse2(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                            ptrdiff_t delta, const int16_t *weights)
+{
+    filter_block(dst, stride, src, stride, delta, weights, 8);
+}
+
+X86_TARGET("sse2")
+void ff_vp6_filter_diag4_sse2(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                              const int16_t *h_weights,
+                              const int16_t *v_weights)
+{
+    uint8_t tmp[8 * 11];
+
+    /* The C version keeps the clipped first pass in ints, bytes are
+     * enough */
+    filter_block(tmp, 8, src - stride, stride, 1, h_weights, 11);
+    filter_block(dst, stride, tmp + 8, 8, 8, v_weights, 8);
+}
@@ -0,0 +1,163 @@
+/*
+ * AVX and FMA3 versions of the AVFloatDSPContext functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <immintrin.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "float_dsp.h"
+
+/* The AVX functions are bit-exact with the C ones. The FMA3 ones round
+ * once where C rounds twice, they differ in the last bit. */
+
+X86_TARGET("avx")
+void ff_vector_fmul_avx(float *dst, const float *src0, const float *src1,
+                        int len)
+{
+    int i;
+
+    for (i = 0; i < len; i += 16) {
+        __m256 a = _mm256_mul_ps(_mm256_load_ps(src0 + i),
+                                 _mm256_load_ps(src1 + i));
+        __m256 b = _mm256_mul_ps(_mm256_load_ps(src0 + i + 8),
+                                 _mm256_load_ps(src1 + i + 8));
+        _mm256_store_ps(dst + i,     a);
+        _mm256_store_ps(dst + i + 8, b);
+    }
+}
+
+X86_TARGET("avx")
+void ff_vector_dmul_avx(double *dst, const double *src0, const double *src1,
+                        int len)
+{
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m256d a = _mm256_mul_pd(_mm256_load_pd(src0 + i),
+                                  _mm256_load_pd(src1 + i));
+        __m256d b = _mm256_mul_pd(_mm256_load_pd(src0 + i + 4),
+                                  _mm256_load_pd(src1 + i + 4));
+        _mm256_store_pd(dst + i,     a);
+        _mm256_store_pd(dst + i + 4, b);
+    }
+}
+
+/* a * b + c, rounded twice as in C for AVX */
+#define MADD_PS(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#define MADD_PD(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+
+#define VECTOR_FMAC_SCALAR(ext, target, madd)                               \
+X86_TARGET(target)                                                          \
+void ff_vector_fmac_scalar_ ## ext(float *dst, const float *src, float mul, \
+                                   int len)                                 \
+{                                                                           \
+    __m256 m = _mm256_set1_ps(mul);                                         \
+    int i;                                                                  \
+                                                                            \
+    for (i = 0; i < len; i += 16) {                                         \
+        __m256 a = madd(_mm256_load_ps(src + i), m,                         \
+                        _mm256_load_ps(dst + i));                           \
+        __m256 b = madd(_mm256_load_ps(src + i + 8), m,                     \
+                        _mm256_load_ps(dst + i + 8));                       \
+        _mm256_store_ps(dst + i,     a);                                    \
+        _mm256_store_ps(dst + i + 8, b);                                    \
+    }                                                                       \
+}
+
+VECTOR_FMAC_SCALAR(avx,  "avx",     MADD_PS)
+VECTOR_FMAC_SCALAR(fma3, "avx,fma", _mm256_fmadd_ps)
+
+#define VECTOR_DMAC_SCALAR(ext, target, madd)                                  \
+X86_TARGET(target)                                                             \
+void ff_vector_dmac_scalar_ ## ext(double *dst, const double *src, double mul, \
+                                   int len)                                    \
+{                                                                              \
+    __m256d m = _mm256_set1_pd(mul);                                           \
+    int i;                                                                     \
+                                                                               \
+    for (i = 0; i < len; i += 8) {                                             \
+        __m256d a = madd(_mm256_load_pd(src + i), m,                           \
+                         _mm256_load_pd(dst + i));                             \
+        __m256d b = madd(_mm256_load_pd(src + i + 4), m,                       \
+                         _mm256_load_pd(dst + i + 4));                         \
+        _mm256_store_pd(dst + i,     a);                                       \
+        _mm256_store_pd(dst + i + 4, b);                                       \
+    }                                                                          \
+}
+
+VECTOR_DMAC_SCALAR(avx,  "avx",     MADD_PD)
+VECTOR_DMAC_SCALAR(fma3, "avx,fma", _mm256_fmadd_pd)
+
+X86_TARGET("avx")
+void ff_vector_dmul_scalar_avx(double *dst, const double *src, double mul,
+                               int len)
+{
+    __m256d m = _mm256_set1_pd(mul);
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        _mm256_store_pd(dst + i,     _mm256_mul_pd(_mm256_load_pd(src + i),     m));
+        _mm256_store_pd(dst + i + 4, _mm256_mul_pd(_mm256_load_pd(src + i + 4), m));
+    }
+}
+
+#define VECTOR_FMUL_ADD(ext, target, madd)                                  \
+X86_TARGET(target)                                                          \
+void ff_vector_fmul_add_ ## ext(float *dst, const float *src0,              \
+                                const float *src1, const float *src2,       \
+                                int len)                                    \
+{                                                                           \
+    int i;                                                                  \
+                                                                            \
+    for (i = 0; i < len; i += 16) {                                         \
+        __m256 a = madd(_mm256_load_ps(src0 + i), _mm256_load_ps(src1 + i), \
+                        _mm256_load_ps(src2 + i));                          \
+        __m256 b = madd(_mm256_load_ps(src0 + i + 8),                       \
+                        _mm256_load_ps(src1 + i + 8),                       \
+                        _mm256_load_ps(src2 + i + 8));                      \
+        _mm256_store_ps(dst + i,     a);                                    \
+        _mm256_store_ps(dst + i + 8, b);                                    \
+    }                                                                       \
+}
+
+VECTOR_FMUL_ADD(avx,  "avx",     MADD_PS)
+VECTOR_FMUL_ADD(fma3, "avx,fma", _mm256_fmadd_ps)
+
+static av_always_inline X86_TARGET("avx")
+__m256 reverse(__m256 v)
+{
+    v = _mm256_permute2f128_ps(v, v, 0x01);
+    return _mm256_permute_ps(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+X86_TARGET("avx")
+void ff_vector_fmul_reverse_avx(float *dst, const float *src0,
+                                const float *src1, int len)
+{
+    int i;
+
+    src1 += len - 16;
+    for (i = 0; i < len; i += 16) {
+        __m256 a = reverse(_mm256_load_ps(src1 - i + 8));
+        __m256 b = reverse(_mm256_load_ps(src1 - i));
+        _mm256_store_ps(dst + i,     _mm256_mul_ps(_mm256_load_ps(src0 + i),     a));
+        _mm256_store_ps(dst + i + 8, _mm256_mul_ps(_mm256_load_ps(src0 + i + 8), b));
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/float_dsp.h"
+#include "cpu.h"
+#include "float_dsp.h"
+
+av_cold void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (X86_SSE(cpu_flags)) {
+        fdsp->vector_fmul         = ff_vector_fmul_sse;
+        fdsp->vector_fmac_scalar  = ff_vector_fmac_scalar_sse;
+        fdsp->vector_fmul_scalar  = ff_vector_fmul_scalar_sse;
+        fdsp->vector_fmul_window  = ff_vector_fmul_window_sse;
+        fdsp->vector_fmul_add     = ff_vector_fmul_add_sse;
+        fdsp->vector_fmul_reverse = ff_vector_fmul_reverse_sse;
+        fdsp->butterflies_float   = ff_butterflies_float_sse;
+        fdsp->scalarproduct_float = ff_scalarproduct_float_sse;
+    }
+    if (X86_SSE2(cpu_flags)) {
+        fdsp->vector_dmul         = ff_vector_dmul_sse2;
+        fdsp->vector_dmac_scalar  = ff_vector_dmac_scalar_sse2;
+        fdsp->vector_dmul_scalar  = ff_vector_dmul_scalar_sse2;
+    }
+    /* vector_fmul_scalar and vector_fmul_window only get 16-byte aligned
+     * buffers, they stay on SSE. */
+    if (X86_AVX_FAST(cpu_flags)) {
+        fdsp->vector_fmul         = ff_vector_fmul_avx;
+        fdsp->vector_dmul         = ff_vector_dmul_avx;
+        fdsp->vector_fmac_scalar  = ff_vector_fmac_scalar_avx;
+        fdsp->vector_dmac_scalar  = ff_vector_dmac_scalar_avx;
+        fdsp->vector_dmul_scalar  = ff_vector_dmul_scalar_avx;
+        fdsp->vector_fmul_add     = ff_vector_fmul_add_avx;
+        fdsp->vector_fmul_reverse = ff_vector_fmul_reverse_avx;
+    }
+    if (X86_FMA3_FAST(cpu_flags)) {
+        fdsp->vector_fmac_scalar  = ff_vector_fmac_scalar_fma3;
+        fdsp->vector_dmac_scalar  = ff_vector_dmac_scalar_fma3;
+        fdsp->vector_fmul_add     = ff_vector_fmul_add_fma3;
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ * SSE and SSE2 versions of the AVFloatDSPContext functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <emmintrin.h>
+#include <xmmintrin.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/x86/cpu.h"
+#include "float_dsp.h"
+
+/* Every element gets the same operations as in C, in the same order, so
+ * all of them but scalarproduct_float are bit-exact. */
+
+X86_TARGET("sse")
+void ff_vector_fmul_sse(float *dst, const float *src0, const float *src1,
+                        int len)
+{
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_load_ps(src0 + i),     _mm_load_ps(src1 + i));
+        __m128 b = _mm_mul_ps(_mm_load_ps(src0 + i + 4), _mm_load_ps(src1 + i + 4));
+        _mm_store_ps(dst + i,     a);
+        _mm_store_ps(dst + i + 4, b);
+    }
+}
+
+X86_TARGET("sse2")
+void ff_vector_dmul_sse2(double *dst, const double *src0, const double *src1,
+                         int len)
+{
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128d a = _mm_mul_pd(_mm_load_pd(src0 + i),     _mm_load_pd(src1 + i));
+        __m128d b = _mm_mul_pd(_mm_load_pd(src0 + i + 2), _mm_load_pd(src1 + i + 2));
+        _mm_store_pd(dst + i,     a);
+        _mm_store_pd(dst + i + 2, b);
+    }
+}
+
+X86_TARGET("sse")
+void ff_vector_fmac_scalar_sse(float *dst, const float *src, float mul,
+                               int len)
+{
+    __m128 m = _mm_set1_ps(mul);
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_load_ps(src + i),     m);
+        __m128 b = _mm_mul_ps(_mm_load_ps(src + i + 4), m);
+        _mm_store_ps(dst + i,     _mm_add_ps(_mm_load_ps(dst + i),     a));
+        _mm_store_ps(dst + i + 4, _mm_add_ps(_mm_load_ps(dst + i + 4), b));
+    }
+}
+
+X86_TARGET("sse2")
+void ff_vector_dmac_scalar_sse2(double *dst, const double *src, double mul,
+                                int len)
+{
+    __m128d m = _mm_set1_pd(mul);
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128d a = _mm_mul_pd(_mm_load_pd(src + i),     m);
+        __m128d b = _mm_mul_pd(_mm_load_pd(src + i + 2), m);
+        _mm_store_pd(dst + i,     _mm_add_pd(_mm_load_pd(dst + i),     a));
+        _mm_store_pd(dst + i + 2, _mm_add_pd(_mm_load_pd(dst + i + 2), b));
+    }
+}
+
+X86_TARGET("sse")
+void ff_vector_fmul_scalar_sse(float *dst, const float *src, float mul,
+                               int len)
+{
+    __m128 m = _mm_set1_ps(mul);
+    int i;
+
+    for (i = 0; i < len; i += 4)
+        _mm_store_ps(dst + i, _mm_mul_ps(_mm_load_ps(src + i), m));
+}
+
+X86_TARGET("sse2")
+void ff_vector_dmul_scalar_sse2(double *dst, const double *src, double mul,
+                                int len)
+{
+    __m128d m = _mm_set1_pd(mul);
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        _mm_store_pd(dst + i,     _mm_mul_pd(_mm_load_pd(src + i),     m));
+        _mm_store_pd(dst + i + 2, _mm_mul_pd(_mm_load_pd(src + i + 2), m));
+    }
+}
+
+#define REVERSE(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+
+/* Both ends are loaded before either is stored, so dst may be src0, as in
+ * the CELT overlap-add. */
+X86_TARGET("sse")
+void ff_vector_fmul_window_sse(float *dst, const float *src0,
+                               const float *src1, const float *win, int len)
+{
+    int i, j;
+
+    for (i = 0, j = 2 * len - 4; i < len; i += 4, j -= 4) {
+        __m128 s0 = _mm_load_ps(src0 + i);
+        __m128 wi = _mm_load_ps(win + i);
+        __m128 s1 = REVERSE(_mm_load_ps(src1 + j - len));
+        __m128 wj = REVERSE(_mm_load_ps(win + j));
+        __m128 lo = _mm_sub_ps(_mm_mul_ps(s0, wj), _mm_mul_ps(s1, wi));
+        __m128 hi = _mm_add_ps(_mm_mul_ps(s0, wi), _mm_mul_ps(s1, wj));
+        _mm_store_ps(dst + i, lo);
+        _mm_store_ps(dst + j, REVERSE(hi));
+    }
+}
+
+X86_TARGET("sse")
+void ff_vector_fmul_add_sse(float *dst, const float *src0, const float *src1,
+                            const float *src2, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_load_ps(src0 + i),     _mm_load_ps(src1 + i));
+        __m128 b = _mm_mul_ps(_mm_load_ps(src0 + i + 4), _mm_load_ps(src1 + i + 4));
+        _mm_store_ps(dst + i,     _mm_add_ps(a, _mm_load_ps(src2 + i)));
+        _mm_store_ps(dst + i + 4, _mm_add_ps(b, _mm_load_ps(src2 + i + 4)));
+    }
+}
+
+X86_TARGET("sse")
+void ff_vector_fmul_reverse_sse(float *dst, const float *src0,
+                                const float *src1, int len)
+{
+    int i;
+
+    src1 += len - 8;
+    for (i = 0; i < len; i += 8) {
+        __m128 a = REVERSE(_mm_load_ps(src1 - i + 4));
+        __m128 b = REVERSE(_mm_load_ps(src1 - i));
+        _mm_store_ps(dst + i,     _mm_mul_ps(_mm_load_ps(src0 + i),     a));
+        _mm_store_ps(dst + i + 4, _mm_mul_ps(_mm_load_ps(src0 + i + 4), b));
+    }
+}
+
+X86_TARGET("sse")
+void ff_butterflies_float_sse(float *av_restrict v1, float *av_restrict v2,
+                              int len)
+{
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128 a = _mm_load_ps(v1 + i);
+        __m128 b = _mm_load_ps(v2 + i);
+        _mm_store_ps(v1 + i, _mm_add_ps(a, b));
+        _mm_store_ps(v2 + i, _mm_sub_ps(a, b));
+    }
+}
+
+/* Four running sums instead of one: the result differs from C in the last
+ * bits. */
+X86_TARGET("sse")
+float ff_scalarproduct_float_sse(const float *v1, const float *v2, int len)
+{
+    __m128 sum = _mm_setzero_ps();
+    int i;
+
+    for (i = 0; i < len; i += 4)
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(v1 + i),
+                                         _mm_load_ps(v2 + i)));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+}
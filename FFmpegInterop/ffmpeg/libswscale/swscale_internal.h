@@ -877,6 +877,10 @@ void ff_hyscale_fast_c(SwsContext *c, int16_t *dst, int dstWidth,
 void ff_hcscale_fast_c(SwsContext *c, int16_t *dst1, int16_t *dst2,
                        int dstWidth, const uint8_t *src1,
                        const uint8_t *src2, int srcW, int xInc);
+/* The runtime-generated MMXEXT fast bilinear scaler below is not part of
+ * this tree (no x86/hscale_fast_bilinear_simd.c), keep it disabled. */
+#define USE_MMXEXT_HSCALER 0
+
 int ff_init_hscaler_mmxext(int dstW, int xInc, uint8_t *filterCode,
                            int16_t *filter, int32_t *filterPos,
                            int numSplits);
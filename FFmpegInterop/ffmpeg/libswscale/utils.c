@@ -1417,7 +1417,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     if (c->dstBpc == 16)
         dst_stride <<= 1;
 
-    if (INLINE_MMXEXT(cpu_flags) && c->srcBpc == 8 && c->dstBpc <= 14) {
+    if (USE_MMXEXT_HSCALER && INLINE_MMXEXT(cpu_flags) &&
+        c->srcBpc == 8 && c->dstBpc <= 14) {
         c->canMMXEXTBeUsed = dstW >= srcW && (dstW & 31) == 0 &&
                              c->chrDstW >= c->chrSrcW &&
                              (srcW & 15) == 0;
@@ -1602,7 +1603,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 
     /* precalculate horizontal scaler filter coefficients */
     {
-#if HAVE_MMXEXT_INLINE
+#if HAVE_MMXEXT_INLINE && USE_MMXEXT_HSCALER
 // can't downscale !!!
         if (c->canMMXEXTBeUsed && (flags & SWS_FAST_BILINEAR)) {
             c->lumMmxextFilterCodeSize = ff_init_hscaler_mmxext(dstW, c->lumXInc, NULL,
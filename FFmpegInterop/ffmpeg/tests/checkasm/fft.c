@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/fft.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "checkasm.h"
+
+#define MAX_FFT_BITS  10
+#define MAX_MDCT_BITS 12
+
+#define randomize_buffer(buf, len)                                  \
+    do {                                                            \
+        int i;                                                      \
+        for (i = 0; i < len; i++)                                   \
+            buf[i] = ((int)(rnd() & 0xFFFF) - 0x8000) / 32768.0f;   \
+    } while (0)
+
+/* The transforms sum up to n inputs of magnitude <= 1, so scale the
+ * tolerance with the transform size. */
+#define EPS(n) ((n) * 1.0e-6f)
+
+static void check_fft_calc(void)
+{
+    LOCAL_ALIGNED_32(FFTComplex, in,   [1 << MAX_FFT_BITS]);
+    LOCAL_ALIGNED_32(FFTComplex, out0, [1 << MAX_FFT_BITS]);
+    LOCAL_ALIGNED_32(FFTComplex, out1, [1 << MAX_FFT_BITS]);
+    FFTContext s;
+    int nbits;
+
+    declare_func(void, FFTContext *s, FFTComplex *z);
+
+    for (nbits = 2; nbits <= MAX_FFT_BITS; nbits++) {
+        int n = 1 << nbits;
+
+        if (ff_fft_init(&s, nbits, 0) < 0) {
+            fail();
+            return;
+        }
+        if (check_func(s.fft_calc, "fft_calc_%d", n)) {
+            randomize_buffer(((float *)in), 2 * n);
+            memcpy(out0, in, n * sizeof(*in));
+            memcpy(out1, in, n * sizeof(*in));
+            call_ref(&s, out0);
+            call_new(&s, out1);
+            if (!float_near_abs_eps_array((float *)out0, (float *)out1,
+                                          EPS(n), 2 * n))
+                fail();
+            bench_new(&s, out1);
+        }
+        ff_fft_end(&s);
+    }
+    report("fft_calc");
+}
+
+static void check_imdct(void)
+{
+    LOCAL_ALIGNED_32(FFTSample, in,   [1 << (MAX_MDCT_BITS - 1)]);
+    LOCAL_ALIGNED_32(FFTSample, out0, [1 << MAX_MDCT_BITS]);
+    LOCAL_ALIGNED_32(FFTSample, out1, [1 << MAX_MDCT_BITS]);
+    FFTContext s;
+    int nbits;
+
+    declare_func(void, FFTContext *s, FFTSample *output, const FFTSample *input);
+
+    for (nbits = 5; nbits <= MAX_MDCT_BITS; nbits++) {
+        int n = 1 << nbits;
+
+        if (ff_mdct_init(&s, nbits, 1, 1.0) < 0) {
+            fail();
+            return;
+        }
+        randomize_buffer(in, n / 2);
+        if (check_func(s.imdct_half, "imdct_half_%d", n)) {
+            call_ref(&s, out0, in);
+            call_new(&s, out1, in);
+            if (!float_near_abs_eps_array(out0, out1, EPS(n), n / 2))
+                fail();
+            bench_new(&s, out1, in);
+        }
+        if (check_func(s.imdct_calc, "imdct_calc_%d", n)) {
+            call_ref(&s, out0, in);
+            call_new(&s, out1, in);
+            if (!float_near_abs_eps_array(out0, out1, EPS(n), n))
+                fail();
+            bench_new(&s, out1, in);
+        }
+        ff_mdct_end(&s);
+    }
+    report("imdct");
+}
+
+void checkasm_check_fft(void)
+{
+    check_fft_calc();
+    if (CONFIG_MDCT)
+        check_imdct();
+}
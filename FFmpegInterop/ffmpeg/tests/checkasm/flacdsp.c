@@ -53,6 +53,38 @@ static void check_decorrelate(uint8_t **ref_dst, uint8_t **ref_src, uint8_t **ne
     bench_new(new_dst, (int32_t **)new_src, channels, BUF_SIZE / sizeof(int32_t), 8);
 }
 
+#define LPC_LEN 1024
+
+static void check_lpc(FLACDSPContext *h, int bits)
+{
+    LOCAL_ALIGNED_16(int32_t, ref, [LPC_LEN]);
+    LOCAL_ALIGNED_16(int32_t, new, [LPC_LEN]);
+    int coeffs[32];
+    int order, i;
+
+    declare_func(void, int32_t *samples, const int coeffs[32], int order,
+                 int qlevel, int len);
+
+    for (order = 1; order <= 32; order++) {
+        if (check_func(bits == 16 ? h->lpc16 : h->lpc32, "flac_lpc_%d_%d", bits, order)) {
+            int sample_bits = bits == 16 ? 16 : 24;
+            int qlevel = rnd() % 16;
+            int len = LPC_LEN - (rnd() & 7);
+
+            for (i = 0; i < order; i++)
+                coeffs[i] = (int)(rnd() & 0x7FFF) - 0x4000;
+            for (i = 0; i < LPC_LEN; i++)
+                ref[i] = new[i] = (int)(rnd() & ((1 << sample_bits) - 1)) - (1 << (sample_bits - 1));
+
+            call_ref(ref, coeffs, order, qlevel, len);
+            call_new(new, coeffs, order, qlevel, len);
+            if (memcmp(ref, new, LPC_LEN * sizeof(*ref)))
+                fail();
+            bench_new(new, coeffs, order, qlevel, len);
+        }
+    }
+}
+
 void checkasm_check_flacdsp(void)
 {
     LOCAL_ALIGNED_16(uint8_t, ref_dst, [BUF_SIZE*MAX_CHANNELS]);
@@ -77,7 +109,7 @@ void checkasm_check_flacdsp(void)
     for (i = 0; i < 2; i++) {
         ff_flacdsp_init(&h, fmts[i].fmt, 2, 0);
         for (j = 0; j < 3; j++)
-            if (check_func(h.decorrelate[j], "flac_decorrelate_%s_%d", names[j], fmts[i].bits))
+            if (check_func(h.decorrelate[j + 1], "flac_decorrelate_%s_%d", names[j], fmts[i].bits))
                 check_decorrelate(&ref_dst, ref_src, &new_dst, new_src, 2, fmts[i].bits);
         for (j = 2; j <= MAX_CHANNELS; j += 2) {
             ff_flacdsp_init(&h, fmts[i].fmt, j, 0);
@@ -87,4 +119,9 @@ void checkasm_check_flacdsp(void)
     }
 
     report("decorrelate");
+
+    ff_flacdsp_init(&h, AV_SAMPLE_FMT_S16, 2, 16);
+    check_lpc(&h, 16);
+    check_lpc(&h, 32);
+    report("lpc");
 }
@@ -61,6 +61,32 @@ static void test_vector_fmul(const float *src0, const float *src1)
     bench_new(odst, src0, src1, LEN);
 }
 
+/* src1 is read backwards from src1[len - 1], so shorter lengths are
+ * checked too. */
+static void test_vector_fmul_reverse(const float *src0, const float *src1)
+{
+    LOCAL_ALIGNED_32(float, cdst, [LEN]);
+    LOCAL_ALIGNED_32(float, odst, [LEN]);
+    int i, len;
+
+    declare_func(void, float *dst, const float *src0, const float *src1,
+                 int len);
+
+    for (len = 16; len <= LEN; len += 16) {
+        call_ref(cdst, src0, src1, len);
+        call_new(odst, src0, src1, len);
+        for (i = 0; i < len; i++) {
+            if (!float_near_abs_eps(cdst[i], odst[i], FLT_EPSILON)) {
+                fprintf(stderr, "%d/%d: %- .12f - %- .12f = % .12g\n",
+                        i, len, cdst[i], odst[i], cdst[i] - odst[i]);
+                fail();
+                return;
+            }
+        }
+    }
+    bench_new(odst, src0, src1, LEN);
+}
+
 static void test_vector_dmul(const double *src0, const double *src1)
 {
     LOCAL_ALIGNED_32(double, cdst, [LEN]);
@@ -309,7 +335,7 @@ void checkasm_check_float_dsp(void)
     if (check_func(fdsp->vector_fmul_scalar, "vector_fmul_scalar"))
         test_vector_fmul_scalar(src3, src4);
     if (check_func(fdsp->vector_fmul_reverse, "vector_fmul_reverse"))
-        test_vector_fmul(src0, src1);
+        test_vector_fmul_reverse(src0, src1);
     if (check_func(fdsp->vector_fmul_window, "vector_fmul_window"))
         test_vector_fmul_window(src3, src4, src5);
     report("vector_fmul");
@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/h263dsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "checkasm.h"
+
+#define PIXEL_STRIDE 16
+#define BUF_SIZE     (16 * PIXEL_STRIDE)
+
+#define randomize_pixels(buf, size)                                          \
+    do {                                                                     \
+        int i;                                                               \
+        for (i = 0; i < size; i += 4)                                        \
+            AV_WN32A((buf) + i, rnd());                                      \
+    } while (0)
+
+void checkasm_check_h263dsp(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf,  [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, buf1, [BUF_SIZE]);
+    H263DSPContext c;
+    int dir, i;
+    static const char *const names[] = { "h_loop_filter", "v_loop_filter" };
+
+    ff_h263dsp_init(&c);
+
+    for (dir = 0; dir < 2; dir++) {
+        void (*func)(uint8_t *, int, int) = dir ? c.h263_v_loop_filter : c.h263_h_loop_filter;
+        /* Across the edge at the middle of the buffer */
+        int offset = dir ? 8 * PIXEL_STRIDE + 4 : 4 * PIXEL_STRIDE + 8;
+        declare_func(void, uint8_t *src, int stride, int qscale);
+
+        if (check_func(func, "h263_%s", names[dir])) {
+            for (i = 0; i < 8; i++) {
+                int qscale = 1 + rnd() % 31;
+
+                randomize_pixels(buf, BUF_SIZE);
+                /* Small steps too, the filter folds back the larger ones */
+                if (i & 1) {
+                    int j;
+                    for (j = 0; j < BUF_SIZE; j++)
+                        buf[j] = 128 + (buf[j] & 63) - 32;
+                }
+                memcpy(buf0, buf, BUF_SIZE);
+                memcpy(buf1, buf, BUF_SIZE);
+                call_ref(buf0 + offset, PIXEL_STRIDE, qscale);
+                call_new(buf1 + offset, PIXEL_STRIDE, qscale);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+            }
+            bench_new(buf1 + offset, PIXEL_STRIDE, 16);
+        }
+    }
+
+    report("loop_filter");
+}
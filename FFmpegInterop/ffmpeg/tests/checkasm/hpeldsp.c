@@ -0,0 +1,87 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/hpeldsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "checkasm.h"
+
+#define PIXEL_STRIDE 32
+#define BUF_SIZE     (17 * PIXEL_STRIDE)
+
+#define randomize_pixels(buf, size)                                          \
+    do {                                                                     \
+        int i;                                                               \
+        for (i = 0; i < size; i += 4)                                        \
+            AV_WN32A((buf) + i, rnd());                                      \
+    } while (0)
+
+static void check_pixels_tab(op_pixels_func (*tab)[4], int sizes,
+                             const char *name)
+{
+    LOCAL_ALIGNED_16(uint8_t, src,  [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [BUF_SIZE]);
+    int i, j, h;
+    static const char *const pos[] = { "", "_x2", "_y2", "_xy2" };
+    declare_func(void, uint8_t *block, const uint8_t *pixels,
+                 ptrdiff_t line_size, int h);
+
+    for (i = 0; i < sizes; i++) {
+        int size = 16 >> i;
+
+        for (j = 0; j < 4; j++) {
+            if (check_func(tab[i][j], "%s_pixels%d%s", name, size, pos[j])) {
+                /* Both heights the decoders use, from unaligned sources */
+                for (h = size / 2; h <= size; h += size / 2) {
+                    randomize_pixels(src, BUF_SIZE);
+                    randomize_pixels(dst0, BUF_SIZE);
+                    memcpy(dst1, dst0, BUF_SIZE);
+                    call_ref(dst0, src + 1, PIXEL_STRIDE, h);
+                    call_new(dst1, src + 1, PIXEL_STRIDE, h);
+                    if (memcmp(dst0, dst1, BUF_SIZE))
+                        fail();
+                }
+                bench_new(dst1, src + 1, PIXEL_STRIDE, size);
+            }
+        }
+    }
+}
+
+void checkasm_check_hpeldsp(void)
+{
+    HpelDSPContext h;
+
+    ff_hpeldsp_init(&h, 0);
+
+    check_pixels_tab(h.put_pixels_tab, 2, "put");
+    report("put_pixels");
+
+    check_pixels_tab(h.avg_pixels_tab, 2, "avg");
+    report("avg_pixels");
+
+    check_pixels_tab(h.put_no_rnd_pixels_tab, 2, "put_no_rnd");
+    report("put_no_rnd_pixels");
+
+    check_pixels_tab(&h.avg_no_rnd_pixels_tab, 1, "avg_no_rnd");
+    report("avg_no_rnd_pixels");
+}
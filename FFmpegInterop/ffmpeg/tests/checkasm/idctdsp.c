@@ -0,0 +1,161 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/idctdsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "checkasm.h"
+
+#define PIXEL_STRIDE 16
+
+#define randomize_pixels(buf, size)                                          \
+    do {                                                                     \
+        int i;                                                               \
+        for (i = 0; i < size; i += 4)                                        \
+            AV_WN32A((buf) + i, rnd());                                      \
+    } while (0)
+
+/* Dense, sparse and DC-only blocks: the C version takes shortcuts on the
+ * rows with only a DC. The dense ones are kept in the range of dequantized
+ * coefficients, the others go up to the limits of int16_t. */
+static void randomize_block(int16_t *block, int type)
+{
+    int i;
+
+    memset(block, 0, 64 * sizeof(*block));
+    switch (type) {
+    case 0:
+        for (i = 0; i < 64; i++)
+            block[i] = (int)(rnd() % 4096) - 2048;
+        break;
+    case 1:
+        for (i = 0; i < 6; i++)
+            block[rnd() & 63] = rnd();
+        break;
+    default:
+        for (i = 0; i < 8; i++)
+            block[8 * i] = rnd();
+        break;
+    }
+}
+
+static void check_idct(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, dst0, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(int16_t, block,  [64]);
+    LOCAL_ALIGNED_16(int16_t, block0, [64]);
+    LOCAL_ALIGNED_16(int16_t, block1, [64]);
+    AVCodecContext avctx = {
+        .bits_per_raw_sample = 8,
+    };
+    IDCTDSPContext c;
+    int i, type;
+    static const char *const names[] = { "idct_put", "idct_add" };
+
+    ff_idctdsp_init(&c, &avctx);
+
+    for (i = 0; i < 2; i++) {
+        void (*func)(uint8_t *, ptrdiff_t, int16_t *) = i ? c.idct_add : c.idct_put;
+        declare_func(void, uint8_t *dest, ptrdiff_t line_size, int16_t *block);
+
+        if (check_func(func, "simple_%s", names[i])) {
+            for (type = 0; type < 3; type++) {
+                randomize_pixels(dst0, 8 * PIXEL_STRIDE);
+                memcpy(dst1, dst0, 8 * PIXEL_STRIDE);
+                randomize_block(block, type);
+                memcpy(block0, block, 64 * sizeof(*block));
+                memcpy(block1, block, 64 * sizeof(*block));
+                /* What is left in block is not part of the result */
+                call_ref(dst0, PIXEL_STRIDE, block0);
+                call_new(dst1, PIXEL_STRIDE, block1);
+                if (memcmp(dst0, dst1, 8 * PIXEL_STRIDE))
+                    fail();
+            }
+            memcpy(block1, block, 64 * sizeof(*block));
+            bench_new(dst1, PIXEL_STRIDE, block1);
+        }
+    }
+
+    if (check_func(c.idct, "simple_idct")) {
+        declare_func(void, int16_t *block);
+
+        for (type = 0; type < 3; type++) {
+            randomize_block(block0, type);
+            memcpy(block1, block0, 64 * sizeof(*block));
+            call_ref(block0);
+            call_new(block1);
+            if (memcmp(block0, block1, 64 * sizeof(*block)))
+                fail();
+        }
+        bench_new(block1);
+    }
+
+    report("idct");
+}
+
+static void check_pixels_clamped(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, dst0, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(int16_t, block, [64]);
+    AVCodecContext avctx = {
+        .bits_per_raw_sample = 8,
+    };
+    IDCTDSPContext c;
+    int i, j;
+    static const char *const names[] = {
+        "put_pixels_clamped", "put_signed_pixels_clamped", "add_pixels_clamped",
+    };
+
+    ff_idctdsp_init(&c, &avctx);
+
+    for (i = 0; i < 3; i++) {
+        void (*func)(const int16_t *, uint8_t *, ptrdiff_t) =
+            i == 0 ? c.put_pixels_clamped :
+            i == 1 ? c.put_signed_pixels_clamped : c.add_pixels_clamped;
+        declare_func(void, const int16_t *block, uint8_t *pixels,
+                     ptrdiff_t line_size);
+
+        if (check_func(func, "%s", names[i])) {
+            /* Past both limits of the pixels, and of int16_t */
+            for (j = 0; j < 64; j++)
+                block[j] = j & 1 ? (int)(rnd() % 1024) - 384 : rnd();
+            randomize_pixels(dst0, 8 * PIXEL_STRIDE);
+            memcpy(dst1, dst0, 8 * PIXEL_STRIDE);
+            call_ref(block, dst0, PIXEL_STRIDE);
+            call_new(block, dst1, PIXEL_STRIDE);
+            if (memcmp(dst0, dst1, 8 * PIXEL_STRIDE))
+                fail();
+            bench_new(block, dst1, PIXEL_STRIDE);
+        }
+    }
+
+    report("pixels_clamped");
+}
+
+void checkasm_check_idctdsp(void)
+{
+    check_idct();
+    check_pixels_clamped();
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/mdct15.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "checkasm.h"
+
+#define MAX_N      6
+#define MAX_LEN4   (15 << (MAX_N - 1))
+#define STRIDE     4
+
+#define randomize_buffer(buf, len)                                  \
+    do {                                                            \
+        int i;                                                      \
+        for (i = 0; i < len; i++)                                   \
+            buf[i] = ((int)(rnd() & 0xFFFF) - 0x8000) / 32768.0f;   \
+    } while (0)
+
+#define EPS 1.0e-5f
+
+static void check_fft15(MDCT15Context *s)
+{
+    LOCAL_ALIGNED_32(FFTComplex, in,   [15]);
+    LOCAL_ALIGNED_32(FFTComplex, out0, [15 * STRIDE]);
+    LOCAL_ALIGNED_32(FFTComplex, out1, [15 * STRIDE]);
+
+    declare_func(void, FFTComplex *out, FFTComplex *in, FFTComplex *exptab,
+                 ptrdiff_t stride);
+
+    if (check_func(s->fft15, "fft15")) {
+        randomize_buffer(((float *)in), 2 * 15);
+        memset(out0, 0, 15 * STRIDE * sizeof(*out0));
+        memset(out1, 0, 15 * STRIDE * sizeof(*out1));
+        call_ref(out0, in, s->exptab, STRIDE);
+        call_new(out1, in, s->exptab, STRIDE);
+        if (!float_near_abs_eps_array((float *)out0, (float *)out1, EPS,
+                                      2 * 15 * STRIDE))
+            fail();
+        bench_new(out1, in, s->exptab, STRIDE);
+    }
+}
+
+static void check_postreindex(MDCT15Context *s, int N)
+{
+    LOCAL_ALIGNED_32(FFTComplex, in,   [MAX_LEN4]);
+    LOCAL_ALIGNED_32(FFTComplex, out0, [MAX_LEN4]);
+    LOCAL_ALIGNED_32(FFTComplex, out1, [MAX_LEN4]);
+    ptrdiff_t len8 = s->len4 >> 1;
+
+    declare_func(void, FFTComplex *out, FFTComplex *in, FFTComplex *exp,
+                 int *lut, ptrdiff_t len8);
+
+    if (check_func(s->postreindex, "mdct15_postreindex_%d", 15 << N)) {
+        randomize_buffer(((float *)in), 2 * s->len4);
+        call_ref(out0, in, s->twiddle_exptab, s->pfa_postreindex, len8);
+        call_new(out1, in, s->twiddle_exptab, s->pfa_postreindex, len8);
+        if (!float_near_abs_eps_array((float *)out0, (float *)out1, EPS,
+                                      2 * s->len4))
+            fail();
+        bench_new(out1, in, s->twiddle_exptab, s->pfa_postreindex, len8);
+    }
+}
+
+void checkasm_check_mdct15(void)
+{
+    MDCT15Context *s;
+    int N;
+
+    for (N = 3; N <= MAX_N; N++) {
+        if (ff_mdct15_init(&s, 1, N, 1.0) < 0) {
+            fail();
+            return;
+        }
+        if (N == 3)
+            check_fft15(s);
+        check_postreindex(s, N);
+        ff_mdct15_uninit(&s);
+    }
+    report("mdct15");
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/vorbisdsp.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "checkasm.h"
+
+#define LEN 512
+
+/* Include exact zeros so that both sign paths of the coupling are hit
+ * on their boundaries. */
+#define randomize_buffer(buf)                                       \
+    do {                                                            \
+        int i;                                                      \
+        for (i = 0; i < LEN; i++)                                   \
+            buf[i] = (rnd() & 7) ? ((int)(rnd() & 0xFFFF) - 0x8000) \
+                                   / 32768.0f : 0.0f;               \
+    } while (0)
+
+void checkasm_check_vorbisdsp(void)
+{
+    LOCAL_ALIGNED_16(float, mag0, [LEN]);
+    LOCAL_ALIGNED_16(float, ang0, [LEN]);
+    LOCAL_ALIGNED_16(float, mag1, [LEN]);
+    LOCAL_ALIGNED_16(float, ang1, [LEN]);
+    VorbisDSPContext dsp;
+
+    declare_func(void, float *mag, float *ang, intptr_t blocksize);
+
+    ff_vorbisdsp_init(&dsp);
+
+    if (check_func(dsp.vorbis_inverse_coupling, "vorbis_inverse_coupling")) {
+        randomize_buffer(mag0);
+        randomize_buffer(ang0);
+        memcpy(mag1, mag0, sizeof(*mag0) * LEN);
+        memcpy(ang1, ang0, sizeof(*ang0) * LEN);
+        call_ref(mag0, ang0, LEN);
+        call_new(mag1, ang1, LEN);
+        if (memcmp(mag0, mag1, sizeof(*mag0) * LEN) ||
+            memcmp(ang0, ang1, sizeof(*ang0) * LEN))
+            fail();
+        bench_new(mag1, ang1, LEN);
+    }
+    report("inverse_coupling");
+}
@@ -0,0 +1,196 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/vp3dsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "checkasm.h"
+
+#define PIXEL_STRIDE 16
+
+#define randomize_pixels(buf, size)                                          \
+    do {                                                                     \
+        int i;                                                               \
+        for (i = 0; i < size; i += 4)                                        \
+            AV_WN32A((buf) + i, rnd());                                      \
+    } while (0)
+
+/* Dense, sparse and DC-only blocks: the C version takes shortcuts on the
+ * rows and columns of zeros */
+static void randomize_block(int16_t *block, int type)
+{
+    int i;
+
+    memset(block, 0, 64 * sizeof(*block));
+    switch (type) {
+    case 0:
+        for (i = 0; i < 64; i++)
+            block[i] = rnd();
+        break;
+    case 1:
+        for (i = 0; i < 6; i++)
+            block[rnd() & 63] = (int)(rnd() % 4096) - 2048;
+        break;
+    default:
+        block[0] = rnd();
+        break;
+    }
+}
+
+static void check_idct(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, dst,  [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(int16_t, block,  [64]);
+    LOCAL_ALIGNED_16(int16_t, block0, [64]);
+    LOCAL_ALIGNED_16(int16_t, block1, [64]);
+    VP3DSPContext d;
+    int type, i;
+    static const char *const names[] = { "idct_put", "idct_add", "idct_dc_add" };
+
+    ff_vp3dsp_init(&d, 0);
+
+    for (i = 0; i < 3; i++) {
+        void (*func)(uint8_t *, ptrdiff_t, int16_t *) =
+            i == 0 ? d.idct_put : i == 1 ? d.idct_add : d.idct_dc_add;
+        declare_func(void, uint8_t *dest, ptrdiff_t stride, int16_t *block);
+
+        if (check_func(func, "vp3_%s", names[i])) {
+            for (type = 0; type < 3; type++) {
+                randomize_pixels(dst, 8 * PIXEL_STRIDE);
+                randomize_block(block, i == 2 ? 2 : type);
+                memcpy(dst0, dst, 8 * PIXEL_STRIDE);
+                memcpy(dst1, dst, 8 * PIXEL_STRIDE);
+                memcpy(block0, block, 64 * sizeof(*block));
+                memcpy(block1, block, 64 * sizeof(*block));
+                call_ref(dst0, PIXEL_STRIDE, block0);
+                call_new(dst1, PIXEL_STRIDE, block1);
+                if (memcmp(dst0, dst1, 8 * PIXEL_STRIDE) ||
+                    memcmp(block0, block1, 64 * sizeof(*block)))
+                    fail();
+            }
+            bench_new(dst1, PIXEL_STRIDE, block1);
+        }
+    }
+
+    report("idct");
+}
+
+/* Built like init_loop_filter() in vp3.c does */
+static void init_bounding_values(int *bounding_values_array, int filter_limit)
+{
+    int *bounding_values = bounding_values_array + 127;
+    int x, value;
+
+    memset(bounding_values_array, 0, 256 * sizeof(int));
+    for (x = 0; x < filter_limit; x++) {
+        bounding_values[-x] = -x;
+        bounding_values[x] = x;
+    }
+    for (x = value = filter_limit; x < 128 && value; x++, value--) {
+        bounding_values[ x] =  value;
+        bounding_values[-x] = -value;
+    }
+    if (value)
+        bounding_values[128] = value;
+    bounding_values[129] = bounding_values[130] = filter_limit * 0x02020202;
+}
+
+static void check_loop_filter(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf,  [16 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, buf0, [16 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, buf1, [16 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_8(int, bounding_values_array, [256 + 2]);
+    int *bounding_values = bounding_values_array + 127;
+    VP3DSPContext d;
+    int dir, i;
+    static const char *const names[] = { "h_loop_filter", "v_loop_filter" };
+
+    ff_vp3dsp_init(&d, 0);
+
+    for (dir = 0; dir < 2; dir++) {
+        void (*func)(uint8_t *, ptrdiff_t, int *) = dir ? d.v_loop_filter : d.h_loop_filter;
+        /* Across the edge at the middle of the buffer */
+        int offset = dir ? 8 * PIXEL_STRIDE + 4 : 4 * PIXEL_STRIDE + 8;
+        declare_func(void, uint8_t *src, ptrdiff_t stride, int *bounding_values);
+
+        if (check_func(func, "vp3_%s", names[dir])) {
+            for (i = 0; i < 8; i++) {
+                /* Small steps too, the filter only changes those */
+                init_bounding_values(bounding_values_array, i < 2 ? 127 * i : rnd() % 128);
+                randomize_pixels(buf, 16 * PIXEL_STRIDE);
+                if (i & 1) {
+                    int j;
+                    for (j = 0; j < 16 * PIXEL_STRIDE; j++)
+                        buf[j] = 128 + (buf[j] & 15) - 8;
+                }
+                memcpy(buf0, buf, 16 * PIXEL_STRIDE);
+                memcpy(buf1, buf, 16 * PIXEL_STRIDE);
+                call_ref(buf0 + offset, PIXEL_STRIDE, bounding_values);
+                call_new(buf1 + offset, PIXEL_STRIDE, bounding_values);
+                if (memcmp(buf0, buf1, 16 * PIXEL_STRIDE))
+                    fail();
+            }
+            bench_new(buf1 + offset, PIXEL_STRIDE, bounding_values);
+        }
+    }
+
+    report("loop_filter");
+}
+
+static void check_put_no_rnd_pixels_l2(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, src0, [9 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, src1, [9 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [8 * PIXEL_STRIDE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [8 * PIXEL_STRIDE]);
+    VP3DSPContext d;
+    declare_func(void, uint8_t *dst, const uint8_t *a,
+                 const uint8_t *b, ptrdiff_t stride, int h);
+
+    ff_vp3dsp_init(&d, 0);
+
+    if (check_func(d.put_no_rnd_pixels_l2, "vp3_put_no_rnd_pixels_l2")) {
+        randomize_pixels(src0, 9 * PIXEL_STRIDE);
+        randomize_pixels(src1, 9 * PIXEL_STRIDE);
+        randomize_pixels(dst0, 8 * PIXEL_STRIDE);
+        memcpy(dst1, dst0, 8 * PIXEL_STRIDE);
+        /* Unaligned sources, as with the motion vectors of the decoder */
+        call_ref(dst0, src0 + 1, src1 + PIXEL_STRIDE + 3, PIXEL_STRIDE, 8);
+        call_new(dst1, src0 + 1, src1 + PIXEL_STRIDE + 3, PIXEL_STRIDE, 8);
+        if (memcmp(dst0, dst1, 8 * PIXEL_STRIDE))
+            fail();
+        bench_new(dst1, src0 + 1, src1 + PIXEL_STRIDE + 3, PIXEL_STRIDE, 8);
+    }
+
+    report("put_no_rnd_pixels_l2");
+}
+
+void checkasm_check_vp3dsp(void)
+{
+    check_idct();
+    check_loop_filter();
+    check_put_no_rnd_pixels_l2();
+}
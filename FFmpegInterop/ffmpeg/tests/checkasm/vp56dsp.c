@@ -0,0 +1,164 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/vp56data.h"
+#include "libavcodec/vp56dsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "checkasm.h"
+
+#define PIXEL_STRIDE 32
+#define BUF_SIZE     (16 * PIXEL_STRIDE)
+
+#define randomize_pixels(buf, size)                                          \
+    do {                                                                     \
+        int i;                                                               \
+        for (i = 0; i < size; i += 4)                                        \
+            AV_WN32A((buf) + i, rnd());                                      \
+    } while (0)
+
+/* Taps of up to 4 * 128 like those of the decoder, negative ones included:
+ * the sums of the sharpest filters go past 16 bits */
+static void randomize_weights(int16_t *weights)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        weights[i] = (int)(rnd() % 257) - 64;
+}
+
+static void check_edge_filter(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf,  [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, buf1, [BUF_SIZE]);
+    VP56DSPContext d;
+    int dir, i;
+    static const char *const names[] = { "edge_filter_hor", "edge_filter_ver" };
+
+    ff_vp6dsp_init(&d);
+
+    for (dir = 0; dir < 2; dir++) {
+        void (*func)(uint8_t *, ptrdiff_t, int) = dir ? d.edge_filter_ver : d.edge_filter_hor;
+        /* Across the edge at the middle of the 12 pixels filtered */
+        int offset = dir ? 8 * PIXEL_STRIDE + 2 : 2 * PIXEL_STRIDE + 8;
+        declare_func(void, uint8_t *yuv, ptrdiff_t stride, int t);
+
+        if (check_func(func, "vp6_%s", names[dir])) {
+            for (i = 0; i < 8; i++) {
+                int t = ff_vp56_filter_threshold[rnd() % 64];
+
+                randomize_pixels(buf, BUF_SIZE);
+                /* Small steps too, the filter folds back the larger ones */
+                if (i & 1) {
+                    int j;
+                    for (j = 0; j < BUF_SIZE; j++)
+                        buf[j] = 128 + (buf[j] & 63) - 32;
+                }
+                memcpy(buf0, buf, BUF_SIZE);
+                memcpy(buf1, buf, BUF_SIZE);
+                call_ref(buf0 + offset, PIXEL_STRIDE, t);
+                call_new(buf1 + offset, PIXEL_STRIDE, t);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+            }
+            bench_new(buf1 + offset, PIXEL_STRIDE, 8);
+        }
+    }
+
+    report("edge_filter");
+}
+
+static void check_filter_hv4(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, src, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [BUF_SIZE]);
+    int16_t weights[4];
+    VP56DSPContext d;
+    int dir, i;
+    static const char *const names[] = { "h", "v" };
+
+    ff_vp6dsp_init(&d);
+
+    for (dir = 0; dir < 2; dir++) {
+        ptrdiff_t delta = dir ? PIXEL_STRIDE : 1;
+        declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                     ptrdiff_t delta, const int16_t *weights);
+
+        if (check_func(d.vp6_filter_hv4, "vp6_filter_hv4_%s", names[dir])) {
+            for (i = 0; i < 4; i++) {
+                randomize_pixels(src, BUF_SIZE);
+                randomize_pixels(dst0, BUF_SIZE);
+                memcpy(dst1, dst0, BUF_SIZE);
+                randomize_weights(weights);
+                /* Unaligned, as with the motion vectors of the decoder */
+                call_ref(dst0, src + 2 * PIXEL_STRIDE + 3, PIXEL_STRIDE, delta, weights);
+                call_new(dst1, src + 2 * PIXEL_STRIDE + 3, PIXEL_STRIDE, delta, weights);
+                if (memcmp(dst0, dst1, BUF_SIZE))
+                    fail();
+            }
+            bench_new(dst1, src + 2 * PIXEL_STRIDE + 3, PIXEL_STRIDE, delta, weights);
+        }
+    }
+
+    report("filter_hv4");
+}
+
+static void check_filter_diag4(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, src, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [BUF_SIZE]);
+    int16_t h_weights[4], v_weights[4];
+    VP56DSPContext d;
+    int i;
+    declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                 const int16_t *h_weights, const int16_t *v_weights);
+
+    ff_vp6dsp_init(&d);
+
+    if (check_func(d.vp6_filter_diag4, "vp6_filter_diag4")) {
+        for (i = 0; i < 4; i++) {
+            randomize_pixels(src, BUF_SIZE);
+            randomize_pixels(dst0, BUF_SIZE);
+            memcpy(dst1, dst0, BUF_SIZE);
+            randomize_weights(h_weights);
+            randomize_weights(v_weights);
+            call_ref(dst0, src + 2 * PIXEL_STRIDE + 3, PIXEL_STRIDE, h_weights, v_weights);
+            call_new(dst1, src + 2 * PIXEL_STRIDE + 3, PIXEL_STRIDE, h_weights, v_weights);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+        }
+        bench_new(dst1, src + 2 * PIXEL_STRIDE + 3, PIXEL_STRIDE, h_weights, v_weights);
+    }
+
+    report("filter_diag4");
+}
+
+void checkasm_check_vp56dsp(void)
+{
+    check_edge_filter();
+    check_filter_hv4();
+    check_filter_diag4();
+}
@@ -0,0 +1,88 @@
+//Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include "pch.h"
+
+#include <CppUnitTest.h>
+
+#include "FFmpegDecoderMFT.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FFmpegPack;
+
+namespace DecoderAppServiceTests
+{
+	TEST_CLASS(FFmpegDecoderMFTTests)
+	{
+	public:
+		TEST_CLASS_INITIALIZE(StartMediaFoundation)
+		{
+			Assert::AreEqual(S_OK, MFStartup(MF_VERSION));
+		}
+
+		TEST_CLASS_CLEANUP(ShutdownMediaFoundation)
+		{
+			MFShutdown();
+		}
+
+		/**
+		 * In synchronous mode the pipeline may call ProcessOutput before the
+		 * first ProcessInput. There is no decoder yet, so the MFT must ask for
+		 * input rather than fail, and accept input afterwards.
+		 */
+		TEST_METHOD(SyncProcessOutputBeforeFirstInput)
+		{
+			CComPtr<IMFTransform> spMFT;
+			Assert::AreEqual(S_OK, FFmpegDecoderMFT::CreateInstance(&spMFT));
+
+			SetTypes(spMFT);
+
+			MFT_OUTPUT_DATA_BUFFER output = {};
+			DWORD dwStatus = 0;
+			Assert::AreEqual(MF_E_TRANSFORM_NEED_MORE_INPUT, spMFT->ProcessOutput(0, 1, &output, &dwStatus));
+			Assert::IsNull(output.pSample);
+
+			DWORD dwFlags = 0;
+			Assert::AreEqual(S_OK, spMFT->GetInputStatus(0, &dwFlags));
+			Assert::AreEqual((DWORD)MFT_INPUT_STATUS_ACCEPT_DATA, dwFlags);
+
+			// Asking again, e.g. after a new output type, is still no error
+			Assert::AreEqual(MF_E_TRANSFORM_NEED_MORE_INPUT, spMFT->ProcessOutput(0, 1, &output, &dwStatus));
+
+			Shutdown(spMFT);
+		}
+
+	private:
+		/** Sets the first input type of the pack, and the first output type offered for it. */
+		static void SetTypes(IMFTransform *pMFT)
+		{
+			CComPtr<IMFMediaType> spInputType;
+			Assert::AreEqual(S_OK, pMFT->GetInputAvailableType(0, 0, &spInputType));
+
+			GUID majorType = GUID_NULL;
+			Assert::AreEqual(S_OK, spInputType->GetGUID(MF_MT_MAJOR_TYPE, &majorType));
+
+			if (majorType == MFMediaType_Audio)
+			{
+				Assert::AreEqual(S_OK, spInputType->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, 2));
+				Assert::AreEqual(S_OK, spInputType->SetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, 44100));
+			}
+			else
+			{
+				Assert::AreEqual(S_OK, MFSetAttributeSize(spInputType, MF_MT_FRAME_SIZE, 320, 240));
+			}
+
+			Assert::AreEqual(S_OK, pMFT->SetInputType(0, spInputType, 0));
+
+			CComPtr<IMFMediaType> spOutputType;
+			Assert::AreEqual(S_OK, pMFT->GetOutputAvailableType(0, 0, &spOutputType));
+			Assert::AreEqual(S_OK, pMFT->SetOutputType(0, spOutputType, 0));
+		}
+
+		static void Shutdown(IMFTransform *pMFT)
+		{
+			CComPtr<IMFShutdown> spShutdown;
+			if (SUCCEEDED(pMFT->QueryInterface(IID_PPV_ARGS(&spShutdown))))
+				spShutdown->Shutdown();
+		}
+	};
+}